@@ -29,6 +29,7 @@ namespace Invader {
          * @param  sharpen            sharpening filter
          * @param  blur               blur filter
          * @param  alpha_bias         alpha bias filter
+         * @param  output             output to hold messages in (or nullptr to print them immediately)
          * @return                    scanned color plate data
          */
         static void process_bitmap_data(
@@ -42,7 +43,8 @@ namespace Invader {
             std::optional<float> mipmap_fade_factor,
             std::optional<float> sharpen,
             std::optional<float> blur,
-            std::optional<float> alpha_bias
+            std::optional<float> alpha_bias,
+            BufferedOutput *output = nullptr
         );
         
     private:
@@ -52,8 +54,9 @@ namespace Invader {
          * Process height maps for the bitmap
          * @param generated_bitmap bitmap data to write to (output)
          * @param bump_height      bump height value
+         * @param output           output to hold messages in (or nullptr)
          */
-        static void process_height_maps(GeneratedBitmapData &generated_bitmap, float bump_height);
+        static void process_height_maps(GeneratedBitmapData &generated_bitmap, float bump_height, BufferedOutput *output);
 
         /**
          * Generate mipmaps for the color plate
@@ -64,14 +67,16 @@ namespace Invader {
          * @param sharpen            sharpen filter
          * @param alpha_bias         alpha bias
          * @param usage              bitmap usage value
+         * @param output             output to hold messages in (or nullptr)
          */
-        static void generate_mipmaps(GeneratedBitmapData &generated_bitmap, std::int16_t mipmaps, BitmapMipmapScaleType mipmap_type, std::optional<float> mipmap_fade_factor, std::optional<float> sharpen, std::optional<float> blur, std::optional<float> alpha_bias, BitmapUsage usage);
+        static void generate_mipmaps(GeneratedBitmapData &generated_bitmap, std::int16_t mipmaps, BitmapMipmapScaleType mipmap_type, std::optional<float> mipmap_fade_factor, std::optional<float> sharpen, std::optional<float> blur, std::optional<float> alpha_bias, BitmapUsage usage, BufferedOutput *output);
 
         /**
          * Consolidate the stacked bitmap data (cubemaps and 3d textures)
          * @param generated_bitmap bitmap data to do cubemap stuff with
+         * @param output           output to hold messages in (or nullptr)
          */
-        static void consolidate_stacked_bitmaps(GeneratedBitmapData &generated_bitmap);
+        static void consolidate_stacked_bitmaps(GeneratedBitmapData &generated_bitmap, BufferedOutput *output);
 
         /**
          * Merge the mipmaps for 3D textures for depth
@@ -83,8 +88,9 @@ namespace Invader {
          * @param generated_bitmap bitmap data to do sprite stuff with
          * @param parameters       sprite parameters
          * @param mipmaps          mipmap count
+         * @param output           output to hold messages in (or nullptr)
          */
-        static void process_sprites(GeneratedBitmapData &generated_bitmap, BitmapProcessorSpriteParameters &parameters, std::int16_t &mipmaps);
+        static void process_sprites(GeneratedBitmapData &generated_bitmap, BitmapProcessorSpriteParameters &parameters, std::int16_t &mipmaps, BufferedOutput *output);
     };
 };
 
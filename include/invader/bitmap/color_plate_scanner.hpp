@@ -8,6 +8,7 @@
 #include <optional>
 #include <invader/tag/hek/definition.hpp>
 #include <invader/bitmap/pixel.hpp>
+#include <invader/printf.hpp>
 
 namespace Invader {
     using BitmapType = HEK::BitmapType;
@@ -76,6 +77,8 @@ namespace Invader {
          * @param usage                  usage value for bitmap
          * @param reg_point_hack         ignore sequence dividers when calculating registration point
          * @param allow_non_power_of_two allow non-power-of-two textures (besides when the type is sprites or interface bitmaps)
+         * @param max_threads            maximum number of threads to scan with
+         * @param output                 output to hold messages in (or nullptr to print them immediately)
          */
         static GeneratedBitmapData scan_color_plate(
             const Pixel *pixels,
@@ -84,13 +87,21 @@ namespace Invader {
             BitmapType type,
             BitmapUsage usage,
             bool reg_point_hack,
-            bool allow_non_power_of_two
+            bool allow_non_power_of_two,
+            std::size_t max_threads = 1,
+            BufferedOutput *output = nullptr
         );
 
     private:
         /** Is power of two required */
         bool power_of_two = true;
 
+        /** Maximum number of threads to scan with */
+        std::size_t max_threads = 1;
+
+        /** Output to hold messages in (or nullptr to print them immediately) */
+        BufferedOutput *output = nullptr;
+
         /** Transparency color */
         std::optional<Pixel> transparency_color;
 
@@ -137,6 +148,13 @@ namespace Invader {
          */
         void read_color_plate(GeneratedBitmapData &generated_bitmap, const Pixel *pixels, std::uint32_t width, bool reg_point_hack) const;
 
+        /**
+         * Call the function for each band of [0, count) in parallel
+         * @param count    number of items
+         * @param function function to call with the first item of the band and the item after the last item of the band
+         */
+        template <typename F> void for_each_band(std::size_t count, const F &function) const;
+
         /**
          * Read an unrolled cubemap
          * @param generated_bitmap bitmap data to write to (output)
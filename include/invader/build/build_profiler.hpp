@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef INVADER__BUILD__BUILD_PROFILER_HPP
+#define INVADER__BUILD__BUILD_PROFILER_HPP
+
+#include <vector>
+#include <optional>
+#include <string>
+#include <filesystem>
+#include <chrono>
+
+#include "../hek/fourcc.hpp"
+
+namespace Invader {
+    /**
+     * Records how long each part of a build takes
+     */
+    class BuildProfiler {
+    public:
+        enum EventType {
+            /** Build phase (reading tags, generating tag data, etc.) */
+            EVENT_TYPE_PHASE,
+
+            /** Compiling a tag, including the tags it references */
+            EVENT_TYPE_TAG,
+
+            /** Part of a phase or tag (reading, parsing, compiling scripts, etc.) */
+            EVENT_TYPE_STEP
+        };
+
+        struct Event {
+            /** Name of the event */
+            std::string name;
+
+            /** Type of the event */
+            EventType type;
+
+            /** Tag index, if this is a tag */
+            std::optional<std::size_t> tag_index;
+
+            /** Time the event started relative to the start of the build in microseconds */
+            double start = 0.0;
+
+            /** How long the event took in microseconds */
+            double duration = 0.0;
+
+            /** How much of the duration was spent compiling other tags in microseconds */
+            double child_tag_duration = 0.0;
+
+            /** Index of the event this event is in */
+            std::optional<std::size_t> parent;
+
+            /**
+             * Get the time spent in the event not including other tags
+             * @return time in microseconds
+             */
+            double get_self_duration() const noexcept {
+                return this->duration - this->child_tag_duration;
+            }
+        };
+
+        /**
+         * Ends an event when it goes out of scope
+         */
+        class Scope {
+        public:
+            /**
+             * End the event now rather than when going out of scope
+             */
+            void end() noexcept;
+
+            Scope(Scope &&move) noexcept;
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+            ~Scope() noexcept;
+
+        private:
+            friend class BuildProfiler;
+            Scope(BuildProfiler *profiler, std::optional<std::size_t> event) noexcept : profiler(profiler), event(event) {}
+            BuildProfiler *profiler;
+            std::optional<std::size_t> event;
+        };
+
+        /**
+         * Start timing a build phase
+         * @param name name of the phase
+         * @return     scope which ends the phase
+         */
+        Scope phase(const char *name);
+
+        /**
+         * Start timing compiling a tag
+         * @param tag_index index of the tag in the workload
+         * @return          scope which ends compiling the tag
+         */
+        Scope tag(std::size_t tag_index);
+
+        /**
+         * Start timing part of a phase or tag
+         * @param name name of the step
+         * @return     scope which ends the step
+         */
+        Scope step(const char *name);
+
+        /**
+         * Set whether or not events are recorded. This also resets the start time.
+         * @param enabled enable recording
+         */
+        void set_enabled(bool enabled) noexcept;
+
+        /**
+         * Get whether or not events are recorded
+         * @return true if enabled
+         */
+        bool is_enabled() const noexcept {
+            return this->enabled;
+        }
+
+        /**
+         * Get all events recorded
+         * @return events
+         */
+        const std::vector<Event> &get_events() const noexcept {
+            return this->events;
+        }
+
+        /**
+         * Print the time taken by each phase, the slowest tags, and the time taken by each tag class
+         * @param tag_names         name of each tag (path and extension) by tag index
+         * @param tag_classes       class of each tag by tag index
+         * @param slowest_tag_count number of slowest tags to show
+         */
+        void print_summary(const std::vector<std::string> &tag_names, const std::vector<TagFourCC> &tag_classes, std::size_t slowest_tag_count) const;
+
+        /**
+         * Write the events as Chrome trace event JSON (this can be opened with chrome://tracing or Perfetto)
+         * @param path        path to write to
+         * @param tag_names   name of each tag (path and extension) by tag index
+         * @param tag_classes class of each tag by tag index
+         * @return            true if successful
+         */
+        bool write_chrome_trace(const std::filesystem::path &path, const std::vector<std::string> &tag_names, const std::vector<TagFourCC> &tag_classes) const;
+
+    private:
+        std::vector<Event> events;
+        std::optional<std::size_t> current;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool enabled = false;
+
+        Scope begin(EventType type, std::string name, std::optional<std::size_t> tag_index);
+        void end(std::size_t event) noexcept;
+    };
+}
+
+#endif
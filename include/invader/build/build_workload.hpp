@@ -4,6 +4,7 @@
 #define INVADER__BUILD__BUILD_WORKLOAD_HPP
 
 #include <vector>
+#include <unordered_map>
 #include <optional>
 #include <string>
 #include <filesystem>
@@ -12,6 +13,7 @@
 #include "../resource/resource_map.hpp"
 #include "../tag/parser/parser.hpp"
 #include "../error_handler/error_handler.hpp"
+#include "build_profiler.hpp"
 
 namespace Invader {
     class BuildWorkload : public ErrorHandler {
@@ -97,6 +99,11 @@ namespace Invader {
              */
             bool optimize_space = false;
             
+            /**
+             * Write a Chrome trace event JSON file of the build to this path
+             */
+            std::optional<std::filesystem::path> trace;
+            
             /**
              * Control how cache files are built. Changing these may result in an incompatible cache file
              */
@@ -381,6 +388,15 @@ namespace Invader {
 
         /** Indices for models */
         std::vector<HEK::LittleEndian<HEK::Index>> model_indices;
+
+        /** Positions in model_indices by the three indices starting there, in ascending order (used for deduping indices) */
+        std::unordered_map<std::uint64_t, std::vector<std::size_t>> model_indices_lookup;
+
+        /** Positions in uncompressed_model_vertices by the hash of the vertex there, in ascending order (used for deduping vertices) */
+        std::unordered_map<std::size_t, std::vector<std::size_t>> uncompressed_model_vertices_lookup;
+
+        /** Positions in compressed_model_vertices by the hash of the vertex there, in ascending order (used for deduping vertices) */
+        std::unordered_map<std::size_t, std::vector<std::size_t>> compressed_model_vertices_lookup;
         
         struct BuildWorkloadModelPart {
             /** index of the struct the part is in */
@@ -427,6 +443,9 @@ namespace Invader {
         /** Scenario index? */
         std::size_t scenario_index;
         
+        /** Times each phase and tag (only enabled when building cache files) */
+        BuildProfiler profiler;
+        
         /** 
          * Get the build parameters
          * @return build parameters
@@ -480,6 +499,8 @@ namespace Invader {
         const BuildParameters *parameters = nullptr;
         void generate_compressed_model_tag_array();
         void check_hud_text_indices();
+        void print_profile_summary() const;
+        void write_profile_trace(const std::filesystem::path &path) const;
     };
 }
 
@@ -8,6 +8,7 @@
 #include <vector>
 #include <optional>
 #include "../hek/fourcc.hpp"
+#include "../file/file.hpp"
 
 namespace Invader {
     struct FoundTagDependency {
@@ -16,7 +17,26 @@ namespace Invader {
         bool broken;
         std::optional<std::filesystem::path> file_path;
 
-        static std::vector<FoundTagDependency> find_dependencies(const char *tag_path_to_find, Invader::TagFourCC tag_int_to_find, std::vector<std::filesystem::path> tags, bool reverse, bool recursive, bool &success);
+        /**
+         * Get all tags referenced by the tag
+         * @param tag_data        tag data
+         * @param tag_data_length length of the tag data
+         * @return                referenced tags (using the system's preferred path separators)
+         */
+        static std::vector<File::TagFilePath> get_dependencies(const std::byte *tag_data, std::size_t tag_data_length);
+
+        /**
+         * Find all tags referenced by a tag, or all tags that reference a tag
+         * @param tag_path_to_find tag path
+         * @param tag_int_to_find  tag class
+         * @param tags             tags directories
+         * @param reverse          find tags that reference the tag instead
+         * @param recursive        also find the references of the references
+         * @param success          set to true if successful
+         * @param use_index        use and update the index file in each tags directory when looking for tags that reference the tag
+         * @return                 tags found
+         */
+        static std::vector<FoundTagDependency> find_dependencies(const char *tag_path_to_find, Invader::TagFourCC tag_int_to_find, std::vector<std::filesystem::path> tags, bool reverse, bool recursive, bool &success, bool use_index = false);
 
         FoundTagDependency(std::string path, Invader::TagFourCC fourcc, bool broken, std::optional<std::filesystem::path> file_path) : path(path), fourcc(fourcc), broken(broken), file_path(file_path) {}
     };
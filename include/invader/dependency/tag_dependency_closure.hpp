@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef INVADER__DEPENDENCY__TAG_DEPENDENCY_CLOSURE_HPP
+#define INVADER__DEPENDENCY__TAG_DEPENDENCY_CLOSURE_HPP
+
+#include <vector>
+#include <filesystem>
+
+#include "../file/file.hpp"
+#include "../hek/map.hpp"
+
+namespace Invader {
+    /**
+     * Finds every tag a cache file would use without building it
+     */
+    class TagDependencyClosure {
+    public:
+        struct ClosureTag {
+            /** Tag path (using Halo path separators) */
+            File::TagFilePath path;
+
+            /** Full filesystem path */
+            std::filesystem::path full_path;
+        };
+
+        /**
+         * Find every tag that would be built into a cache file for the scenario, including child scenarios and the tags the engine requires.
+         * Tags are scanned for references in parallel rather than compiled.
+         * @param scenario          scenario tag path without extension
+         * @param engine_info       engine being targeted
+         * @param tags_directories  tags directories to use
+         * @param job_count         number of threads to use (0 = CPU thread count)
+         * @return                  all tags sorted by path
+         * @throws                  if a tag is missing or could not be read
+         */
+        static std::vector<ClosureTag> find_cache_file_dependencies(const std::string &scenario, const HEK::GameEngineInfo &engine_info, const std::vector<std::filesystem::path> &tags_directories, std::size_t job_count = 0);
+    };
+}
+
+#endif
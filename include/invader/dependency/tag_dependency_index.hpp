@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef INVADER__DEPENDENCY__TAG_DEPENDENCY_INDEX_HPP
+#define INVADER__DEPENDENCY__TAG_DEPENDENCY_INDEX_HPP
+
+#include <map>
+#include <set>
+#include <vector>
+#include <filesystem>
+#include <optional>
+#include <cstdint>
+
+#include "../file/file.hpp"
+
+namespace Invader {
+    /**
+     * Index of the references of every tag in a virtual tags directory, used to find what references a tag without parsing every tag each time
+     */
+    class TagDependencyIndex {
+    public:
+        /** Name of the index file stored in each tags directory by index_tags_directories() */
+        static constexpr const char *INDEX_FILE_NAME = ".invader-tag-index";
+
+        struct IndexedTag {
+            /** Full filesystem path */
+            std::filesystem::path full_path;
+
+            /** Tag directory this tag is in (lower number = higher priority) */
+            std::size_t tag_directory = {};
+
+            /** Tags referenced by this tag */
+            std::vector<File::TagFilePath> dependencies;
+
+            /** Size of the tag file */
+            std::uint64_t file_size = 0;
+
+            /** Last modified time of the tag file */
+            std::int64_t modified_time = 0;
+
+            /** 64-bit FNV-1a hash of the tag file (0 if the tag was not hashed because it can't reference other tags) */
+            std::uint64_t hash = 0;
+
+            /** Tag class in the tag file's header */
+            TagFourCC header_fourcc = {};
+
+            /** Version in the tag file's header */
+            std::uint16_t header_version = 0;
+
+            /** CRC32 in the tag file's header */
+            std::uint32_t header_crc32 = 0;
+        };
+
+        /**
+         * Build an index of a virtual tags directory, parsing tags in parallel
+         * @param tags      tags to index (from File::load_virtual_tag_folder)
+         * @param job_count number of threads to use (0 = CPU thread count)
+         * @param previous  optional previous index; tags that are unchanged since then are not read again
+         * @return          index
+         */
+        static TagDependencyIndex index_virtual_tag_folder(const std::vector<File::TagFile> &tags, std::size_t job_count = 0, const TagDependencyIndex *previous = nullptr);
+
+        /**
+         * Build an index of a virtual tags directory using the index file in each tags directory, and then update the
+         * index files so only tags that changed need to be read next time
+         * @param tags             tags to index (from File::load_virtual_tag_folder)
+         * @param tags_directories tags directories the tags were loaded from
+         * @param job_count        number of threads to use (0 = CPU thread count)
+         * @return                 index
+         */
+        static TagDependencyIndex index_tags_directories(const std::vector<File::TagFile> &tags, const std::vector<std::filesystem::path> &tags_directories, std::size_t job_count = 0);
+
+        /**
+         * Load an index file
+         * @param path           path to the index file
+         * @param tags_directory tags directory the index file is for
+         * @param tag_directory  index of the tags directory
+         * @return               index, or std::nullopt if it could not be read or was made by a different version
+         */
+        static std::optional<TagDependencyIndex> load_index_file(const std::filesystem::path &path, const std::filesystem::path &tags_directory, std::size_t tag_directory = 0);
+
+        /**
+         * Save the tags in the given tags directory to an index file
+         * @param path          path to the index file
+         * @param tag_directory index of the tags directory
+         * @return              true if successful
+         */
+        bool save_index_file(const std::filesystem::path &path, std::size_t tag_directory = 0) const;
+
+        /**
+         * Check if tags of the given group can reference other tags at all
+         * @param fourcc group to check
+         * @return       true if it can
+         */
+        static bool tag_fourcc_can_have_dependencies(TagFourCC fourcc) noexcept;
+
+        /**
+         * Parse and add the tag to the index, replacing it if it's already indexed
+         * @param tag tag to add
+         * @return    true if the tag was parsed successfully
+         */
+        bool update_tag(const File::TagFile &tag);
+
+        /**
+         * Remove the tag from the index
+         * @param tag tag to remove (using Halo path separators)
+         */
+        void remove_tag(const File::TagFilePath &tag);
+
+        /**
+         * Get all tags that reference the given tag
+         * @param tag tag to look for (using Halo path separators)
+         * @return    referencing tags (using Halo path separators)
+         */
+        const std::set<File::TagFilePath> &get_referrers(const File::TagFilePath &tag) const noexcept;
+
+        /**
+         * Get all tags that the given tag references
+         * @param tag tag to look for (using Halo path separators)
+         * @return    referenced tags (using Halo path separators) or nullptr if the tag is not indexed
+         */
+        const std::vector<File::TagFilePath> *get_dependencies(const File::TagFilePath &tag) const noexcept;
+
+        /**
+         * Get the file path of an indexed tag
+         * @param tag tag to look for (using Halo path separators)
+         * @return    file path or nullptr if the tag is not indexed
+         */
+        const std::filesystem::path *get_file_path(const File::TagFilePath &tag) const noexcept;
+
+        /**
+         * Get everything indexed for a tag
+         * @param tag tag to look for (using Halo path separators)
+         * @return    indexed tag or nullptr if the tag is not indexed
+         */
+        const IndexedTag *get_tag(const File::TagFilePath &tag) const noexcept;
+
+        /**
+         * Get the number of tags indexed
+         * @return number of tags
+         */
+        std::size_t get_tag_count() const noexcept {
+            return this->tags.size();
+        }
+
+        /**
+         * Get the number of tags that failed to be parsed
+         * @return number of errors
+         */
+        std::size_t get_error_count() const noexcept {
+            return this->error_count;
+        }
+
+        /**
+         * Get the number of tags that were unchanged since the previous index and didn't need to be read
+         * @return number of tags reused
+         */
+        std::size_t get_reused_count() const noexcept {
+            return this->reused_count;
+        }
+
+    private:
+        /** All indexed tags */
+        std::map<File::TagFilePath, IndexedTag> tags;
+
+        /** Tags referencing each tag */
+        std::map<File::TagFilePath, std::set<File::TagFilePath>> referrers;
+
+        /** Number of tags that failed to be parsed */
+        std::size_t error_count = 0;
+
+        /** Number of tags reused from the previous index */
+        std::size_t reused_count = 0;
+
+        /**
+         * Add an already-parsed tag to the index
+         * @param path tag path
+         * @param tag  indexed tag
+         */
+        void add_tag(const File::TagFilePath &path, IndexedTag &&tag);
+    };
+}
+
+#endif
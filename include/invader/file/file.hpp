@@ -8,6 +8,9 @@
 #include <filesystem>
 #include <optional>
 #include <mutex>
+#include <functional>
+#include <cstdint>
+#include <string>
 
 #include "../hek/fourcc.hpp"
 
@@ -76,6 +79,40 @@ namespace Invader::File {
      */
     bool save_file(const std::filesystem::path &path, const std::vector<std::byte> &data);
 
+    /**
+     * Hash the data with 64-bit FNV-1a. This is only for detecting changes and is not cryptographically secure.
+     * @param  data data to hash
+     * @param  size size of the data in bytes
+     * @return      hash of the data
+     */
+    std::uint64_t hash_data(const void *data, std::size_t size) noexcept;
+
+    /**
+     * Hash the data with 64-bit FNV-1a. This is only for detecting changes and is not cryptographically secure.
+     * @param  data data to hash
+     * @return      hash of the data
+     */
+    inline std::uint64_t hash_data(const std::vector<std::byte> &data) noexcept {
+        return hash_data(data.data(), data.size());
+    }
+
+    /**
+     * Read a text file that remembers state between runs (such as a cache or an index), written with save_state_file()
+     * @param  path   path to the file
+     * @param  header header the file must start with; this should identify the tool and version so stale files are ignored
+     * @return        contents after the header, or std::nullopt if the file does not exist or has a different header
+     */
+    std::optional<std::string> open_state_file(const std::filesystem::path &path, const std::string &header);
+
+    /**
+     * Save a text file that remembers state between runs, only replacing the old file once the new one is fully written
+     * @param  path     path to the file
+     * @param  header   header to start the file with
+     * @param  contents contents after the header
+     * @return          true on success; false on failure
+     */
+    bool save_state_file(const std::filesystem::path &path, const std::string &header, const std::string &contents);
+
     /**
      * Convert a tag path to a file path for one tags directory. The file must exist, or std::nullopt will be returned.
      * @param  tag_path   tag path to use
@@ -163,9 +200,11 @@ namespace Invader::File {
      * @param  filter_duplicates filter out duplicates (by default)
      * @param  status            optional pointer to a size_t to store the current number of tags loaded (for status messages)
      * @param  errors            optional pointer to hold the number of errors
+     * @param  found             optional function called with all tags loaded so far and the number of tags just added to the end of it, called after each directory is listed
+     * @param  directories       optional pointer to hold every directory that was listed, including the tags directories themselves
      * @return                   all tags in the folder
      */
-    std::vector<TagFile> load_virtual_tag_folder(const std::vector<std::filesystem::path> &tags, bool filter_duplicates = true, std::pair<std::mutex, std::size_t> *status = nullptr, std::size_t *errors = nullptr);
+    std::vector<TagFile> load_virtual_tag_folder(const std::vector<std::filesystem::path> &tags, bool filter_duplicates = true, std::pair<std::mutex, std::size_t> *status = nullptr, std::size_t *errors = nullptr, const std::function<void (const std::vector<TagFile> &tags, std::size_t new_tags)> &found = nullptr, std::vector<std::filesystem::path> *directories = nullptr);
 
     /**
      * Convert the tag path to a path using the system's preferred separators
@@ -263,6 +302,65 @@ namespace Invader::File {
      * @return        true if a match was found
      */
     bool path_matches(const char *path, const std::vector<std::string> &include, const std::vector<std::string> &exclude) noexcept;
+    
+    /**
+     * Compiled set of include and exclude patterns (same syntax as path_matches)
+     *
+     * All patterns are compiled into a single automaton, so each path is checked against every pattern in one pass without
+     * backtracking. Construct this once and reuse it when checking many paths.
+     */
+    class PathMatcher {
+    public:
+        /**
+         * Compile the patterns
+         * @param include include patterns to check (empty matches all)
+         * @param exclude exclude patterns to check
+         */
+        PathMatcher(const std::vector<std::string> &include, const std::vector<std::string> &exclude);
+        
+        /**
+         * Check if the path matches
+         * @param path path to check
+         * @return     true if the path matches an include pattern (or there are none) and does not match any exclude pattern
+         */
+        bool matches(const char *path) const noexcept;
+        
+        /**
+         * Check if the path matches
+         * @param path path to check
+         * @return     true if the path matches an include pattern (or there are none) and does not match any exclude pattern
+         */
+        bool matches(const std::string &path) const noexcept {
+            return this->matches(path.c_str());
+        }
+        
+    private:
+        enum StateType : std::uint8_t {
+            STATE_LITERAL,
+            STATE_ANY,
+            STATE_SEPARATOR,
+            STATE_STAR,
+            STATE_ACCEPT_INCLUDE,
+            STATE_ACCEPT_EXCLUDE
+        };
+        
+        struct State {
+            StateType type;
+            char character;
+        };
+        
+        /** States of every pattern, each pattern terminated with an accept state */
+        std::vector<State> states;
+        
+        /** Active states before reading the first character */
+        std::vector<std::uint64_t> start_states;
+        
+        /** Whether there were no include patterns */
+        bool include_all;
+        
+        void add_state(std::uint64_t *set, std::size_t state) const noexcept;
+        void compile(const std::string &pattern, StateType accept);
+    };
 }
 
 #endif
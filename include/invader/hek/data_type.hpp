@@ -1052,6 +1052,38 @@ namespace Invader::HEK {
 
     std::uint32_t compress_vector(float i, float j, float k) noexcept;
 
+    /**
+     * Compress vectors in bulk; this gives the same result as compress_vector for each vector
+     * @param vectors    vectors to compress (i, j, and k of each vector)
+     * @param compressed array to write compressed vectors to
+     * @param count      number of vectors
+     */
+    void compress_vectors(const float *vectors, std::uint32_t *compressed, std::size_t count) noexcept;
+
+    /**
+     * Decompress vectors in bulk; this gives the same result as decompress_vector for each vector
+     * @param compressed compressed vectors
+     * @param vectors    array to write vectors to (i, j, and k of each vector)
+     * @param count      number of vectors
+     */
+    void decompress_vectors(const std::uint32_t *compressed, float *vectors, std::size_t count) noexcept;
+
+    /**
+     * Compress model vertices in bulk; this gives the same result as compress_model_vertex for each vertex
+     * @param vertices   vertices to compress
+     * @param compressed array to write compressed vertices to
+     * @param count      number of vertices
+     */
+    void compress_model_vertices(const ModelVertexUncompressed<NativeEndian> *vertices, ModelVertexCompressed<NativeEndian> *compressed, std::size_t count) noexcept;
+
+    /**
+     * Decompress model vertices in bulk; this gives the same result as decompress_model_vertex for each vertex
+     * @param compressed compressed vertices
+     * @param vertices   array to write vertices to
+     * @param count      number of vertices
+     */
+    void decompress_model_vertices(const ModelVertexCompressed<NativeEndian> *compressed, ModelVertexUncompressed<NativeEndian> *vertices, std::size_t count) noexcept;
+
     ScenarioStructureBSPMaterialCompressedRenderedVertex<NativeEndian> compress_sbsp_rendered_vertex(const ScenarioStructureBSPMaterialUncompressedRenderedVertex<NativeEndian> &vertex) noexcept;
     ScenarioStructureBSPMaterialUncompressedRenderedVertex<NativeEndian> decompress_sbsp_rendered_vertex(const ScenarioStructureBSPMaterialCompressedRenderedVertex<NativeEndian> &vertex) noexcept;
 
@@ -7,12 +7,118 @@
 #include <cstddef>
 #include <cstdint>
 #include <exception>
+#include <vector>
+#include <type_traits>
+#include <utility>
+
+#ifdef _MSC_VER
+#include <cstdlib>
+#endif
 
 namespace Invader::HEK {
     #define ENDIAN_TEMPLATE(tname) template <template<typename> class tname>
     #define COPY_THIS(what) copy . what = this -> what;
     #define COPY_THIS_ARRAY(what) for(std::size_t copy_this_array_iterator = 0; copy_this_array_iterator < sizeof(this -> what)/sizeof(this -> what[0]); copy_this_array_iterator++) { copy . what [copy_this_array_iterator] = this -> what [copy_this_array_iterator]; }
 
+    /**
+     * Reverse the byte order of an unsigned integer
+     * @param value value to swap
+     * @return      swapped value
+     */
+    template <typename U> inline U swap_endian_word(U value) noexcept {
+        static_assert(std::is_unsigned_v<U>);
+        if constexpr(sizeof(U) == 1) {
+            return value;
+        }
+        #if defined(__GNUC__) || defined(__clang__)
+        else if constexpr(sizeof(U) == 2) {
+            return __builtin_bswap16(value);
+        }
+        else if constexpr(sizeof(U) == 4) {
+            return __builtin_bswap32(value);
+        }
+        else if constexpr(sizeof(U) == 8) {
+            return __builtin_bswap64(value);
+        }
+        #elif defined(_MSC_VER)
+        else if constexpr(sizeof(U) == 2) {
+            return _byteswap_ushort(value);
+        }
+        else if constexpr(sizeof(U) == 4) {
+            return _byteswap_ulong(value);
+        }
+        else if constexpr(sizeof(U) == 8) {
+            return _byteswap_uint64(value);
+        }
+        #endif
+        else {
+            U swapped = 0;
+            for(std::size_t i = 0; i < sizeof(U); i++) {
+                swapped = static_cast<U>((swapped << 8) | ((value >> (i * 8)) & 0xFF));
+            }
+            return swapped;
+        }
+    }
+
+    /**
+     * Unsigned integer type with the given width in bytes
+     */
+    template <std::size_t width> using endian_word_t = std::conditional_t<width == 1, std::uint8_t, std::conditional_t<width == 2, std::uint16_t, std::conditional_t<width == 4, std::uint32_t, std::uint64_t>>>;
+
+    /**
+     * Reverse the byte order of an array of values in place. This is written so the compiler can vectorize it.
+     * @param data  pointer to the first value
+     * @param count number of values
+     */
+    template <std::size_t width> inline void swap_endian_words(std::byte *data, std::size_t count) noexcept {
+        static_assert(width == 1 || width == 2 || width == 4 || width == 8);
+        if constexpr(width > 1) {
+            using U = endian_word_t<width>;
+            for(std::size_t i = 0; i < count; i++) {
+                U word;
+                std::memcpy(&word, data + i * width, width);
+                word = swap_endian_word(word);
+                std::memcpy(data + i * width, &word, width);
+            }
+        }
+    }
+
+    /**
+     * Describes the layout of a record (e.g. an array of structs) for swapping its byte order in bulk
+     */
+    class EndianSwapMask {
+    public:
+        /**
+         * Append values to the end of the record. Adjacent values of the same width are merged.
+         * @param width width of each value in bytes (1, 2, 4, or 8)
+         * @param count number of values
+         */
+        void add(std::size_t width, std::size_t count);
+
+        /**
+         * Get the size of the record in bytes
+         * @return size of the record
+         */
+        std::size_t get_record_size() const noexcept {
+            return this->record_size;
+        }
+
+        /**
+         * Reverse the byte order of an array of records in place
+         * @param data         pointer to the first record
+         * @param record_count number of records
+         */
+        void swap(std::byte *data, std::size_t record_count) const noexcept;
+
+    private:
+        struct Run {
+            std::size_t width;
+            std::size_t count;
+        };
+        std::vector<Run> runs;
+        std::size_t record_size = 0;
+    };
+
     /**
      * This is a simple interface for reading/writing swapped endian data
      */
@@ -27,11 +133,21 @@ namespace Invader::HEK {
          * @return the value in host endian
          */
         T read() const noexcept {
-            std::byte value_copy_byte[sizeof(T)];
-            for(std::size_t i = 0; i < sizeof(T); i++) {
-                value_copy_byte[i] = value[sizeof(T) - (i + 1)];
+            T copy;
+            if constexpr(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8) {
+                endian_word_t<sizeof(T)> word;
+                std::memcpy(&word, this->value, sizeof(T));
+                word = swap_endian_word(word);
+                std::memcpy(&copy, &word, sizeof(T));
+            }
+            else {
+                std::byte value_copy_byte[sizeof(T)];
+                for(std::size_t i = 0; i < sizeof(T); i++) {
+                    value_copy_byte[i] = value[sizeof(T) - (i + 1)];
+                }
+                std::memcpy(&copy, value_copy_byte, sizeof(T));
             }
-            return *reinterpret_cast<const T *>(value_copy_byte);
+            return copy;
         }
 
         /**
@@ -47,7 +163,15 @@ namespace Invader::HEK {
          * @param new_value value to overwrite
          */
         void write(const T &new_value) noexcept {
-            *reinterpret_cast<T *>(this->value) = reinterpret_cast<const SwappedEndian<T> *>(&new_value)->read();
+            std::memcpy(this->value, &new_value, sizeof(T));
+            if constexpr(sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8) {
+                swap_endian_words<sizeof(T)>(this->value, 1);
+            }
+            else {
+                for(std::size_t i = 0; i < sizeof(T) / 2; i++) {
+                    std::swap(this->value[i], this->value[sizeof(T) - (i + 1)]);
+                }
+            }
         }
 
         /**
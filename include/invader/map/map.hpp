@@ -313,6 +313,14 @@ namespace Invader {
          */
         bool is_clean() const noexcept;
         
+        /**
+         * Do a basic check to ensure the map hasn't been improperly modified or corrupted using an already calculated CRC32 and protection check
+         * @param crc32        CRC32 of the map (from get_crc32())
+         * @param is_protected whether or not the map is protected (from is_protected())
+         * @return             true if the map is clean
+         */
+        bool is_clean(std::uint32_t crc32, bool is_protected) const noexcept;
+        
         /**
          * Get the game engine
          * @return game engine
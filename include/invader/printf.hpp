@@ -16,6 +16,10 @@ bool is_on_color_term() noexcept;
 #include <cstdlib>
 #include <cstring>
 #include <cstdio>
+#include <cstdarg>
+#include <string>
+#include <utility>
+#include <vector>
 
 #define eprintf(...) std::fprintf(stderr, __VA_ARGS__)
 #define oprintf(...) std::fprintf(stdout, __VA_ARGS__)
@@ -89,4 +93,83 @@ else {\
     oprintf("\n"); \
 }
 
+namespace Invader {
+    /**
+     * Output held so it can be printed later all at once, such as when work is done on multiple threads but printed in order
+     */
+    class BufferedOutput {
+    public:
+        enum OutputType {
+            /** Print to stdout as-is (oprintf) */
+            OUTPUT_PLAIN,
+
+            /** Print to stderr as-is (eprintf) */
+            OUTPUT_PLAIN_ERROR,
+
+            /** Print with oprintf_success */
+            OUTPUT_SUCCESS,
+
+            /** Print with oprintf_success_warn */
+            OUTPUT_SUCCESS_WARN,
+
+            /** Print with oprintf_success_lesser_warn */
+            OUTPUT_SUCCESS_LESSER_WARN,
+
+            /** Print with oprintf_fail */
+            OUTPUT_FAIL,
+
+            /** Print with eprintf_warn */
+            OUTPUT_WARN,
+
+            /** Print with eprintf_error */
+            OUTPUT_ERROR
+        };
+
+        /**
+         * Format and hold a message
+         * @param type type of message (decides how it is printed)
+         * @param fmt  printf format
+         */
+        void print(OutputType type, const char *fmt, ...);
+
+        /**
+         * Format and hold a message
+         * @param type type of message (decides how it is printed)
+         * @param fmt  printf format
+         * @param args printf arguments
+         */
+        void vprint(OutputType type, const char *fmt, std::va_list args);
+
+        /**
+         * Format a message and hold it in output, or print it now if output is null
+         * @param output output to hold the message in (or nullptr)
+         * @param type   type of message (decides how it is printed)
+         * @param fmt    printf format
+         */
+        static void print_to(BufferedOutput *output, OutputType type, const char *fmt, ...);
+
+        /**
+         * Print everything held and clear it
+         */
+        void flush();
+
+        /**
+         * Get everything held as it would be printed without colors (messages printed with a color end with a newline)
+         * @return text
+         */
+        std::string to_string() const;
+
+        /**
+         * Get whether nothing is held
+         * @return true if nothing is held
+         */
+        bool empty() const noexcept {
+            return this->messages.empty();
+        }
+
+    private:
+        std::vector<std::pair<OutputType, std::string>> messages;
+    };
+}
+
 #endif
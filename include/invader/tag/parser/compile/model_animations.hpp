@@ -3,6 +3,8 @@
 #ifndef INVADER__TAG__PARSER__COMPILE__MODEL_ANIMATIONS_HPP
 #define INVADER__TAG__PARSER__COMPILE__MODEL_ANIMATIONS_HPP
 
+#include "../../../hek/endian.hpp"
+
 namespace Invader::Parser {
     struct ModelAnimationsAnimation;
 
@@ -18,6 +20,14 @@ namespace Invader::Parser {
      * @param animation animation
      */
     std::size_t expected_uncompressed_frame_size_for_animation(ModelAnimationsAnimation &animation) noexcept;
+
+    /**
+     * Get the layout of one uncompressed frame (or the default data) for swapping its endianness.
+     * @param animation    animation
+     * @param default_data use the nodes stored in the default data rather than the frame data
+     * @return             swap mask
+     */
+    HEK::EndianSwapMask animation_frame_endian_swap_mask(ModelAnimationsAnimation &animation, bool default_data);
 }
 
 #endif
@@ -10,6 +10,10 @@
 #include <optional>
 #include <variant>
 #include <memory>
+#include <span>
+#include <iterator>
+#include <functional>
+#include <string_view>
 #include "../hek/definition.hpp"
 
 namespace Invader {
@@ -122,6 +126,20 @@ namespace Invader::Parser {
         }
     };
 
+    /**
+     * Non-zero byte found in the padding or unused fields of a struct
+     */
+    struct PaddingScanResult {
+        /** Name of the struct */
+        const char *struct_name;
+
+        /** Offset of the byte in the struct */
+        std::size_t offset;
+
+        /** Value of the byte */
+        std::uint8_t value;
+    };
+
     class ParserStructValue {
     public:
         enum ValueType {
@@ -214,7 +232,7 @@ namespace Invader::Parser {
          * @return the comment
          */
         const char *get_comment() const noexcept {
-            return this->comment;
+            return this->descriptor->comment;
         }
         
         /**
@@ -222,7 +240,7 @@ namespace Invader::Parser {
          * @return minimum value or nullopt if there is no minimum
          */
         std::optional<Number> get_minimum() const noexcept {
-            return this->minimum;
+            return this->descriptor->minimum;
         }
         
         /**
@@ -230,7 +248,7 @@ namespace Invader::Parser {
          * @return maximum value or nullopt if there is no maximum
          */
         std::optional<Number> get_maximum() const noexcept {
-            return this->maximum;
+            return this->descriptor->maximum;
         }
 
         /**
@@ -270,7 +288,7 @@ namespace Invader::Parser {
          * @return value type
          */
         ValueType get_type() const noexcept {
-            return this->type;
+            return this->descriptor->type;
         }
 
         /**
@@ -278,7 +296,7 @@ namespace Invader::Parser {
          * @return name of the value
          */
         const char *get_name() const noexcept {
-            return this->name;
+            return this->descriptor->name;
         }
 
         /**
@@ -286,7 +304,7 @@ namespace Invader::Parser {
          * @return member name of the value
          */
         const char *get_member_name() const noexcept {
-            return this->member_name;
+            return this->descriptor->member_name;
         }
 
         /**
@@ -302,7 +320,7 @@ namespace Invader::Parser {
          * @return unit
          */
         const char *get_unit() const noexcept {
-            return this->unit;
+            return this->descriptor->unit;
         }
         
         /**
@@ -310,7 +328,7 @@ namespace Invader::Parser {
          * @return volatile
          */
         bool is_volatile() const noexcept {
-            return this->volatile_value;
+            return this->descriptor->volatile_value;
         }
 
         /**
@@ -329,7 +347,7 @@ namespace Invader::Parser {
          * @return       object in array
          */
         ParserStruct &get_object_in_array(std::size_t index) {
-            return this->get_object_in_array_fn(index, this->address);
+            return this->descriptor->get_object_in_array_fn(index, this->address);
         }
 
         /**
@@ -346,7 +364,7 @@ namespace Invader::Parser {
          * @return number of elements in array
          */
         std::size_t get_array_size() const noexcept {
-            return this->get_array_size_fn(this->address);
+            return this->descriptor->get_array_size_fn(this->address);
         }
 
         /**
@@ -354,7 +372,7 @@ namespace Invader::Parser {
          * @return minimum number of elements in array
          */
         std::size_t get_array_minimum_size() const noexcept {
-            return this->min_array_size;
+            return this->descriptor->min_array_size;
         }
 
         /**
@@ -362,7 +380,7 @@ namespace Invader::Parser {
          * @return maximum number of elements in array
          */
         std::size_t get_array_maximum_size() const noexcept {
-            return this->max_array_size;
+            return this->descriptor->max_array_size;
         }
 
         /**
@@ -371,7 +389,7 @@ namespace Invader::Parser {
          * @param count number of objects to delete
          */
         void delete_objects_in_array(std::size_t index, std::size_t count) {
-            return this->delete_objects_in_array_fn(index, count, this->address);
+            return this->descriptor->delete_objects_in_array_fn(index, count, this->address);
         }
 
         /**
@@ -380,7 +398,7 @@ namespace Invader::Parser {
          * @param count number of objects to create
          */
         void insert_objects_in_array(std::size_t index, std::size_t count) {
-            return this->insert_objects_in_array_fn(index, count, this->address);
+            return this->descriptor->insert_objects_in_array_fn(index, count, this->address);
         }
 
         /**
@@ -390,7 +408,7 @@ namespace Invader::Parser {
          * @param count      number of objects to create
          */
         void duplicate_objects_in_array(std::size_t index_from, std::size_t index_to, std::size_t count) {
-            return this->duplicate_objects_in_array_fn(index_from, index_to, count, this->address);
+            return this->descriptor->duplicate_objects_in_array_fn(index_from, index_to, count, this->address);
         }
 
         /**
@@ -400,7 +418,7 @@ namespace Invader::Parser {
          * @param count      number of objects to create
          */
         void swap_objects_in_array(std::size_t index_from, std::size_t index_to, std::size_t count) {
-            return this->swap_objects_in_array_fn(index_from, index_to, count, this->address);
+            return this->descriptor->swap_objects_in_array_fn(index_from, index_to, count, this->address);
         }
 
         /**
@@ -408,7 +426,7 @@ namespace Invader::Parser {
          * @return is bounds
          */
         bool is_bounds() const noexcept {
-            return this->bounds;
+            return this->descriptor->bounds;
         }
 
         /**
@@ -432,7 +450,7 @@ namespace Invader::Parser {
          * @return enum
          */
         const char *read_enum() const {
-            return this->read_enum_fn(address);
+            return this->descriptor->read_enum_fn(this->address);
         }
 
         /**
@@ -440,7 +458,7 @@ namespace Invader::Parser {
          * @param value value to write
          */
         void write_enum(const char *value) {
-            this->write_enum_fn(value, address);
+            this->descriptor->write_enum_fn(value, this->address);
         }
 
         /**
@@ -449,7 +467,7 @@ namespace Invader::Parser {
          * @return value
          */
         bool read_bitfield(const char *field) const {
-            return this->read_bitfield_fn(field, address);
+            return this->descriptor->read_bitfield_fn(field, this->address);
         }
 
         /**
@@ -458,7 +476,7 @@ namespace Invader::Parser {
          * @param  value value name
          */
         void write_bitfield(const char *field, bool value) {
-            this->write_bitfield_fn(field, value, address);
+            this->descriptor->write_bitfield_fn(field, value, this->address);
         }
 
         /**
@@ -474,7 +492,7 @@ namespace Invader::Parser {
          * @return all enum values
          */
         std::vector<const char *> list_enum() const noexcept {
-            return this->list_enum_fn();
+            return this->descriptor->list_enum_fn();
         }
 
         /**
@@ -482,7 +500,7 @@ namespace Invader::Parser {
          * @return all enum values
          */
         std::vector<const char *> list_enum_pretty() const noexcept {
-            return this->list_enum_pretty_fn();
+            return this->descriptor->list_enum_pretty_fn();
         }
 
         using get_object_in_array_fn_type = ParserStruct &(*)(std::size_t index, void *addr);
@@ -708,8 +726,8 @@ namespace Invader::Parser {
          * Get all of the allowed classes of the dependency
          * @return all allowed classes
          */
-        const std::vector<TagFourCC> &get_allowed_classes() const noexcept {
-            return this->allowed_classes;
+        std::span<const TagFourCC> get_allowed_classes() const noexcept {
+            return std::span<const TagFourCC>(this->descriptor->allowed_classes, this->descriptor->allowed_class_count);
         }
 
         /**
@@ -717,213 +735,109 @@ namespace Invader::Parser {
          * @return true if value is read only
          */
         bool is_read_only() const noexcept {
-            return this->read_only;
+            return this->descriptor->read_only;
+        }
+
+        using get_address_fn_type = void *(*)(ParserStruct &object);
+
+        /**
+         * Get the address of the member in the struct (for get_address_fn)
+         * @param  object struct to get the member of
+         * @return        address of the member
+         */
+        template <typename T, auto member>
+        static void *get_address_template(ParserStruct &object) {
+            return &(static_cast<T &>(object).*member);
+        }
+
+        /**
+         * Description of a value in a struct type. These are generated as static tables, one per struct type, and they are
+         * shared by every instance of that type.
+         */
+        struct Descriptor {
+            /** Type of value */
+            ValueType type;
+
+            /** Name of the value */
+            const char *name = nullptr;
+
+            /** Variable name of the value in the definitions struct */
+            const char *member_name = nullptr;
+
+            /** Comments */
+            const char *comment = nullptr;
+
+            /** Function for getting the address of the value in the struct (nullptr if this is a group start) */
+            get_address_fn_type get_address_fn = nullptr;
+
+            /** Array of allowed classes (dependencies only) */
+            const TagFourCC *allowed_classes = nullptr;
+
+            /** Number of allowed classes in the array */
+            std::size_t allowed_class_count = 0;
+
+            /** Number of values (if multiple values or bounds) */
+            std::size_t count = 1;
+
+            /** Whether or not this is bounds */
+            bool bounds = false;
+
+            /** Unit to use */
+            const char *unit = nullptr;
+
+            /** Optional minimum value */
+            std::optional<Number> minimum = std::nullopt;
+
+            /** Optional maximum value */
+            std::optional<Number> maximum = std::nullopt;
+
+            get_object_in_array_fn_type get_object_in_array_fn = nullptr;
+            get_array_size_fn_type get_array_size_fn = nullptr;
+            delete_objects_in_array_fn_type delete_objects_in_array_fn = nullptr;
+            insert_objects_in_array_fn_type insert_objects_in_array_fn = nullptr;
+            duplicate_objects_in_array_fn_type duplicate_objects_in_array_fn = nullptr;
+            swap_objects_in_array_fn_type swap_objects_in_array_fn = nullptr;
+
+            list_enum_fn_type list_enum_fn = nullptr;
+            list_enum_fn_type list_enum_pretty_fn = nullptr;
+            read_enum_fn_type read_enum_fn = nullptr;
+            write_enum_fn_type write_enum_fn = nullptr;
+            read_bitfield_fn_type read_bitfield_fn = nullptr;
+            write_bitfield_fn_type write_bitfield_fn = nullptr;
+
+            /** Minimum number of elements in the array */
+            std::size_t min_array_size = 0;
+
+            /** Maximum number of elements in the array */
+            std::size_t max_array_size = 0;
+
+            /** Value is volatile */
+            bool volatile_value = false;
+
+            /** Value is read only */
+            bool read_only = false;
+        };
+
+        /**
+         * Get the descriptor of the value
+         * @return descriptor
+         */
+        const Descriptor &get_descriptor() const noexcept {
+            return *this->descriptor;
         }
 
         /**
-         * Instantiate a ParserStructValue with a group start
-         * @param name    name of the group
-         * @param comment comments
-         */
-        ParserStructValue(
-            const char *name,
-            const char *comment
-        );
-
-        /**
-         * Instantiate a ParserStructValue with a dependency
-         * @param name            name of the dependency
-         * @param member_name     variable name of the dependency
-         * @param comment         comments
-         * @param dependency      pointer to the dependency
-         * @param allowed_classes array of allowed classes
-         * @param count           number of allowed classes in array
-         * @param read_only       value is read only
-         */
-        ParserStructValue(
-            const char *       name,
-            const char *       member_name,
-            const char *       comment,
-            Dependency *       dependency,
-            const TagFourCC *allowed_classes,
-            std::size_t        count,
-            bool               read_only
-        );
-
-        /**
-         * Instantiate a ParserStructValue with an array
-         * @param name                          name of the array
-         * @param member_name                   variable name of the array
-         * @param comment                       comments
-         * @param array                         pointer to the array
-         * @param get_object_in_array_fn        pointer to function for getting object in array
-         * @param get_array_size_fn             pointer to function for getting the size of array
-         * @param delete_objects_in_array_fn    pointer to function for deleting objects from an array
-         * @param insert_objects_in_array_fn    pointer to function for inserting objects in an array
-         * @param duplicate_objects_in_array_fn pointer to function for duplicating objects in an array
-         * @param swap_objects_in_array_fn      pointer to function for swapping objects in an array
-         * @param minimum_array_size            minimum number of elements in the array
-         * @param maximum_array_size            maximum number of elements in the array
-         * @param read_only                     value is read only
-         */
-        ParserStructValue(
-            const char *                        name,
-            const char *                        member_name,
-            const char *                        comment,
-            void *                              array,
-            get_object_in_array_fn_type         get_object_in_array_fn,
-            get_array_size_fn_type              get_array_size_fn,
-            delete_objects_in_array_fn_type     delete_objects_in_array_fn,
-            insert_objects_in_array_fn_type     insert_objects_in_array_fn,
-            duplicate_objects_in_array_fn_type  duplicate_objects_in_array_fn,
-            swap_objects_in_array_fn_type       swap_objects_in_array_fn,
-            std::size_t                         minimum_array_size,
-            std::size_t                         maximum_array_size,
-            bool                                read_only
-        );
-
-        /**
-         * Instantiate a ParserStructValue with a TagString
-         * @param name        name of the value
-         * @param member_name variable name of the value
-         * @param comment     comments
-         * @param string      pointer to string
-         * @param read_only   value is read only
-         */
-        ParserStructValue(
-            const char *    name,
-            const char *    member_name,
-            const char *    comment,
-            HEK::TagString *string,
-            bool            read_only
-        );
-
-        /**
-         * Instantiate a ParserStructValue with a TagDataOffset
-         * @param name        name of the value
-         * @param member_name variable name of the value
-         * @param comment     comments
-         * @param offset      pointer to offset
-         * @param read_only   value is read only
-         */
-        ParserStructValue(
-            const char *            name,
-            const char *            member_name,
-            const char *            comment,
-            std::vector<std::byte> *offset,
-            bool                    read_only
-        );
-
-        /**
-         * Instantiate a ParserStructValue with a TagEnum
-         * @param name                 name of the value
-         * @param member_name          variable name of the value
-         * @param comment              comments
-         * @param value                pointer to value
-         * @param list_enum_fn         pointer to function for listing enums
-         * @param list_enum_pretty_fn  pointer to function for listing enums with definition naming
-         * @param read_enum_fn         pointer to function for reading enums
-         * @param write_enum_fn        pointer to function for writing enums
-         * @param read_only            value is read only
-         */
-        ParserStructValue(
-            const char *       name,
-            const char *       member_name,
-            const char *       comment,
-            void *             value,
-            list_enum_fn_type  list_enum_fn,
-            list_enum_fn_type  list_enum_pretty_fn,
-            read_enum_fn_type  read_enum_fn,
-            write_enum_fn_type write_enum_fn,
-            bool               read_only
-        );
-
-        /**
-         * Instantiate a ParserStructValue with a bitfield
-         * @param name                 name of the value
-         * @param member_name          variable name of the value
-         * @param comment              comments
-         * @param value                pointer to value
-         * @param list_enum_fn         pointer to function for listing enums
-         * @param list_enum_pretty_fn  pointer to function for listing enums with definition naming
-         * @param read_bitfield_fn     pointer to function for reading enums
-         * @param write_bitfield_fn    pointer to function for writing enums
-         * @param read_only            value is read only
-         */
-        ParserStructValue(
-            const char *           name,
-            const char *           member_name,
-            const char *           comment,
-            void *                 value,
-            list_enum_fn_type      list_enum_fn,
-            list_enum_fn_type      list_enum_pretty_fn,
-            read_bitfield_fn_type  read_bitfield_fn,
-            write_bitfield_fn_type write_bitfield_fn,
-            bool                   read_only
-        );
-
-        /**
-         * Instantiate a ParserStructValue with a value
-         * @param name           name of the value
-         * @param member_name    variable name of the value
-         * @param comment        comments
-         * @param object         pointer to the object
-         * @param type           type of value
-         * @param unit           unit to use
-         * @param count          number of values (if multiple values or bounds)
-         * @param bounds         whether or not this is bounds
-         * @param volatile_value value is volatile
-         * @param read_only      value is read only
-         * @param minimum        optional minimum value
-         * @param maximum        optional maximum value
-         */
-        ParserStructValue(
-            const char *          name,
-            const char *          member_name,
-            const char *          comment,
-            void *                object,
-            ValueType             type,
-            const char *          unit = nullptr,
-            std::size_t           count = 1,
-            bool                  bounds = false,
-            bool                  volatile_value = false,
-            bool                  read_only = false,
-            std::optional<Number> minimum = std::nullopt,
-            std::optional<Number> maximum = std::nullopt
-        );
+         * Instantiate a ParserStructValue
+         * @param descriptor descriptor of the value (must outlive this)
+         * @param object     struct containing the value
+         */
+        ParserStructValue(const Descriptor &descriptor, ParserStruct &object) noexcept :
+            descriptor(&descriptor),
+            address(descriptor.get_address_fn ? descriptor.get_address_fn(object) : nullptr) {}
 
     private:
-        const char *name = nullptr;
-        const char *member_name = nullptr;
-        const char *comment = nullptr;
-        ValueType type;
+        const Descriptor *descriptor;
         void *address;
-        std::vector<TagFourCC> allowed_classes;
-        std::size_t count = 1;
-        bool bounds = false;
-        const char *unit = nullptr;
-        std::optional<Number> minimum;
-        std::optional<Number> maximum;
-
-        get_object_in_array_fn_type get_object_in_array_fn = nullptr;
-        get_array_size_fn_type get_array_size_fn = nullptr;
-        delete_objects_in_array_fn_type delete_objects_in_array_fn = nullptr;
-        insert_objects_in_array_fn_type insert_objects_in_array_fn = nullptr;
-        duplicate_objects_in_array_fn_type duplicate_objects_in_array_fn = nullptr;
-        swap_objects_in_array_fn_type swap_objects_in_array_fn = nullptr;
-
-        list_enum_fn_type list_enum_fn = nullptr;
-        list_enum_fn_type list_enum_pretty_fn = nullptr;
-        read_enum_fn_type read_enum_fn = nullptr;
-        write_enum_fn_type write_enum_fn = nullptr;
-        read_bitfield_fn_type read_bitfield_fn = nullptr;
-        write_bitfield_fn_type write_bitfield_fn = nullptr;
-
-        std::size_t min_array_size;
-        std::size_t max_array_size;
-
-        bool volatile_value = false;
-        bool read_only = false;
 
         template <typename T>
         static void assert_range_exists(std::size_t index, std::size_t count, const T &array) {
@@ -939,6 +853,95 @@ namespace Invader::Parser {
         }
     };
 
+    /**
+     * Values of a struct, made from the struct type's descriptors. This does not allocate anything.
+     */
+    class ParserStructValues {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = ParserStructValue;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = ParserStructValue;
+
+            ParserStructValue operator*() const noexcept {
+                return ParserStructValue(*this->descriptor, *this->object);
+            }
+
+            iterator &operator++() noexcept {
+                this->descriptor++;
+                return *this;
+            }
+
+            iterator operator++(int) noexcept {
+                auto copy = *this;
+                this->descriptor++;
+                return copy;
+            }
+
+            bool operator==(const iterator &other) const noexcept {
+                return this->descriptor == other.descriptor;
+            }
+
+            bool operator!=(const iterator &other) const noexcept {
+                return this->descriptor != other.descriptor;
+            }
+
+            iterator() noexcept = default;
+            iterator(const ParserStructValue::Descriptor *descriptor, ParserStruct *object) noexcept : descriptor(descriptor), object(object) {}
+
+        private:
+            const ParserStructValue::Descriptor *descriptor = nullptr;
+            ParserStruct *object = nullptr;
+        };
+
+        /**
+         * Get the number of values
+         * @return number of values
+         */
+        std::size_t size() const noexcept {
+            return this->descriptors.size();
+        }
+
+        /**
+         * Get whether there are no values
+         * @return true if there are no values
+         */
+        bool empty() const noexcept {
+            return this->descriptors.empty();
+        }
+
+        /**
+         * Get the value at the index
+         * @param  index index of the value
+         * @return       value
+         */
+        ParserStructValue operator[](std::size_t index) const noexcept {
+            return ParserStructValue(this->descriptors[index], *this->object);
+        }
+
+        iterator begin() const noexcept {
+            return iterator(this->descriptors.data(), this->object);
+        }
+
+        iterator end() const noexcept {
+            return iterator(this->descriptors.data() + this->descriptors.size(), this->object);
+        }
+
+        /**
+         * Instantiate a ParserStructValues
+         * @param descriptors descriptors of the struct type
+         * @param object      struct to get the values of
+         */
+        ParserStructValues(std::span<const ParserStructValue::Descriptor> descriptors, ParserStruct &object) noexcept : descriptors(descriptors), object(&object) {}
+
+    private:
+        std::span<const ParserStructValue::Descriptor> descriptors;
+        ParserStruct *object;
+    };
+
     struct ParserStruct {
         /**
          * Get whether or not the data is formatted for cache files.
@@ -955,6 +958,20 @@ namespace Invader::Parser {
          */
         static std::unique_ptr<ParserStruct> parse_hek_tag_file(const std::byte *data, std::size_t data_size, bool postprocess = false);
 
+        /**
+         * Function called for each dependency found when scanning a tag; the path uses Halo path separators and is not null terminated
+         */
+        using DependencyCallback = std::function<void (TagFourCC tag_fourcc, std::string_view path)>;
+
+        /**
+         * Find the dependencies in a HEK tag file without parsing it. Only dependencies with a path are found.
+         * @param data       Tag file data to read from
+         * @param data_size  Size of the tag file
+         * @param callback   Function to call for each dependency found
+         * @param cache_only Only find dependencies that are compiled into cache files (skip non-cached and compile-ignored fields)
+         */
+        static void scan_hek_tag_dependencies(const std::byte *data, std::size_t data_size, const DependencyCallback &callback, bool cache_only = false);
+
         /**
          * Generate a tag base struct
          * @param  tag_class tag class
@@ -1065,16 +1082,24 @@ namespace Invader::Parser {
          * Get the values in the struct
          * @return values in the struct
          */
-        std::vector<ParserStructValue> &get_values();
+        ParserStructValues get_values() noexcept {
+            return ParserStructValues(this->get_value_descriptors(), *this);
+        }
 
         /**
          * Get the values in the struct
          * @return values in the struct
          */
-        const std::vector<ParserStructValue> &get_values() const {
+        const ParserStructValues get_values() const noexcept {
             return const_cast<ParserStruct *>(this)->get_values();
         }
 
+        /**
+         * Get the descriptors of the values of the struct type
+         * @return descriptors of the values
+         */
+        virtual std::span<const ParserStructValue::Descriptor> get_value_descriptors() const noexcept = 0;
+
         /**
          * Get whether or not the struct has a title
          * @return true if struct has title
@@ -1111,20 +1136,11 @@ namespace Invader::Parser {
         }
 
         virtual ~ParserStruct() = default;
-        
-        ParserStruct() = default;
-        ParserStruct(const ParserStruct &) noexcept;
-        ParserStruct(ParserStruct &&) noexcept;
-        ParserStruct &operator=(const ParserStruct &) noexcept;
     protected:
         bool cache_formatted = false;
         
-        virtual std::vector<ParserStructValue> get_values_internal() = 0;
-        
     private:
         bool compare(const ParserStruct *what, bool precision, bool ignore_volatile, std::list<std::string> *differences, std::size_t depth) const;
-        
-        std::optional<std::vector<ParserStructValue>> values;
     };
 }
 
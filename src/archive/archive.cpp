@@ -3,13 +3,19 @@
 #include <vector>
 #include <string>
 #include <filesystem>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
 #include <archive.h>
 #include <archive_entry.h>
 #include <invader/version.hpp>
 #include <invader/printf.hpp>
-#include <invader/build/build_workload.hpp>
-#include <invader/map/map.hpp>
+#include <invader/hek/map.hpp>
 #include <invader/dependency/found_tag_dependency.hpp>
+#include <invader/dependency/tag_dependency_closure.hpp>
+#include <invader/tag/parser/parser_struct.hpp>
 #include "../command_line_option.hpp"
 #include <invader/file/file.hpp>
 
@@ -18,14 +24,23 @@ struct Format {
     const char *extension;
     int (*filter)(archive *a);
     int (*format)(archive *a);
+    bool multithreaded_filter;
 };
 
 static const constexpr Format formats[] = {
-    {"7z", ".7z", nullptr, archive_write_set_format_7zip},
-    {"tar-gz", ".tar.xz", archive_write_add_filter_gzip, archive_write_set_format_pax_restricted},
-    {"tar-xz", ".tar.xz", archive_write_add_filter_xz, archive_write_set_format_pax_restricted},
-    {"tar-zst", ".tar.zst", archive_write_add_filter_zstd, archive_write_set_format_pax_restricted},
-    {"zip", ".zip", nullptr, archive_write_set_format_zip}
+    {"7z", ".7z", nullptr, archive_write_set_format_7zip, false},
+    {"tar-gz", ".tar.xz", archive_write_add_filter_gzip, archive_write_set_format_pax_restricted, false},
+    {"tar-xz", ".tar.xz", archive_write_add_filter_xz, archive_write_set_format_pax_restricted, true},
+    {"tar-zst", ".tar.zst", archive_write_add_filter_zstd, archive_write_set_format_pax_restricted, true},
+    {"zip", ".zip", nullptr, archive_write_set_format_zip, false}
+};
+
+// Number of tags that can be read ahead of the archive writer
+static constexpr std::size_t PREFETCH_TAG_COUNT = 64;
+
+struct PrefetchedTag {
+    std::optional<std::vector<std::byte>> data;
+    std::time_t modified;
 };
 
 static std::string list_formats() {
@@ -54,6 +69,7 @@ int main(int argc, const char **argv) {
         bool copy = false;
         bool verbose = false;
         bool overwrite = false;
+        std::size_t max_threads = 0;
         std::optional<HEK::GameEngine> engine;
         const Format *format = &formats[0];
     } archive_options;
@@ -75,7 +91,8 @@ int main(int argc, const char **argv) {
         CommandLineOption("output", 'o', 1, "Output to a specific file. Extension must be .tar.xz unless using --copy which then it's a directory.", "<file>"),
         CommandLineOption("fs-path", 'P', 0, "Use a filesystem path for the tag."),
         CommandLineOption("copy", 'C', 0, "Copy instead of making an archive."),
-        CommandLineOption("verbose", 'v', 0, "Print whether or not tags are omitted. Do verbose comparisons.")
+        CommandLineOption("verbose", 'v', 0, "Print whether or not tags are omitted. Do verbose comparisons."),
+        CommandLineOption("threads", 'j', 1, "Set the number of threads to use for finding dependencies, reading and comparing tags, and compressing tar-xz and tar-zst archives. Default: CPU thread count")
     };
 
     auto remaining_arguments = CommandLineOption::parse_arguments<ArchiveOptions &>(argc, argv, options, USAGE, DESCRIPTION, 1, 1, archive_options, [](char opt, const auto &arguments, auto &archive_options) {
@@ -136,6 +153,19 @@ int main(int argc, const char **argv) {
             case 'C':
                 archive_options.copy = true;
                 break;
+            case 'j':
+                try {
+                    archive_options.max_threads = std::stoul(arguments[0]);
+                }
+                catch(std::exception &) {
+                    eprintf_error("Invalid number of threads %s", arguments[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                if(archive_options.max_threads < 1) {
+                    eprintf_error("Invalid number of threads %s", arguments[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                break;
         }
     });
 
@@ -145,6 +175,10 @@ int main(int argc, const char **argv) {
         return EXIT_FAILURE;
     }
 
+    if(archive_options.max_threads == 0) {
+        archive_options.max_threads = std::thread::hardware_concurrency() < 1 ? 1 : std::thread::hardware_concurrency();
+    }
+
     // No tags folder? Use tags in current directory
     if(archive_options.tags.size() == 0) {
         archive_options.tags.emplace_back("tags");
@@ -214,84 +248,19 @@ int main(int argc, const char **argv) {
     File::remove_duplicate_slashes_chars(base_tag.data());
 
     if(!archive_options.single_tag) {
-        // Build the map
-        std::vector<std::byte> map;
-
-        try {
-            BuildWorkload::BuildParameters parameters(*archive_options.engine);
-            parameters.scenario = base_tag;
-            parameters.tags_directories = archive_options.tags;
-            parameters.use_tags_for_script_data = true; // TODODILE: use data folder and implement tags/ and data/ split in output archive
-            if(parameters.details.build_cache_file_engine == HEK::CacheFileEngine::CACHE_FILE_XBOX) {
-                parameters.details.build_compression_level = 0;
-            }
-            if(parameters.details.build_cache_file_engine != HEK::CacheFileEngine::CACHE_FILE_NATIVE) {
-                parameters.details.build_maximum_cache_file_size = UINT32_MAX;
-            }
-            parameters.verbosity = BuildWorkload::BuildParameters::BUILD_VERBOSITY_QUIET;
-
-            map = BuildWorkload::compile_map(parameters);
-        }
-        catch(std::exception &e) {
-            eprintf_error("Failed to compile scenario %s into a map: %s", base_tag.c_str(), e.what());
-            return EXIT_FAILURE;
-        }
-
-        // Parse the map
-        std::unique_ptr<Map> parsed_map;
+        // Find everything the map would use without building it
+        std::vector<TagDependencyClosure::ClosureTag> closure;
         try {
-            parsed_map = std::make_unique<Map>(Map::map_with_move(std::move(map)));
+            closure = TagDependencyClosure::find_cache_file_dependencies(base_tag, HEK::GameEngineInfo::get_game_engine_info(*archive_options.engine), archive_options.tags, archive_options.max_threads);
         }
         catch(std::exception &e) {
-            eprintf_error("Failed to parse the map file generated with scenario %s: %s", base_tag.c_str(), e.what());
+            eprintf_error("Failed to get dependencies of %s.scenario: %s", base_tag.c_str(), e.what());
             return EXIT_FAILURE;
         }
-        auto tag_count = parsed_map->get_tag_count();
-
-        // Go through each tag and see if we can find everything.
-        archive_list.reserve(tag_count + 64);
-
-        auto archive_it = [&archive_options, &archive_list](const std::string &path, TagFourCC fourcc) {
-            std::string full_tag_path = File::halo_path_to_preferred_path(path) + "." + tag_fourcc_to_extension(fourcc);
-
-            // Check each tags directory if it exists. If so, archive it (todo: refactor to tag_path_to_file_path())
-            bool exists = false;
-            for(auto &dir : archive_options.tags) {
-                std::filesystem::path tag_path = std::filesystem::path(dir) / full_tag_path;
-                if(std::filesystem::exists(tag_path)) {
-                    exists = true;
-                    archive_list.emplace_back(tag_path.string(), full_tag_path);
-                    break;
-                }
-            }
 
-            if(!exists) {
-                eprintf_error("Failed to find %s. Archive could not be made.", full_tag_path.c_str());
-                std::exit(EXIT_FAILURE);
-            }
-        };
-
-        for(std::size_t i = 0; i < tag_count; i++) {
-            // Get the tag path information
-            auto &tag = parsed_map->get_tag(i);
-            archive_it(tag.get_path(), tag.get_tag_fourcc());
-        }
-
-        // Archive child scenarios
-        try {
-            auto path = Invader::File::tag_path_to_file_path(base_tag + ".scenario", archive_options.tags);
-            auto scenario_data = Invader::File::open_file(path.value()).value();
-            auto scenario_ptr = Invader::Parser::ParserStruct::parse_hek_tag_file(scenario_data.data(), scenario_data.size());
-            auto &scenario = dynamic_cast<Invader::Parser::Scenario &>(*scenario_ptr);
-            for(auto &child : scenario.child_scenarios) {
-                if(!child.child_scenario.path.empty()) {
-                    archive_it(child.child_scenario.path, child.child_scenario.tag_fourcc);
-                }
-            }
-        }
-        catch(std::exception &e) {
-            eprintf_error("Failed to get dependencies of %s.scenario: %s", base_tag.c_str(), e.what());
-            return EXIT_FAILURE;
+        archive_list.reserve(closure.size());
+        for(auto &tag : closure) {
+            archive_list.emplace_back(tag.full_path, File::halo_path_to_preferred_path(tag.path.join()));
         }
     }
     else {
@@ -355,43 +324,79 @@ int main(int argc, const char **argv) {
     }
 
     for(auto &i : archive_options.tags_excluded_same) {
-        for(std::size_t t = 0; t < archive_list.size(); t++) {
-            // First check if it exists
-            auto path_to_test = i / File::halo_path_to_preferred_path(archive_list[t].second);
+        // Compare everything that exists in both directories in parallel, then remove matching tags in order
+        struct ExclusionResult {
+            bool exclude = false;
+            bool failed = false;
+            std::filesystem::path path_to_test;
+            std::list<std::string> differences;
+        };
+        std::vector<ExclusionResult> results(archive_list.size());
+        std::atomic<std::size_t> next_tag = 0;
+
+        auto compare_thread = [&archive_list, &results, &next_tag, &archive_options, &i]() {
+            while(true) {
+                auto t = next_tag.fetch_add(1, std::memory_order_relaxed);
+                if(t >= archive_list.size()) {
+                    return;
+                }
 
-            if(std::filesystem::exists(path_to_test)) {
-                // Okay it exists. Open both then
-                std::list<std::string> differences;
+                // First check if it exists
+                auto &result = results[t];
+                result.path_to_test = i / File::halo_path_to_preferred_path(archive_list[t].second);
+                if(!std::filesystem::exists(result.path_to_test)) {
+                    continue;
+                }
 
+                // Okay it exists. Open both then
                 try {
                     auto tag_archive_data = File::open_file(archive_list[t].first).value();
                     auto tag_archive = Parser::ParserStruct::parse_hek_tag_file(tag_archive_data.data(), tag_archive_data.size(), true);
 
-                    auto tag_exclude_data = File::open_file(path_to_test).value();
+                    auto tag_exclude_data = File::open_file(result.path_to_test).value();
                     auto tag_exclude = Parser::ParserStruct::parse_hek_tag_file(tag_exclude_data.data(), tag_exclude_data.size(), true);
 
                     // Do a functional comparison
-                    if(!tag_archive->compare(tag_exclude.get(), true, true, archive_options.verbose ? &differences : nullptr)) {
-                        continue;
-                    }
+                    result.exclude = tag_archive->compare(tag_exclude.get(), true, true, archive_options.verbose ? &result.differences : nullptr);
                 }
                 catch (std::exception &) {
-                    eprintf_error("Failed to do a functional comparison of %s and %s\n", archive_list[t].first.string().c_str(), path_to_test.string().c_str());
-                    std::exit(EXIT_FAILURE);
+                    result.failed = true;
                 }
+            }
+        };
 
-                if(archive_options.verbose) {
-                    std::printf("Omitting %s\n", archive_list[t].second.c_str());
+        std::vector<std::thread> threads;
+        auto thread_count = std::min(archive_options.max_threads, archive_list.size());
+        threads.reserve(thread_count);
+        for(std::size_t j = 0; j < thread_count; j++) {
+            threads.emplace_back(compare_thread);
+        }
+        for(auto &t : threads) {
+            t.join();
+        }
 
-                    for(auto &i : differences) {
-                        eprintf("%s\n", i.c_str());
-                    }
-                }
+        std::vector<std::pair<std::filesystem::path, std::string>> remaining;
+        remaining.reserve(archive_list.size());
+        for(std::size_t t = 0; t < archive_list.size(); t++) {
+            auto &result = results[t];
+            if(result.failed) {
+                eprintf_error("Failed to do a functional comparison of %s and %s\n", archive_list[t].first.string().c_str(), result.path_to_test.string().c_str());
+                return EXIT_FAILURE;
+            }
+            if(!result.exclude) {
+                remaining.emplace_back(std::move(archive_list[t]));
+                continue;
+            }
 
-                archive_list.erase(archive_list.begin() + t);
-                t--;
+            if(archive_options.verbose) {
+                std::printf("Omitting %s\n", archive_list[t].second.c_str());
+
+                for(auto &d : result.differences) {
+                    eprintf("%s\n", d.c_str());
+                }
             }
         }
+        archive_list = std::move(remaining);
     }
 
     // If we eliminate all tags, don't bother archiving anything
@@ -406,16 +411,94 @@ int main(int argc, const char **argv) {
         auto *archive = archive_write_new();
         if(archive_options.format->filter) {
             archive_options.format->filter(archive);
+            if(archive_options.format->multithreaded_filter && archive_write_set_filter_option(archive, nullptr, "threads", std::to_string(archive_options.max_threads).c_str()) != ARCHIVE_OK) {
+                eprintf_warn("Failed to enable multithreaded compression; compressing with one thread instead");
+            }
         }
         if(archive_options.format->format) {
             archive_options.format->format(archive);
         }
         archive_write_open_filename(archive, archive_options.output.c_str());
 
+        auto start = std::chrono::steady_clock::now();
+        std::size_t total_size = 0;
+
+        // Read tags ahead of the writer so it doesn't have to wait on the disk
+        std::vector<std::optional<PrefetchedTag>> prefetched(archive_list.size());
+        std::size_t next_read = 0;
+        std::size_t next_write = 0;
+        bool stop_reading = false;
+        std::mutex prefetch_mutex;
+        std::condition_variable prefetch_cv;
+
+        auto read_thread = [&]() {
+            std::unique_lock<std::mutex> lock(prefetch_mutex);
+            while(true) {
+                prefetch_cv.wait(lock, [&]() { return stop_reading || next_read >= archive_list.size() || next_read < next_write + PREFETCH_TAG_COUNT; });
+                if(stop_reading || next_read >= archive_list.size()) {
+                    return;
+                }
+                auto i = next_read++;
+                lock.unlock();
+
+                PrefetchedTag tag;
+                auto str_path = archive_list[i].first.string();
+                tag.data = File::open_file(str_path);
+
+                // Get the modified time
+                struct stat s;
+                stat(str_path.c_str(), &s);
+
+                // Windows uses mtime which is a time_t rather than a struct with nanoseconds
+                #ifdef _WIN32
+                tag.modified = s.st_mtime;
+                #else
+                tag.modified = s.st_mtim.tv_sec;
+                #endif
+
+                lock.lock();
+                prefetched[i] = std::move(tag);
+                prefetch_cv.notify_all();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        auto thread_count = std::min(archive_options.max_threads, archive_list.size());
+        threads.reserve(thread_count);
+        for(std::size_t j = 0; j < thread_count; j++) {
+            threads.emplace_back(read_thread);
+        }
+
+        auto stop_threads = [&]() {
+            {
+                std::scoped_lock<std::mutex> lock(prefetch_mutex);
+                stop_reading = true;
+            }
+            prefetch_cv.notify_all();
+            for(auto &t : threads) {
+                t.join();
+            }
+        };
+
         // Go through each tag path we got
         for(std::size_t i = 0; i < archive_list.size(); i++) {
-            auto str_path = archive_list[i].first.string();
-            const char *path = str_path.c_str();
+            PrefetchedTag tag;
+            {
+                std::unique_lock<std::mutex> lock(prefetch_mutex);
+                prefetch_cv.wait(lock, [&]() { return prefetched[i].has_value(); });
+                tag = std::move(*prefetched[i]);
+                prefetched[i].reset();
+                next_write = i + 1;
+            }
+            prefetch_cv.notify_all();
+
+            if(!tag.data.has_value()) {
+                eprintf_error("Failed to open %s\n", archive_list[i].first.string().c_str());
+                stop_threads();
+                archive_write_free(archive);
+                return EXIT_FAILURE;
+            }
+            auto &data = *tag.data;
 
             // libarchive always needs POSIX paths.
             auto archive_path = archive_list[i].second;
@@ -430,41 +513,27 @@ int main(int argc, const char **argv) {
             archive_entry_set_pathname(entry, archive_path.c_str());
             archive_entry_set_perm(entry, 0644);
             archive_entry_set_filetype(entry, AE_IFREG);
-
-            auto data_maybe = File::open_file(path);
-            if(!data_maybe.has_value()) {
-                eprintf_error("Failed to open %s\n", path);
-                return EXIT_FAILURE;
-            }
-            auto &data = data_maybe.value();
-
-            // Get the filesystem path and write time
-            std::filesystem::path path_path = path;
-
-            // Get the modified time
-            struct stat s;
-            stat(path, &s);
-
-            // Windows uses mtime which is a time_t rather than a struct with nanoseconds
-            #ifdef _WIN32
-            archive_entry_set_mtime(entry, s.st_mtime, 0);
-            #else
-            archive_entry_set_mtime(entry, s.st_mtim.tv_sec, 0);
-            #endif
+            archive_entry_set_mtime(entry, tag.modified, 0);
 
             // Archive that bastard
             archive_entry_set_size(entry, data.size());
             archive_write_header(archive, entry);
             archive_write_data(archive, data.data(), data.size());
+            total_size += data.size();
 
             // Close it
             archive_entry_free(entry);
         }
 
+        stop_threads();
+
         // Save and close
         archive_write_close(archive);
         archive_write_free(archive);
 
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto mib = total_size / 1024.0 / 1024.0;
+        oprintf("Archived %zu tag%s (%.02f MiB) in %.03f seconds (%.02f MiB/s)\n", archive_list.size(), archive_list.size() == 1 ? "" : "s", mib, seconds, seconds > 0.0 ? mib / seconds : 0.0);
         oprintf("Saved %s\n", archive_options.output.c_str());
     }
     // Copy
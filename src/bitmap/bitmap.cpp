@@ -3,6 +3,12 @@
 #include <zlib.h>
 #include <filesystem>
 #include <optional>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <set>
+#include <sstream>
 
 #include <invader/printf.hpp>
 #include <invader/version.hpp>
@@ -102,33 +108,141 @@ struct BitmapOptions {
 
     // Regenerate?
     bool regenerate = false;
+
+    // Build every bitmap in the data directory that matches these
+    std::vector<std::string> batch, batch_exclude;
+
+    // Number of threads to load and scan the color plate with (split between the bitmaps being built at once when batching)
+    std::size_t max_threads = std::thread::hardware_concurrency() < 1 ? 1 : std::thread::hardware_concurrency();
+
+    // Skip bitmaps that are unchanged since they were last built
+    std::optional<std::filesystem::path> manifest;
+};
+
+// Bitmaps that were already built, keyed by bitmap tag path. A bitmap is skipped if its source image, settings, and tag are all unchanged.
+struct BitmapManifestEntry {
+    std::uint64_t source_hash;
+    std::uint64_t settings_hash;
+    std::uint64_t tag_hash;
+
+    bool operator==(const BitmapManifestEntry &) const = default;
 };
+using BitmapManifest = std::map<std::string, BitmapManifestEntry>;
+
+template <typename T> static void add_bitmap_setting(std::ostringstream &settings, const std::optional<T> &value) {
+    if(value.has_value()) {
+        settings << +*value << " ";
+    }
+    else {
+        settings << "- ";
+    }
+}
 
-template <typename T> static int perform_the_ritual(const std::string &bitmap_tag, const std::filesystem::path &tag_path, const std::filesystem::path &final_path, BitmapOptions &bitmap_options, TagFourCC tag_fourcc) {
+// Hash every option given that changes the output (values taken from an existing tag are covered by the tag's hash instead)
+static std::uint64_t bitmap_settings_hash(const BitmapOptions &bitmap_options) {
+    std::ostringstream settings;
+    settings << std::hexfloat;
+    add_bitmap_setting(settings, bitmap_options.mipmap_scale_type);
+    add_bitmap_setting(settings, bitmap_options.format);
+    add_bitmap_setting(settings, bitmap_options.auto_format);
+    add_bitmap_setting(settings, bitmap_options.usage);
+    add_bitmap_setting(settings, bitmap_options.bump_height);
+    add_bitmap_setting(settings, bitmap_options.palettize);
+    add_bitmap_setting(settings, bitmap_options.mipmap_fade);
+    add_bitmap_setting(settings, bitmap_options.bitmap_type);
+    add_bitmap_setting(settings, bitmap_options.sprite_usage);
+    add_bitmap_setting(settings, bitmap_options.sprite_budget);
+    add_bitmap_setting(settings, bitmap_options.sprite_budget_count);
+    add_bitmap_setting(settings, bitmap_options.sprite_spacing);
+    add_bitmap_setting(settings, bitmap_options.dithering);
+    add_bitmap_setting(settings, bitmap_options.sharpen);
+    add_bitmap_setting(settings, bitmap_options.blur);
+    add_bitmap_setting(settings, bitmap_options.alpha_bias);
+    add_bitmap_setting(settings, bitmap_options.max_mipmap_count);
+    add_bitmap_setting(settings, bitmap_options.filthy_sprite_bug_fix);
+    settings << bitmap_options.allow_non_power_of_two << " " << bitmap_options.force_square_sprite_sheets << " " << bitmap_options.regenerate << " " << bitmap_options.ignore_tag_data;
+    auto str = settings.str();
+    return File::hash_data(str.data(), str.size());
+}
+
+// The manifest is only valid for the same version, since the output may change between versions
+static std::string bitmap_manifest_header() {
+    return std::string("invader-bitmap manifest ") + full_version() + "\n";
+}
+
+static BitmapManifest load_bitmap_manifest(const std::filesystem::path &path) {
+    BitmapManifest manifest;
+    auto text = File::open_state_file(path, bitmap_manifest_header());
+    if(!text.has_value()) {
+        return manifest;
+    }
+
+    std::istringstream stream(*text);
+    std::string line;
+    while(std::getline(stream, line)) {
+        std::istringstream line_stream(line);
+        BitmapManifestEntry entry;
+        std::string bitmap_tag;
+        if(line_stream >> std::hex >> entry.source_hash >> entry.settings_hash >> entry.tag_hash && line_stream.get() == ' ' && std::getline(line_stream, bitmap_tag)) {
+            manifest[bitmap_tag] = entry;
+        }
+    }
+    return manifest;
+}
+
+static bool save_bitmap_manifest(const std::filesystem::path &path, const BitmapManifest &manifest) {
+    std::ostringstream stream;
+    stream << std::hex;
+    for(auto &i : manifest) {
+        stream << i.second.source_hash << " " << i.second.settings_hash << " " << i.second.tag_hash << " " << i.first << "\n";
+    }
+    return File::save_state_file(path, bitmap_manifest_header(), stream.str());
+}
+
+struct BitmapResult {
+    // The bitmap was unchanged, so it was not built
+    bool skipped = false;
+
+    // Size of the pixel data that was built
+    std::size_t pixel_data_size = 0;
+
+    // What to remember in the manifest if it was built
+    std::optional<BitmapManifestEntry> manifest_entry;
+};
+
+template <typename T> static int perform_the_ritual(const std::string &bitmap_tag, const std::filesystem::path &tag_path, const std::filesystem::path &final_path, BitmapOptions &bitmap_options, TagFourCC tag_fourcc, const BitmapManifest *manifest, BitmapResult &result, BufferedOutput *output) {
     // Let's begin
     std::filesystem::path data_path = bitmap_options.data;
 
     // Start building the bitmap tag
     T bitmap_tag_data = {};
+    std::optional<std::uint64_t> existing_tag_hash;
+    BitmapManifestEntry manifest_entry = {};
+    if(manifest) {
+        manifest_entry.settings_hash = bitmap_settings_hash(bitmap_options);
+    }
 
     // See if we can get anything out of this
     if(!bitmap_options.ignore_tag_data && std::filesystem::exists(final_path)) {
         auto tag_data = Invader::File::open_file(final_path).value();
         bitmap_tag_data = T::parse_hek_tag_file(tag_data.data(), tag_data.size());
+        if(manifest) {
+            existing_tag_hash = File::hash_data(tag_data.data(), tag_data.size());
+        }
 
         // We do not support these options in this implementation of invader-bitmap.
         // These are available in the Rust implementation instead.
         if(bitmap_tag_data.flags & HEK::BitmapFlagsFlag::BITMAP_FLAGS_FLAG_INVERT_DETAIL_FADE) {
-            eprintf_error("The \"invert detail fade\" option is not supported by this implementation of invader-bitmap");
-            std::exit(EXIT_FAILURE);
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "The \"invert detail fade\" option is not supported by this implementation of invader-bitmap");
+            return EXIT_FAILURE;
         }
         if(bitmap_tag_data.flags & HEK::BitmapFlagsFlag::BITMAP_FLAGS_FLAG_USE_AVERAGE_COLOR_FOR_DETAIL_FADE) {
-            eprintf_error("The \"use average color for detail fade\" option is not supported by this implementation of invader-bitmap");
-            std::exit(EXIT_FAILURE);
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "The \"use average color for detail fade\" option is not supported by this implementation of invader-bitmap");
+            return EXIT_FAILURE;
         }
         if((bitmap_tag_data.encoding_format == HEK::BitmapFormat::BITMAP_FORMAT_BC7 && !bitmap_options.format.has_value()) || bitmap_options.format == HEK::BitmapFormat::BITMAP_FORMAT_BC7) {
-            eprintf_error("BC7 bitmap encoding is not supported by this implementation of invader-bitmap");
-            std::exit(EXIT_FAILURE);
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "BC7 bitmap encoding is not supported by this implementation of invader-bitmap");
+            return EXIT_FAILURE;
         }
 
         // Set some default values
@@ -194,8 +308,8 @@ template <typename T> static int perform_the_ritual(const std::string &bitmap_ta
         bitmap_tag_data.processed_pixel_data.clear();
     }
     else if(bitmap_options.regenerate) {
-        eprintf_error("Cannot regenerate. No bitmap tag exists at %s", final_path.string().c_str());
-        std::exit(EXIT_FAILURE);
+        BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Cannot regenerate. No bitmap tag exists at %s", final_path.string().c_str());
+        return EXIT_FAILURE;
     }
 
     // If these values weren't set, set them
@@ -223,6 +337,55 @@ template <typename T> static int perform_the_ritual(const std::string &bitmap_ta
 
     #undef DEFAULT_VALUE
 
+    // Find the source image
+    std::optional<std::string> image_path;
+    SupportedFormatsInt image_format = SUPPORTED_FORMATS_INT_COUNT;
+    if(!bitmap_options.regenerate) {
+        // Try to figure out the extension
+        auto bitmap_data_path = (data_path / bitmap_tag).string();
+        for(auto i = static_cast<SupportedFormatsInt>(0); i < SUPPORTED_FORMATS_INT_COUNT; i = static_cast<SupportedFormatsInt>(i + 1)) {
+            std::string path = bitmap_data_path + SUPPORTED_FORMATS[i];
+            if(std::filesystem::exists(path)) {
+                image_path = std::move(path);
+                image_format = i;
+                break;
+            }
+        }
+
+        if(!image_path.has_value()) {
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Failed to find %s in %s", bitmap_tag.c_str(), bitmap_options.data.string().c_str());
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_PLAIN_ERROR, "Valid formats are:\n");
+            for(auto *format : SUPPORTED_FORMATS) {
+                BufferedOutput::print_to(output, BufferedOutput::OUTPUT_PLAIN_ERROR, "    %s\n", format);
+            }
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Skip it if the source image, settings, and tag are the same as when it was last built
+    if(manifest) {
+        if(image_path.has_value()) {
+            auto image_data = File::open_file(*image_path);
+            if(!image_data.has_value()) {
+                BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Failed to read %s", image_path->c_str());
+                return EXIT_FAILURE;
+            }
+            manifest_entry.source_hash = File::hash_data(image_data->data(), image_data->size());
+        }
+        else {
+            manifest_entry.source_hash = File::hash_data(bitmap_tag_data.compressed_color_plate_data.data(), bitmap_tag_data.compressed_color_plate_data.size());
+        }
+
+        auto previous_entry = manifest->find(File::preferred_path_to_halo_path(bitmap_tag));
+        if(existing_tag_hash.has_value() && previous_entry != manifest->end()) {
+            manifest_entry.tag_hash = *existing_tag_hash;
+            if(previous_entry->second == manifest_entry) {
+                result.skipped = true;
+                return EXIT_SUCCESS;
+            }
+        }
+    }
+
     // Have these variables handy
     std::uint32_t image_width = 0, image_height = 0;
     std::size_t image_size = 0;
@@ -235,7 +398,7 @@ template <typename T> static int perform_the_ritual(const std::string &bitmap_ta
         image_width = bitmap_tag_data.color_plate_width;
         image_height = bitmap_tag_data.color_plate_height;
         if(size < sizeof(std::uint32_t) || image_width == 0 || image_height == 0) {
-            eprintf_error("Cannot regenerate a bitmap that doesn't have color plate data.");
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Cannot regenerate a bitmap that doesn't have color plate data.");
             return EXIT_FAILURE;
         }
 
@@ -243,7 +406,7 @@ template <typename T> static int perform_the_ritual(const std::string &bitmap_ta
         auto *data = bitmap_tag_data.compressed_color_plate_data.data();
         image_size = reinterpret_cast<HEK::BigEndian<std::uint32_t> *>(data)->read();
         if((image_size % sizeof(Pixel)) != 0) {
-            eprintf_error("Cannot regenerate due the compressed color plate data size being wrong");
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Cannot regenerate due the compressed color plate data size being wrong");
             return EXIT_FAILURE;
         }
         image_pixels = std::vector<Pixel>(image_size / sizeof(Pixel));
@@ -266,37 +429,25 @@ template <typename T> static int perform_the_ritual(const std::string &bitmap_ta
         inflateEnd(&inflate_stream);
     }
 
-    // Otherwise, find the file
+    // Otherwise, load the file
     else {
-        // Try to figure out the extension
-        auto bitmap_data_path = (data_path / bitmap_tag).string();
-        for(auto i = static_cast<SupportedFormatsInt>(0); i < SUPPORTED_FORMATS_INT_COUNT; i = static_cast<SupportedFormatsInt>(i + 1)) {
-            std::string image_path = bitmap_data_path + SUPPORTED_FORMATS[i];
-            if(std::filesystem::exists(image_path)) {
-                switch(i) {
-                    case SUPPORTED_FORMATS_TIF:
-                    case SUPPORTED_FORMATS_TIFF:
-                        image_pixels = load_tiff(image_path.c_str(), image_width, image_height, image_size);
-                        break;
-                    case SUPPORTED_FORMATS_PNG:
-                    case SUPPORTED_FORMATS_TGA:
-                    case SUPPORTED_FORMATS_BMP:
-                        image_pixels = load_image(image_path.c_str(), image_width, image_height, image_size);
-                        break;
-                    default:
-                        std::terminate();
-                        break;
-                }
-                break;
+        try {
+            switch(image_format) {
+                case SUPPORTED_FORMATS_TIF:
+                case SUPPORTED_FORMATS_TIFF:
+                    image_pixels = load_tiff(image_path->c_str(), image_width, image_height, image_size, bitmap_options.max_threads, output);
+                    break;
+                case SUPPORTED_FORMATS_PNG:
+                case SUPPORTED_FORMATS_TGA:
+                case SUPPORTED_FORMATS_BMP:
+                    image_pixels = load_image(image_path->c_str(), image_width, image_height, image_size, output);
+                    break;
+                default:
+                    std::terminate();
+                    break;
             }
         }
-
-        if(image_pixels.empty()) {
-            eprintf_error("Failed to find %s in %s", bitmap_tag.c_str(), bitmap_options.data.string().c_str());
-            eprintf("Valid formats are:\n");
-            for(auto *format : SUPPORTED_FORMATS) {
-                eprintf("    %s\n", format);
-            }
+        catch(std::exception &) {
             return EXIT_FAILURE;
         }
     }
@@ -314,24 +465,20 @@ template <typename T> static int perform_the_ritual(const std::string &bitmap_ta
     }
 
     // Do it!
-    auto try_to_scan_color_plate = [&image_pixels, &image_width, &image_height, &bitmap_options, &sprite_parameters]() {
-        try {
-            auto scanned_data = ColorPlateScanner::scan_color_plate(image_pixels.data(), image_width, image_height, bitmap_options.bitmap_type.value(), bitmap_options.usage.value(), *bitmap_options.filthy_sprite_bug_fix, bitmap_options.allow_non_power_of_two);
-            BitmapProcessor::process_bitmap_data(scanned_data, bitmap_options.bitmap_type.value(), bitmap_options.usage.value(), bitmap_options.bump_height.value(), sprite_parameters, bitmap_options.max_mipmap_count.value(), bitmap_options.mipmap_scale_type.value(), bitmap_options.usage == BitmapUsage::BITMAP_USAGE_DETAIL_MAP ? bitmap_options.mipmap_fade : std::nullopt, bitmap_options.sharpen, bitmap_options.blur, bitmap_options.alpha_bias);
-            return scanned_data;
-        }
-        catch (std::exception &e) {
-            eprintf_error("Failed to process the image: %s", e.what());
-            std::exit(1);
-        };
-    };
-
-    auto scanned_color_plate = try_to_scan_color_plate();
+    GeneratedBitmapData scanned_color_plate;
+    try {
+        scanned_color_plate = ColorPlateScanner::scan_color_plate(image_pixels.data(), image_width, image_height, bitmap_options.bitmap_type.value(), bitmap_options.usage.value(), *bitmap_options.filthy_sprite_bug_fix, bitmap_options.allow_non_power_of_two, bitmap_options.max_threads, output);
+        BitmapProcessor::process_bitmap_data(scanned_color_plate, bitmap_options.bitmap_type.value(), bitmap_options.usage.value(), bitmap_options.bump_height.value(), sprite_parameters, bitmap_options.max_mipmap_count.value(), bitmap_options.mipmap_scale_type.value(), bitmap_options.usage == BitmapUsage::BITMAP_USAGE_DETAIL_MAP ? bitmap_options.mipmap_fade : std::nullopt, bitmap_options.sharpen, bitmap_options.blur, bitmap_options.alpha_bias, output);
+    }
+    catch (std::exception &e) {
+        BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Failed to process the image: %s", e.what());
+        return EXIT_FAILURE;
+    }
 
     // Compress the original input blob
     if(!bitmap_options.regenerate) {
         if(image_width > static_cast<std::uint16_t>(INT16_MAX) || image_height > static_cast<std::uint16_t>(INT16_MAX)) {
-            eprintf_warn("Color plate dimensions exceed %zux%zu\nThe bitmap can still be made, but it cannot be regenerated.", static_cast<std::size_t>(INT16_MAX),  static_cast<std::size_t>(INT16_MAX));
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_WARN, "Color plate dimensions exceed %zux%zu\nThe bitmap can still be made, but it cannot be regenerated.", static_cast<std::size_t>(INT16_MAX),  static_cast<std::size_t>(INT16_MAX));
             bitmap_tag_data.color_plate_width = 0;
             bitmap_tag_data.color_plate_height = 0;
         }
@@ -368,22 +515,19 @@ template <typename T> static int perform_the_ritual(const std::string &bitmap_ta
     }
 
     // Now let's add the actual bitmap data
-    #define BYTES_TO_MIB(bytes) (bytes / 1024.0F / 1024.0F)
-
-    // Add our bitmap data
     try {
         // If we don't have a format, set it to null (it will determine it instead)
         if(*bitmap_options.auto_format) {
             bitmap_options.format = std::nullopt;
         }
 
-        write_bitmap_data(scanned_color_plate, bitmap_tag_data.processed_pixel_data, bitmap_tag_data.bitmap_data, bitmap_options.usage.value(), bitmap_options.format, bitmap_options.bitmap_type.value(), bitmap_options.palettize.value(), bitmap_options.dithering.value());
+        write_bitmap_data(scanned_color_plate, bitmap_tag_data.processed_pixel_data, bitmap_tag_data.bitmap_data, bitmap_options.usage.value(), bitmap_options.format, bitmap_options.bitmap_type.value(), bitmap_options.palettize.value(), bitmap_options.dithering.value(), output);
     }
     catch (std::exception &e) {
-        eprintf_error("Failed to generate bitmap data: %s", e.what());
-        std::exit(1);
+        BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Failed to generate bitmap data: %s", e.what());
+        return EXIT_FAILURE;
     }
-    oprintf("Total: %.03f MiB\n", BYTES_TO_MIB(bitmap_tag_data.processed_pixel_data.size()));
+    result.pixel_data_size = bitmap_tag_data.processed_pixel_data.size();
 
     // Add all sequences
     for(auto &sequence : scanned_color_plate.sequences) {
@@ -477,11 +621,18 @@ template <typename T> static int perform_the_ritual(const std::string &bitmap_ta
     std::error_code ec;
     std::filesystem::create_directories(tag_path.parent_path(), ec);
 
-    if(!File::save_file(final_path.c_str(), bitmap_tag_data.generate_hek_tag_data(tag_fourcc, true))) {
-        eprintf_error("Error: Failed to write to %s.", final_path.string().c_str());
+    auto final_tag_data = bitmap_tag_data.generate_hek_tag_data(tag_fourcc, true);
+    if(!File::save_file(final_path.c_str(), final_tag_data)) {
+        BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Error: Failed to write to %s.", final_path.string().c_str());
         return EXIT_FAILURE;
     }
 
+    // Remember it so it can be skipped next time if nothing changes
+    if(manifest) {
+        manifest_entry.tag_hash = File::hash_data(final_tag_data.data(), final_tag_data.size());
+        result.manifest_entry = manifest_entry;
+    }
+
     return EXIT_SUCCESS;
 }
 
@@ -511,14 +662,18 @@ int main(int argc, char *argv[]) {
         CommandLineOption("usage", 'u', 1, "Set the bitmap usage. Can be: alpha_blend, default, height_map, detail_map, light_map, vector_map. Default: default", "<usage>"),
         CommandLineOption("reg-point-hack", 'r', 1, "Ignore sequence borders when calculating registration point (AKA 'filthy sprite bug fix'). Can be: off or on. Default (new tag): off", "<val>"),
         CommandLineOption("regenerate", 'R', 0, "Use the bitmap tag's compressed color plate data as data."),
-        CommandLineOption("allow-non-power-of-two", 'n', 0, "Allow color plates with non-power-of-two, non-interface bitmaps.")
+        CommandLineOption("allow-non-power-of-two", 'n', 0, "Allow color plates with non-power-of-two, non-interface bitmaps."),
+        CommandLineOption("batch", 'b', 1, "Build all bitmaps with images in the data directory that match a given expression.", "<expr>"),
+        CommandLineOption::from_preset(CommandLineOption::PRESET_COMMAND_LINE_OPTION_BATCH_EXCLUDE),
+        CommandLineOption("threads", 'j', 1, "Set the number of threads to use for loading and scanning the color plate. When batching, these are split between the bitmaps being built at once. Default: CPU thread count"),
+        CommandLineOption("manifest", 'm', 1, "Skip bitmaps whose image, options, and tag are unchanged since they were last built, and remember the bitmaps that are built. Results are stored in the given file.", "<file>")
     };
 
     static constexpr char DESCRIPTION[] = "Create or modify a bitmap tag.";
-    static constexpr char USAGE[] = "[options] <bitmap-tag>";
+    static constexpr char USAGE[] = "[options] <-b <expr>|bitmap-tag>";
 
     // Go through each argument
-    auto remaining_arguments = CommandLineOption::parse_arguments<BitmapOptions &>(argc, argv, options, USAGE, DESCRIPTION, 1, 1, bitmap_options, [](char opt, const std::vector<const char *> &arguments, auto &bitmap_options) {
+    auto remaining_arguments = CommandLineOption::parse_arguments<BitmapOptions &>(argc, argv, options, USAGE, DESCRIPTION, 0, 1, bitmap_options, [](char opt, const std::vector<const char *> &arguments, auto &bitmap_options) {
         switch(opt) {
             case 'd':
                 bitmap_options.data = arguments[0];
@@ -688,9 +843,174 @@ int main(int argc, char *argv[]) {
             case 'P':
                 bitmap_options.filesystem_path = true;
                 break;
+
+            case 'b':
+                bitmap_options.batch.emplace_back(arguments[0]);
+                break;
+
+            case 'e':
+                bitmap_options.batch_exclude.emplace_back(arguments[0]);
+                break;
+
+            case 'j':
+                try {
+                    bitmap_options.max_threads = std::stoul(arguments[0]);
+                }
+                catch(std::exception &) {
+                    eprintf_error("Invalid number of threads %s", arguments[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                if(bitmap_options.max_threads < 1) {
+                    eprintf_error("Invalid number of threads %s", arguments[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'm':
+                bitmap_options.manifest = arguments[0];
+                break;
         }
     });
 
+    auto use_batching = !(bitmap_options.batch.empty() && bitmap_options.batch_exclude.empty());
+    if(use_batching != remaining_arguments.empty()) {
+        eprintf_error("Expected batching or a bitmap tag but not both.");
+        return EXIT_FAILURE;
+    }
+
+    // Check if the tags directory exists
+    if(!std::filesystem::is_directory(bitmap_options.tags)) {
+        eprintf_error("Directory %s was not found or is not a directory", bitmap_options.tags.string().c_str());
+        return EXIT_FAILURE;
+    }
+
+    std::optional<BitmapManifest> manifest;
+    if(bitmap_options.manifest.has_value()) {
+        manifest = load_bitmap_manifest(*bitmap_options.manifest);
+    }
+
+    auto save_manifest = [&manifest, &bitmap_options]() {
+        if(manifest.has_value() && !save_bitmap_manifest(*bitmap_options.manifest, *manifest)) {
+            eprintf_warn("Failed to save the manifest to %s", bitmap_options.manifest->string().c_str());
+        }
+    };
+
+    #define BYTES_TO_MIB(bytes) (bytes / 1024.0F / 1024.0F)
+
+    if(use_batching) {
+        // Find every image in the data directory
+        std::set<std::string> bitmap_tag_set;
+        File::PathMatcher matcher(bitmap_options.batch, bitmap_options.batch_exclude);
+        try {
+            for(auto &i : std::filesystem::recursive_directory_iterator(bitmap_options.data)) {
+                if(!i.is_regular_file()) {
+                    continue;
+                }
+                auto extension = i.path().extension().string();
+                bool supported = false;
+                for(auto *format : SUPPORTED_FORMATS) {
+                    supported = supported || extension == format;
+                }
+                if(!supported) {
+                    continue;
+                }
+
+                auto bitmap_tag = File::preferred_path_to_halo_path(i.path().lexically_relative(bitmap_options.data).replace_extension().string());
+                if(matcher.matches(bitmap_tag)) {
+                    bitmap_tag_set.emplace(std::move(bitmap_tag));
+                }
+            }
+        }
+        catch(std::exception &e) {
+            eprintf_error("Failed to read %s: %s", bitmap_options.data.string().c_str(), e.what());
+            return EXIT_FAILURE;
+        }
+
+        // Each bitmap's result and messages are kept so output stays in order regardless of which thread finished first
+        struct BuiltBitmap {
+            int status = EXIT_FAILURE;
+            BitmapResult result;
+            BufferedOutput output;
+        };
+
+        std::vector<std::string> bitmap_tags(bitmap_tag_set.begin(), bitmap_tag_set.end());
+        std::size_t total = bitmap_tags.size();
+        std::vector<BuiltBitmap> results(total);
+        std::atomic<std::size_t> next_bitmap = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        // Split the thread budget between the bitmaps being built at once so loading and scanning each one doesn't start
+        // even more threads on top of them (only small batches have any threads left over for each bitmap)
+        auto thread_count = std::min(bitmap_options.max_threads, total);
+        auto threads_per_bitmap = std::max<std::size_t>(bitmap_options.max_threads / std::max<std::size_t>(thread_count, 1), 1);
+
+        auto bitmap_thread = [&bitmap_tags, &results, &next_bitmap, &total, &bitmap_options, &manifest, &threads_per_bitmap]() {
+            while(true) {
+                auto b = next_bitmap.fetch_add(1, std::memory_order_relaxed);
+                if(b >= total) {
+                    return;
+                }
+
+                // Each bitmap gets its own copy of the options since the tag's values are filled into them
+                auto bitmap_tag = File::halo_path_to_preferred_path(bitmap_tags[b]);
+                auto options_copy = bitmap_options;
+                options_copy.max_threads = threads_per_bitmap;
+                auto tag_path = bitmap_options.tags / bitmap_tag;
+                auto final_path_bitmap = std::filesystem::path(tag_path) += ".bitmap";
+                try {
+                    results[b].status = perform_the_ritual<Invader::Parser::Bitmap>(bitmap_tag, tag_path, final_path_bitmap, options_copy, TagFourCC::TAG_FOURCC_BITMAP, manifest.has_value() ? &*manifest : nullptr, results[b].result, &results[b].output);
+                }
+                catch(std::exception &e) {
+                    results[b].output.print(BufferedOutput::OUTPUT_ERROR, "Failed to build %s: %s", bitmap_tags[b].c_str(), e.what());
+                    results[b].status = EXIT_FAILURE;
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count);
+        for(std::size_t j = 0; j < thread_count; j++) {
+            threads.emplace_back(bitmap_thread);
+        }
+        for(auto &t : threads) {
+            t.join();
+        }
+
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Report results
+        std::size_t success = 0, skipped = 0, failed = 0;
+        for(std::size_t b = 0; b < total; b++) {
+            auto &r = results[b];
+            r.output.flush();
+            if(r.status != EXIT_SUCCESS) {
+                eprintf_error("Failed to build %s", bitmap_tags[b].c_str());
+                failed++;
+            }
+            else if(r.result.skipped) {
+                skipped++;
+            }
+            else {
+                oprintf_success("Built %s (%.03f MiB)", bitmap_tags[b].c_str(), BYTES_TO_MIB(r.result.pixel_data_size));
+                success++;
+            }
+
+            if(manifest.has_value() && r.result.manifest_entry.has_value()) {
+                (*manifest)[bitmap_tags[b]] = *r.result.manifest_entry;
+            }
+        }
+        save_manifest();
+
+        if(success) {
+            oprintf_success("Built %zu of %zu bitmap%s (%zu unchanged, %zu failed) in %.03f seconds", success, total, total == 1 ? "" : "s", skipped, failed, seconds);
+        }
+        else {
+            oprintf("Built %zu of %zu bitmap%s (%zu unchanged, %zu failed) in %.03f seconds\n", success, total, total == 1 ? "" : "s", skipped, failed, seconds);
+        }
+
+        return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     // Resolve the bitmap tag
     std::string bitmap_tag;
     if(bitmap_options.filesystem_path) {
@@ -708,13 +1028,30 @@ int main(int argc, char *argv[]) {
         bitmap_tag = remaining_arguments[0];
     }
 
-    // Check if the tags directory exists
-    if(!std::filesystem::is_directory(bitmap_options.tags)) {
-        eprintf_error("Directory %s was not found or is not a directory", bitmap_options.tags.string().c_str());
+    auto tag_path = bitmap_options.tags / bitmap_tag;
+    auto final_path_bitmap = std::filesystem::path(tag_path) += ".bitmap";
+    BitmapResult result;
+    int status;
+    try {
+        status = perform_the_ritual<Invader::Parser::Bitmap>(bitmap_tag, tag_path, final_path_bitmap, bitmap_options, TagFourCC::TAG_FOURCC_BITMAP, manifest.has_value() ? &*manifest : nullptr, result, nullptr);
+    }
+    catch(std::exception &e) {
+        eprintf_error("Failed to build %s: %s", bitmap_tag.c_str(), e.what());
         return EXIT_FAILURE;
     }
 
-    auto tag_path = bitmap_options.tags / bitmap_tag;
-    auto final_path_bitmap = std::filesystem::path(tag_path) += ".bitmap";
-    return perform_the_ritual<Invader::Parser::Bitmap>(bitmap_tag, tag_path, final_path_bitmap, bitmap_options, TagFourCC::TAG_FOURCC_BITMAP);
+    if(status == EXIT_SUCCESS) {
+        if(result.skipped) {
+            oprintf("%s is unchanged\n", bitmap_tag.c_str());
+        }
+        else {
+            oprintf("Total: %.03f MiB\n", BYTES_TO_MIB(result.pixel_data_size));
+        }
+        if(manifest.has_value() && result.manifest_entry.has_value()) {
+            (*manifest)[File::preferred_path_to_halo_path(bitmap_tag)] = *result.manifest_entry;
+            save_manifest();
+        }
+    }
+
+    return status;
 }
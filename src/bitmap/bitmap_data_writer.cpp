@@ -7,7 +7,7 @@
 #include <algorithm>
 
 namespace Invader {
-    void write_bitmap_data(const GeneratedBitmapData &scanned_color_plate, std::vector<std::byte> &bitmap_data_pixels, std::vector<Parser::BitmapData> &bitmap_data, BitmapUsage usage, std::optional<BitmapFormat> &format, BitmapType bitmap_type, bool palettize, bool dither) {
+    void write_bitmap_data(const GeneratedBitmapData &scanned_color_plate, std::vector<std::byte> &bitmap_data_pixels, std::vector<Parser::BitmapData> &bitmap_data, BitmapUsage usage, std::optional<BitmapFormat> &format, BitmapType bitmap_type, bool palettize, bool dither, BufferedOutput *output) {
         using namespace Invader::HEK;
 
         auto bitmap_count = scanned_color_plate.bitmaps.size();
@@ -54,20 +54,20 @@ namespace Invader {
 
             switch(*format) {
                 case BitmapFormat::BITMAP_FORMAT_32_BIT:
-                    oprintf("Automatically determined format as 32-bit\n");
+                    BufferedOutput::print_to(output, BufferedOutput::OUTPUT_PLAIN, "Automatically determined format as 32-bit\n");
                     break;
                 case BitmapFormat::BITMAP_FORMAT_16_BIT:
-                    oprintf("Automatically determined format as 16-bit\n");
+                    BufferedOutput::print_to(output, BufferedOutput::OUTPUT_PLAIN, "Automatically determined format as 16-bit\n");
                     break;
                 case BitmapFormat::BITMAP_FORMAT_MONOCHROME:
-                    oprintf("Automatically determined format as monochrome\n");
+                    BufferedOutput::print_to(output, BufferedOutput::OUTPUT_PLAIN, "Automatically determined format as monochrome\n");
                     break;
                 default:
                     std::terminate();
             }
         }
 
-        oprintf("Found %zu bitmap%s:\n", bitmap_count, bitmap_count == 1 ? "" : "s");
+        BufferedOutput::print_to(output, BufferedOutput::OUTPUT_PLAIN, "Found %zu bitmap%s:\n", bitmap_count, bitmap_count == 1 ? "" : "s");
 
         bool warn_on_semi_transparent_1_bit_alpha = false;
         bool warn_on_lost_color = false;
@@ -153,15 +153,15 @@ namespace Invader {
 
             #define BYTES_TO_MIB(bytes) (bytes / 1024.0F / 1024.0F)
 
-            oprintf("    Bitmap #%zu: %ux%u, %u mipmap%s, %s - %.03f MiB\n", i, scanned_color_plate.bitmaps[i].width, scanned_color_plate.bitmaps[i].height, mipmap_count, mipmap_count == 1 ? "" : "s", bitmap_data_format_name(bitmap.format), BYTES_TO_MIB(encoded_pixels.size()));
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_PLAIN, "    Bitmap #%zu: %ux%u, %u mipmap%s, %s - %.03f MiB\n", i, scanned_color_plate.bitmaps[i].width, scanned_color_plate.bitmaps[i].height, mipmap_count, mipmap_count == 1 ? "" : "s", bitmap_data_format_name(bitmap.format), BYTES_TO_MIB(encoded_pixels.size()));
         }
 
         if(warn_on_semi_transparent_1_bit_alpha) {
-            eprintf_warn("Compressing semi-transparent pixels to 1-bit alpha.");
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_WARN, "Compressing semi-transparent pixels to 1-bit alpha.");
         }
 
         if(warn_on_lost_color) {
-            eprintf_warn("Compressing transparent non-black pixels. Color may be lost.");
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_WARN, "Compressing transparent non-black pixels. Color may be lost.");
         }
     }
 }
@@ -10,9 +10,9 @@ namespace Invader {
     using BitmapFormat = HEK::BitmapFormat;
 
     /**
-     * if format is nullopt, it will determine one
+     * if format is nullopt, it will determine one; messages are held in output if it is set
      */
-    void write_bitmap_data(const GeneratedBitmapData &scanned_color_plate, std::vector<std::byte> &bitmap_data_pixels, std::vector<Parser::BitmapData> &bitmap_data, BitmapUsage usage, std::optional<BitmapFormat> &format, BitmapType bitmap_type, bool palettize, bool dither);
+    void write_bitmap_data(const GeneratedBitmapData &scanned_color_plate, std::vector<std::byte> &bitmap_data_pixels, std::vector<Parser::BitmapData> &bitmap_data, BitmapUsage usage, std::optional<BitmapFormat> &format, BitmapType bitmap_type, bool palettize, bool dither, BufferedOutput *output = nullptr);
 }
 
 #endif
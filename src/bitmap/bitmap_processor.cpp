@@ -14,7 +14,8 @@ namespace Invader {
         std::optional<float> mipmap_fade_factor,
         std::optional<float> sharpen,
         std::optional<float> blur,
-        std::optional<float> alpha_bias) {
+        std::optional<float> alpha_bias,
+        BufferedOutput *output) {
         
         BitmapProcessor processor;
         processor.power_of_two = (type != BitmapType::BITMAP_TYPE_SPRITES) && (type != BitmapType::BITMAP_TYPE_INTERFACE_BITMAPS);
@@ -82,13 +83,13 @@ namespace Invader {
                 done_check:
                 if(new_end_x != width || new_end_y != height || new_start_x != 0 || new_start_y != 0) {
                     if(new_end_x == new_start_x) {
-                        eprintf_warn("Bitmap #%zu was deleted due to zero alpha (alpha blend usage)", b);
+                        BufferedOutput::print_to(output, BufferedOutput::OUTPUT_WARN, "Bitmap #%zu was deleted due to zero alpha (alpha blend usage)", b);
                         bitmaps_to_remove.emplace_back(b);
                     }
                     else {
                         std::size_t new_width = new_end_x - new_start_x;
                         std::size_t new_height = new_end_y - new_start_y;
-                        eprintf_warn("Bitmap #%zu was resized to %zux%zu due to zero alpha on edge (alpha blend usage)", b, new_width, new_height);
+                        BufferedOutput::print_to(output, BufferedOutput::OUTPUT_WARN, "Bitmap #%zu was resized to %zux%zu due to zero alpha on edge (alpha blend usage)", b, new_width, new_height);
                         
                         // Overwrite pixels
                         std::vector<Pixel> new_pixels(new_width * new_height);
@@ -104,7 +105,7 @@ namespace Invader {
                         
                         // Check if power-of-two
                         if(processor.power_of_two && (!HEK::is_power_of_two(new_width) || !HEK::is_power_of_two(new_height))) {
-                            eprintf_error("This is non-power-of-two, but the bitmap type requires power-of-two");
+                            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "This is non-power-of-two, but the bitmap type requires power-of-two");
                             throw InvalidInputBitmapException();
                         }
                     }
@@ -114,7 +115,7 @@ namespace Invader {
             // Remove any empty bitmaps
             auto bitmap_removal_count = bitmaps_to_remove.size();
             if(bitmap_removal_count) {
-                eprintf_warn("%zu bitmaps were deleted due to no alpha (usage is set to alpha blend)", bitmap_removal_count);
+                BufferedOutput::print_to(output, BufferedOutput::OUTPUT_WARN, "%zu bitmaps were deleted due to no alpha (usage is set to alpha blend)", bitmap_removal_count);
                 
                 for(std::size_t i = 0; i < bitmap_removal_count; i++) {
                     // Get the index
@@ -147,7 +148,7 @@ namespace Invader {
         
         // If we have zero bitmaps, error
         if(generated_bitmap.bitmaps.empty()) {
-            eprintf_error("Error: No bitmaps were found in the color plate");
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Error: No bitmaps were found in the color plate");
             throw InvalidInputBitmapException();
         }
 
@@ -161,22 +162,22 @@ namespace Invader {
             if(mipmaps > 2) {
                 mipmaps = 2;
             }
-            process_sprites(generated_bitmap, sprite_parameters.value(), mipmaps);
+            process_sprites(generated_bitmap, sprite_parameters.value(), mipmaps, output);
         }
 
         // If we're doing height maps, do this
         if(usage == BitmapUsage::BITMAP_USAGE_HEIGHT_MAP) {
-            process_height_maps(generated_bitmap, bump_height);
+            process_height_maps(generated_bitmap, bump_height, output);
         }
 
         // If we aren't making interface bitmaps, generate mipmaps when needed
         if(type != BitmapType::BITMAP_TYPE_INTERFACE_BITMAPS && usage != BitmapUsage::BITMAP_USAGE_LIGHT_MAP) {
-            generate_mipmaps(generated_bitmap, mipmaps, mipmap_type, mipmap_fade_factor, sharpen, blur, alpha_bias, usage);
+            generate_mipmaps(generated_bitmap, mipmaps, mipmap_type, mipmap_fade_factor, sharpen, blur, alpha_bias, usage, output);
         }
 
         // If we're making cubemaps, we need to make all sides of each cubemap sequence one cubemap bitmap data. 3D textures work similarly
         if(type == BitmapType::BITMAP_TYPE_CUBE_MAPS || type == BitmapType::BITMAP_TYPE_3D_TEXTURES) {
-            consolidate_stacked_bitmaps(generated_bitmap);
+            consolidate_stacked_bitmaps(generated_bitmap, output);
         }
 
         // 3D textures also halve in depth, too
@@ -185,14 +186,14 @@ namespace Invader {
         }
     }
 
-    void BitmapProcessor::process_height_maps(GeneratedBitmapData &generated_bitmap, float bump_height) {
+    void BitmapProcessor::process_height_maps(GeneratedBitmapData &generated_bitmap, float bump_height, BufferedOutput *output) {
         if(bump_height <= 0.0F) {
-            eprintf_warn("process_height_maps(): No bump height given, so no bump map will be generated");
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_WARN, "process_height_maps(): No bump height given, so no bump map will be generated");
             return;
         }
         
         if(bump_height > 0.5F) {
-            eprintf_warn("process_height_maps(): Bump height was capped to 0.5");
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_WARN, "process_height_maps(): Bump height was capped to 0.5");
             bump_height = 0.5F;
         }
 
@@ -251,7 +252,7 @@ namespace Invader {
         }
     }
 
-    void BitmapProcessor::generate_mipmaps(GeneratedBitmapData &generated_bitmap, std::int16_t mipmaps, BitmapMipmapScaleType mipmap_type, std::optional<float> mipmap_fade_factor, std::optional<float> sharpen, std::optional<float> blur, std::optional<float> alpha_bias, BitmapUsage usage) {
+    void BitmapProcessor::generate_mipmaps(GeneratedBitmapData &generated_bitmap, std::int16_t mipmaps, BitmapMipmapScaleType mipmap_type, std::optional<float> mipmap_fade_factor, std::optional<float> sharpen, std::optional<float> blur, std::optional<float> alpha_bias, BitmapUsage usage, BufferedOutput *output) {
         auto mipmaps_unsigned = static_cast<std::uint32_t>(mipmaps);
         float fade = mipmap_fade_factor.value_or(0.0F);
         
@@ -568,11 +569,11 @@ namespace Invader {
         }
         
         if(warn_on_zero_alpha) {
-            eprintf_warn("Usage is alpha blend, and a bitmap has zero alpha; its mipmaps will be black.");
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_WARN, "Usage is alpha blend, and a bitmap has zero alpha; its mipmaps will be black.");
         }
     }
 
-    void BitmapProcessor::consolidate_stacked_bitmaps(GeneratedBitmapData &generated_bitmap) {
+    void BitmapProcessor::consolidate_stacked_bitmaps(GeneratedBitmapData &generated_bitmap, BufferedOutput *output) {
         std::vector<GeneratedBitmapDataSequence> new_sequences;
         std::vector<GeneratedBitmapDataBitmap> new_bitmaps;
         for(auto &sequence : generated_bitmap.sequences) {
@@ -584,7 +585,7 @@ namespace Invader {
             const std::uint32_t FACES = sequence.bitmap_count;
 
             if(FACES == 0) {
-                eprintf_error("Error: Stacked bitmaps must have at least one bitmap. %u found.\n", FACES);
+                BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Error: Stacked bitmaps must have at least one bitmap. %u found.\n", FACES);
                 throw InvalidInputBitmapException();
             }
 
@@ -604,17 +605,17 @@ namespace Invader {
 
             if(generated_bitmap.type == BitmapType::BITMAP_TYPE_CUBE_MAPS) {
                 if(FACES != 6) {
-                    eprintf_error("Error: Cubemaps must have six bitmaps per cubemap. %u found.\n", FACES);
+                    BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Error: Cubemaps must have six bitmaps per cubemap. %u found.\n", FACES);
                     throw InvalidInputBitmapException();
                 }
                 if(BITMAP_WIDTH != BITMAP_HEIGHT) {
-                    eprintf_error("Error: Cubemap length must equal width and height. %ux%u found.\n", BITMAP_WIDTH, BITMAP_HEIGHT);
+                    BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Error: Cubemap length must equal width and height. %ux%u found.\n", BITMAP_WIDTH, BITMAP_HEIGHT);
                     throw InvalidInputBitmapException();
                 }
             }
             else if(generated_bitmap.type == BitmapType::BITMAP_TYPE_3D_TEXTURES) {
                 if(!FACES || !HEK::is_power_of_two(FACES)) {
-                    eprintf_error("Error: 3D texture depth must be a power of two. Got %u\n", FACES);
+                    BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Error: 3D texture depth must be a power of two. Got %u\n", FACES);
                     throw InvalidInputBitmapException();
                 }
             }
@@ -648,13 +649,13 @@ namespace Invader {
 
                 // Ensure it's the same dimensions
                 if(bitmap.height != BITMAP_HEIGHT || bitmap.width != BITMAP_WIDTH) {
-                    eprintf_error("Error: Stacked bitmaps must be the same dimensions. Expected %ux%u. %ux%u found\n", BITMAP_WIDTH, BITMAP_WIDTH, bitmap.width, bitmap.height);
+                    BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Error: Stacked bitmaps must be the same dimensions. Expected %ux%u. %ux%u found\n", BITMAP_WIDTH, BITMAP_WIDTH, bitmap.width, bitmap.height);
                     throw InvalidInputBitmapException();
                 }
 
                 // Also ensure it has the same # of mipmaps. I don't know how it wouldn't, but you never know
                 if(bitmap.mipmaps.size() != MIPMAP_COUNT) {
-                    eprintf_error("Error: Stacked bitmaps must have the same number of mipmaps. Expected %u. %zu found\n", MIPMAP_COUNT, bitmap.mipmaps.size());
+                    BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Error: Stacked bitmaps must have the same number of mipmaps. Expected %u. %zu found\n", MIPMAP_COUNT, bitmap.mipmaps.size());
                     throw InvalidInputBitmapException();
                 }
 
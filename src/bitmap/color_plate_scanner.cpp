@@ -3,6 +3,8 @@
 #include <cassert>
 #include <optional>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 
 #include <invader/hek/data_type.hpp>
 #include <invader/bitmap/color_plate_scanner.hpp>
@@ -22,15 +24,51 @@ namespace Invader {
 
     #define GET_PIXEL(x,y) (pixels[y * width + x])
 
-    GeneratedBitmapData ColorPlateScanner::scan_color_plate(const Pixel *pixels, std::uint32_t width, std::uint32_t height, BitmapType type, BitmapUsage usage, bool reg_point_hack, bool allow_non_power_of_two) {
+    // Number of rows or columns each thread takes at a time
+    static constexpr std::size_t BAND_SIZE = 64;
+
+    template <typename F> void ColorPlateScanner::for_each_band(std::size_t count, const F &function) const {
+        std::size_t band_count = (count + BAND_SIZE - 1) / BAND_SIZE;
+        auto thread_count = std::min(this->max_threads, band_count);
+
+        // Not worth making threads for this
+        if(thread_count <= 1) {
+            function(0, count);
+            return;
+        }
+
+        std::atomic<std::size_t> next_band = 0;
+        auto band_thread = [&next_band, &band_count, &count, &function]() {
+            while(true) {
+                auto b = next_band.fetch_add(1, std::memory_order_relaxed);
+                if(b >= band_count) {
+                    return;
+                }
+                function(b * BAND_SIZE, std::min((b + 1) * BAND_SIZE, count));
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count);
+        for(std::size_t j = 0; j < thread_count; j++) {
+            threads.emplace_back(band_thread);
+        }
+        for(auto &t : threads) {
+            t.join();
+        }
+    }
+
+    GeneratedBitmapData ColorPlateScanner::scan_color_plate(const Pixel *pixels, std::uint32_t width, std::uint32_t height, BitmapType type, BitmapUsage usage, bool reg_point_hack, bool allow_non_power_of_two, std::size_t max_threads, BufferedOutput *output) {
         // We don't support this yet
         if(usage == BitmapUsage::BITMAP_USAGE_VECTOR_MAP) {
-            eprintf_error("Vector maps are not supported at this time");
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Vector maps are not supported at this time");
             throw std::exception();
         }
         
         ColorPlateScanner scanner;
         GeneratedBitmapData generated_bitmap;
+        scanner.max_threads = max_threads < 1 ? 1 : max_threads;
+        scanner.output = output;
 
         generated_bitmap.type = type;
         scanner.power_of_two = !allow_non_power_of_two && ((type != BitmapType::BITMAP_TYPE_SPRITES) && (type != BitmapType::BITMAP_TYPE_INTERFACE_BITMAPS));
@@ -88,17 +126,24 @@ namespace Invader {
                         }
                     };
                     
-                    for(std::size_t y = 1; y < height; y++) {
-                        bool all_blue = true;
-                        for(std::size_t x = 0; x < width; x++) {
-                            if(!scanner.is_transparency_color(GET_PIXEL(x,y))) {
-                                all_blue = false;
-                                break;
+                    // Find which rows are all blue first since each row can be checked independently
+                    std::vector<std::uint8_t> row_all_blue(height);
+                    scanner.for_each_band(height, [&scanner, &pixels, &width, &row_all_blue](std::size_t y_start, std::size_t y_end) {
+                        for(std::size_t y = y_start; y < y_end; y++) {
+                            bool all_blue = true;
+                            for(std::size_t x = 0; x < width; x++) {
+                                if(!scanner.is_transparency_color(GET_PIXEL(x,y))) {
+                                    all_blue = false;
+                                    break;
+                                }
                             }
+                            row_all_blue[y] = all_blue;
                         }
-                        
+                    });
+                    
+                    for(std::size_t y = 1; y < height; y++) {
                         // If it's all blue and we're in a sequence, then the sequence has ended
-                        if(all_blue == start_y.has_value()) {
+                        if(static_cast<bool>(row_all_blue[y]) == start_y.has_value()) {
                             break_off_sequence(y);
                         }
                     }
@@ -108,7 +153,7 @@ namespace Invader {
                     scanner.spacing_color = Pixel { 0xFF, 0xFF, 0x00, 0xFF };
                     
                     if(!scanner.is_transparency_color(spacing_candidate) && !scanner.is_spacing_color(spacing_candidate)) {
-                        eprintf_error("Error: Spacing color, if set, can only be #00FFFF if sequence divider is not set");
+                        BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Error: Spacing color, if set, can only be #00FFFF if sequence divider is not set");
                         throw InvalidInputBitmapException();
                     }
                 }
@@ -119,17 +164,35 @@ namespace Invader {
                 // Generate sequences
                 auto *sequence = &generated_bitmap.sequences.emplace_back();
                 
-                auto is_horizontal_bar = [&scanner, &width, &pixels](std::size_t y) {
-                    if(scanner.is_sequence_divider_color(GET_PIXEL(0,y))) {
-                        for(std::size_t x = 1; x < width; x++) {
-                            if(!scanner.is_sequence_divider_color(GET_PIXEL(x,y))) {
-                                eprintf_error("Sequence divider broken at (%zu,%zu)", x, y);
-                                throw InvalidInputBitmapException();
+                // Check each row for sequence dividers first. A row is a divider if it starts with the sequence divider
+                // color, and it's broken if any pixel after that isn't the sequence divider color (0 if not broken).
+                struct RowDivider {
+                    bool divider = false;
+                    std::size_t broken_x = 0;
+                };
+                std::vector<RowDivider> row_dividers(height);
+                scanner.for_each_band(height, [&scanner, &pixels, &width, &row_dividers](std::size_t y_start, std::size_t y_end) {
+                    for(std::size_t y = y_start; y < y_end; y++) {
+                        auto &row = row_dividers[y];
+                        if(scanner.is_sequence_divider_color(GET_PIXEL(0,y))) {
+                            row.divider = true;
+                            for(std::size_t x = 1; x < width; x++) {
+                                if(!scanner.is_sequence_divider_color(GET_PIXEL(x,y))) {
+                                    row.broken_x = x;
+                                    break;
+                                }
                             }
                         }
-                        return true;
                     }
-                    return false;
+                });
+                
+                auto is_horizontal_bar = [&row_dividers, &output](std::size_t y) {
+                    auto &row = row_dividers[y];
+                    if(row.divider && row.broken_x != 0) {
+                        BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Sequence divider broken at (%zu,%zu)", row.broken_x, y);
+                        throw InvalidInputBitmapException();
+                    }
+                    return row.divider;
                 };
                 
                 sequence->y_start = is_horizontal_bar(1) ? 2 : 1;
@@ -154,7 +217,7 @@ namespace Invader {
                 
                 // Make sure it's valid!
                 if(same_color_ignore_opacity(separator_candidate, spacing_candidate)) {
-                    eprintf_error("Spacing and sequence divider colors must not match");
+                    BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Spacing and sequence divider colors must not match");
                     throw InvalidInputBitmapException();
                 }
             }
@@ -177,7 +240,7 @@ namespace Invader {
                 scanner.read_unrolled_cubemap(generated_bitmap, pixels, width, height);
             }
             else if(type == BitmapType::BITMAP_TYPE_SPRITES) {
-                eprintf_error("Error: Sprite color plates must have a color plate key.\n");
+                BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Error: Sprite color plates must have a color plate key.\n");
                 throw InvalidInputBitmapException();
             }
             else {
@@ -189,186 +252,195 @@ namespace Invader {
     }
 
     void ColorPlateScanner::read_color_plate(GeneratedBitmapData &generated_bitmap, const Pixel *pixels, std::uint32_t width, bool reg_point_hack) const {
-        for(auto &sequence : generated_bitmap.sequences) {
+        // Bitmaps are separated by columns that are entirely blue/magenta within the sequence, and their bounds only depend
+        // on the pixels in each column, so first find the bounds of each column of each sequence.
+        struct ColumnBounds {
+            // Any pixel that isn't blue/magenta/cyan
+            bool has_pixels = false;
+            std::uint32_t min_y = 0;
+            std::uint32_t max_y = 0;
+
+            // Any pixel that isn't blue/magenta (includes cyan spacing)
+            bool has_virtual_pixels = false;
+            std::uint32_t virtual_min_y = 0;
+            std::uint32_t virtual_max_y = 0;
+        };
+
+        const std::uint32_t X_END = width;
+        std::size_t sequence_count = generated_bitmap.sequences.size();
+        std::size_t bands_per_sequence = (X_END + BAND_SIZE - 1) / BAND_SIZE;
+        std::vector<std::vector<ColumnBounds>> column_bounds(sequence_count, std::vector<ColumnBounds>(X_END));
+
+        // Each band of columns of each sequence is a tile which can be scanned on its own
+        this->for_each_band(sequence_count * bands_per_sequence * BAND_SIZE, [this, &generated_bitmap, &column_bounds, &pixels, &width, &bands_per_sequence, &X_END](std::size_t tile_start, std::size_t tile_end) {
+            for(std::size_t tile = tile_start / BAND_SIZE; tile < (tile_end + BAND_SIZE - 1) / BAND_SIZE; tile++) {
+                std::size_t s = tile / bands_per_sequence;
+                auto &sequence = generated_bitmap.sequences[s];
+                auto &bounds = column_bounds[s];
+                const std::uint32_t X_START = static_cast<std::uint32_t>((tile % bands_per_sequence) * BAND_SIZE);
+                const std::uint32_t X_STOP = std::min(static_cast<std::uint32_t>(X_START + BAND_SIZE), X_END);
+
+                // Go row by row so we read the pixels in the order they're stored
+                for(std::uint32_t y = sequence.y_start; y < sequence.y_end; y++) {
+                    for(std::uint32_t x = X_START; x < X_STOP; x++) {
+                        auto &pixel = GET_PIXEL(x, y);
+                        auto &column = bounds[x];
+
+                        // Anything that's not a magenta/blue pixel
+                        if(this->is_transparency_color(pixel) || this->is_sequence_divider_color(pixel)) {
+                            continue;
+                        }
+
+                        if(!column.has_virtual_pixels) {
+                            column.has_virtual_pixels = true;
+                            column.virtual_min_y = y;
+                        }
+                        column.virtual_max_y = y;
+
+                        // This is for anything that's not a cyan/magenta/blue pixel
+                        if(this->is_spacing_color(pixel)) {
+                            continue;
+                        }
+
+                        if(!column.has_pixels) {
+                            column.has_pixels = true;
+                            column.min_y = y;
+                        }
+                        column.max_y = y;
+                    }
+                }
+            }
+        });
+
+        // Next, go through each sequence in order to find the bitmaps
+        for(std::size_t s = 0; s < sequence_count; s++) {
+            auto &sequence = generated_bitmap.sequences[s];
+            auto &bounds = column_bounds[s];
             sequence.first_bitmap = generated_bitmap.bitmaps.size();
             sequence.bitmap_count = 0;
 
-            // Search left and right for bitmap borders
-            const std::uint32_t X_END = width;
             const std::uint32_t Y_START = sequence.y_start;
             const std::uint32_t Y_END = sequence.y_end;
 
             // This is used for the registration point
             const double MID_Y = (static_cast<double>(Y_START) + static_cast<double>(Y_END)) / 2.0;
 
-            // Go through each pixel
             for(std::uint32_t x = 0; x < X_END; x++) {
-                for(std::uint32_t y = Y_START; y < Y_END; y++) {
-                    auto &pixel = GET_PIXEL(x,y);
+                // Ignore? Okay.
+                if(!bounds[x].has_virtual_pixels) {
+                    continue;
+                }
 
-                    // Ignore? Okay.
-                    if(this->is_transparency_color(pixel) || this->is_sequence_divider_color(pixel)) {
-                        continue;
+                // Begin.
+                std::optional<std::uint32_t> min_x;
+                std::optional<std::uint32_t> max_x;
+                std::optional<std::uint32_t> min_y;
+                std::optional<std::uint32_t> max_y;
+
+                std::uint32_t virtual_min_x = x;
+                std::uint32_t virtual_max_x = x;
+                std::uint32_t virtual_min_y = bounds[x].virtual_min_y;
+                std::uint32_t virtual_max_y = bounds[x].virtual_max_y;
+
+                // Find the minimum x, y, max x, and max y stuff until we hit a column with nothing in it
+                std::uint32_t xb;
+                for(xb = x; xb < X_END && bounds[xb].has_virtual_pixels; xb++) {
+                    auto &column = bounds[xb];
+
+                    virtual_max_x = xb;
+                    virtual_min_y = std::min(virtual_min_y, column.virtual_min_y);
+                    virtual_max_y = std::max(virtual_max_y, column.virtual_max_y);
+
+                    if(column.has_pixels) {
+                        if(min_x.has_value()) {
+                            min_y = std::min(*min_y, column.min_y);
+                            max_y = std::max(*max_y, column.max_y);
+                        }
+                        else {
+                            min_x = xb;
+                            min_y = column.min_y;
+                            max_y = column.max_y;
+                        }
+                        max_x = xb;
                     }
+                }
 
-                    // Begin.
-                    std::optional<std::uint32_t> min_x;
-                    std::optional<std::uint32_t> max_x;
-                    std::optional<std::uint32_t> min_y;
-                    std::optional<std::uint32_t> max_y;
-
-                    std::optional<std::uint32_t> virtual_min_x;
-                    std::optional<std::uint32_t> virtual_max_x;
-                    std::optional<std::uint32_t> virtual_min_y;
-                    std::optional<std::uint32_t> virtual_max_y;
-
-                    // Find the minimum x, y, max x, and max y stuff
-                    for(std::uint32_t xb = x; xb < X_END; xb++) {
-                        // Set this to false if we got something this column
-                        bool ignored_this_x = true;
-
-                        for(std::uint32_t yb = Y_START; yb < Y_END; yb++) {
-                            auto &pixel = GET_PIXEL(xb, yb);
-
-                            // This is for anything that's not a cyan/magenta/blue pixel
-                            if(!this->is_ignored(pixel)) {
-                                if(min_x.has_value()) {
-                                    if(min_x.value() > xb) {
-                                        min_x = xb;
-                                    }
-                                    if(min_y.value() > yb) {
-                                        min_y = yb;
-                                    }
-                                    if(max_x.value() < xb) {
-                                        max_x = xb;
-                                    }
-                                    if(max_y.value() < yb) {
-                                        max_y = yb;
-                                    }
-                                }
-                                else {
-                                    min_x = xb;
-                                    min_y = yb;
-                                    max_x = xb;
-                                    max_y = yb;
-                                }
-                            }
+                // If we never got a minimum x, then there is nothing up to the empty column
+                if(!min_x.has_value()) {
+                    x = xb;
+                    continue;
+                }
 
-                            // Anything that's not a magenta/blue pixel then
-                            if(!this->is_transparency_color(pixel) && !this->is_sequence_divider_color(pixel)) {
-                                ignored_this_x = false;
-
-                                if(virtual_min_x.has_value()) {
-                                    if(virtual_min_x.value() > xb) {
-                                        virtual_min_x = xb;
-                                    }
-                                    if(virtual_min_y.value() > yb) {
-                                        virtual_min_y = yb;
-                                    }
-                                    if(virtual_max_x.value() < xb) {
-                                        virtual_max_x = xb;
-                                    }
-                                    if(virtual_max_y.value() < yb) {
-                                        virtual_max_y = yb;
-                                    }
-                                }
-                                else {
-                                    virtual_min_x = xb;
-                                    virtual_min_y = yb;
-                                    virtual_max_x = xb;
-                                    virtual_max_y = yb;
-                                }
-                            }
-                        }
+                // Get the width and height
+                std::uint32_t bitmap_width = max_x.value() - min_x.value() + 1;
+                std::uint32_t bitmap_height = max_y.value() - min_y.value() + 1;
 
-                        if(ignored_this_x) {
-                            break;
-                        }
+                // If we require power-of-two, check
+                if(power_of_two) {
+                    if(!HEK::is_power_of_two(bitmap_width)) {
+                        BufferedOutput::print_to(this->output, BufferedOutput::OUTPUT_PLAIN_ERROR, ERROR_INVALID_BITMAP_WIDTH, bitmap_width);
+                        throw InvalidInputBitmapException();
                     }
-
-                    // If we never got a minimum x, then continue on
-                    if(!min_x.has_value()) {
-                        continue;
+                    if(!HEK::is_power_of_two(bitmap_height)) {
+                        BufferedOutput::print_to(this->output, BufferedOutput::OUTPUT_PLAIN_ERROR, ERROR_INVALID_BITMAP_HEIGHT, bitmap_height);
+                        throw InvalidInputBitmapException();
                     }
+                }
 
-                    // Get the width and height
-                    std::uint32_t bitmap_width = max_x.value() - min_x.value() + 1;
-                    std::uint32_t bitmap_height = max_y.value() - min_y.value() + 1;
+                // Add the bitmap (the pixels are loaded once all of the bitmaps are found)
+                auto &bitmap = generated_bitmap.bitmaps.emplace_back();
+                bitmap.width = bitmap_width;
+                bitmap.height = bitmap_height;
+                bitmap.color_plate_x = min_x.value();
+                bitmap.color_plate_y = min_y.value();
+                
+                auto min_x_f = static_cast<double>(*min_x);
+                auto min_y_f = static_cast<double>(*min_y);
+                auto virtual_min_x_f = static_cast<double>(virtual_min_x);
+                auto virtual_min_y_f = static_cast<double>(virtual_min_y);
+                
+                auto virtual_max_x_f = static_cast<double>(virtual_max_x);
+                auto virtual_max_y_f = static_cast<double>(virtual_max_y);
 
-                    // If we require power-of-two, check
-                    if(power_of_two) {
-                        if(!HEK::is_power_of_two(bitmap_width)) {
-                            eprintf(ERROR_INVALID_BITMAP_WIDTH, bitmap_width);
-                            throw InvalidInputBitmapException();
-                        }
-                        if(!HEK::is_power_of_two(bitmap_height)) {
-                            eprintf(ERROR_INVALID_BITMAP_HEIGHT, bitmap_height);
-                            throw InvalidInputBitmapException();
-                        }
-                    }
+                // Calculate registration point.
+                const double MID_X = (virtual_max_x_f + virtual_min_x_f) / 2.0;
 
-                    // Add the bitmap
-                    auto &bitmap = generated_bitmap.bitmaps.emplace_back();
-                    bitmap.width = bitmap_width;
-                    bitmap.height = bitmap_height;
-                    bitmap.color_plate_x = min_x.value();
-                    bitmap.color_plate_y = min_y.value();
-                    
-                    assert(min_x.has_value());
-                    assert(min_y.has_value());
-                    assert(virtual_min_x.has_value());
-                    assert(virtual_min_y.has_value());
-                    
-                    assert(max_x.has_value());
-                    assert(max_y.has_value());
-                    assert(virtual_max_x.has_value());
-                    assert(virtual_max_y.has_value());
-                    
-                    auto min_x_f = static_cast<double>(*min_x);
-                    auto min_y_f = static_cast<double>(*min_y);
-                    auto virtual_min_x_f = static_cast<double>(*virtual_min_x);
-                    auto virtual_min_y_f = static_cast<double>(*virtual_min_y);
-                    
-                    //auto max_x_f = static_cast<double>(*max_x);
-                    //auto max_y_f = static_cast<double>(*max_y);
-                    auto virtual_max_x_f = static_cast<double>(*virtual_max_x);
-                    auto virtual_max_y_f = static_cast<double>(*virtual_max_y);
+                // The x point is the midpoint of the width of the bitmap and cyan stuff relative to the left
+                bitmap.registration_point_x = MID_X - min_x_f + 0.5;
 
-                    // Calculate registration point.
-                    const double MID_X = (virtual_max_x_f + virtual_min_x_f) / 2.0;
+                // The y point is the midpoint of the height of the entire sequence relative to the top (or if we have the reg point hack, relative to the top of the bitmap itself)
+                if(!reg_point_hack) {
+                    bitmap.registration_point_y = MID_Y - min_y_f + 0.5;
+                }
+                else {
+                    bitmap.registration_point_y = virtual_min_y_f - min_y_f + (virtual_max_y_f - virtual_min_y_f) / 2.0 + 0.5;
+                }
 
-                    // The x point is the midpoint of the width of the bitmap and cyan stuff relative to the left
-                    bitmap.registration_point_x = MID_X - min_x_f + 0.5;
+                sequence.bitmap_count++;
 
-                    // The y point is the midpoint of the height of the entire sequence relative to the top (or if we have the reg point hack, relative to the top of the bitmap itself)
-                    if(!reg_point_hack) {
-                        bitmap.registration_point_y = MID_Y - min_y_f + 0.5;
-                    }
-                    else {
-                        bitmap.registration_point_y = virtual_min_y_f - min_y_f + (virtual_max_y_f - virtual_min_y_f) / 2.0 + 0.5;
-                    }
+                // Set it to the max value. Add 1 since sprites can't possibly be adjacent to each other. Then, the for loop will add 1 again to get to the minimum possible x value.
+                x = virtual_max_x + 1;
+            }
+        }
 
-                    // Load the pixels
-                    for(std::uint32_t by = min_y.value(); by <= max_y.value(); by++) {
-                        for(std::uint32_t bx = min_x.value(); bx <= max_x.value(); bx++) {
-                            auto &pixel = GET_PIXEL(bx, by);
-                            if(this->is_ignored(pixel)) {
-                                bitmap.pixels.push_back(Pixel {});
-                            }
-                            else {
-                                bitmap.pixels.push_back(pixel);
-                            }
+        // Load the pixels
+        this->for_each_band(generated_bitmap.bitmaps.size(), [this, &generated_bitmap, &pixels, &width](std::size_t bitmap_start, std::size_t bitmap_end) {
+            for(std::size_t b = bitmap_start; b < bitmap_end; b++) {
+                auto &bitmap = generated_bitmap.bitmaps[b];
+                bitmap.pixels.reserve(static_cast<std::size_t>(bitmap.width) * bitmap.height);
+                for(std::uint32_t by = bitmap.color_plate_y; by < bitmap.color_plate_y + bitmap.height; by++) {
+                    for(std::uint32_t bx = bitmap.color_plate_x; bx < bitmap.color_plate_x + bitmap.width; bx++) {
+                        auto &pixel = GET_PIXEL(bx, by);
+                        if(this->is_ignored(pixel)) {
+                            bitmap.pixels.push_back(Pixel {});
+                        }
+                        else {
+                            bitmap.pixels.push_back(pixel);
                         }
                     }
-
-                    sequence.bitmap_count++;
-
-                    // Set it to the max value. Add 1 since sprites can't possibly be adjacent to each other. Then, the for loop will add 1 again to get to the minimum possible x value.
-                    x = virtual_max_x.value() + 1;
-                    break;
                 }
             }
-        }
+        });
     }
 
     void ColorPlateScanner::read_unrolled_cubemap(GeneratedBitmapData &generated_bitmap, const Pixel *pixels, std::uint32_t width, std::uint32_t height) const {
@@ -377,7 +449,7 @@ namespace Invader {
         std::uint32_t face_height = face_width;
 
         if(!HEK::is_power_of_two(face_width) || face_width < 1 || face_width * 4 != width || face_height * 3 > height) {
-            eprintf_error("Error: Invalid cubemap input dimensions %ux%u", face_width, face_height);
+            BufferedOutput::print_to(this->output, BufferedOutput::OUTPUT_ERROR, "Error: Invalid cubemap input dimensions %ux%u", face_width, face_height);
             throw InvalidInputBitmapException();
         }
 
@@ -436,11 +508,11 @@ namespace Invader {
     void ColorPlateScanner::read_single_bitmap(GeneratedBitmapData &generated_bitmap, const Pixel *pixels, std::uint32_t width, std::uint32_t height) const {
         if(this->power_of_two) {
             if(!HEK::is_power_of_two(width)) {
-                eprintf(ERROR_INVALID_BITMAP_WIDTH, width);
+                BufferedOutput::print_to(this->output, BufferedOutput::OUTPUT_PLAIN_ERROR, ERROR_INVALID_BITMAP_WIDTH, width);
                 throw InvalidInputBitmapException();
             }
             if(!HEK::is_power_of_two(height)) {
-                eprintf(ERROR_INVALID_BITMAP_WIDTH, height);
+                BufferedOutput::print_to(this->output, BufferedOutput::OUTPUT_PLAIN_ERROR, ERROR_INVALID_BITMAP_WIDTH, height);
                 throw InvalidInputBitmapException();
             }
         }
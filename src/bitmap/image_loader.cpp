@@ -1,9 +1,18 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
 #include <tiffio.h>
+#include <zlib.h>
 #include "image_loader.hpp"
 #include <invader/printf.hpp>
 #include "stb/stb_image.h"
+#include <exception>
+#include <optional>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <atomic>
+#include <thread>
+#include <algorithm>
 
 namespace Invader {
     static std::vector<Pixel> rgba_to_pixel(const std::uint8_t *data, std::size_t pixel_count) {
@@ -22,22 +31,417 @@ namespace Invader {
 
     #undef ALLOCATE_PIXELS
 
-    std::vector<Pixel> load_image(const char *path, std::uint32_t &image_width, std::uint32_t &image_height, std::size_t &image_size) {
+    static std::uint32_t read_png_uint32(const std::uint8_t *data) {
+        return (static_cast<std::uint32_t>(data[0]) << 24) | (static_cast<std::uint32_t>(data[1]) << 16) | (static_cast<std::uint32_t>(data[2]) << 8) | static_cast<std::uint32_t>(data[3]);
+    }
+
+    static std::uint16_t read_png_uint16(const std::uint8_t *data) {
+        return static_cast<std::uint16_t>((data[0] << 8) | data[1]);
+    }
+
+    std::optional<std::vector<Pixel>> load_png_by_row(const char *path, std::uint32_t &image_width, std::uint32_t &image_height) {
+        std::FILE *file = std::fopen(path, "rb");
+        if(!file) {
+            return std::nullopt;
+        }
+
+        // Close the file and inflater when we're done, whatever happens
+        z_stream inflate_stream = {};
+        bool inflate_initialized = false;
+        struct PNGCleanup {
+            std::FILE *&file;
+            z_stream &inflate_stream;
+            bool &inflate_initialized;
+            ~PNGCleanup() {
+                std::fclose(file);
+                if(inflate_initialized) {
+                    inflateEnd(&inflate_stream);
+                }
+            }
+        } cleanup = { file, inflate_stream, inflate_initialized };
+
+        auto read_exactly = [&file](void *data, std::size_t size) -> bool {
+            return std::fread(data, 1, size, file) == size;
+        };
+
+        static constexpr const std::uint8_t PNG_SIGNATURE[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        std::uint8_t signature[sizeof(PNG_SIGNATURE)];
+        if(!read_exactly(signature, sizeof(signature)) || std::memcmp(signature, PNG_SIGNATURE, sizeof(signature)) != 0) {
+            return std::nullopt;
+        }
+
+        #define PNG_CHUNK_TYPE(a, b, c, d) ((static_cast<std::uint32_t>(a) << 24) | (static_cast<std::uint32_t>(b) << 16) | (static_cast<std::uint32_t>(c) << 8) | static_cast<std::uint32_t>(d))
+
+        std::uint32_t width = 0, height = 0;
+        std::uint8_t depth = 0, color = 0;
+        std::size_t channels = 0;
+        std::size_t row_size = 0;
+        std::size_t filter_bytes = 0;
+
+        std::uint8_t palette[256 * 4];
+        std::size_t palette_count = 0;
+        bool has_transparency = false;
+        std::uint16_t transparency_color[3] = {};
+
+        std::vector<Pixel> pixels;
+        std::vector<std::uint8_t> current_row, previous_row;
+        std::size_t current_row_offset = 0;
+        std::uint32_t rows_done = 0;
+        bool first = true;
+        bool idat_done = false;
+
+        // Scale a sample of a gray image to 8-bit like stb_image does
+        static constexpr const std::uint8_t DEPTH_SCALE[] = { 0, 0xFF, 0x55, 0, 0x11, 0, 0, 0, 0x01 };
+
+        auto unfilter_and_convert_row = [&]() -> bool {
+            auto filter = current_row[0];
+            auto *row = current_row.data() + 1;
+            const auto *prior = previous_row.data() + 1;
+
+            switch(filter) {
+                case 0:
+                    break;
+                case 1:
+                    for(std::size_t i = filter_bytes; i < row_size; i++) {
+                        row[i] = static_cast<std::uint8_t>(row[i] + row[i - filter_bytes]);
+                    }
+                    break;
+                case 2:
+                    for(std::size_t i = 0; i < row_size; i++) {
+                        row[i] = static_cast<std::uint8_t>(row[i] + prior[i]);
+                    }
+                    break;
+                case 3:
+                    for(std::size_t i = 0; i < row_size; i++) {
+                        int left = i >= filter_bytes ? row[i - filter_bytes] : 0;
+                        row[i] = static_cast<std::uint8_t>(row[i] + ((left + prior[i]) >> 1));
+                    }
+                    break;
+                case 4:
+                    for(std::size_t i = 0; i < row_size; i++) {
+                        int a = i >= filter_bytes ? row[i - filter_bytes] : 0;
+                        int b = prior[i];
+                        int c = i >= filter_bytes ? prior[i - filter_bytes] : 0;
+                        int p = a + b - c;
+                        int pa = std::abs(p - a);
+                        int pb = std::abs(p - b);
+                        int pc = std::abs(p - c);
+                        int paeth = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+                        row[i] = static_cast<std::uint8_t>(row[i] + paeth);
+                    }
+                    break;
+                default:
+                    return false;
+            }
+
+            // Get a sample at its original depth
+            auto sample = [&row](std::size_t x, std::size_t channel, std::size_t channels, std::uint8_t depth) -> std::uint16_t {
+                if(depth == 16) {
+                    return read_png_uint16(row + (x * channels + channel) * 2);
+                }
+                else if(depth == 8) {
+                    return row[x * channels + channel];
+                }
+                else {
+                    std::size_t bit = x * depth;
+                    return (row[bit / 8] >> (8 - depth - bit % 8)) & ((1 << depth) - 1);
+                }
+            };
+
+            // And at 8-bit
+            auto sample_8 = [&sample, &color](std::size_t x, std::size_t channel, std::size_t channels, std::uint8_t depth) -> std::uint8_t {
+                auto value = sample(x, channel, channels, depth);
+                if(depth == 16) {
+                    return static_cast<std::uint8_t>(value >> 8);
+                }
+                else if(color == 0) {
+                    return static_cast<std::uint8_t>(value * DEPTH_SCALE[depth]);
+                }
+                else {
+                    return static_cast<std::uint8_t>(value);
+                }
+            };
+
+            // Transparent if every color sample matches the tRNS color
+            auto transparent = [&sample, &sample_8, &transparency_color](std::size_t x, std::size_t channels, std::uint8_t depth) -> bool {
+                for(std::size_t c = 0; c < channels; c++) {
+                    if(depth == 16 ? (sample(x, c, channels, depth) != transparency_color[c]) : (sample_8(x, c, channels, depth) != static_cast<std::uint8_t>((transparency_color[c] & 0xFF) * DEPTH_SCALE[depth]))) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            auto *output = pixels.data() + static_cast<std::size_t>(rows_done) * width;
+            for(std::size_t x = 0; x < width; x++) {
+                auto &pixel = output[x];
+                switch(color) {
+                    case 0:
+                        pixel.red = pixel.green = pixel.blue = sample_8(x, 0, 1, depth);
+                        pixel.alpha = (has_transparency && transparent(x, 1, depth)) ? 0 : 0xFF;
+                        break;
+                    case 2:
+                        pixel.red = sample_8(x, 0, 3, depth);
+                        pixel.green = sample_8(x, 1, 3, depth);
+                        pixel.blue = sample_8(x, 2, 3, depth);
+                        pixel.alpha = (has_transparency && transparent(x, 3, depth)) ? 0 : 0xFF;
+                        break;
+                    case 3: {
+                        auto index = sample(x, 0, 1, depth);
+                        if(index >= palette_count) {
+                            return false;
+                        }
+                        auto *entry = palette + index * 4;
+                        pixel.red = entry[0];
+                        pixel.green = entry[1];
+                        pixel.blue = entry[2];
+                        pixel.alpha = entry[3];
+                        break;
+                    }
+                    case 4:
+                        pixel.red = pixel.green = pixel.blue = sample_8(x, 0, 2, depth);
+                        pixel.alpha = sample_8(x, 1, 2, depth);
+                        break;
+                    case 6:
+                        pixel.red = sample_8(x, 0, 4, depth);
+                        pixel.green = sample_8(x, 1, 4, depth);
+                        pixel.blue = sample_8(x, 2, 4, depth);
+                        pixel.alpha = sample_8(x, 3, 4, depth);
+                        break;
+                }
+            }
+
+            std::swap(current_row, previous_row);
+            current_row_offset = 0;
+            rows_done++;
+            return true;
+        };
+
+        std::vector<std::uint8_t> buffer;
+        while(true) {
+            std::uint8_t chunk_header[8];
+            if(!read_exactly(chunk_header, sizeof(chunk_header))) {
+                return std::nullopt;
+            }
+            auto chunk_length = read_png_uint32(chunk_header);
+            auto chunk_type = read_png_uint32(chunk_header + 4);
+
+            if(first && chunk_type != PNG_CHUNK_TYPE('I','H','D','R')) {
+                return std::nullopt;
+            }
+
+            switch(chunk_type) {
+                case PNG_CHUNK_TYPE('I','H','D','R'): {
+                    std::uint8_t ihdr[13];
+                    if(!first || chunk_length != sizeof(ihdr) || !read_exactly(ihdr, sizeof(ihdr))) {
+                        return std::nullopt;
+                    }
+                    first = false;
+
+                    width = read_png_uint32(ihdr);
+                    height = read_png_uint32(ihdr + 4);
+                    depth = ihdr[8];
+                    color = ihdr[9];
+                    auto compression = ihdr[10];
+                    auto filter = ihdr[11];
+                    auto interlace = ihdr[12];
+
+                    // Interlaced images are left to stb_image, as are any dimensions it would reject
+                    if(compression != 0 || filter != 0 || interlace != 0 || width == 0 || height == 0 || width > (1 << 24) || height > (1 << 24)) {
+                        return std::nullopt;
+                    }
+
+                    switch(color) {
+                        case 0:
+                            channels = 1;
+                            if(depth != 1 && depth != 2 && depth != 4 && depth != 8 && depth != 16) {
+                                return std::nullopt;
+                            }
+                            break;
+                        case 3:
+                            channels = 1;
+                            if(depth != 1 && depth != 2 && depth != 4 && depth != 8) {
+                                return std::nullopt;
+                            }
+                            break;
+                        case 2:
+                        case 4:
+                        case 6:
+                            channels = color == 2 ? 3 : (color == 4 ? 2 : 4);
+                            if(depth != 8 && depth != 16) {
+                                return std::nullopt;
+                            }
+                            break;
+                        default:
+                            return std::nullopt;
+                    }
+
+                    // stb_image rejects anything over 1 GiB
+                    if((1 << 30) / width / channels < height) {
+                        return std::nullopt;
+                    }
+
+                    row_size = (static_cast<std::size_t>(width) * channels * depth + 7) / 8;
+                    filter_bytes = std::max<std::size_t>(1, channels * depth / 8);
+                    current_row.resize(row_size + 1);
+                    previous_row.resize(row_size + 1);
+                    buffer.resize(65536);
+                    break;
+                }
+
+                case PNG_CHUNK_TYPE('C','g','B','I'):
+                    return std::nullopt;
+
+                case PNG_CHUNK_TYPE('P','L','T','E'): {
+                    if(chunk_length > 256 * 3 || chunk_length % 3 != 0 || chunk_length == 0 || !read_exactly(buffer.data(), chunk_length)) {
+                        return std::nullopt;
+                    }
+                    palette_count = chunk_length / 3;
+                    for(std::size_t i = 0; i < palette_count; i++) {
+                        palette[i * 4 + 0] = buffer[i * 3 + 0];
+                        palette[i * 4 + 1] = buffer[i * 3 + 1];
+                        palette[i * 4 + 2] = buffer[i * 3 + 2];
+                        palette[i * 4 + 3] = 0xFF;
+                    }
+                    break;
+                }
+
+                case PNG_CHUNK_TYPE('t','R','N','S'): {
+                    if(!pixels.empty() || chunk_length > 256 || !read_exactly(buffer.data(), chunk_length)) {
+                        return std::nullopt;
+                    }
+                    if(color == 3) {
+                        if(palette_count == 0 || chunk_length > palette_count) {
+                            return std::nullopt;
+                        }
+                        for(std::size_t i = 0; i < chunk_length; i++) {
+                            palette[i * 4 + 3] = buffer[i];
+                        }
+                    }
+                    else {
+                        if(color == 4 || color == 6 || chunk_length != channels * 2) {
+                            return std::nullopt;
+                        }
+                        for(std::size_t c = 0; c < channels; c++) {
+                            transparency_color[c] = read_png_uint16(buffer.data() + c * 2);
+                        }
+                        has_transparency = true;
+                    }
+                    break;
+                }
+
+                case PNG_CHUNK_TYPE('I','D','A','T'): {
+                    if(color == 3 && palette_count == 0) {
+                        return std::nullopt;
+                    }
+
+                    // Allocate the pixels once we know we actually have image data
+                    if(!inflate_initialized) {
+                        if(inflateInit(&inflate_stream) != Z_OK) {
+                            return std::nullopt;
+                        }
+                        inflate_initialized = true;
+                        pixels.resize(static_cast<std::size_t>(width) * height);
+                    }
+
+                    std::uint32_t remaining = chunk_length;
+                    while(remaining > 0) {
+                        auto read_size = std::min<std::uint32_t>(remaining, buffer.size());
+                        if(!read_exactly(buffer.data(), read_size)) {
+                            return std::nullopt;
+                        }
+                        remaining -= read_size;
+
+                        // Anything after the last row is ignored
+                        if(idat_done) {
+                            continue;
+                        }
+
+                        inflate_stream.next_in = buffer.data();
+                        inflate_stream.avail_in = read_size;
+                        while(!idat_done) {
+                            inflate_stream.next_out = current_row.data() + current_row_offset;
+                            inflate_stream.avail_out = current_row.size() - current_row_offset;
+                            auto result = inflate(&inflate_stream, Z_NO_FLUSH);
+                            current_row_offset = current_row.size() - inflate_stream.avail_out;
+
+                            // If we filled the row, there may be more to inflate even if we're out of input
+                            bool row_done = current_row_offset == current_row.size();
+                            if(row_done) {
+                                if(!unfilter_and_convert_row()) {
+                                    return std::nullopt;
+                                }
+                                idat_done = rows_done == height;
+                            }
+
+                            if(result == Z_STREAM_END) {
+                                if(!idat_done) {
+                                    return std::nullopt;
+                                }
+                                break;
+                            }
+                            else if(result != Z_OK && result != Z_BUF_ERROR) {
+                                return std::nullopt;
+                            }
+                            else if(!row_done) {
+                                break;
+                            }
+                        }
+                    }
+                    break;
+                }
+
+                case PNG_CHUNK_TYPE('I','E','N','D'):
+                    if(!idat_done) {
+                        return std::nullopt;
+                    }
+                    image_width = width;
+                    image_height = height;
+                    return pixels;
+
+                default:
+                    // Unknown critical chunks are an error
+                    if((chunk_type & (1 << 29)) == 0) {
+                        return std::nullopt;
+                    }
+                    if(std::fseek(file, chunk_length, SEEK_CUR) != 0) {
+                        return std::nullopt;
+                    }
+                    break;
+            }
+
+            // Skip the CRC
+            if(std::fseek(file, 4, SEEK_CUR) != 0) {
+                return std::nullopt;
+            }
+        }
+
+        #undef PNG_CHUNK_TYPE
+    }
+
+    std::vector<Pixel> load_image(const char *path, std::uint32_t &image_width, std::uint32_t &image_height, std::size_t &image_size, BufferedOutput *output) {
+        // PNGs can be decoded a row at a time, which keeps memory usage down for large color plates
+        auto png = load_png_by_row(path, image_width, image_height);
+        if(png.has_value()) {
+            image_size = static_cast<std::size_t>(image_width) * image_height * sizeof(Invader::Pixel);
+            return std::move(*png);
+        }
+
         // Load it
         int x = 0, y = 0, channels = 0;
         auto *image_buffer = stbi_load(path, &x, &y, &channels, 4);
         if(!image_buffer) {
-            eprintf_error("Failed to load %s. Error was: %s", path, stbi_failure_reason());
-            exit(EXIT_FAILURE);
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Failed to load %s. Error was: %s", path, stbi_failure_reason());
+            throw std::exception();
         }
 
         // Get the width and height
         image_width = static_cast<std::uint32_t>(x);
         image_height = static_cast<std::uint32_t>(y);
-        image_size = image_width * image_height * sizeof(Invader::Pixel);
+        image_size = static_cast<std::size_t>(image_width) * image_height * sizeof(Invader::Pixel);
 
         // Do the thing
-        auto return_value = rgba_to_pixel(reinterpret_cast<std::uint8_t *>(image_buffer), image_width * image_height);
+        auto return_value = rgba_to_pixel(reinterpret_cast<std::uint8_t *>(image_buffer), static_cast<std::size_t>(image_width) * image_height);
 
         // Free the buffer
         stbi_image_free(image_buffer);
@@ -45,14 +449,11 @@ namespace Invader {
         return return_value;
     }
 
-    std::vector<Pixel> load_tiff(const char *path, std::uint32_t &image_width, std::uint32_t &image_height, std::size_t &image_size) {
+    static TIFF *open_tiff(const char *path) {
         TIFF *image_tiff = TIFFOpen(path, "r");
         if(!image_tiff) {
-            eprintf_error("Cannot open %s", path);
-            exit(EXIT_FAILURE);
+            return nullptr;
         }
-        TIFFGetField(image_tiff, TIFFTAG_IMAGEWIDTH, &image_width);
-        TIFFGetField(image_tiff, TIFFTAG_IMAGELENGTH, &image_height);
 
         // Force associated alpha if we have alpha so alpha doesn't get multiplied in TIFFReadRGBAImageOriented
         std::uint16_t count;
@@ -65,22 +466,156 @@ namespace Invader {
             }
         }
 
+        return image_tiff;
+    }
+
+    /**
+     * Read each strip or tile of the TIFF on multiple threads, converting them straight into pixels
+     * @param path         path to the image (each thread opens the image on its own)
+     * @param image_tiff   image that is already opened
+     * @param image_width  width of the image
+     * @param image_height height of the image
+     * @param pixels       pixels to write to
+     * @param max_threads  maximum number of threads to use
+     * @return             true if successful, or false if the image has to be read in one go
+     */
+    static bool load_tiff_parts(const char *path, TIFF *image_tiff, std::uint32_t image_width, std::uint32_t image_height, Pixel *pixels, std::size_t max_threads) {
+        // Strips and tiles are read bottom-up, so only flip images that are stored top-down
+        std::uint16_t orientation = ORIENTATION_TOPLEFT;
+        TIFFGetFieldDefaulted(image_tiff, TIFFTAG_ORIENTATION, &orientation);
+        char error[1024];
+        if(orientation != ORIENTATION_TOPLEFT || !TIFFRGBAImageOK(image_tiff, error)) {
+            return false;
+        }
+
+        bool tiled = TIFFIsTiled(image_tiff);
+        std::uint32_t part_width = image_width, part_height = 0;
+        if(tiled) {
+            TIFFGetField(image_tiff, TIFFTAG_TILEWIDTH, &part_width);
+            TIFFGetField(image_tiff, TIFFTAG_TILELENGTH, &part_height);
+        }
+        else {
+            TIFFGetFieldDefaulted(image_tiff, TIFFTAG_ROWSPERSTRIP, &part_height);
+            part_height = std::min(part_height, image_height);
+        }
+        if(part_width == 0 || part_height == 0) {
+            return false;
+        }
+
+        std::size_t parts_across = (image_width + part_width - 1) / part_width;
+        std::size_t parts_down = (image_height + part_height - 1) / part_height;
+        std::size_t part_count = parts_across * parts_down;
+
+        std::atomic<std::size_t> next_part = 0;
+        std::atomic<bool> failed = false;
+
+        auto part_thread = [&](TIFF *thread_tiff) {
+            // libtiff handles can't be shared between threads
+            bool own_tiff = thread_tiff == nullptr;
+            if(own_tiff) {
+                thread_tiff = open_tiff(path);
+                if(!thread_tiff) {
+                    failed = true;
+                    return;
+                }
+            }
+
+            std::vector<std::uint32_t> raster(static_cast<std::size_t>(part_width) * part_height);
+            while(!failed) {
+                auto p = next_part.fetch_add(1, std::memory_order_relaxed);
+                if(p >= part_count) {
+                    break;
+                }
+
+                std::uint32_t left = static_cast<std::uint32_t>((p % parts_across) * part_width);
+                std::uint32_t top = static_cast<std::uint32_t>((p / parts_across) * part_height);
+                std::uint32_t columns = std::min(part_width, image_width - left);
+                std::uint32_t rows = std::min(part_height, image_height - top);
+
+                // Tiles are always a full tile, but the last strip only has the rows that are left
+                std::uint32_t raster_rows;
+                if(tiled) {
+                    if(!TIFFReadRGBATile(thread_tiff, left, top, raster.data())) {
+                        failed = true;
+                        break;
+                    }
+                    raster_rows = part_height;
+                }
+                else {
+                    if(!TIFFReadRGBAStrip(thread_tiff, top, raster.data())) {
+                        failed = true;
+                        break;
+                    }
+                    raster_rows = rows;
+                }
+
+                for(std::uint32_t y = 0; y < rows; y++) {
+                    const auto *input = raster.data() + static_cast<std::size_t>(raster_rows - y - 1) * part_width;
+                    auto *output = pixels + static_cast<std::size_t>(top + y) * image_width + left;
+                    for(std::uint32_t x = 0; x < columns; x++) {
+                        auto abgr = input[x];
+                        output[x].red = TIFFGetR(abgr);
+                        output[x].green = TIFFGetG(abgr);
+                        output[x].blue = TIFFGetB(abgr);
+                        output[x].alpha = TIFFGetA(abgr);
+                    }
+                }
+            }
+
+            if(own_tiff) {
+                TIFFClose(thread_tiff);
+            }
+        };
+
+        auto thread_count = std::min(max_threads, part_count);
+        if(thread_count <= 1) {
+            part_thread(image_tiff);
+        }
+        else {
+            std::vector<std::thread> threads;
+            threads.reserve(thread_count);
+            threads.emplace_back(part_thread, image_tiff);
+            for(std::size_t j = 1; j < thread_count; j++) {
+                threads.emplace_back(part_thread, nullptr);
+            }
+            for(auto &t : threads) {
+                t.join();
+            }
+        }
+
+        return !failed;
+    }
+
+    std::vector<Pixel> load_tiff(const char *path, std::uint32_t &image_width, std::uint32_t &image_height, std::size_t &image_size, std::size_t max_threads, BufferedOutput *output) {
+        TIFF *image_tiff = open_tiff(path);
+        if(!image_tiff) {
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Cannot open %s", path);
+            throw std::exception();
+        }
+        TIFFGetField(image_tiff, TIFFTAG_IMAGEWIDTH, &image_width);
+        TIFFGetField(image_tiff, TIFFTAG_IMAGELENGTH, &image_height);
+
         // Read it all
-        image_size = image_width * image_height * sizeof(Invader::Pixel);
-        auto image_pixels = std::vector<Invader::Pixel>(image_size);
-        TIFFReadRGBAImageOriented(image_tiff, image_width, image_height, reinterpret_cast<std::uint32_t *>(image_pixels.data()), ORIENTATION_TOPLEFT);
+        std::size_t pixel_count = static_cast<std::size_t>(image_width) * image_height;
+        image_size = pixel_count * sizeof(Invader::Pixel);
+        auto image_pixels = std::vector<Invader::Pixel>(pixel_count);
 
-        // Close the TIFF
-        TIFFClose(image_tiff);
+        // Read it a strip or tile at a time if we can, otherwise read it in one go
+        if(!load_tiff_parts(path, image_tiff, image_width, image_height, image_pixels.data(), max_threads)) {
+            TIFFReadRGBAImageOriented(image_tiff, image_width, image_height, reinterpret_cast<std::uint32_t *>(image_pixels.data()), ORIENTATION_TOPLEFT);
 
-        // Swap red and blue channels
-        for(std::size_t i = 0; i < image_size / 4; i++) {
-            Invader::Pixel swapped = image_pixels[i];
-            swapped.red = image_pixels[i].blue;
-            swapped.blue = image_pixels[i].red;
-            image_pixels[i] = swapped;
+            // Swap red and blue channels
+            for(std::size_t i = 0; i < pixel_count; i++) {
+                Invader::Pixel swapped = image_pixels[i];
+                swapped.red = image_pixels[i].blue;
+                swapped.blue = image_pixels[i].red;
+                image_pixels[i] = swapped;
+            }
         }
 
+        // Close the TIFF
+        TIFFClose(image_tiff);
+
         return image_pixels;
     }
 }
@@ -4,12 +4,25 @@
 #define INVADER__BITMAP__IMAGE_LOADER_HPP
 
 #include <invader/bitmap/pixel.hpp>
+#include <invader/printf.hpp>
 #include <vector>
 #include <cstdint>
+#include <optional>
 
 namespace Invader {
-    std::vector<Pixel> load_tiff(const char *path, std::uint32_t &image_width, std::uint32_t &image_height, std::size_t &image_size);
-    std::vector<Pixel> load_image(const char *path, std::uint32_t &image_width, std::uint32_t &image_height, std::size_t &image_size);
+    /**
+     * Decode a PNG one row at a time straight into pixels, so only the pixels and two rows need to be held in memory.
+     * This gives the same result as stb_image, and anything it doesn't handle (interlaced images, Apple's CgBI PNGs, and
+     * invalid data) is left to stb_image so it can load it or report the error.
+     * @param path         path to the image
+     * @param image_width  width of the image (output)
+     * @param image_height height of the image (output)
+     * @return             pixels if successful
+     */
+    std::optional<std::vector<Pixel>> load_png_by_row(const char *path, std::uint32_t &image_width, std::uint32_t &image_height);
+
+    std::vector<Pixel> load_tiff(const char *path, std::uint32_t &image_width, std::uint32_t &image_height, std::size_t &image_size, std::size_t max_threads = 1, BufferedOutput *output = nullptr);
+    std::vector<Pixel> load_image(const char *path, std::uint32_t &image_width, std::uint32_t &image_height, std::size_t &image_size, BufferedOutput *output = nullptr);
 }
 
 #endif
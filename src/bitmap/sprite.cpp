@@ -501,7 +501,7 @@ namespace Invader {
         }
     };
     
-    std::vector<SpriteSheet> generate_sheets(std::size_t max_length, std::size_t max_sheet_count, unsigned int spacing, GeneratedBitmapData &bitmap) {
+    std::vector<SpriteSheet> generate_sheets(std::size_t max_length, std::size_t max_sheet_count, unsigned int spacing, GeneratedBitmapData &bitmap, BufferedOutput *output) {
         // Reserve it
         std::vector<SpriteSheet> sprite_sheets;
         sprite_sheets.reserve(max_sheet_count); // reserve the max sheet count (performance)
@@ -590,7 +590,7 @@ namespace Invader {
                         
                         // If we can't even fit it in a sheet by itself, then get rekt
                         if(!next_sheet->add_sprite_to_sheet_and_lock_if_needed(sprite, si)) {
-                            eprintf_error("Could not fit all sprites in sequence %zu in %zux%zu sprite sheets", si, max_length, max_length);
+                            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Could not fit all sprites in sequence %zu in %zux%zu sprite sheets", si, max_length, max_length);
                             throw InvalidTagDataException();
                         }
                     }
@@ -603,14 +603,14 @@ namespace Invader {
         
         // If we split it across multiple sheets, complain but continue
         if(split_across) {
-            eprintf_warn("%zu sequence%s had to be split across multiple sheets\nThis is valid but may cause issues", split_across, split_across == 1 ? "" : "s");
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_WARN, "%zu sequence%s had to be split across multiple sheets\nThis is valid but may cause issues", split_across, split_across == 1 ? "" : "s");
         }
         
         // Done
         return sprite_sheets;
     }
     
-    void BitmapProcessor::process_sprites(GeneratedBitmapData &generated_bitmap, BitmapProcessorSpriteParameters &parameters, std::int16_t &mipmap_count) {
+    void BitmapProcessor::process_sprites(GeneratedBitmapData &generated_bitmap, BitmapProcessorSpriteParameters &parameters, std::int16_t &mipmap_count, BufferedOutput *output) {
         // Get our parameters
         unsigned int spacing;
         
@@ -670,7 +670,7 @@ namespace Invader {
             }
         }
         
-        auto sheets = generate_sheets(max_sheet_length, max_sheet_count, spacing, generated_bitmap);
+        auto sheets = generate_sheets(max_sheet_length, max_sheet_count, spacing, generated_bitmap, output);
         unsigned long long total_pixel_usage = 0;
         unsigned long long max_pixel_usage = max_sheet_length * max_sheet_length * max_sheet_count;
         
@@ -682,7 +682,7 @@ namespace Invader {
         
         // Failure?
         if(total_pixel_usage > max_pixel_usage) {
-            eprintf_error("Maximum budget exceeded (%llu / %llu pixels)", total_pixel_usage, max_pixel_usage);
+            BufferedOutput::print_to(output, BufferedOutput::OUTPUT_ERROR, "Maximum budget exceeded (%llu / %llu pixels)", total_pixel_usage, max_pixel_usage);
             throw InvalidTagDataException();
         }
         
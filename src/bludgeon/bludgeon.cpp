@@ -12,6 +12,9 @@
 #include <invader/file/file.hpp>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <map>
+#include <sstream>
 
 #include "bludgeoner.hpp"
 
@@ -92,13 +95,62 @@ static BludgeonAction all_fixes[] = {
     { .name = "everything", .fix_bit = static_cast<std::uint64_t>(~0) }
 };
 
+// Tags that were already checked and had no issues, keyed by the tag file's size and hash
+struct BludgeonCacheKey {
+    std::uint64_t size;
+    std::uint64_t hash;
+
+    auto operator<=>(const BludgeonCacheKey &) const = default;
+};
+using BludgeonCache = std::map<BludgeonCacheKey, std::uint64_t>;
+
+static BludgeonCacheKey bludgeon_cache_key(const std::vector<std::byte> &data) noexcept {
+    return { data.size(), File::hash_data(data) };
+}
+
+// The cache is only valid for the same version and set of fixes, since the bits change if fixes are added
+static std::string bludgeon_cache_header() {
+    std::string header = std::string("invader-bludgeon cache ") + full_version() + "\n";
+    for(auto &i : all_fixes) {
+        header += i.name;
+        header += " ";
+    }
+    header += "\n";
+    return header;
+}
+
+static BludgeonCache load_bludgeon_cache(const std::filesystem::path &path) {
+    BludgeonCache cache;
+    auto text = File::open_state_file(path, bludgeon_cache_header());
+    if(!text.has_value()) {
+        return cache;
+    }
+
+    std::istringstream stream(*text);
+    BludgeonCacheKey key;
+    std::uint64_t checked;
+    while(stream >> std::hex >> key.size >> key.hash >> checked) {
+        cache[key] |= checked;
+    }
+    return cache;
+}
+
+static bool save_bludgeon_cache(const std::filesystem::path &path, const BludgeonCache &cache) {
+    std::ostringstream stream;
+    stream << std::hex;
+    for(auto &i : cache) {
+        stream << i.first.size << " " << i.first.hash << " " << i.second << "\n";
+    }
+    return File::save_state_file(path, bludgeon_cache_header(), stream.str());
+}
+
 // Singleton the printf!
 static std::mutex bad_code_design_mutex;
 #define badly_designed_printf(function, ...) bad_code_design_mutex.lock(); \
                                              function(__VA_ARGS__); \
                                              bad_code_design_mutex.unlock();
 
-static int bludgeon_tag(const std::filesystem::path &file_path, const std::string &tag_path, std::uint64_t fixes, bool &bludgeoned) {
+static int bludgeon_tag(const std::filesystem::path &file_path, const std::string &tag_path, std::uint64_t fixes, bool &bludgeoned, const BludgeonCache *cache, std::optional<BludgeonCacheKey> &verified) {
     using namespace Bludgeoner;
     using namespace HEK;
     using namespace File;
@@ -112,6 +164,17 @@ static int bludgeon_tag(const std::filesystem::path &file_path, const std::strin
         return EXIT_FAILURE;
     }
 
+    // Skip it if it was already checked for these issues and had none
+    std::uint64_t checked = fixes == 0 ? static_cast<std::uint64_t>(~0) : fixes;
+    std::optional<BludgeonCacheKey> key;
+    if(cache) {
+        key = bludgeon_cache_key(*tag);
+        auto cached = cache->find(*key);
+        if(cached != cache->end() && (cached->second & checked) == checked) {
+            return EXIT_SUCCESS;
+        }
+    }
+
     // Get the header
     std::vector<std::byte> file_data;
     try {
@@ -144,6 +207,7 @@ static int bludgeon_tag(const std::filesystem::path &file_path, const std::strin
 
         // No issues? OK
         if(!issues_present) {
+            verified = key;
             return EXIT_SUCCESS;
         }
 
@@ -188,7 +252,8 @@ int main(int argc, char * const *argv) {
         CommandLineOption::from_preset(CommandLineOption::PRESET_COMMAND_LINE_OPTION_BATCH_EXCLUDE),
         CommandLineOption::from_preset(CommandLineOption::PRESET_COMMAND_LINE_OPTION_FS_PATH),
         CommandLineOption("threads", 'j', 1, "Set the number of threads to use for parallel bludgeoning when using --batch. Default: CPU thread count"),
-        CommandLineOption("type", 'T', 1, issues_list.c_str())
+        CommandLineOption("type", 'T', 1, issues_list.c_str()),
+        CommandLineOption("cache", 'c', 1, "Skip tags that were already checked and had no issues, and remember tags that have none. Results are stored in the given file.", "<file>")
     };
 
     static constexpr char DESCRIPTION[] = "Convinces tags to work with Invader.";
@@ -200,6 +265,7 @@ int main(int argc, char * const *argv) {
         bool fs_path = false;
         std::vector<std::string> search;
         std::vector<std::string> search_exclude;
+        std::optional<std::filesystem::path> cache;
         std::size_t max_threads = std::thread::hardware_concurrency() < 1 ? 1 : std::thread::hardware_concurrency();
     } bludgeon_options;
 
@@ -237,6 +303,9 @@ int main(int argc, char * const *argv) {
                     std::exit(EXIT_FAILURE);
                 }
                 break;
+            case 'c':
+                bludgeon_options.cache = arguments[0];
+                break;
             case 'T':
                 for(auto &i : all_fixes) {
                     if(std::strcmp(arguments[0], i.name) == 0) {
@@ -274,7 +343,6 @@ int main(int argc, char * const *argv) {
 
     auto &fixes = bludgeon_options.fixes;
 
-    std::size_t success = 0;
     std::vector<File::TagFile> all_tags;
 
     if(single_tag.has_value()) {
@@ -294,44 +362,59 @@ int main(int argc, char * const *argv) {
     else {
         auto all_virtual_tags = File::load_virtual_tag_folder(std::vector<std::filesystem::path>(&bludgeon_options.tags, &bludgeon_options.tags + 1));
         all_tags.reserve(all_virtual_tags.size());
+        File::PathMatcher matcher(bludgeon_options.search, bludgeon_options.search_exclude);
         for(auto &i : all_virtual_tags) {
-            if(File::path_matches(i.tag_path.c_str(), bludgeon_options.search, bludgeon_options.search_exclude)) {
+            if(matcher.matches(i.tag_path)) {
                 all_tags.emplace_back(std::move(i));
             }
         }
     }
 
-    std::mutex thread_mutex;
+    std::optional<BludgeonCache> cache;
+    if(bludgeon_options.cache.has_value()) {
+        cache = load_bludgeon_cache(*bludgeon_options.cache);
+    }
+
+    std::mutex cache_mutex;
     std::vector<std::thread> threads;
-    std::size_t tag_index = 0;
+    std::atomic<std::size_t> tag_index = 0;
+    std::atomic<std::size_t> success = 0;
+    std::vector<BludgeonCacheKey> verified_tags;
     threads.reserve(bludgeon_options.max_threads);
 
-    auto bludgeon_worker = [](auto *all_tags, std::size_t *tag_index, std::mutex *thread_mutex, std::size_t *success, auto *fixes) {
+    auto bludgeon_worker = [&all_tags, &tag_index, &success, &fixes, &cache, &cache_mutex, &verified_tags]() {
+        std::vector<BludgeonCacheKey> verified_by_thread;
+
         while(true) {
-            thread_mutex->lock();
-            std::size_t this_index = *tag_index;
-            if(this_index == all_tags->size()) {
-                thread_mutex->unlock();
-                return;
+            std::size_t this_index = tag_index.fetch_add(1, std::memory_order_relaxed);
+            if(this_index >= all_tags.size()) {
+                break;
             }
-            (*tag_index)++;
-            thread_mutex->unlock();
 
             // Bludgeon
-            bool bludgeoned;
-            auto &tag = all_tags->data()[this_index];
-            bludgeon_tag(tag.full_path, tag.tag_path, *fixes, bludgeoned);
+            bool bludgeoned = false;
+            std::optional<BludgeonCacheKey> verified;
+            auto &tag = all_tags[this_index];
+            bludgeon_tag(tag.full_path, tag.tag_path, fixes, bludgeoned, cache.has_value() ? &*cache : nullptr, verified);
 
             // Increment
-            thread_mutex->lock();
-            (*success) += bludgeoned;
-            thread_mutex->unlock();
+            if(bludgeoned) {
+                success.fetch_add(1, std::memory_order_relaxed);
+            }
+            if(verified.has_value()) {
+                verified_by_thread.emplace_back(*verified);
+            }
+        }
+
+        if(!verified_by_thread.empty()) {
+            std::scoped_lock<std::mutex> lock(cache_mutex);
+            verified_tags.insert(verified_tags.end(), verified_by_thread.begin(), verified_by_thread.end());
         }
     };
 
     // Go through each tag
     for(std::size_t i = 0; i < bludgeon_options.max_threads; i++) {
-        threads.emplace_back(bludgeon_worker, &all_tags, &tag_index, &thread_mutex, &success, &fixes);
+        threads.emplace_back(bludgeon_worker);
     }
 
     // Wait for all threads to end
@@ -339,7 +422,19 @@ int main(int argc, char * const *argv) {
         i.join();
     }
 
-    oprintf("%s %zu out of %zu tag%s\n", fixes ? "Bludgeoned" : "Identified issues with", success, tag_index, tag_index == 1 ? "" : "s");
+    // Remember what had no issues
+    if(cache.has_value()) {
+        std::uint64_t checked = fixes == 0 ? static_cast<std::uint64_t>(~0) : fixes;
+        for(auto &i : verified_tags) {
+            (*cache)[i] |= checked;
+        }
+        if(!save_bludgeon_cache(*bludgeon_options.cache, *cache)) {
+            eprintf_warn("Failed to save the cache to %s", bludgeon_options.cache->string().c_str());
+        }
+    }
+
+    std::size_t tag_count = all_tags.size();
+    oprintf("%s %zu out of %zu tag%s\n", fixes ? "Bludgeoned" : "Identified issues with", success.load(), tag_count, tag_count == 1 ? "" : "s");
 
     return EXIT_SUCCESS;
 }
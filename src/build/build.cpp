@@ -76,6 +76,7 @@ int main(int argc, const char **argv) {
         bool do_not_auto_forge = false;
         bool use_anniverary_mode = false;
         bool use_tags_for_script_source = false;
+        std::optional<std::filesystem::path> trace;
     } build_options;
 
     const CommandLineOption options[] = {
@@ -101,6 +102,7 @@ int main(int argc, const char **argv) {
         CommandLineOption("anniversary-mode", 'a', 0, "Enable anniversary graphics and audio (CEA only)"),
         CommandLineOption("resource-maps", 'R', 1, "Specify the directory for loading resource maps. (by default this is the maps directory)", "<dir>"),
         CommandLineOption("tag-space", 'T', 1, "Override the tag space. This may result in a map that does not work with the stock games. You can specify the number of bytes, optionally suffixing with K (for KiB) or M (for MiB), or specify in hexadecimal the number of bytes (e.g. 0x1000).", "<size>"),
+        CommandLineOption("trace", 'p', 1, "Write how long each part of the build took to a Chrome trace event JSON file. This can be viewed with chrome://tracing or Perfetto.", "<file>"),
         CommandLineOption("resource-usage", 'r', 1, "Specify the behavior for using resource maps. Must be: none (don't use resource maps), check (check resource maps), always (always index tags in resource maps - Custom Edition only). Default: none", "<usage>")
     };
 
@@ -216,6 +218,9 @@ int main(int argc, const char **argv) {
             case 'O':
                 build_options.optimize_space = true;
                 break;
+            case 'p':
+                build_options.trace = arguments[0];
+                break;
             case 'H':
                 build_options.hide_pedantic_warnings = true;
                 break;
@@ -356,6 +361,7 @@ int main(int argc, const char **argv) {
         parameters.scenario = scenario;
         parameters.rename_scenario = build_options.rename_scenario;
         parameters.optimize_space = build_options.optimize_space;
+        parameters.trace = build_options.trace;
         parameters.forge_crc = build_options.forged_crc;
         parameters.index = with_index;
 
@@ -0,0 +1,215 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <algorithm>
+#include <map>
+#include <cstdio>
+
+#include <invader/build/build_profiler.hpp>
+#include <invader/file/file.hpp>
+#include <invader/printf.hpp>
+
+namespace Invader {
+    BuildProfiler::Scope::Scope(Scope &&move) noexcept : profiler(move.profiler), event(move.event) {
+        move.event = std::nullopt;
+    }
+
+    void BuildProfiler::Scope::end() noexcept {
+        if(this->event.has_value()) {
+            this->profiler->end(*this->event);
+            this->event = std::nullopt;
+        }
+    }
+
+    BuildProfiler::Scope::~Scope() noexcept {
+        this->end();
+    }
+
+    BuildProfiler::Scope BuildProfiler::phase(const char *name) {
+        return this->begin(EventType::EVENT_TYPE_PHASE, name, std::nullopt);
+    }
+
+    BuildProfiler::Scope BuildProfiler::tag(std::size_t tag_index) {
+        return this->begin(EventType::EVENT_TYPE_TAG, std::string(), tag_index);
+    }
+
+    BuildProfiler::Scope BuildProfiler::step(const char *name) {
+        return this->begin(EventType::EVENT_TYPE_STEP, name, std::nullopt);
+    }
+
+    void BuildProfiler::set_enabled(bool enabled) noexcept {
+        this->enabled = enabled;
+        this->start = std::chrono::steady_clock::now();
+    }
+
+    static double microseconds_since(std::chrono::steady_clock::time_point start) noexcept {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    BuildProfiler::Scope BuildProfiler::begin(EventType type, std::string name, std::optional<std::size_t> tag_index) {
+        if(!this->enabled) {
+            return Scope(this, std::nullopt);
+        }
+
+        std::size_t index = this->events.size();
+        auto &event = this->events.emplace_back();
+        event.name = std::move(name);
+        event.type = type;
+        event.tag_index = tag_index;
+        event.parent = this->current;
+        event.start = microseconds_since(this->start);
+        this->current = index;
+        return Scope(this, index);
+    }
+
+    void BuildProfiler::end(std::size_t event_index) noexcept {
+        auto &event = this->events[event_index];
+        event.duration = microseconds_since(this->start) - event.start;
+        this->current = event.parent;
+
+        // Time spent compiling a referenced tag is not part of the referencing tag's own time
+        if(event.type == EventType::EVENT_TYPE_TAG) {
+            for(auto parent = event.parent; parent.has_value(); parent = this->events[*parent].parent) {
+                auto &parent_event = this->events[*parent];
+                if(parent_event.type == EventType::EVENT_TYPE_TAG) {
+                    parent_event.child_tag_duration += event.duration;
+                    break;
+                }
+            }
+        }
+    }
+
+    void BuildProfiler::print_summary(const std::vector<std::string> &tag_names, const std::vector<TagFourCC> &tag_classes, std::size_t slowest_tag_count) const {
+        static const char INDENT[] = "                   ";
+
+        // Phases in the order they ran
+        const char *label = "Phases:";
+        for(auto &e : this->events) {
+            if(e.type == EventType::EVENT_TYPE_PHASE && !e.parent.has_value()) {
+                oprintf("%-19s%-32s %10.03f ms\n", label, e.name.c_str(), e.duration / 1000.0);
+                label = INDENT;
+            }
+        }
+
+        // Steps are added up by name since they can happen many times (e.g. reading each tag)
+        std::vector<std::pair<std::string, double>> steps;
+        for(auto &e : this->events) {
+            if(e.type == EventType::EVENT_TYPE_STEP) {
+                auto s = std::find_if(steps.begin(), steps.end(), [&e](auto &step) { return step.first == e.name; });
+                if(s == steps.end()) {
+                    steps.emplace_back(e.name, e.duration);
+                }
+                else {
+                    s->second += e.duration;
+                }
+            }
+        }
+        label = "Steps:";
+        for(auto &s : steps) {
+            oprintf("%-19s%-32s %10.03f ms\n", label, s.first.c_str(), s.second / 1000.0);
+            label = INDENT;
+        }
+
+        // Tags and tag classes by the time they took (not including the tags they reference)
+        std::vector<const Event *> tags;
+        std::map<TagFourCC, std::pair<std::size_t, double>> classes;
+        for(auto &e : this->events) {
+            if(e.type == EventType::EVENT_TYPE_TAG && e.tag_index.has_value() && *e.tag_index < tag_classes.size()) {
+                tags.emplace_back(&e);
+                auto &c = classes[tag_classes[*e.tag_index]];
+                c.first++;
+                c.second += e.get_self_duration();
+            }
+        }
+
+        auto slowest_count = std::min(slowest_tag_count, tags.size());
+        std::partial_sort(tags.begin(), tags.begin() + slowest_count, tags.end(), [](const Event *a, const Event *b) { return a->get_self_duration() > b->get_self_duration(); });
+        label = "Slowest tags:";
+        for(std::size_t t = 0; t < slowest_count; t++) {
+            oprintf("%-19s%-32s %10.03f ms\n", label, tag_names[*tags[t]->tag_index].c_str(), tags[t]->get_self_duration() / 1000.0);
+            label = INDENT;
+        }
+
+        std::vector<std::pair<TagFourCC, std::pair<std::size_t, double>>> classes_sorted(classes.begin(), classes.end());
+        std::sort(classes_sorted.begin(), classes_sorted.end(), [](auto &a, auto &b) { return a.second.second > b.second.second; });
+        label = "Tag classes:";
+        for(auto &c : classes_sorted) {
+            char class_name[64];
+            std::snprintf(class_name, sizeof(class_name), "%s (%zu)", HEK::tag_fourcc_to_extension(c.first), c.second.first);
+            oprintf("%-19s%-32s %10.03f ms\n", label, class_name, c.second.second / 1000.0);
+            label = INDENT;
+        }
+    }
+
+    static void append_json_string(std::string &json, const std::string &string) {
+        json += '"';
+        for(char c : string) {
+            switch(c) {
+                case '"':
+                    json += "\\\"";
+                    break;
+                case '\\':
+                    json += "\\\\";
+                    break;
+                default:
+                    if(static_cast<unsigned char>(c) < 0x20) {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+                        json += escaped;
+                    }
+                    else {
+                        json += c;
+                    }
+                    break;
+            }
+        }
+        json += '"';
+    }
+
+    bool BuildProfiler::write_chrome_trace(const std::filesystem::path &path, const std::vector<std::string> &tag_names, const std::vector<TagFourCC> &tag_classes) const {
+        std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        char number[64];
+
+        for(auto &e : this->events) {
+            if(!first) {
+                json += ",";
+            }
+            first = false;
+
+            const char *category;
+            bool is_tag = e.type == EventType::EVENT_TYPE_TAG && e.tag_index.has_value() && *e.tag_index < tag_names.size() && *e.tag_index < tag_classes.size();
+            switch(e.type) {
+                case EventType::EVENT_TYPE_PHASE:
+                    category = "phase";
+                    break;
+                case EventType::EVENT_TYPE_TAG:
+                    category = "tag";
+                    break;
+                default:
+                    category = "step";
+                    break;
+            }
+
+            json += "\n{\"name\":";
+            append_json_string(json, is_tag ? tag_names[*e.tag_index] : e.name);
+            json += ",\"cat\":\"";
+            json += category;
+            std::snprintf(number, sizeof(number), "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.03f,\"dur\":%.03f", e.start, e.duration);
+            json += number;
+
+            // Tags also get their class and how long they took on their own
+            if(is_tag) {
+                json += ",\"args\":{\"class\":\"";
+                json += HEK::tag_fourcc_to_extension(tag_classes[*e.tag_index]);
+                std::snprintf(number, sizeof(number), "\",\"self_ms\":%.03f}", e.get_self_duration() / 1000.0);
+                json += number;
+            }
+            json += "}";
+        }
+
+        json += "\n]}\n";
+
+        const auto *json_data = reinterpret_cast<const std::byte *>(json.data());
+        return File::save_file(path, std::vector<std::byte>(json_data, json_data + json.size()));
+    }
+}
@@ -57,6 +57,7 @@ namespace Invader {
 
         // Start benchmark
         workload.start = std::chrono::steady_clock::now();
+        workload.profiler.set_enabled(true);
 
         // Hide these?
         switch(parameters.verbosity) {
@@ -74,7 +75,50 @@ namespace Invader {
                 break;
         }
 
-        return workload.build_cache_file();
+        // Write the trace even if the build failed, since it shows where it got to
+        std::vector<std::byte> map;
+        try {
+            map = workload.build_cache_file();
+        }
+        catch(std::exception &) {
+            if(parameters.trace.has_value()) {
+                workload.write_profile_trace(*parameters.trace);
+            }
+            throw;
+        }
+        if(parameters.trace.has_value()) {
+            workload.write_profile_trace(*parameters.trace);
+        }
+        return map;
+    }
+
+    void BuildWorkload::print_profile_summary() const {
+        std::vector<std::string> tag_names;
+        std::vector<TagFourCC> tag_classes;
+        tag_names.reserve(this->tags.size());
+        tag_classes.reserve(this->tags.size());
+        for(auto &t : this->tags) {
+            tag_names.emplace_back(File::halo_path_to_preferred_path(t.path) + "." + tag_fourcc_to_extension(t.tag_fourcc));
+            tag_classes.emplace_back(t.tag_fourcc);
+        }
+        this->profiler.print_summary(tag_names, tag_classes, 5);
+    }
+
+    void BuildWorkload::write_profile_trace(const std::filesystem::path &path) const {
+        std::vector<std::string> tag_names;
+        std::vector<TagFourCC> tag_classes;
+        tag_names.reserve(this->tags.size());
+        tag_classes.reserve(this->tags.size());
+        for(auto &t : this->tags) {
+            tag_names.emplace_back(File::halo_path_to_preferred_path(t.path) + "." + tag_fourcc_to_extension(t.tag_fourcc));
+            tag_classes.emplace_back(t.tag_fourcc);
+        }
+        if(!this->profiler.write_chrome_trace(path, tag_names, tag_classes)) {
+            eprintf_error("Failed to write trace to %s", path.string().c_str());
+        }
+        else if(this->parameters->verbosity > BuildParameters::BuildVerbosity::BUILD_VERBOSITY_QUIET) {
+            oprintf("Wrote trace to %s\n", path.string().c_str());
+        }
     }
 
     #define BYTES_TO_MiB(bytes) (bytes / 1024.0 / 1024.0)
@@ -121,18 +165,25 @@ namespace Invader {
         if(this->parameters->verbosity > BuildParameters::BuildVerbosity::BUILD_VERBOSITY_QUIET) {
             oprintf("Reading tags...\n");
         }
+        auto reading_tags_phase = this->profiler.phase("Reading tags");
         this->add_tags();
+        reading_tags_phase.end();
 
         // Check this stuff
+        auto checking_phase = this->profiler.phase("Checking HUD text indices");
         this->check_hud_text_indices();
+        checking_phase.end();
 
         // If we have resource maps to check, check them
         if(this->parameters->details.build_raw_data_handling != BuildParameters::BuildParametersDetails::RawDataHandling::RAW_DATA_HANDLING_RETAIN_ALL) {
+            auto externalizing_phase = this->profiler.phase("Externalizing tags");
             this->externalize_tags();
         }
 
         // Generate the tag array
+        auto tag_array_phase = this->profiler.phase("Generating tag array");
         this->generate_tag_array();
+        tag_array_phase.end();
 
         // Set the scenario tag thingy
         auto make_tag_data_header_struct = [](std::size_t scenario_index, auto &structs, auto size) {
@@ -175,11 +226,13 @@ namespace Invader {
 
         // Generate memes on Xbox
         if(cache_version == HEK::CacheFileEngine::CACHE_FILE_XBOX) {
+            auto compressed_model_phase = this->profiler.phase("Generating compressed models");
             this->generate_compressed_model_tag_array();
         }
 
         // Dedupe structs
         if(this->parameters->optimize_space) {
+            auto dedupe_phase = this->profiler.phase("Deduping structs");
             this->dedupe_structs();
         }
 
@@ -188,7 +241,9 @@ namespace Invader {
             oprintf("Building tag data...");
             oflush();
         }
+        auto tag_data_phase = this->profiler.phase("Building tag data");
         std::size_t end_of_bsps = this->generate_tag_data();
+        tag_data_phase.end();
         if(this->parameters->verbosity > BuildParameters::BuildVerbosity::BUILD_VERBOSITY_QUIET) {
             oprintf(" done\n");
         }
@@ -229,7 +284,9 @@ namespace Invader {
             oprintf("Building raw data...");
             oflush();
         }
+        auto raw_data_phase = this->profiler.phase("Building raw data");
         this->generate_bitmap_sound_data(end_of_bsps);
+        raw_data_phase.end();
         if(this->parameters->verbosity > BuildParameters::BuildVerbosity::BUILD_VERBOSITY_QUIET) {
             oprintf(" done\n");
         }
@@ -258,6 +315,7 @@ namespace Invader {
             }
 
             // Add header stuff
+            auto cache_file_data_phase = workload.profiler.phase("Building cache file data");
             final_data.resize(sizeof(HEK::CacheFileHeader));
 
             // Add each BSP data thing
@@ -283,6 +341,11 @@ namespace Invader {
             std::size_t model_offset;
             std::size_t tag_data_offset;
 
+            // These are only needed for deduping model data while compiling
+            workload.model_indices_lookup = decltype(workload.model_indices_lookup)();
+            workload.uncompressed_model_vertices_lookup = decltype(workload.uncompressed_model_vertices_lookup)();
+            workload.compressed_model_vertices_lookup = decltype(workload.compressed_model_vertices_lookup)();
+
             // If we're not on Xbox, we put the model data here
             if(cache_version != HEK::CacheFileEngine::CACHE_FILE_XBOX) {
                 // Let's get the model data there
@@ -391,7 +454,9 @@ namespace Invader {
             std::uint32_t new_crc = 0;
             bool can_calculate_crc = cache_version != CacheFileEngine::CACHE_FILE_XBOX;
 
+            cache_file_data_phase.end();
             if(can_calculate_crc) {
+                auto crc_phase = workload.profiler.phase(workload.parameters->forge_crc.has_value() ? "Forging CRC32" : "Calculating CRC32");
                 if(workload.parameters->verbosity > BuildParameters::BuildVerbosity::BUILD_VERBOSITY_QUIET) {
                     oprintf("Calculating CRC32...");
                     oflush();
@@ -433,7 +498,9 @@ namespace Invader {
                     oprintf("Compressing...");
                     oflush();
                 }
+                auto compress_phase = workload.profiler.phase("Compressing");
                 final_data = Compression::compress_map_data(final_data.data(), final_data.size(), workload.parameters->details.build_compression_level.value_or(19));
+                compress_phase.end();
                 if(workload.parameters->verbosity > BuildParameters::BuildVerbosity::BUILD_VERBOSITY_QUIET) {
                     oprintf(" done\n");
                 }
@@ -552,6 +619,9 @@ namespace Invader {
                 }
 
                 oprintf("\n");
+
+                // And where that time went
+                workload.print_profile_summary();
             }
 
             return final_data;
@@ -583,7 +653,10 @@ namespace Invader {
 
     void BuildWorkload::compile_tag_data_recursively(const std::byte *tag_data, std::size_t tag_data_size, std::size_t tag_index, std::optional<TagFourCC> tag_fourcc) {
         #define COMPILE_TAG_CLASS(class_struct, fourcc) case TagFourCC::fourcc: { \
-            do_compile_tag(std::move(Parser::class_struct::parse_hek_tag_file(tag_data, tag_data_size, true))); \
+            auto parsing_step = this->profiler.step("Parsing tags"); \
+            auto tag_data_parsed = Parser::class_struct::parse_hek_tag_file(tag_data, tag_data_size, true); \
+            parsing_step.end(); \
+            do_compile_tag(std::move(tag_data_parsed)); \
             break; \
         }
 
@@ -750,7 +823,9 @@ namespace Invader {
             // And, of course, BSP tags
             case TagFourCC::TAG_FOURCC_SCENARIO_STRUCTURE_BSP: {
                 // First thing's first - parse the tag data
+                auto parsing_step = this->profiler.step("Parsing tags");
                 auto tag_data_parsed = Parser::ScenarioStructureBSP::parse_hek_tag_file(tag_data, tag_data_size, true);
+                parsing_step.end();
                 std::size_t bsp = this->bsp_count++;
 
                 auto cache_version = this->parameters->details.build_cache_file_engine;
@@ -882,7 +957,10 @@ namespace Invader {
         }
 
         // Open it
+        auto tag_phase = this->profiler.tag(return_value);
+        auto reading_step = this->profiler.step("Reading tag files");
         auto tag_file = Invader::File::open_file(*new_path);
+        reading_step.end();
         if(!tag_file.has_value()) {
             eprintf_error("Failed to open %s\n", formatted_path);
             throw FailedToOpenFileException();
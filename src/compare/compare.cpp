@@ -2,7 +2,10 @@
 
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <vector>
+#include <map>
+#include <set>
 #include <cstring>
 #include <regex>
 
@@ -33,6 +36,30 @@ struct Input {
     std::vector<File::TagFilePath> tag_paths;
     std::vector<File::TagFile> virtual_directory;
     std::unique_ptr<Map> map_data;
+
+    // Every tag in the input, in the same order as the map's tag array or the virtual directory
+    std::vector<File::TagFilePath> all_tags;
+
+    // Indices into all_tags, looked up by path and class or by class alone (in order)
+    std::map<File::TagFilePath, std::size_t> all_tags_by_path;
+    std::map<TagFourCC, std::vector<std::size_t>> all_tags_by_fourcc;
+
+    // Tags in tag_paths (i.e. after filtering), looked up by path and class or by class alone
+    std::set<File::TagFilePath> tag_paths_set;
+    std::map<TagFourCC, std::size_t> tag_paths_fourcc_count;
+
+    void build_index() {
+        for(std::size_t t = 0; t < this->all_tags.size(); t++) {
+            auto &tag = this->all_tags[t];
+            this->all_tags_by_path.try_emplace(tag, t);
+            this->all_tags_by_fourcc[tag.fourcc].emplace_back(t);
+        }
+        for(auto &tag : this->tag_paths) {
+            if(this->tag_paths_set.insert(tag).second) {
+                this->tag_paths_fourcc_count[tag.fourcc]++;
+            }
+        }
+    }
 };
 
 template <typename T> static void close_input(T &options) {
@@ -249,10 +276,11 @@ int main(int argc, const char **argv) {
     close_input(compare_options);
 
     // Automatically make up maps directories for any map when necessary, then open their respective resources
+    File::PathMatcher matcher(compare_options.search, compare_options.search_exclude);
     for(auto &i : compare_options.inputs) {
         // Check if it matches our filters
-        auto add_if_matched = [&i, &compare_options](Invader::File::TagFilePath &&path) {
-            if(File::path_matches(Invader::File::preferred_path_to_halo_path(path.join()).c_str(), compare_options.search, compare_options.search_exclude)) {
+        auto add_if_matched = [&i, &matcher](Invader::File::TagFilePath &&path) {
+            if(matcher.matches(Invader::File::preferred_path_to_halo_path(path.join()))) {
                 i.tag_paths.emplace_back(std::move(path));
             }
         };
@@ -310,9 +338,11 @@ int main(int argc, const char **argv) {
             // Go through each tag and add them if we want to do the thing
             auto tag_count = map.get_tag_count();
             i.tag_paths.reserve(tag_count);
+            i.all_tags.reserve(tag_count);
             for(std::size_t t = 0; t < tag_count; t++) {
                 auto &tag = map.get_tag(t);
                 auto tag_fourcc = tag.get_tag_fourcc();
+                i.all_tags.emplace_back(tag.get_path(), tag_fourcc);
                 if(!tag.data_is_available() || std::strcmp(tag_fourcc_to_extension(tag_fourcc), "unknown") == 0) {
                     continue;
                 }
@@ -328,42 +358,73 @@ int main(int argc, const char **argv) {
                 return EXIT_FAILURE;
             }
             i.tag_paths.reserve(i.virtual_directory.size());
+            i.all_tags.reserve(i.virtual_directory.size());
             for(auto &t : i.virtual_directory) {
-                add_if_matched(File::split_tag_class_extension(File::preferred_path_to_halo_path(t.tag_path)).value());
+                auto &path = i.all_tags.emplace_back(File::split_tag_class_extension(File::preferred_path_to_halo_path(t.tag_path)).value());
+                add_if_matched(File::TagFilePath(path));
             }
         }
         i.tag_paths.shrink_to_fit();
+        i.build_index();
     }
 
     regular_comparison(compare_options.inputs, compare_options.precision, compare_options.show, compare_options.match_all, compare_options.functional, compare_options.by_path, compare_options.verbose, *compare_options.job_count);
 }
 
+// Check if the input has a tag (after filtering) that can be compared against the given tag
+static bool filtered_input_has_match(const Input &input, const File::TagFilePath &tag, ByPath by_path) {
+    switch(by_path) {
+        case ByPath::BY_PATH_SAME:
+            return input.tag_paths_set.contains(tag);
+        case ByPath::BY_PATH_ANY:
+            return input.tag_paths_fourcc_count.contains(tag.fourcc);
+        case ByPath::BY_PATH_DIFFERENT: {
+            auto count = input.tag_paths_fourcc_count.find(tag.fourcc);
+            if(count == input.tag_paths_fourcc_count.end()) {
+                return false;
+            }
+            return count->second > (input.tag_paths_set.contains(tag) ? 1 : 0);
+        }
+    }
+    return false;
+}
+
+// Get the indices of all tags in the input (in order) that can be compared against the given tag
+static void find_input_matches(const Input &input, const File::TagFilePath &tag, ByPath by_path, std::vector<std::size_t> &matches) {
+    matches.clear();
+
+    if(by_path == ByPath::BY_PATH_SAME) {
+        auto found = input.all_tags_by_path.find(tag);
+        if(found != input.all_tags_by_path.end()) {
+            matches.emplace_back(found->second);
+        }
+        return;
+    }
+
+    auto found = input.all_tags_by_fourcc.find(tag.fourcc);
+    if(found == input.all_tags_by_fourcc.end()) {
+        return;
+    }
+    for(auto t : found->second) {
+        if(by_path == ByPath::BY_PATH_ANY || input.all_tags[t].path != tag.path) {
+            matches.emplace_back(t);
+        }
+    }
+}
+
 static void regular_comparison(const std::vector<Input> &inputs, bool precision, Show show, bool match_all, bool functional, ByPath by_path, bool verbose, std::size_t job_count) {
     // Find all tags we have in common first
     auto input_count = inputs.size();
     std::vector<File::TagFilePath> tags;
 
-    #define CAN_COMPARE(by_path, path1, path2) ((by_path == ByPath::BY_PATH_SAME && path1 == path2) || (by_path == ByPath::BY_PATH_DIFFERENT && path1 != path2) || (by_path == ByPath::BY_PATH_ANY))
-
     // Do this thing
     if(match_all) {
         auto &first_input = inputs[0];
-        auto input_count = inputs.size();
         tags.reserve(first_input.tag_paths.size());
         for(auto &tag : first_input.tag_paths) {
             bool not_found = false;
             for(std::size_t i = 1; i < input_count; i++) {
-                bool found = false;
-                for(auto &tag2 : inputs[i].tag_paths) {
-                    if(tag2.fourcc != tag.fourcc) {
-                        continue;
-                    }
-                    if(CAN_COMPARE(by_path, tag.path, tag2.path)) {
-                        found = true;
-                        break;
-                    }
-                }
-                if(!found) {
+                if(!filtered_input_has_match(inputs[i], tag, by_path)) {
                     not_found = true;
                     break;
                 }
@@ -375,33 +436,16 @@ static void regular_comparison(const std::vector<Input> &inputs, bool precision,
         }
     }
     else {
+        std::set<File::TagFilePath> tags_added;
         for(std::size_t i = 0; i < input_count; i++) {
             auto &input = inputs[i];
             for(std::size_t j = i + 1; j < input_count; j++) {
                 auto &input2 = inputs[j];
                 for(auto &tag : input.tag_paths) {
-                    // Make sure we don't add any duplicates
-                    bool found = false;
-                    for(auto &otag : tags) {
-                        if(otag == tag) {
-                            found = true;
-                            break;
-                        }
-                    }
-                    if(found) {
-                        continue;
-                    }
-
-                    // Add it if it's present!
-                    for(auto &tag2 : input2.tag_paths) {
-                        if(tag2.fourcc != tag.fourcc) {
-                            continue;
-                        }
-                        if(CAN_COMPARE(by_path, tag.path, tag2.path)) {
-                            found = true;
-                            tags.push_back(tag);
-                            break;
-                        }
+                    // Make sure we don't add any duplicates, then add it if it's present!
+                    if(!tags_added.contains(tag) && filtered_input_has_match(input2, tag, by_path)) {
+                        tags_added.insert(tag);
+                        tags.push_back(tag);
                     }
                 }
             }
@@ -413,116 +457,90 @@ static void regular_comparison(const std::vector<Input> &inputs, bool precision,
     bool show_all = (show & Show::SHOW_ALL) == Show::SHOW_ALL;
 
     // Next, compare each tag
-    std::size_t matched_count = 0;
-    std::size_t mismatched_count = 0;
+    std::atomic<std::size_t> matched_count = 0;
+    std::atomic<std::size_t> mismatched_count = 0;
 
-    std::mutex tag_mutex;
     std::mutex log_mutex;
-    std::size_t tag_index = 0;
+    std::atomic<std::size_t> tag_index = 0;
 
     std::vector<std::thread> threads;
     threads.reserve(job_count);
     for(std::size_t t = 0; t < job_count; t++) {
-        auto perform_comparison_thread = [](auto *inputs, auto *tags, auto by_path, auto show_all, auto show, auto *matched_count, auto *mismatched_count, auto functional, auto precision, auto verbose, auto *tag_mutex, auto *tag_index, auto *log_mutex) {
-            reset_loop: while(true) {
-                tag_mutex->lock();
-                if(*tag_index >= tags->size()) {
-                    tag_mutex->unlock();
+        auto perform_comparison_thread = [](auto *inputs, auto *tags, auto by_path, auto show_all, auto show, auto *matched_count, auto *mismatched_count, auto functional, auto precision, auto verbose, auto *tag_index, auto *log_mutex) {
+            // Buffer each tag's output so it can be written all at once without holding the log mutex while working
+            BufferedOutput log;
+            std::vector<std::size_t> matches;
+
+            while(true) {
+                // Flush anything we logged for the last tag
+                if(!log.empty()) {
+                    std::lock_guard<std::mutex> lock(*log_mutex);
+                    log.flush();
+                }
+
+                auto next_index = tag_index->fetch_add(1, std::memory_order_relaxed);
+                if(next_index >= tags->size()) {
                     return;
                 }
-                auto &tag = (*tags)[*tag_index];
-                (*tag_index)++;
-                tag_mutex->unlock();
+                auto &tag = (*tags)[next_index];
 
                 std::vector<std::unique_ptr<Parser::ParserStruct>> structs;
                 std::vector<std::string> struct_paths;
                 std::vector<const Input *> struct_inputs;
 
                 bool first_input = true;
-                bool only_finding_same_tag = true;
-                auto path_unsplit = File::halo_path_to_preferred_path(tag.path + "." + HEK::tag_fourcc_to_extension(tag.fourcc)); // combine this
+                bool successful = true;
 
                 try {
                     // Go through each input
                     for(auto &i : *inputs) {
-                        // On the first input, we always break when we find the tag since we're only looking for tags with the same path to match the tag with the outer loop
-                        // On subsequent inputs, we only break if we're *always* looking for tags with the same path.
+                        // On the first input, we only look for the tag with the same path to match the tag with the outer loop
                         auto by_path_copy = by_path;
                         if(first_input) {
                             first_input = false; // set to false
                             by_path_copy = ByPath::BY_PATH_SAME;
                         }
 
-                        only_finding_same_tag = by_path_copy == ByPath::BY_PATH_SAME;
-
-                        // If it's a map, do this
-                        if(i.map.has_value()) {
-                            // First, extract it
-                            auto tag_count = i.map_data->get_tag_count();
-                            for(std::size_t t = 0; t < tag_count; t++) {
-                                auto &map_tag = i.map_data->get_tag(t);
-                                auto &map_tag_path = map_tag.get_path();
-                                if(map_tag.get_tag_fourcc() == tag.fourcc && CAN_COMPARE(by_path_copy, tag.path, map_tag_path)) {
-                                    // Lock the lock mutex in case issues arise when extracting the tag. This may slow down throughput a bit, but it's better than clobbering standard error while other stuff is logging.
-                                    log_mutex->lock();
-
-                                    bool successful = false;
-                                    try {
-                                        auto extracted_data = Invader::ExtractionWorkload::extract_single_tag(i.map_data->get_tag(t));
-                                        structs.emplace_back(Parser::ParserStruct::parse_hek_tag_file(extracted_data.data(), extracted_data.size(), true));
-                                        struct_paths.emplace_back(map_tag_path);
-                                        struct_inputs.emplace_back(&i);
-                                        successful = true;
-                                    }
-                                    catch(std::exception &e) {
-                                        eprintf_error("Cannot compare %s.%s due to an error: %s", File::halo_path_to_preferred_path(tag.path).c_str(), HEK::tag_fourcc_to_extension(tag.fourcc), e.what());
-                                        successful = false;
-                                    }
-
-                                    // We can now unlock the mutex
-                                    log_mutex->unlock();
-
-                                    // And if we failed, restart the whole loop
-                                    if(!successful) {
-                                        goto reset_loop;
-                                    }
-
-                                    if(only_finding_same_tag) {
-                                        break;
-                                    }
-                                }
-                            }
-                        }
+                        find_input_matches(i, tag, by_path_copy, matches);
+
+                        for(auto m : matches) {
+                            auto &match_path = i.all_tags[m];
 
-                        // If it's a tag, do this
-                        else {
-                            for(auto &vd : i.virtual_directory) {
-                                // Skip if the FourCC is different
-                                if(vd.tag_fourcc != tag.fourcc) {
-                                    continue;
+                            // If it's a map, extract it first
+                            if(i.map.has_value()) {
+                                try {
+                                    auto extracted_data = Invader::ExtractionWorkload::extract_single_tag(i.map_data->get_tag(m));
+                                    structs.emplace_back(Parser::ParserStruct::parse_hek_tag_file(extracted_data.data(), extracted_data.size(), true));
+                                }
+                                catch(std::exception &e) {
+                                    log.print(BufferedOutput::OUTPUT_ERROR, "Cannot compare %s.%s due to an error: %s", File::halo_path_to_preferred_path(tag.path).c_str(), HEK::tag_fourcc_to_extension(tag.fourcc), e.what());
+                                    successful = false;
+                                    break;
                                 }
+                            }
 
-                                if(CAN_COMPARE(by_path_copy, path_unsplit, vd.tag_path)) {
-                                    // Open it
-                                    auto file = Invader::File::open_file(vd.full_path).value();
+                            // If it's a tag, open it and parse it
+                            else {
+                                auto file = Invader::File::open_file(i.virtual_directory[m].full_path).value();
+                                structs.emplace_back(Parser::ParserStruct::parse_hek_tag_file(file.data(), file.size(), true));
+                            }
 
-                                    // Parse it
-                                    structs.emplace_back(Parser::ParserStruct::parse_hek_tag_file(file.data(), file.size(), true));
-                                    struct_paths.emplace_back(File::split_tag_class_extension(File::preferred_path_to_halo_path(vd.tag_path)).value().path);
-                                    struct_inputs.emplace_back(&i);
+                            struct_paths.emplace_back(match_path.path);
+                            struct_inputs.emplace_back(&i);
+                        }
 
-                                    if(only_finding_same_tag) {
-                                        break;
-                                    }
-                                }
-                            }
+                        // And if we failed, skip this tag
+                        if(!successful) {
+                            break;
                         }
                     }
                 }
                 catch(std::exception &e) {
-                    log_mutex->lock();
-                    eprintf_error("Cannot compare %s.%s due to an error: %s", File::halo_path_to_preferred_path(tag.path).c_str(), HEK::tag_fourcc_to_extension(tag.fourcc), e.what());
-                    log_mutex->unlock();
+                    log.print(BufferedOutput::OUTPUT_ERROR, "Cannot compare %s.%s due to an error: %s", File::halo_path_to_preferred_path(tag.path).c_str(), HEK::tag_fourcc_to_extension(tag.fourcc), e.what());
+                    continue;
+                }
+
+                if(!successful) {
                     continue;
                 }
 
@@ -538,58 +556,43 @@ static void regular_comparison(const std::vector<Input> &inputs, bool precision,
                 auto &first_struct = structs[0];
 
                 // Just for setting counter/debugging
-                auto match_log = [&tag, &matched_count, &show, &show_all, &mismatched_count, &struct_paths, &by_path, &struct_inputs, &inputs, &log_mutex](bool did_match, std::size_t i, const std::list<std::string> &other_messages = {}) {
+                auto match_log = [&tag, &matched_count, &show, &show_all, &mismatched_count, &struct_paths, &by_path, &struct_inputs, &inputs, &log](bool did_match, std::size_t i, const std::list<std::string> &other_messages = {}) {
                     auto *extension = HEK::tag_fourcc_to_extension(tag.fourcc);
                     auto other_path = File::halo_path_to_preferred_path(struct_paths[i]);
                     bool show_different_input = inputs->size() > 2; // only need to show differing inputs if we have more than two inputs
-                    std::size_t input_of_other = 1;
-
-                    // If we're using multiple inputs, get the input of the other thing
-                    if(show_different_input) {
-                        auto *other_input = struct_inputs[i];
-                        for(auto &i : *inputs) {
-                            if(&i == other_input) {
-                                input_of_other = &i - inputs->data();
-                                break;
-                            }
-                        }
-                    }
+                    std::size_t input_of_other = struct_inputs[i] - inputs->data();
 
                     if(did_match) {
                         if(show & Show::SHOW_MATCHED) {
-                            log_mutex->lock();
                             if(by_path == ByPath::BY_PATH_SAME) {
-                                oprintf_success(MATCHED("Matched"), File::halo_path_to_preferred_path(tag.path).c_str(), HEK::tag_fourcc_to_extension(tag.fourcc));
+                                log.print(BufferedOutput::OUTPUT_SUCCESS, MATCHED("Matched"), File::halo_path_to_preferred_path(tag.path).c_str(), HEK::tag_fourcc_to_extension(tag.fourcc));
                             }
                             else if(show_different_input) {
-                                oprintf_success(MATCHED_TO_DIFFERENT_INPUT("Matched"), File::halo_path_to_preferred_path(tag.path).c_str(), extension, other_path.c_str(), extension, input_of_other);
+                                log.print(BufferedOutput::OUTPUT_SUCCESS, MATCHED_TO_DIFFERENT_INPUT("Matched"), File::halo_path_to_preferred_path(tag.path).c_str(), extension, other_path.c_str(), extension, input_of_other);
                             }
                             else {
-                                oprintf_success(MATCHED_TO("Matched"), File::halo_path_to_preferred_path(tag.path).c_str(), extension, other_path.c_str(), extension);
+                                log.print(BufferedOutput::OUTPUT_SUCCESS, MATCHED_TO("Matched"), File::halo_path_to_preferred_path(tag.path).c_str(), extension, other_path.c_str(), extension);
                             }
                             for(auto &i : other_messages) {
-                                oprintf_success("%s", i.c_str());
+                                log.print(BufferedOutput::OUTPUT_SUCCESS, "%s", i.c_str());
                             }
-                            log_mutex->unlock();
                         }
                         (*matched_count)++;
                     }
                     else {
                         if(show & Show::SHOW_MISMATCHED) {
-                            log_mutex->lock();
                             if(by_path == ByPath::BY_PATH_SAME) {
-                                oprintf_success_warn(MATCHED("Mismatched"), File::halo_path_to_preferred_path(tag.path).c_str(), HEK::tag_fourcc_to_extension(tag.fourcc));
+                                log.print(BufferedOutput::OUTPUT_SUCCESS_WARN, MATCHED("Mismatched"), File::halo_path_to_preferred_path(tag.path).c_str(), HEK::tag_fourcc_to_extension(tag.fourcc));
                             }
                             else if(show_different_input) {
-                                oprintf_success_warn(MATCHED_TO_DIFFERENT_INPUT("Mismatched"), File::halo_path_to_preferred_path(tag.path).c_str(), extension, other_path.c_str(), extension, input_of_other);
+                                log.print(BufferedOutput::OUTPUT_SUCCESS_WARN, MATCHED_TO_DIFFERENT_INPUT("Mismatched"), File::halo_path_to_preferred_path(tag.path).c_str(), extension, other_path.c_str(), extension, input_of_other);
                             }
                             else {
-                                oprintf_success_warn(MATCHED_TO("Mismatched"), File::halo_path_to_preferred_path(tag.path).c_str(), extension, other_path.c_str(), extension);
+                                log.print(BufferedOutput::OUTPUT_SUCCESS_WARN, MATCHED_TO("Mismatched"), File::halo_path_to_preferred_path(tag.path).c_str(), extension, other_path.c_str(), extension);
                             }
                             for(auto &i : other_messages) {
-                                oprintf_success_warn("%s", i.c_str());
+                                log.print(BufferedOutput::OUTPUT_SUCCESS_WARN, "%s", i.c_str());
                             }
-                            log_mutex->unlock();
                         }
                         (*mismatched_count)++;
                     }
@@ -657,9 +660,7 @@ static void regular_comparison(const std::vector<Input> &inputs, bool precision,
                         }
                     }
                     catch(std::exception &e) {
-                        log_mutex->lock();
-                        eprintf_error("Cannot functional compare %s.%s due to an error: %s", File::halo_path_to_preferred_path(tag.path).c_str(), HEK::tag_fourcc_to_extension(tag.fourcc), e.what());
-                        log_mutex->unlock();
+                        log.print(BufferedOutput::OUTPUT_ERROR, "Cannot functional compare %s.%s due to an error: %s", File::halo_path_to_preferred_path(tag.path).c_str(), HEK::tag_fourcc_to_extension(tag.fourcc), e.what());
                     }
                 }
                 else {
@@ -673,9 +674,7 @@ static void regular_comparison(const std::vector<Input> &inputs, bool precision,
                             match_successful = true;
                         }
                         catch(std::exception &e) {
-                            log_mutex->lock();
-                            eprintf_error("Cannot compare %s.%s due to an error: %s", File::halo_path_to_preferred_path(tag.path).c_str(), HEK::tag_fourcc_to_extension(tag.fourcc), e.what());
-                            log_mutex->unlock();
+                            log.print(BufferedOutput::OUTPUT_ERROR, "Cannot compare %s.%s due to an error: %s", File::halo_path_to_preferred_path(tag.path).c_str(), HEK::tag_fourcc_to_extension(tag.fourcc), e.what());
                             match_successful = false;
                         }
 
@@ -690,7 +689,7 @@ static void regular_comparison(const std::vector<Input> &inputs, bool precision,
             }
         };
 
-        threads.emplace_back(perform_comparison_thread, &inputs, &tags, by_path, show_all, show, &matched_count, &mismatched_count, functional, precision, verbose, &tag_mutex, &tag_index, &log_mutex);
+        threads.emplace_back(perform_comparison_thread, &inputs, &tags, by_path, show_all, show, &matched_count, &mismatched_count, functional, precision, verbose, &tag_index, &log_mutex);
     }
 
     // Wait for threads to finish
@@ -701,6 +700,6 @@ static void regular_comparison(const std::vector<Input> &inputs, bool precision,
     // Show the total matched if we are showing both
     if(show_all) {
         auto total = matched_count + mismatched_count;
-        oprintf("Matched %zu / %zu tag%s\n", matched_count, total, total == 1 ? "" : "s");
+        oprintf("Matched %zu / %zu tag%s\n", matched_count.load(), total, total == 1 ? "" : "s");
     }
 }
@@ -1,6 +1,9 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
 #include <filesystem>
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include "../command_line_option.hpp"
 #include <invader/file/file.hpp>
 #include <invader/version.hpp>
@@ -86,7 +89,7 @@ int main(int argc, const char **argv) {
         
         std::vector<std::string> batch, batch_exclude;
         
-        
+        std::size_t max_threads = std::thread::hardware_concurrency() < 1 ? 1 : std::thread::hardware_concurrency();
     } convert_options;
 
     const CommandLineOption options[] = {
@@ -97,6 +100,7 @@ int main(int argc, const char **argv) {
         CommandLineOption("overwrite", 'O', 0, "Overwrite any output tags if they exist."),
         CommandLineOption("output-tags", 'o', 1, "Set the output tags directory.", "<dir>"),
         CommandLineOption("groups", 'g', 2, "Set the conversion method.", "<from> <to>"),
+        CommandLineOption("threads", 'j', 1, "Set the number of threads to use for converting tags when batching. Default: CPU thread count"),
     };
 
     static constexpr char DESCRIPTION[] = "Convert from one tag type to another.\n"
@@ -135,6 +139,20 @@ int main(int argc, const char **argv) {
                 compare_options.tags = args[0];
                 break;
                 
+            case 'j':
+                try {
+                    compare_options.max_threads = std::stoul(args[0]);
+                }
+                catch(std::exception &) {
+                    eprintf_error("Invalid number of threads %s", args[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                if(compare_options.max_threads < 1) {
+                    eprintf_error("Invalid number of threads %s", args[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                break;
+                
             case 'g':
                 compare_options.conversion = { HEK::tag_extension_to_fourcc(args[0]), HEK::tag_extension_to_fourcc(args[1]) };
                 
@@ -185,8 +203,9 @@ int main(int argc, const char **argv) {
     tags_vector.emplace_back(convert_options.tags);
     std::vector<File::TagFilePath> paths;
     if(batching) {
+        File::PathMatcher matcher(convert_options.batch, convert_options.batch_exclude);
         for(auto &i : File::load_virtual_tag_folder(tags_vector)) {
-            if(i.tag_fourcc == convert_options.conversion->first && File::path_matches((i.tag_path + "." + HEK::tag_fourcc_to_extension(convert_options.conversion->first)).c_str(), convert_options.batch, convert_options.batch_exclude)) {
+            if(i.tag_fourcc == convert_options.conversion->first && matcher.matches(i.tag_path + "." + HEK::tag_fourcc_to_extension(convert_options.conversion->first))) {
                 paths.emplace_back(File::split_tag_class_extension(File::halo_path_to_preferred_path(i.tag_path)).value());
             }
         }
@@ -205,51 +224,110 @@ int main(int argc, const char **argv) {
     }
     
     // Let's begin
-    std::size_t success = 0;
+    enum ConvertResult {
+        CONVERT_RESULT_CONVERTED,
+        CONVERT_RESULT_SKIPPED,
+        CONVERT_RESULT_FAILED
+    };
+    
+    // Each tag's result and message is kept so output stays in order regardless of which thread finished first
+    struct ConvertedTag {
+        ConvertResult result = ConvertResult::CONVERT_RESULT_FAILED;
+        std::string message;
+    };
+    
     std::size_t total = paths.size();
-    for(auto &i : paths) {
-        auto path_from = convert_options.tags / i.join();
-        auto path_to = *convert_options.output_tags / File::TagFilePath(i.path, convert_options.conversion->second).join();
-        
-        try {
-            auto tag_file = File::open_file(path_from);
-            if(!tag_file.has_value()) {
-                eprintf_error("Failed to read %s", path_from.string().c_str());
+    std::vector<ConvertedTag> results(total);
+    std::atomic<std::size_t> next_tag = 0;
+    auto start = std::chrono::steady_clock::now();
+    
+    auto convert_thread = [&paths, &results, &next_tag, &convert_options, &conversion_fn, &total]() {
+        while(true) {
+            auto t = next_tag.fetch_add(1, std::memory_order_relaxed);
+            if(t >= total) {
+                return;
             }
             
-            auto input_struct = Parser::ParserStruct::parse_hek_tag_file(tag_file->data(), tag_file->size());
+            auto &i = paths[t];
+            auto &result = results[t];
+            auto path_from = convert_options.tags / i.join();
+            auto path_to = *convert_options.output_tags / File::TagFilePath(i.path, convert_options.conversion->second).join();
             
             if(!convert_options.overwrite && std::filesystem::exists(path_to)) {
-                eprintf_warn("Skipping %s...", i.join().c_str());
+                result.result = ConvertResult::CONVERT_RESULT_SKIPPED;
+                result.message = "Skipping " + i.join() + "...";
                 continue;
             }
             
-            // Convert it
-            auto final_data = (*conversion_fn)(*input_struct)->generate_hek_tag_data(convert_options.conversion->second);
-            
-            // Make directories
-            std::error_code ec;
-            std::filesystem::create_directories(path_to.parent_path(), ec);
-
-            // Save
-            if(File::save_file(path_to, final_data)) {
-                oprintf_success("Saved %s", path_to.string().c_str());
-                success++;
+            try {
+                auto tag_file = File::open_file(path_from);
+                if(!tag_file.has_value()) {
+                    result.message = "Failed to read " + path_from.string();
+                    continue;
+                }
+                
+                auto input_struct = Parser::ParserStruct::parse_hek_tag_file(tag_file->data(), tag_file->size());
+                tag_file.reset();
+                
+                // Convert it
+                auto final_data = (*conversion_fn)(*input_struct)->generate_hek_tag_data(convert_options.conversion->second);
+                
+                // Make directories
+                std::error_code ec;
+                std::filesystem::create_directories(path_to.parent_path(), ec);
+                
+                // Save
+                if(File::save_file(path_to, final_data)) {
+                    result.result = ConvertResult::CONVERT_RESULT_CONVERTED;
+                    result.message = "Saved " + path_to.string();
+                }
+                else {
+                    result.message = "Failed to write to " + path_to.string();
+                }
             }
-            else {
-                eprintf_error("Failed to write to %s", path_to.string().c_str());
+            catch(std::exception &e) {
+                result.message = "Failed to convert " + i.join() + ": " + e.what();
             }
         }
-        catch(std::exception &e) {
-            eprintf_error("Failed to convert %s: %s", i.join().c_str(), e.what());
-        }
+    };
+    
+    std::vector<std::thread> threads;
+    auto thread_count = std::min(convert_options.max_threads, total);
+    threads.reserve(thread_count);
+    for(std::size_t j = 0; j < thread_count; j++) {
+        threads.emplace_back(convert_thread);
+    }
+    for(auto &t : threads) {
+        t.join();
     }
     
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
     // Report results
+    std::size_t success = 0, skipped = 0, failed = 0;
+    for(auto &r : results) {
+        switch(r.result) {
+            case ConvertResult::CONVERT_RESULT_CONVERTED:
+                oprintf_success("%s", r.message.c_str());
+                success++;
+                break;
+            case ConvertResult::CONVERT_RESULT_SKIPPED:
+                eprintf_warn("%s", r.message.c_str());
+                skipped++;
+                break;
+            case ConvertResult::CONVERT_RESULT_FAILED:
+                eprintf_error("%s", r.message.c_str());
+                failed++;
+                break;
+        }
+    }
+    
     if(success) {
-        oprintf_success("Converted %zu of %zu tag%s", success, total, total == 1 ? "" : "s");
+        oprintf_success("Converted %zu of %zu tag%s (%zu skipped, %zu failed) in %.03f seconds", success, total, total == 1 ? "" : "s", skipped, failed, seconds);
     }
     else {
-        oprintf("Converted %zu of %zu tag%s\n", success, total, total == 1 ? "" : "s");
+        oprintf("Converted %zu of %zu tag%s (%zu skipped, %zu failed) in %.03f seconds\n", success, total, total == 1 ? "" : "s", skipped, failed, seconds);
     }
+    
+    return EXIT_SUCCESS;
 }
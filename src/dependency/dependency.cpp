@@ -23,7 +23,8 @@ int main(int argc, char * const *argv) {
         CommandLineOption::from_preset(CommandLineOption::PRESET_COMMAND_LINE_OPTION_FS_PATH),
         CommandLineOption::from_preset(CommandLineOption::PRESET_COMMAND_LINE_OPTION_TAGS_MULTIPLE),
         CommandLineOption("reverse", 'R', 0, "Find all tags that depend on the tag, instead. The tag does not have to exist if not using --fs-path."),
-        CommandLineOption("recursive", 'r', 0, "Recursively get all depended tags."),
+        CommandLineOption("recursive", 'r', 0, "Recursively get all depended tags, or all depending tags if using --reverse."),
+        CommandLineOption("index", 'x', 0, "When using --reverse, keep an index of what each tag references in each tags directory (.invader-tag-index) so only tags that changed since the last time need to be read."),
     };
 
     static constexpr char DESCRIPTION[] = "Check dependencies for a tag.";
@@ -34,6 +35,7 @@ int main(int argc, char * const *argv) {
         bool recursive = false;
         std::vector<std::filesystem::path> tags;
         bool use_filesystem_path = false;
+        bool use_index = false;
     } dependency_options;
 
     auto remaining_arguments = CommandLineOption::parse_arguments<DependencyOption &>(argc, argv, options, USAGE, DESCRIPTION, 1, 1, dependency_options, [](char opt, const auto &arguments, auto &dependency_options) {
@@ -53,6 +55,9 @@ int main(int argc, char * const *argv) {
             case 'P':
                 dependency_options.use_filesystem_path = true;
                 break;
+            case 'x':
+                dependency_options.use_index = true;
+                break;
         }
     });
 
@@ -87,7 +92,7 @@ int main(int argc, char * const *argv) {
     std::vector<FoundTagDependency> found_tags;
     try {
         bool success;
-        found_tags = FoundTagDependency::find_dependencies(tag_path_split->path.c_str(), tag_path_split->fourcc, dependency_options.tags, dependency_options.reverse, dependency_options.recursive, success);
+        found_tags = FoundTagDependency::find_dependencies(tag_path_split->path.c_str(), tag_path_split->fourcc, dependency_options.tags, dependency_options.reverse, dependency_options.recursive, success, dependency_options.use_index);
         if(!success) {
             return EXIT_FAILURE;
         }
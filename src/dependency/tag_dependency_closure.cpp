@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <deque>
+#include <exception>
+
+#include <invader/dependency/tag_dependency_closure.hpp>
+#include <invader/tag/parser/parser.hpp>
+#include <invader/tag/hek/header.hpp>
+#include <invader/printf.hpp>
+#include <invader/error.hpp>
+
+namespace Invader {
+    using ScenarioType = HEK::ScenarioType;
+
+    // Open a tag from the tags directories, returning the file path and data
+    static std::pair<std::filesystem::path, std::vector<std::byte>> open_closure_tag(const File::TagFilePath &tag, const std::vector<std::filesystem::path> &tags_directories) {
+        auto file_path = File::tag_path_to_file_path(tag, tags_directories);
+        if(!file_path.has_value() || !std::filesystem::exists(*file_path)) {
+            eprintf_error("Failed to find %s", File::halo_path_to_preferred_path(tag.join()).c_str());
+            throw InvalidTagPathException();
+        }
+
+        auto data = File::open_file(*file_path);
+        if(!data.has_value()) {
+            eprintf_error("Failed to open %s", file_path->string().c_str());
+            throw FailedToOpenFileException();
+        }
+
+        return { std::move(*file_path), std::move(*data) };
+    }
+
+    // Get the references of a tag the same way the build would see them
+    static std::vector<File::TagFilePath> scan_closure_tag(const File::TagFilePath &tag, std::vector<std::byte> &data, ScenarioType scenario_type) {
+        // Globals have blocks removed depending on the scenario type when building (see Globals::pre_compile), so these references are not used
+        if(tag.fourcc == TagFourCC::TAG_FOURCC_GLOBALS) {
+            auto globals = Parser::Globals::parse_hek_tag_file(data.data(), data.size());
+            if(scenario_type != ScenarioType::SCENARIO_TYPE_MULTIPLAYER) {
+                globals.multiplayer_information.clear();
+                globals.cheat_powerups.clear();
+                globals.weapon_list.clear();
+            }
+            if(scenario_type == ScenarioType::SCENARIO_TYPE_USER_INTERFACE) {
+                globals.falling_damage.clear();
+                globals.materials.clear();
+                for(auto &p : globals.player_information) {
+                    p.unit.path.clear();
+                    p.unit.tag_fourcc = TagFourCC::TAG_FOURCC_NONE;
+                }
+            }
+            data = globals.generate_hek_tag_data(TagFourCC::TAG_FOURCC_GLOBALS);
+        }
+
+        std::vector<File::TagFilePath> dependencies;
+        // Only follow references the build uses (e.g. a meter's source bitmap is never loaded)
+        Parser::ParserStruct::scan_hek_tag_dependencies(data.data(), data.size(), [&dependencies](TagFourCC tag_fourcc, std::string_view path) {
+            dependencies.emplace_back(File::remove_duplicate_slashes(std::string(path)), tag_fourcc);
+        }, true);
+        return dependencies;
+    }
+
+    std::vector<TagDependencyClosure::ClosureTag> TagDependencyClosure::find_cache_file_dependencies(const std::string &scenario, const HEK::GameEngineInfo &engine_info, const std::vector<std::filesystem::path> &tags_directories, std::size_t job_count) {
+        File::TagFilePath scenario_path(File::remove_duplicate_slashes(File::preferred_path_to_halo_path(scenario)), TagFourCC::TAG_FOURCC_SCENARIO);
+
+        // The scenario type decides which tags are required, so read it first
+        auto [scenario_file_path, scenario_data] = open_closure_tag(scenario_path, tags_directories);
+        HEK::TagFileHeader::validate_header(reinterpret_cast<const HEK::TagFileHeader *>(scenario_data.data()), scenario_data.size(), TagFourCC::TAG_FOURCC_SCENARIO);
+        if(scenario_data.size() < sizeof(HEK::TagFileHeader) + sizeof(Parser::Scenario::struct_big)) {
+            eprintf_error("%s is too small to be a scenario tag", scenario_file_path.string().c_str());
+            throw OutOfBoundsException();
+        }
+        const auto &scenario_struct = *reinterpret_cast<const Parser::Scenario::struct_big *>(scenario_data.data() + sizeof(HEK::TagFileHeader));
+        ScenarioType scenario_type = scenario_struct.type;
+        bool demo_ui = scenario_struct.flags.read() & HEK::ScenarioFlagsFlag::SCENARIO_FLAGS_FLAG_USE_DEMO_UI;
+        if(scenario_type >= ScenarioType::SCENARIO_TYPE_ENUM_COUNT) {
+            eprintf_error("%s has an invalid scenario type", scenario_file_path.string().c_str());
+            throw InvalidTagDataException();
+        }
+
+        // Everything found so far (value is the file path once it has been scanned)
+        std::map<File::TagFilePath, std::optional<std::filesystem::path>> found;
+        std::deque<File::TagFilePath> queue;
+        std::size_t in_progress = 0;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable cv;
+
+        // Must be called with the mutex locked
+        auto add_tag = [&found, &queue](const File::TagFilePath &tag) {
+            if(tag.path.empty() || found.contains(tag)) {
+                return;
+            }
+            found.emplace(tag, std::nullopt);
+            queue.emplace_back(tag);
+        };
+
+        found.emplace(scenario_path, scenario_file_path);
+        for(auto &d : scan_closure_tag(scenario_path, scenario_data, scenario_type)) {
+            add_tag(d);
+        }
+        scenario_data.clear();
+
+        // Add the tags the engine requires for this scenario type (see BuildWorkload::add_tags)
+        const auto &required_tags = engine_info.required_tags;
+        auto add_all = [&add_tag](const HEK::GameEngineInfo::RequiredTags::TagPairPtrArray &what) {
+            for(std::size_t c = 0; c < what.count; c++) {
+                add_tag(File::TagFilePath(what.ptr[c].path, what.ptr[c].fourcc));
+            }
+        };
+        add_all(required_tags.all);
+        switch(scenario_type) {
+            case ScenarioType::SCENARIO_TYPE_SINGLEPLAYER:
+                add_all(required_tags.singleplayer);
+                add_all(demo_ui ? required_tags.singleplayer_demo : required_tags.singleplayer_full);
+                break;
+            case ScenarioType::SCENARIO_TYPE_MULTIPLAYER:
+                add_all(required_tags.multiplayer);
+                add_all(demo_ui ? required_tags.multiplayer_demo : required_tags.multiplayer_full);
+                break;
+            case ScenarioType::SCENARIO_TYPE_USER_INTERFACE:
+                add_all(required_tags.user_interface);
+                add_all(demo_ui ? required_tags.user_interface_demo : required_tags.user_interface_full);
+                break;
+            case ScenarioType::SCENARIO_TYPE_ENUM_COUNT:
+                std::terminate();
+        }
+
+        // The build always reads the globals tag
+        add_tag(File::TagFilePath("globals\\globals", TagFourCC::TAG_FOURCC_GLOBALS));
+
+        auto closure_thread = [&]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while(true) {
+                cv.wait(lock, [&queue, &in_progress, &error]() { return !queue.empty() || in_progress == 0 || error; });
+                if(error || queue.empty()) {
+                    return;
+                }
+
+                auto tag = std::move(queue.front());
+                queue.pop_front();
+                in_progress++;
+                lock.unlock();
+
+                std::filesystem::path file_path;
+                std::vector<File::TagFilePath> dependencies;
+                std::exception_ptr tag_error;
+                try {
+                    auto [tag_file_path, tag_data] = open_closure_tag(tag, tags_directories);
+                    file_path = std::move(tag_file_path);
+                    dependencies = scan_closure_tag(tag, tag_data, scenario_type);
+                }
+                catch(std::exception &e) {
+                    if(!file_path.empty()) {
+                        eprintf_error("Failed to read %s: %s", file_path.string().c_str(), e.what());
+                    }
+                    tag_error = std::current_exception();
+                }
+
+                lock.lock();
+                in_progress--;
+                if(tag_error) {
+                    if(!error) {
+                        error = tag_error;
+                    }
+                }
+                else {
+                    found[tag] = std::move(file_path);
+                    for(auto &d : dependencies) {
+                        add_tag(d);
+                    }
+                }
+                cv.notify_all();
+            }
+        };
+
+        if(job_count == 0) {
+            job_count = std::thread::hardware_concurrency() < 1 ? 1 : std::thread::hardware_concurrency();
+        }
+
+        std::vector<std::thread> threads;
+        threads.reserve(job_count);
+        for(std::size_t j = 0; j < job_count; j++) {
+            threads.emplace_back(closure_thread);
+        }
+        for(auto &t : threads) {
+            t.join();
+        }
+
+        if(error) {
+            std::rethrow_exception(error);
+        }
+
+        std::vector<ClosureTag> closure;
+        closure.reserve(found.size());
+        for(auto &f : found) {
+            closure.emplace_back(ClosureTag { f.first, std::move(f.second.value()) });
+        }
+        return closure;
+    }
+}
@@ -0,0 +1,357 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+
+#include <invader/dependency/tag_dependency_index.hpp>
+#include <invader/dependency/found_tag_dependency.hpp>
+#include <invader/tag/hek/header.hpp>
+#include <invader/version.hpp>
+#include <invader/printf.hpp>
+
+namespace Invader {
+    static void read_tag_header(const std::byte *data, std::size_t size, TagDependencyIndex::IndexedTag &tag) noexcept {
+        if(size < sizeof(HEK::TagFileHeader)) {
+            return;
+        }
+        const auto &header = *reinterpret_cast<const HEK::TagFileHeader *>(data);
+        tag.header_fourcc = header.tag_fourcc;
+        tag.header_version = header.version;
+        tag.header_crc32 = header.crc32;
+    }
+
+    // Parse the tag, returning its references with Halo path separators
+    static std::optional<std::vector<File::TagFilePath>> read_tag_dependencies(const std::filesystem::path &full_path, const std::vector<std::byte> &tag_data) {
+        try {
+            auto dependencies = FoundTagDependency::get_dependencies(tag_data.data(), tag_data.size());
+            for(auto &d : dependencies) {
+                d.path = File::preferred_path_to_halo_path(d.path);
+            }
+            return dependencies;
+        }
+        catch(std::exception &e) {
+            eprintf_warn("Warning: Failed to compile tag %s: %s", full_path.string().c_str(), e.what());
+            return std::nullopt;
+        }
+    }
+
+    // Index the tag, reusing the previously indexed tag if the file did not change
+    static std::optional<TagDependencyIndex::IndexedTag> index_tag(const File::TagFile &tag, const TagDependencyIndex::IndexedTag *previous, bool &reused) {
+        reused = false;
+
+        TagDependencyIndex::IndexedTag indexed;
+        indexed.full_path = tag.full_path;
+        indexed.tag_directory = tag.tag_directory;
+
+        std::error_code ec;
+        indexed.file_size = std::filesystem::file_size(tag.full_path, ec);
+        if(!ec) {
+            indexed.modified_time = std::filesystem::last_write_time(tag.full_path, ec).time_since_epoch().count();
+        }
+        if(ec) {
+            eprintf_error("Failed to read tag %s", tag.full_path.string().c_str());
+            return std::nullopt;
+        }
+
+        if(previous && previous->full_path != tag.full_path) {
+            previous = nullptr;
+        }
+
+        // Same size and time? Assume it's the same tag.
+        if(previous && previous->file_size == indexed.file_size && previous->modified_time == indexed.modified_time) {
+            indexed = *previous;
+            indexed.tag_directory = tag.tag_directory;
+            reused = true;
+            return indexed;
+        }
+
+        // Tags that can't reference anything only need their header read
+        if(!TagDependencyIndex::tag_fourcc_can_have_dependencies(tag.tag_fourcc)) {
+            std::byte header[sizeof(HEK::TagFileHeader)];
+            std::ifstream stream(tag.full_path, std::ios_base::in | std::ios_base::binary);
+            if(!stream.is_open()) {
+                eprintf_error("Failed to read tag %s", tag.full_path.string().c_str());
+                return std::nullopt;
+            }
+            stream.read(reinterpret_cast<char *>(header), sizeof(header));
+            read_tag_header(header, static_cast<std::size_t>(stream.gcount()), indexed);
+            return indexed;
+        }
+
+        auto tag_data = File::open_file(tag.full_path);
+        if(!tag_data.has_value()) {
+            eprintf_error("Failed to read tag %s", tag.full_path.string().c_str());
+            return std::nullopt;
+        }
+
+        indexed.file_size = tag_data->size();
+        indexed.hash = File::hash_data(*tag_data);
+        read_tag_header(tag_data->data(), tag_data->size(), indexed);
+
+        // The file was touched but not changed, so the references are the same
+        if(previous && previous->file_size == indexed.file_size && previous->hash == indexed.hash) {
+            indexed.dependencies = previous->dependencies;
+            reused = true;
+            return indexed;
+        }
+
+        auto dependencies = read_tag_dependencies(tag.full_path, *tag_data);
+        if(!dependencies.has_value()) {
+            return std::nullopt;
+        }
+        indexed.dependencies = std::move(*dependencies);
+        return indexed;
+    }
+
+    bool TagDependencyIndex::tag_fourcc_can_have_dependencies(TagFourCC fourcc) noexcept {
+        switch(fourcc) {
+            case TagFourCC::TAG_FOURCC_NULL:
+            case TagFourCC::TAG_FOURCC_BITMAP:
+            case TagFourCC::TAG_FOURCC_CAMERA_TRACK:
+            case TagFourCC::TAG_FOURCC_HUD_MESSAGE_TEXT:
+            case TagFourCC::TAG_FOURCC_PHYSICS:
+            case TagFourCC::TAG_FOURCC_SOUND_ENVIRONMENT:
+            case TagFourCC::TAG_FOURCC_STRING_LIST:
+            case TagFourCC::TAG_FOURCC_UNICODE_STRING_LIST:
+            case TagFourCC::TAG_FOURCC_WIND:
+                return false;
+            default:
+                return true;
+        }
+    }
+
+    TagDependencyIndex TagDependencyIndex::index_virtual_tag_folder(const std::vector<File::TagFile> &tags, std::size_t job_count, const TagDependencyIndex *previous) {
+        TagDependencyIndex index;
+
+        auto tag_count = tags.size();
+        if(job_count == 0) {
+            job_count = std::thread::hardware_concurrency() < 1 ? 1 : std::thread::hardware_concurrency();
+        }
+        if(job_count > tag_count) {
+            job_count = tag_count;
+        }
+
+        // Parse everything first, then merge it in order so the index does not depend on thread scheduling
+        std::vector<std::optional<File::TagFilePath>> paths(tag_count);
+        std::vector<std::optional<IndexedTag>> results(tag_count);
+        std::vector<char> reused(tag_count);
+        std::atomic<std::size_t> next_tag = 0;
+
+        auto index_thread = [&tags, &paths, &results, &reused, &next_tag, &tag_count, &previous]() {
+            while(true) {
+                auto i = next_tag.fetch_add(1, std::memory_order_relaxed);
+                if(i >= tag_count) {
+                    return;
+                }
+
+                auto &tag = tags[i];
+                auto &path = paths[i];
+                path = File::split_tag_class_extension(File::preferred_path_to_halo_path(tag.tag_path));
+                if(!path.has_value()) {
+                    continue;
+                }
+
+                bool tag_reused;
+                results[i] = index_tag(tag, previous ? previous->get_tag(*path) : nullptr, tag_reused);
+                reused[i] = tag_reused;
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(job_count);
+        for(std::size_t j = 0; j < job_count; j++) {
+            threads.emplace_back(index_thread);
+        }
+        for(auto &t : threads) {
+            t.join();
+        }
+
+        for(std::size_t i = 0; i < tag_count; i++) {
+            if(!paths[i].has_value()) {
+                continue;
+            }
+            if(results[i].has_value()) {
+                index.add_tag(*paths[i], std::move(*results[i]));
+                index.reused_count += reused[i];
+            }
+            else {
+                index.error_count++;
+            }
+        }
+
+        return index;
+    }
+
+    TagDependencyIndex TagDependencyIndex::index_tags_directories(const std::vector<File::TagFile> &tags, const std::vector<std::filesystem::path> &tags_directories, std::size_t job_count) {
+        // Combine the index files, preferring higher priority directories like the virtual tags directory does
+        TagDependencyIndex previous;
+        for(std::size_t d = 0; d < tags_directories.size(); d++) {
+            auto loaded = load_index_file(tags_directories[d] / INDEX_FILE_NAME, tags_directories[d], d);
+            if(!loaded.has_value()) {
+                continue;
+            }
+            for(auto &t : loaded->tags) {
+                if(!previous.tags.contains(t.first)) {
+                    previous.tags.emplace(t.first, std::move(t.second));
+                }
+            }
+        }
+
+        auto index = index_virtual_tag_folder(tags, job_count, &previous);
+
+        for(std::size_t d = 0; d < tags_directories.size(); d++) {
+            auto index_path = tags_directories[d] / INDEX_FILE_NAME;
+            if(!index.save_index_file(index_path, d)) {
+                eprintf_warn("Failed to save the tag index to %s", index_path.string().c_str());
+            }
+        }
+
+        return index;
+    }
+
+    // The index is only valid for the same version, since what counts as a reference may change
+    static std::string index_file_header() {
+        return std::string("invader tag index ") + full_version() + "\n";
+    }
+
+    std::optional<TagDependencyIndex> TagDependencyIndex::load_index_file(const std::filesystem::path &path, const std::filesystem::path &tags_directory, std::size_t tag_directory) {
+        auto text = File::open_state_file(path, index_file_header());
+        if(!text.has_value()) {
+            return std::nullopt;
+        }
+
+        // Each tag is a line of numbers followed by a tab and the tag path, and then a line for each dependency
+        TagDependencyIndex index;
+        std::istringstream stream(*text);
+        std::string line;
+        while(std::getline(stream, line)) {
+            auto tab = line.find('\t');
+            if(tab == std::string::npos) {
+                return std::nullopt;
+            }
+
+            auto path = File::split_tag_class_extension(line.substr(tab + 1));
+            if(!path.has_value()) {
+                return std::nullopt;
+            }
+
+            IndexedTag tag;
+            std::uint64_t modified_time, header_fourcc, header_version, header_crc32;
+            std::size_t dependency_count;
+            std::istringstream numbers(line.substr(0, tab));
+            if(!(numbers >> std::hex >> tag.file_size >> modified_time >> tag.hash >> header_fourcc >> header_version >> header_crc32 >> dependency_count)) {
+                return std::nullopt;
+            }
+            tag.modified_time = static_cast<std::int64_t>(modified_time);
+            tag.header_fourcc = static_cast<TagFourCC>(header_fourcc);
+            tag.header_version = static_cast<std::uint16_t>(header_version);
+            tag.header_crc32 = static_cast<std::uint32_t>(header_crc32);
+            tag.tag_directory = tag_directory;
+            tag.full_path = tags_directory / File::halo_path_to_preferred_path(line.substr(tab + 1));
+
+            tag.dependencies.reserve(dependency_count);
+            for(std::size_t d = 0; d < dependency_count; d++) {
+                if(!std::getline(stream, line)) {
+                    return std::nullopt;
+                }
+                auto dependency = File::split_tag_class_extension(line);
+                if(!dependency.has_value()) {
+                    return std::nullopt;
+                }
+                tag.dependencies.emplace_back(std::move(*dependency));
+            }
+
+            index.add_tag(*path, std::move(tag));
+        }
+
+        return index;
+    }
+
+    bool TagDependencyIndex::save_index_file(const std::filesystem::path &path, std::size_t tag_directory) const {
+        std::ostringstream stream;
+        stream << std::hex;
+        for(auto &t : this->tags) {
+            auto &tag = t.second;
+            if(tag.tag_directory != tag_directory) {
+                continue;
+            }
+            stream << tag.file_size << " " << static_cast<std::uint64_t>(tag.modified_time) << " " << tag.hash << " "
+                   << static_cast<std::uint32_t>(tag.header_fourcc) << " " << tag.header_version << " " << tag.header_crc32 << " "
+                   << tag.dependencies.size() << "\t" << t.first.join() << "\n";
+            for(auto &d : tag.dependencies) {
+                stream << d.join() << "\n";
+            }
+        }
+        return File::save_state_file(path, index_file_header(), stream.str());
+    }
+
+    bool TagDependencyIndex::update_tag(const File::TagFile &tag) {
+        auto path = File::split_tag_class_extension(File::preferred_path_to_halo_path(tag.tag_path));
+        if(!path.has_value()) {
+            return false;
+        }
+
+        bool reused;
+        auto indexed = index_tag(tag, nullptr, reused);
+
+        this->remove_tag(*path);
+        if(!indexed.has_value()) {
+            this->error_count++;
+            return false;
+        }
+
+        this->add_tag(*path, std::move(*indexed));
+        return true;
+    }
+
+    void TagDependencyIndex::remove_tag(const File::TagFilePath &tag) {
+        auto indexed = this->tags.find(tag);
+        if(indexed == this->tags.end()) {
+            return;
+        }
+
+        for(auto &d : indexed->second.dependencies) {
+            auto referrers = this->referrers.find(d);
+            if(referrers != this->referrers.end()) {
+                referrers->second.erase(tag);
+                if(referrers->second.empty()) {
+                    this->referrers.erase(referrers);
+                }
+            }
+        }
+
+        this->tags.erase(indexed);
+    }
+
+    void TagDependencyIndex::add_tag(const File::TagFilePath &path, IndexedTag &&tag) {
+        for(auto &d : tag.dependencies) {
+            this->referrers[d].insert(path);
+        }
+
+        this->tags[path] = std::move(tag);
+    }
+
+    const std::set<File::TagFilePath> &TagDependencyIndex::get_referrers(const File::TagFilePath &tag) const noexcept {
+        static const std::set<File::TagFilePath> NO_REFERRERS;
+        auto referrers = this->referrers.find(tag);
+        return referrers == this->referrers.end() ? NO_REFERRERS : referrers->second;
+    }
+
+    const std::vector<File::TagFilePath> *TagDependencyIndex::get_dependencies(const File::TagFilePath &tag) const noexcept {
+        auto indexed = this->tags.find(tag);
+        return indexed == this->tags.end() ? nullptr : &indexed->second.dependencies;
+    }
+
+    const std::filesystem::path *TagDependencyIndex::get_file_path(const File::TagFilePath &tag) const noexcept {
+        auto indexed = this->tags.find(tag);
+        return indexed == this->tags.end() ? nullptr : &indexed->second.full_path;
+    }
+
+    const TagDependencyIndex::IndexedTag *TagDependencyIndex::get_tag(const File::TagFilePath &tag) const noexcept {
+        auto indexed = this->tags.find(tag);
+        return indexed == this->tags.end() ? nullptr : &indexed->second;
+    }
+}
@@ -8,6 +8,12 @@
 #include <invader/tag/hek/header.hpp>
 #include "../crc/crc32.h"
 #include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <mutex>
 
 #include "expression.hpp"
 
@@ -22,6 +28,22 @@
 
 using namespace Invader;
 
+// Output of the tag being edited on this thread, if any
+static thread_local BufferedOutput *tag_output = nullptr;
+
+// Hold the error with the output of the tag being edited on this thread, or print it now if there isn't one
+static void edit_eprintf_error(const char *fmt, ...) {
+    BufferedOutput now;
+    auto &output = tag_output ? *tag_output : now;
+
+    std::va_list args;
+    va_start(args, fmt);
+    output.vprint(BufferedOutput::OUTPUT_ERROR, fmt, args);
+    va_end(args);
+
+    now.flush();
+}
+
 enum ActionType {
     ACTION_TYPE_CHECKSUM,
     ACTION_TYPE_GET,
@@ -35,12 +57,26 @@ enum ActionType {
     ACTION_TYPE_MOVE
 };
 
+// Comma-separated expressions for --set, parsed the first time a numeric value needs them and then reused for every value and tag
+class SetExpressions {
+public:
+    SetExpressions(std::string value) : value(std::move(value)) {}
+
+    const std::vector<Edit::Expression> &get();
+
+private:
+    std::string value;
+    std::once_flag compiled;
+    std::vector<Edit::Expression> expressions;
+};
+
 struct Actions {
     ActionType type;
     std::string key;
     std::string value;
     std::size_t count = 0;
     std::size_t position = 0;
+    std::shared_ptr<SetExpressions> expressions = {};
 };
 
 static std::string get_top_member_name(const std::string &key, std::string &after_member) {
@@ -49,7 +85,7 @@ static std::string get_top_member_name(const std::string &key, std::string &afte
     for(; *c != 0 && *c != '.' && *c != '[' && *c != ']'; c++);
     
     if(c == key_str) {
-        eprintf_error("Invalid key %s", key.c_str());
+        edit_eprintf_error("Invalid key %s", key.c_str());
         throw std::exception();
     }
     
@@ -63,19 +99,19 @@ static std::pair<std::size_t, std::size_t> get_range(const std::string &key, std
     auto *key_end = key_str;
     
     if(key_str[0] == 0) {
-        eprintf_error("Expected range at end of key");
+        edit_eprintf_error("Expected range at end of key");
         throw std::exception();
     }
     
     if(key_str[0] != '[') {
-        eprintf_error("Invalid range in key %s", key.c_str());
+        edit_eprintf_error("Invalid range in key %s", key.c_str());
         throw std::exception();
     }
     
     for(; *key_end != ']'; key_end++) {
         // Unexpected end?
         if(*key_end == 0) {
-            eprintf_error("Invalid range in key %s", key.c_str());
+            edit_eprintf_error("Invalid range in key %s", key.c_str());
             throw std::exception();
         }
     }
@@ -103,7 +139,7 @@ static std::pair<std::size_t, std::size_t> get_range(const std::string &key, std
     
     // Okay
     if(hyphens > 1) {
-        eprintf_error("Invalid range %s", range_str.c_str());
+        edit_eprintf_error("Invalid range %s", range_str.c_str());
         throw std::exception();
     }
     
@@ -133,14 +169,14 @@ static std::pair<std::size_t, std::size_t> get_range(const std::string &key, std
             }
         }
         catch (std::exception &) {
-            eprintf_error("Invalid range %s", range_str.c_str());
+            edit_eprintf_error("Invalid range %s", range_str.c_str());
             throw;
         }
     }
     
     // Did we exceed things?
     if(min > max) {
-        eprintf_error("Invalid range %s", range_str.c_str());
+        edit_eprintf_error("Invalid range %s", range_str.c_str());
         throw std::exception();
     }
     
@@ -149,7 +185,7 @@ static std::pair<std::size_t, std::size_t> get_range(const std::string &key, std
 
 static void build_array(Parser::ParserStruct *ps, std::string key, std::vector<Parser::ParserStructValue> &array, std::string *bitfield, std::pair<std::size_t, std::size_t> *range) {
     if(key == "") {
-        eprintf_error("Expected value name");
+        edit_eprintf_error("Expected value name");
         throw std::exception();
     }
     
@@ -157,20 +193,20 @@ static void build_array(Parser::ParserStruct *ps, std::string key, std::vector<P
         key = std::string(key.begin() + 1, key.end());
     }
     else {
-        eprintf_error("Expected a dot before key %s", key.c_str());
+        edit_eprintf_error("Expected a dot before key %s", key.c_str());
         throw std::exception();
     }
     
     auto member = get_top_member_name(key, key);
     if(member == "") {
-        eprintf_error("No member name given for array");
+        edit_eprintf_error("No member name given for array");
         throw std::exception();
     }
     
-    auto &values = ps->get_values();
+    auto values = ps->get_values();
     
     // Do it!
-    for(auto &i : values) {
+    for(auto i : values) {
         auto *member_name = i.get_member_name();
         
         if(member_name && member_name == member) {
@@ -191,7 +227,7 @@ static void build_array(Parser::ParserStruct *ps, std::string key, std::vector<P
                         return;
                     }
                     
-                    eprintf_error("%s::%s is empty", ps->struct_name(), member.c_str());
+                    edit_eprintf_error("%s::%s is empty", ps->struct_name(), member.c_str());
                     throw std::exception();
                 }
                 
@@ -204,7 +240,7 @@ static void build_array(Parser::ParserStruct *ps, std::string key, std::vector<P
                 }
                 
                 if(count < access_range.first || count <= access_range.second) {
-                    eprintf_error("%zu-%zu is out of bounds for %s::%s (%zu element%s)", access_range.first, access_range.second, ps->struct_name(), member.c_str(), count, count == 1 ? "" : "s");
+                    edit_eprintf_error("%zu-%zu is out of bounds for %s::%s (%zu element%s)", access_range.first, access_range.second, ps->struct_name(), member.c_str(), count, count == 1 ? "" : "s");
                     throw std::exception();
                 }
                 
@@ -227,17 +263,17 @@ static void build_array(Parser::ParserStruct *ps, std::string key, std::vector<P
                 // Is this a bitfield? If so, set it!
                 if(i.get_type() == Parser::ParserStructValue::ValueType::VALUE_TYPE_BITMASK) {
                     if(key.size() == 0) {
-                        eprintf_error("Expected bitfield but got the end of the key");
+                        edit_eprintf_error("Expected bitfield but got the end of the key");
                         throw std::exception();
                     }
                     else if(key[0] != '.') {
-                        eprintf_error("Expected bitfield but got %s", key.c_str());
+                        edit_eprintf_error("Expected bitfield but got %s", key.c_str());
                         throw std::exception();
                     }
                     *bitfield = key.substr(1);
                 }
                 else if(key.size() != 0) {
-                    eprintf_error("Expected end of key but got %s", key.c_str());
+                    edit_eprintf_error("Expected end of key but got %s", key.c_str());
                     throw std::exception();
                 }
                 
@@ -246,7 +282,7 @@ static void build_array(Parser::ParserStruct *ps, std::string key, std::vector<P
         }
     }
     
-    eprintf_error("%s::%s does not exist", ps->struct_name(), member.c_str());
+    edit_eprintf_error("%s::%s does not exist", ps->struct_name(), member.c_str());
     throw std::exception();
 }
 
@@ -254,7 +290,7 @@ static void require_writable_only(const std::vector<Parser::ParserStructValue> &
     if(writable_only) {
         for(auto &i : values) {
             if(i.is_read_only()) {
-                eprintf_error("%s is read-only", i.get_member_name());
+                edit_eprintf_error("%s is read-only", i.get_member_name());
                 throw std::exception();
             }
         }
@@ -296,7 +332,7 @@ static std::string get_value(const Parser::ParserStructValue &value, const std::
             case Parser::ParserStructValue::ValueType::VALUE_TYPE_BITMASK:
                 return std::to_string(value.read_bitfield(bitmask.c_str()) ? 1 : 0);
             default:
-                eprintf_error("Unsupported value type for this operation");
+                edit_eprintf_error("Unsupported value type for this operation");
                 throw std::exception();
         }
     }
@@ -336,7 +372,29 @@ static std::string get_value(const Parser::ParserStructValue &value, const std::
     }
 }
 
-static void set_value(Parser::ParserStructValue &value, const std::string &new_value, const std::optional<std::string> bitfield = std::nullopt) {
+// Parse each comma-separated expression once so it can be used on any number of values and tags
+static std::vector<Edit::Expression> compile_expressions(const std::string &new_value) {
+    std::vector<Edit::Expression> expressions;
+    const char *start = new_value.c_str();
+    const char *cursor;
+    for(cursor = start; *cursor != 0; cursor++) {
+        if(*cursor == ',') {
+            expressions.emplace_back(std::string(start, cursor).c_str());
+            start = cursor + 1;
+        }
+    }
+    expressions.emplace_back(std::string(start, cursor).c_str());
+    return expressions;
+}
+
+const std::vector<Edit::Expression> &SetExpressions::get() {
+    std::call_once(this->compiled, [this]() {
+        this->expressions = compile_expressions(this->value);
+    });
+    return this->expressions;
+}
+
+static void set_value(Parser::ParserStructValue &value, const std::string &new_value, SetExpressions &set_expressions, const std::optional<std::string> bitfield = std::nullopt) {
     auto format = value.get_number_format();
     auto type = value.get_type();
     
@@ -345,7 +403,7 @@ static void set_value(Parser::ParserStructValue &value, const std::string &new_v
         switch(type) {
             case Parser::ParserStructValue::ValueType::VALUE_TYPE_TAGSTRING:
                 if(new_value.size() > 31) {
-                    eprintf_error("String exceeds maximum length (%zu > 31)", new_value.size());
+                    edit_eprintf_error("String exceeds maximum length (%zu > 31)", new_value.size());
                     throw std::exception();
                 }
                 return value.set_string(new_value.c_str());
@@ -375,14 +433,14 @@ static void set_value(Parser::ParserStructValue &value, const std::string &new_v
                         dep.tag_fourcc = new_path.fourcc;
                     }
                     else {
-                        eprintf_error("%s tags cannot be referenced here", tag_fourcc_to_extension(new_path.fourcc));
+                        edit_eprintf_error("%s tags cannot be referenced here", tag_fourcc_to_extension(new_path.fourcc));
                         throw std::exception();
                     }
                 }
                 
                 // Hopefully no one comments on the fact I wrote "else try" a few lines up as if it was something equivalent to "else if".
                 catch (std::exception &) {
-                    eprintf_error("Invalid tag path %s", new_value.c_str());
+                    edit_eprintf_error("Invalid tag path %s", new_value.c_str());
                     throw std::exception();
                 }
                 
@@ -393,7 +451,7 @@ static void set_value(Parser::ParserStructValue &value, const std::string &new_v
                     return value.write_enum(new_value.c_str());
                 }
                 catch (std::exception &) {
-                    eprintf_error("Invalid enum value %s", new_value.c_str());
+                    edit_eprintf_error("Invalid enum value %s", new_value.c_str());
                     throw std::exception();
                 }
             case Parser::ParserStructValue::ValueType::VALUE_TYPE_BITMASK:
@@ -405,16 +463,16 @@ static void set_value(Parser::ParserStructValue &value, const std::string &new_v
                         case 1:
                             return value.write_bitfield(bitfield.value().c_str(), true);
                         default:
-                            eprintf_error("Bitfields can only be set to 0 or 1");
+                            edit_eprintf_error("Bitfields can only be set to 0 or 1");
                             throw std::exception();
                     }
                 }
                 catch (std::exception &) {
-                    eprintf_error("Invalid bitmask/value %s => %s", bitfield.value().c_str(), new_value.c_str());
+                    edit_eprintf_error("Invalid bitmask/value %s => %s", bitfield.value().c_str(), new_value.c_str());
                     throw std::exception();
                 }
             default:
-                eprintf_error("Unsupported value type");
+                edit_eprintf_error("Unsupported value type");
                 throw std::exception();
         }
     }
@@ -422,36 +480,35 @@ static void set_value(Parser::ParserStructValue &value, const std::string &new_v
     // Numeric value?
     else {
         auto expected_value_count = value.get_value_count();
-        
-        std::vector<std::string> expressions;
-        expressions.reserve(expected_value_count);
-        
-        const char *start = new_value.c_str();
-        const char *cursor;
-        for(cursor = start; *cursor != 0; cursor++) {
-            if(*cursor == ',') {
-                expressions.emplace_back(start, cursor);
-                start = ++cursor;
-                continue;
-            }
-        }
-        expressions.emplace_back(start, cursor);
+        auto &expressions = set_expressions.get();
         
         if(expressions.size() != expected_value_count) {
-            eprintf_error("Expected %zu comma-separated value%s but only got %zu", expected_value_count, expected_value_count == 1 ? "" : "s", expressions.size());
+            edit_eprintf_error("Expected %zu comma-separated value%s but only got %zu", expected_value_count, expected_value_count == 1 ? "" : "s", expressions.size());
             throw std::exception();
         }
         
         auto all_values = value.get_values();
         for(std::size_t i = 0; i < expected_value_count; i++) {
             auto &v = all_values[i];
-            auto *e = expressions[i].c_str();
+            auto &e = expressions[i];
             switch(value.get_number_format()) {
                 case Parser::ParserStructValue::NumberFormat::NUMBER_FORMAT_INT:
-                    v = Edit::evaluate_expression(e, std::get<std::int64_t>(v));
+                    try {
+                        v = e.evaluate(std::get<std::int64_t>(v));
+                    }
+                    catch(Edit::DivisionByZeroException &exception) {
+                        edit_eprintf_error("%s", exception.what());
+                        throw std::exception();
+                    }
                     break;
                 case Parser::ParserStructValue::NumberFormat::NUMBER_FORMAT_FLOAT:
-                    v = Edit::evaluate_expression(e, std::get<double>(v));
+                    try {
+                        v = e.evaluate(std::get<double>(v));
+                    }
+                    catch(Edit::DivisionByZeroException &exception) {
+                        edit_eprintf_error("%s", exception.what());
+                        throw std::exception();
+                    }
                     break;
                 default:
                     std::terminate();
@@ -463,7 +520,7 @@ static void set_value(Parser::ParserStructValue &value, const std::string &new_v
 
 // Ensure a struct has at least one of everything in everything (for listing)
 static Parser::ParserStruct &populate_struct(Parser::ParserStruct &ps) {
-    for(auto &i : ps.get_values()) {
+    for(auto i : ps.get_values()) {
         if(i.get_type() == Parser::ParserStructValue::ValueType::VALUE_TYPE_REFLEXIVE) {
             i.insert_objects_in_array(0, 1);
             populate_struct(i.get_object_in_array(0));
@@ -481,7 +538,7 @@ struct TagDataListTreeElement {
 };
 
 static void list_everything(Parser::ParserStruct &ps, std::vector<TagDataListTreeElement> &output, bool with_values, std::size_t level = 0) {
-    for(auto &i : ps.get_values()) {
+    for(auto i : ps.get_values()) {
         auto *mv = i.get_member_name();
         if(!mv) {
             continue;
@@ -782,7 +839,8 @@ int main(int argc, char * const *argv) {
         CommandLineOption("move", 'M', 2, "Swap the selected structs with the structs at the given index or \"end\" if the end of the array. The regions must not intersect.", "<key> <pos>"),
         CommandLineOption("erase", 'E', 1, "Delete the selected struct(s).", "<key>"),
         CommandLineOption("copy", 'c', 2, "Copy the selected struct(s) to the given index or \"end\" if the end of the array.", "<key> <pos>"),
-        CommandLineOption("no-safeguards", 'n', 0, "Allow all tag data to be edited (proceed at your own risk)")
+        CommandLineOption("no-safeguards", 'n', 0, "Allow all tag data to be edited (proceed at your own risk)"),
+        CommandLineOption("threads", 'j', 1, "Set the number of threads to use for editing tags when batching. Default: CPU thread count")
     };
 
     static constexpr char DESCRIPTION[] = "Edit tags via command-line.";
@@ -798,6 +856,7 @@ int main(int argc, char * const *argv) {
         bool view_checksum = false;
         std::vector<std::string> batch, batch_exclude;
         std::optional<std::variant<std::string, std::filesystem::path>> overwrite_path;
+        std::size_t max_threads = std::thread::hardware_concurrency() < 1 ? 1 : std::thread::hardware_concurrency();
     } edit_options;
 
     auto remaining_arguments = CommandLineOption::parse_arguments<EditOptions &>(argc, argv, options, USAGE, DESCRIPTION, 0, 1, edit_options, [](char opt, const std::vector<const char *> &arguments, auto &edit_options) {
@@ -833,7 +892,7 @@ int main(int argc, char * const *argv) {
                 edit_options.actions.emplace_back(Actions { ActionType::ACTION_TYPE_LIST, {}, {}, 0, 0 });
                 break;
             case 'S':
-                edit_options.actions.emplace_back(Actions { ActionType::ACTION_TYPE_SET, arguments[0], arguments[1], 0, 0 });
+                edit_options.actions.emplace_back(Actions { ActionType::ACTION_TYPE_SET, arguments[0], arguments[1], 0, 0, std::make_shared<SetExpressions>(arguments[1]) });
                 break;
             case 'I':
                 try {
@@ -862,6 +921,19 @@ int main(int argc, char * const *argv) {
             case 'n':
                 edit_options.check_read_only = false;
                 break;
+            case 'j':
+                try {
+                    edit_options.max_threads = std::stoul(arguments[0]);
+                }
+                catch(std::exception &) {
+                    eprintf_error("Invalid number of threads %s", arguments[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                if(edit_options.max_threads < 1) {
+                    eprintf_error("Invalid number of threads %s", arguments[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                break;
             case 'o':
                 edit_options.overwrite_path = std::filesystem::path(arguments[0]);
                 break;
@@ -886,7 +958,8 @@ int main(int argc, char * const *argv) {
         return EXIT_FAILURE;
     }
 
-    auto do_it_do_it_do_it_do_it = [&edit_options](const std::string &tag_path) -> bool {
+    // Output is returned rather than printed so tags edited at the same time don't mix their output
+    auto do_it_do_it_do_it_do_it = [&edit_options](const std::string &tag_path, BufferedOutput &output) -> bool {
         std::filesystem::path file_path = std::filesystem::path(edit_options.tags) / tag_path;
         std::unique_ptr<Parser::ParserStruct> tag_struct;
         
@@ -898,26 +971,28 @@ int main(int argc, char * const *argv) {
                 tag_struct = Parser::ParserStruct::generate_base_struct(tag_class);
             }
             catch (std::exception &) {
-                eprintf_error("Failed to create a new tag %s. Make sure the extension is correct.", file_path.string().c_str());
+                edit_eprintf_error("Failed to create a new tag %s. Make sure the extension is correct.", file_path.string().c_str());
                 return false;
             }
             
             // If we're verifying the checksum or viewing the checksum of a new tag, well... okay I guess
             if(edit_options.verify_checksum || edit_options.view_checksum) {
                 if(edit_options.view_checksum) {
-                    std::printf("0x%08X\n", reinterpret_cast<HEK::TagFileHeader *>(tag_struct->generate_hek_tag_data().data())->crc32.read());
+                    char checksum_str[16];
+                    std::snprintf(checksum_str, sizeof(checksum_str), "0x%08X", reinterpret_cast<HEK::TagFileHeader *>(tag_struct->generate_hek_tag_data().data())->crc32.read());
+                    output.print(BufferedOutput::OUTPUT_PLAIN, "%s\n", checksum_str);
                 }
                 
                 // Can't really verify a tag that never existed
                 if(edit_options.verify_checksum) {
-                    std::printf("matched\n");
+                    output.print(BufferedOutput::OUTPUT_PLAIN, "matched\n");
                 }
             }
         }
         else {
             auto value = File::open_file(file_path);
             if(!value.has_value()) {
-                eprintf_error("Failed to read %s", file_path.string().c_str());
+                edit_eprintf_error("Failed to read %s", file_path.string().c_str());
                 return false;
             }
             
@@ -925,7 +1000,7 @@ int main(int argc, char * const *argv) {
                 tag_struct = Parser::ParserStruct::parse_hek_tag_file(value->data(), value->size());
             }
             catch (std::exception &e) {
-                eprintf_error("Failed to parse %s: %s", file_path.string().c_str(), e.what());
+                edit_eprintf_error("Failed to parse %s: %s", file_path.string().c_str(), e.what());
                 return false;
             }
             
@@ -936,16 +1011,18 @@ int main(int argc, char * const *argv) {
                 
                 // Print the checksum
                 if(edit_options.view_checksum) {
-                    std::printf("0x%08X\n", checksum);
+                    char checksum_str[16];
+                    std::snprintf(checksum_str, sizeof(checksum_str), "0x%08X", checksum);
+                    output.print(BufferedOutput::OUTPUT_PLAIN, "%s\n", checksum_str);
                 }
                 
                 // Verify it's correct
                 if(edit_options.verify_checksum) {
                     if(header->crc32 == ~crc32(0, value->data() + sizeof(*header), value->size() - sizeof(*header))) {
-                        std::printf("matched\n");
+                        output.print(BufferedOutput::OUTPUT_PLAIN, "matched\n");
                     }
                     else {
-                        std::printf("mismatched\n");
+                        output.print(BufferedOutput::OUTPUT_PLAIN, "mismatched\n");
                     }
                 }
             }
@@ -953,24 +1030,31 @@ int main(int argc, char * const *argv) {
             tag_class = reinterpret_cast<const HEK::TagFileHeader *>(value->data())->tag_fourcc;
         }
         
-        std::vector<std::string> output;
         bool should_save = edit_options.new_tag; // by default only save if making a new tag. this will be set to true if --set, --insert, --copy, --move, or --delete are used too
         
         for(auto &i : edit_options.actions) {
             switch(i.type) {
                 case ActionType::ACTION_TYPE_LIST: {
-                    list_everything(populate_struct(*Parser::ParserStruct::generate_base_struct(tag_class)), output, false);
+                    std::vector<std::string> list;
+                    list_everything(populate_struct(*Parser::ParserStruct::generate_base_struct(tag_class)), list, false);
+                    for(auto &l : list) {
+                        output.print(BufferedOutput::OUTPUT_PLAIN, "%s\n", l.c_str());
+                    }
                     break;
                 }
                 case ActionType::ACTION_TYPE_LIST_ALL_VALUES: {
-                    list_everything(*tag_struct, output, true);
+                    std::vector<std::string> list;
+                    list_everything(*tag_struct, list, true);
+                    for(auto &l : list) {
+                        output.print(BufferedOutput::OUTPUT_PLAIN, "%s\n", l.c_str());
+                    }
                     break;
                 }
                 case ActionType::ACTION_TYPE_GET: {
                     std::string bitfield;
                     auto arr = get_values_for_key(tag_struct.get(), i.key == "" ? "" : (std::string(".") + i.key), bitfield, false);
                     for(auto &k : arr) {
-                        output.emplace_back(get_value(k, bitfield));
+                        output.print(BufferedOutput::OUTPUT_PLAIN, "%s\n", get_value(k, bitfield).c_str());
                     }
                     break;
                 }
@@ -979,7 +1063,7 @@ int main(int argc, char * const *argv) {
                     should_save = true;
                     auto arr = get_values_for_key(tag_struct.get(), i.key == "" ? "" : (std::string(".") + i.key), bitfield, edit_options.check_read_only);
                     for(auto &k : arr) {
-                        set_value(k, i.value, bitfield);
+                        set_value(k, i.value, *i.expressions, bitfield);
                     }
                     break;
                 }
@@ -987,10 +1071,10 @@ int main(int argc, char * const *argv) {
                     auto arr = get_values_for_key(tag_struct.get(), i.key == "" ? "" : (std::string(".") + i.key), false);
                     for(auto &k : arr) {
                         if(k.get_type() == Parser::ParserStructValue::ValueType::VALUE_TYPE_REFLEXIVE) {
-                            output.emplace_back(std::to_string(k.get_array_size()));
+                            output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", k.get_array_size());
                         }
                         else {
-                            eprintf_error("%s is not an array", k.get_member_name());
+                            edit_eprintf_error("%s is not an array", k.get_member_name());
                             throw std::exception();
                         }
                     }
@@ -1001,12 +1085,12 @@ int main(int argc, char * const *argv) {
                     auto arr = get_values_for_key(tag_struct.get(), i.key == "" ? "" : (std::string(".") + i.key), edit_options.check_read_only);
                     for(auto &k : arr) {
                         if(k.get_type() != Parser::ParserStructValue::ValueType::VALUE_TYPE_REFLEXIVE) {
-                            eprintf_error("%s is not an array", k.get_member_name());
+                            edit_eprintf_error("%s is not an array", k.get_member_name());
                             throw std::exception();
                         }
                         
                         if(i.count + k.get_array_size() > k.get_array_maximum_size()) {
-                            eprintf_error("%s's maximum size of %zu exceeded", k.get_member_name(), k.get_array_maximum_size());
+                            edit_eprintf_error("%s's maximum size of %zu exceeded", k.get_member_name(), k.get_array_maximum_size());
                             throw std::exception();
                         }
                         k.insert_objects_in_array(i.position == SIZE_MAX ? k.get_array_size() : i.position, i.count);
@@ -1019,13 +1103,13 @@ int main(int argc, char * const *argv) {
                     auto arr = get_values_for_key(tag_struct.get(), i.key == "" ? "" : (std::string(".") + i.key), range, edit_options.check_read_only);
                     for(auto &k : arr) {
                         if(k.get_type() != Parser::ParserStructValue::ValueType::VALUE_TYPE_REFLEXIVE) {
-                            eprintf_error("%s is not an array", k.get_member_name());
+                            edit_eprintf_error("%s is not an array", k.get_member_name());
                             throw std::exception();
                         }
                         
                         std::size_t iterations = range.second - range.first + 1;
                         if(k.get_array_size() - iterations < k.get_array_minimum_size()) {
-                            eprintf_error("%s's minimum size of %zu exceeded", k.get_member_name(), k.get_array_maximum_size());
+                            edit_eprintf_error("%s's minimum size of %zu exceeded", k.get_member_name(), k.get_array_maximum_size());
                             throw std::exception();
                         }
                         k.delete_objects_in_array(range.first, iterations);
@@ -1038,7 +1122,7 @@ int main(int argc, char * const *argv) {
                     auto arr = get_values_for_key(tag_struct.get(), i.key == "" ? "" : (std::string(".") + i.key), range, edit_options.check_read_only);
                     for(auto &k : arr) {
                         if(k.get_type() != Parser::ParserStructValue::ValueType::VALUE_TYPE_REFLEXIVE) {
-                            eprintf_error("%s is not an array", k.get_member_name());
+                            edit_eprintf_error("%s is not an array", k.get_member_name());
                             throw std::exception();
                         }
                         
@@ -1057,7 +1141,7 @@ int main(int argc, char * const *argv) {
                     auto arr = get_values_for_key(tag_struct.get(), i.key == "" ? "" : (std::string(".") + i.key), range, edit_options.check_read_only);
                     for(auto &k : arr) {
                         if(k.get_type() != Parser::ParserStructValue::ValueType::VALUE_TYPE_REFLEXIVE) {
-                            eprintf_error("%s is not an array", k.get_member_name());
+                            edit_eprintf_error("%s is not an array", k.get_member_name());
                             throw std::exception();
                         }
                         
@@ -1065,7 +1149,7 @@ int main(int argc, char * const *argv) {
                         std::size_t iterations = range.second - range.first + 1;
                         
                         if(iterations + k.get_array_size() > k.get_array_maximum_size()) {
-                            eprintf_error("%s's maximum size of %zu exceeded", k.get_member_name(), k.get_array_maximum_size());
+                            edit_eprintf_error("%s's maximum size of %zu exceeded", k.get_member_name(), k.get_array_maximum_size());
                             throw std::exception();
                         }
                         
@@ -1074,15 +1158,11 @@ int main(int argc, char * const *argv) {
                     break;
                 }
                 default:
-                    eprintf_error("Unimplemented");
+                    edit_eprintf_error("Unimplemented");
                     std::exit(EXIT_FAILURE);
             }
         }
         
-        for(auto &i : output) {
-            std::puts(i.c_str());
-        }
-        
         // If we're overwriting a file that isn't the main one, let's find out what
         bool create_directories_if_possible = false;
         
@@ -1112,7 +1192,7 @@ int main(int argc, char * const *argv) {
             }
             
             if(!can_save) {
-                eprintf_error("Cannot save: %s does not have the correct .%s extension", file_path.string().c_str(), HEK::tag_fourcc_to_extension(tag_class));
+                edit_eprintf_error("Cannot save: %s does not have the correct .%s extension", file_path.string().c_str(), HEK::tag_fourcc_to_extension(tag_class));
                 return false;
             }
             
@@ -1122,7 +1202,7 @@ int main(int argc, char * const *argv) {
             }
             
             if(!File::save_file(file_path, tag_struct->generate_hek_tag_data(tag_class))) {
-                eprintf_error("Unable to write to %s", file_path.string().c_str());
+                edit_eprintf_error("Unable to write to %s", file_path.string().c_str());
                 return false;
             }
             return true;
@@ -1134,32 +1214,93 @@ int main(int argc, char * const *argv) {
     
     if(use_batching) {
         auto v = File::load_virtual_tag_folder({edit_options.tags});
-        std::size_t count = 0;
-        std::size_t total = 0;
+        std::vector<std::string> paths;
+        File::PathMatcher matcher(edit_options.batch, edit_options.batch_exclude);
         for(auto &t : v) {
-            if(File::path_matches(t.tag_path.c_str(), edit_options.batch, edit_options.batch_exclude)) {
+            if(matcher.matches(t.tag_path)) {
+                paths.emplace_back(std::move(t.tag_path));
+            }
+        }
+        
+        // Each tag's result and output is kept so output stays in order regardless of which thread finished first
+        struct EditedTag {
+            bool success = false;
+            BufferedOutput output;
+        };
+        
+        std::size_t total = paths.size();
+        std::vector<EditedTag> results(total);
+        std::atomic<std::size_t> next_tag = 0;
+        auto start = std::chrono::steady_clock::now();
+        
+        auto edit_thread = [&paths, &results, &next_tag, &total, &do_it_do_it_do_it_do_it]() {
+            while(true) {
+                auto t = next_tag.fetch_add(1, std::memory_order_relaxed);
+                if(t >= total) {
+                    return;
+                }
+                
+                auto &result = results[t];
+                tag_output = &result.output;
                 try {
-                    if(do_it_do_it_do_it_do_it(File::halo_path_to_preferred_path(t.tag_path))) {
-                        count++;
-                        oprintf_success("Successfully edited %s", t.tag_path.c_str());
-                    }
+                    result.success = do_it_do_it_do_it_do_it(File::halo_path_to_preferred_path(paths[t]), result.output);
                 }
-                catch(std::exception &e) {
-                    eprintf_error("Failed to edit %s", t.tag_path.c_str());
+                catch(std::exception &) {
+                    result.success = false;
                 }
-                total++;
+                tag_output = nullptr;
+            }
+        };
+        
+        // Every tag would be saved to the same file, so only do one at a time
+        auto max_threads = edit_options.overwrite_path.has_value() ? 1 : edit_options.max_threads;
+        
+        std::vector<std::thread> threads;
+        auto thread_count = std::min(max_threads, total);
+        threads.reserve(thread_count);
+        for(std::size_t j = 0; j < thread_count; j++) {
+            threads.emplace_back(edit_thread);
+        }
+        for(auto &t : threads) {
+            t.join();
+        }
+        
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        std::size_t count = 0;
+        for(std::size_t t = 0; t < total; t++) {
+            auto &result = results[t];
+            result.output.flush();
+            if(result.success) {
+                count++;
+                oprintf_success("Successfully edited %s", paths[t].c_str());
+            }
+            else {
+                eprintf_error("Failed to edit %s", paths[t].c_str());
             }
         }
         
         auto error_count = total - count;
         if(error_count > 0) {
-            oprintf_success_warn("Edited %zu out of %zu tag%s (%zu error%s)", count, total, total == 1 ? "" : "s", error_count, error_count == 1 ? "" : "s");
+            oprintf_success_warn("Edited %zu out of %zu tag%s (%zu error%s) in %.03f seconds", count, total, total == 1 ? "" : "s", error_count, error_count == 1 ? "" : "s", seconds);
         }
         else {
-            oprintf_success("Edited %zu out of %zu tag%s", count, total, total == 1 ? "" : "s");
+            oprintf_success("Edited %zu out of %zu tag%s in %.03f seconds", count, total, total == 1 ? "" : "s", seconds);
         }
     }
     else {
-        return do_it_do_it_do_it_do_it(File::halo_path_to_preferred_path(remaining_arguments[0])) ? EXIT_SUCCESS : EXIT_FAILURE;
+        BufferedOutput output;
+        tag_output = &output;
+        bool result = false;
+        try {
+            result = do_it_do_it_do_it_do_it(File::halo_path_to_preferred_path(remaining_arguments[0]), output);
+        }
+        catch(std::exception &) {
+            output.flush();
+            throw;
+        }
+        tag_output = nullptr;
+        output.flush();
+        return result ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 }
@@ -8,59 +8,62 @@
 #include <cassert>
 #include <optional>
 #include <cmath>
-
-template <typename Number, Number number_from_value(const std::string &what)> static Number evaluate_expression_of_type(const char *expression, Number input) {
-    struct ParsedToken {
-        enum Type {
-            GROUP,
-            NUMBER,
-            INPUT,
-            POWER,
-            ADD,
-            SUBTRACT,
-            MULTIPLY,
-            DIVIDE
-        } type;
-
-        bool is_operator() const noexcept {
-            switch(this->type) {
-                case Type::ADD:
-                case Type::SUBTRACT:
-                case Type::MULTIPLY:
-                case Type::DIVIDE:
-                case Type::POWER:
-                    return true;
-                default:
-                    return false;
-            }
+#include <algorithm>
+
+template <typename Number> struct ParsedTokenOfType {
+    enum Type {
+        GROUP,
+        NUMBER,
+        INPUT,
+        POWER,
+        ADD,
+        SUBTRACT,
+        MULTIPLY,
+        DIVIDE
+    } type;
+
+    bool is_operator() const noexcept {
+        switch(this->type) {
+            case Type::ADD:
+            case Type::SUBTRACT:
+            case Type::MULTIPLY:
+            case Type::DIVIDE:
+            case Type::POWER:
+                return true;
+            default:
+                return false;
         }
+    }
 
-        int operator_priority() noexcept {
-            assert(this->is_operator());
-
-            switch(this->type) {
-                case Type::ADD:
-                case Type::SUBTRACT:
-                    return 1;
-                case Type::MULTIPLY:
-                case Type::DIVIDE:
-                    return 2;
-                case Type::POWER:
-                    return 3;
-                default:
-                    std::terminate();
-            }
+    int operator_priority() noexcept {
+        assert(this->is_operator());
+
+        switch(this->type) {
+            case Type::ADD:
+            case Type::SUBTRACT:
+                return 1;
+            case Type::MULTIPLY:
+            case Type::DIVIDE:
+                return 2;
+            case Type::POWER:
+                return 3;
+            default:
+                std::terminate();
         }
+    }
 
-        std::vector<ParsedToken> group;
-        Number number = 1.0; // multiplier if group/input. number if number
+    std::vector<ParsedTokenOfType> group;
+    Number number = 1.0; // multiplier if group/input. number if number
 
-        // These next four lines somehow make GCC not scream at me for use-after-free warnings
-        ParsedToken() = default;
-        ParsedToken(ParsedToken &&moving) = default;
-        ParsedToken(const ParsedToken &moving) = default;
-        ParsedToken &operator=(const ParsedToken &moving) = default;
-    };
+    // These next four lines somehow make GCC not scream at me for use-after-free warnings
+    ParsedTokenOfType() = default;
+    ParsedTokenOfType(ParsedTokenOfType &&moving) = default;
+    ParsedTokenOfType(const ParsedTokenOfType &moving) = default;
+    ParsedTokenOfType &operator=(const ParsedTokenOfType &moving) = default;
+};
+
+template <typename Number, Number number_from_value(const std::string &what)> static ParsedTokenOfType<Number> parse_expression_of_type(const char *expression) {
+    using ParsedToken = ParsedTokenOfType<Number>;
 
     // Get tokens
     std::vector<std::string> tokens;
@@ -291,71 +294,148 @@ template <typename Number, Number number_from_value(const std::string &what)> st
 
     recursively_sort_group(main_group, recursively_sort_group);
 
-    // Now we can evaluate it!
-    auto recursively_evaluate_token = [](const ParsedToken &token, Number input, auto &recursively_evaluate_token) -> Number {
+    return main_group;
+}
+
+static double string_to_double(const std::string &what) {
+    return std::stod(what);
+}
+
+static std::int64_t string_to_int(const std::string &what) {
+    return std::stoll(what);
+}
+
+namespace Invader::Edit {
+    template <typename Number, typename Token> void Expression::compile_token(const Token &token, Program<Number> &program, std::size_t &stack_size) {
+        auto push = [&program, &stack_size](InstructionType type, Number number) {
+            program.instructions.emplace_back(Instruction<Number> { type, number });
+            stack_size++;
+            program.stack_size = std::max(program.stack_size, stack_size);
+        };
+
         switch(token.type) {
-            case ParsedToken::Type::INPUT:
-                return input * token.number;
-            case ParsedToken::Type::NUMBER:
-                return token.number;
-            case ParsedToken::Type::GROUP: {
-                Number value = 0.0;
-                auto op = ParsedToken::Type::ADD;
+            case Token::Type::INPUT:
+                push(InstructionType::INSTRUCTION_TYPE_PUSH_INPUT, token.number);
+                break;
+            case Token::Type::NUMBER:
+                push(InstructionType::INSTRUCTION_TYPE_PUSH_NUMBER, token.number);
+                break;
+            case Token::Type::GROUP: {
+                // Groups are evaluated left to right starting from 0
+                push(InstructionType::INSTRUCTION_TYPE_PUSH_NUMBER, 0);
                 auto length = token.group.size();
-                for(std::size_t i = 0; i < length; i+=2) {
-                    auto last = i + 1 == length;
-                    auto next_value = recursively_evaluate_token(token.group[i], input, recursively_evaluate_token);
-                    switch(op) {
-                        case ParsedToken::Type::ADD:
-                            value += next_value;
+                for(std::size_t i = 0; i < length; i += 2) {
+                    compile_token(token.group[i], program, stack_size);
+
+                    InstructionType op;
+                    switch(i == 0 ? Token::Type::ADD : token.group[i - 1].type) {
+                        case Token::Type::ADD:
+                            op = InstructionType::INSTRUCTION_TYPE_ADD;
                             break;
-                        case ParsedToken::Type::SUBTRACT:
-                            value -= next_value;
+                        case Token::Type::SUBTRACT:
+                            op = InstructionType::INSTRUCTION_TYPE_SUBTRACT;
                             break;
-                        case ParsedToken::Type::MULTIPLY:
-                            value *= next_value;
+                        case Token::Type::MULTIPLY:
+                            op = InstructionType::INSTRUCTION_TYPE_MULTIPLY;
                             break;
-                        case ParsedToken::Type::DIVIDE:
-                            if(next_value == 0) {
-                                std::fputs("Division by zero!\n", stderr);
-                                throw std::exception();
-                            }
-                            value /= next_value;
+                        case Token::Type::DIVIDE:
+                            op = InstructionType::INSTRUCTION_TYPE_DIVIDE;
                             break;
-                        case ParsedToken::Type::POWER:
-                            value = std::pow(value, next_value);
+                        case Token::Type::POWER:
+                            op = InstructionType::INSTRUCTION_TYPE_POWER;
                             break;
                         default:
-                            assert(false);
-                    }
-                    if(!last) {
-                        op = token.group[i+1].type;
+                            std::terminate();
                     }
+                    program.instructions.emplace_back(Instruction<Number> { op, 0 });
+                    stack_size--;
                 }
-                return value;
+                break;
             }
             default:
-                assert(false);
                 std::terminate();
         }
-    };
+    }
 
-    return recursively_evaluate_token(main_group, input, recursively_evaluate_token);
-}
+    template <typename Number> Number Expression::run(const Program<Number> &program, Number input) {
+        if(program.error) {
+            std::rethrow_exception(program.error);
+        }
 
-static double string_to_double(const std::string &what) {
-    return std::stod(what);
-}
+        std::vector<Number> stack;
+        stack.reserve(program.stack_size);
+        for(auto &i : program.instructions) {
+            switch(i.type) {
+                case InstructionType::INSTRUCTION_TYPE_PUSH_NUMBER:
+                    stack.emplace_back(i.number);
+                    continue;
+                case InstructionType::INSTRUCTION_TYPE_PUSH_INPUT:
+                    stack.emplace_back(input * i.number);
+                    continue;
+                default:
+                    break;
+            }
 
-static std::int64_t string_to_int(const std::string &what) {
-    return std::stoll(what);
-}
+            auto next_value = stack.back();
+            stack.pop_back();
+            auto &value = stack.back();
+            switch(i.type) {
+                case InstructionType::INSTRUCTION_TYPE_ADD:
+                    value += next_value;
+                    break;
+                case InstructionType::INSTRUCTION_TYPE_SUBTRACT:
+                    value -= next_value;
+                    break;
+                case InstructionType::INSTRUCTION_TYPE_MULTIPLY:
+                    value *= next_value;
+                    break;
+                case InstructionType::INSTRUCTION_TYPE_DIVIDE:
+                    if(next_value == 0) {
+                        throw DivisionByZeroException();
+                    }
+                    value /= next_value;
+                    break;
+                case InstructionType::INSTRUCTION_TYPE_POWER:
+                    value = static_cast<Number>(std::pow(value, next_value));
+                    break;
+                default:
+                    std::terminate();
+            }
+        }
+        return stack.back();
+    }
+
+    Expression::Expression(const char *expression) {
+        // Numbers are parsed differently for integers and floats, so both are compiled
+        try {
+            std::size_t stack_size = 0;
+            compile_token(parse_expression_of_type<double, string_to_double>(expression), this->program_double, stack_size);
+        }
+        catch(std::exception &) {
+            this->program_double.error = std::current_exception();
+        }
+        try {
+            std::size_t stack_size = 0;
+            compile_token(parse_expression_of_type<std::int64_t, string_to_int>(expression), this->program_int, stack_size);
+        }
+        catch(std::exception &) {
+            this->program_int.error = std::current_exception();
+        }
+    }
+
+    double Expression::evaluate(double input) const {
+        return run(this->program_double, input);
+    }
+
+    std::int64_t Expression::evaluate(std::int64_t input) const {
+        return run(this->program_int, input);
+    }
 
-namespace Invader::Edit {
     double evaluate_expression(const char *expression, double input) {
-        return evaluate_expression_of_type<double, string_to_double>(expression, input);
+        return Expression(expression).evaluate(input);
     }
+
     std::int64_t evaluate_expression(const char *expression, std::int64_t input) {
-        return evaluate_expression_of_type<std::int64_t, string_to_int>(expression, input);
+        return Expression(expression).evaluate(input);
     }
 }
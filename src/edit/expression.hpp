@@ -4,8 +4,76 @@
 #define INVADER__EDIT__EXPRESSION_HPP
 
 #include <cstdint>
+#include <vector>
+#include <optional>
+#include <exception>
 
 namespace Invader::Edit {
+    /**
+     * Thrown when evaluating an expression divides by zero
+     */
+    class DivisionByZeroException : public std::exception {
+    public:
+        const char *what() const noexcept override {
+            return "Division by zero!";
+        }
+    };
+
+    /**
+     * Expression that is parsed once so it can be evaluated for any number of inputs
+     */
+    class Expression {
+    public:
+        /**
+         * Parse the expression. If it is invalid, evaluating it will throw the error instead.
+         * @param expression expression to parse
+         */
+        Expression(const char *expression);
+
+        /**
+         * Evaluate the expression
+         * @param input value of n
+         * @return      result
+         */
+        double evaluate(double input) const;
+
+        /**
+         * Evaluate the expression
+         * @param input value of n
+         * @return      result
+         */
+        std::int64_t evaluate(std::int64_t input) const;
+
+    private:
+        enum InstructionType : std::uint8_t {
+            INSTRUCTION_TYPE_PUSH_NUMBER,
+            INSTRUCTION_TYPE_PUSH_INPUT,
+            INSTRUCTION_TYPE_ADD,
+            INSTRUCTION_TYPE_SUBTRACT,
+            INSTRUCTION_TYPE_MULTIPLY,
+            INSTRUCTION_TYPE_DIVIDE,
+            INSTRUCTION_TYPE_POWER
+        };
+
+        template <typename Number> struct Instruction {
+            InstructionType type;
+            Number number;
+        };
+
+        // Instructions are run in order on a stack
+        template <typename Number> struct Program {
+            std::vector<Instruction<Number>> instructions;
+            std::size_t stack_size = 0;
+            std::exception_ptr error;
+        };
+
+        Program<double> program_double;
+        Program<std::int64_t> program_int;
+
+        template <typename Number, typename Token> static void compile_token(const Token &token, Program<Number> &program, std::size_t &stack_size);
+        template <typename Number> static Number run(const Program<Number> &program, Number input);
+    };
+
     double evaluate_expression(const char *expression, double input);
     std::int64_t evaluate_expression(const char *expression, std::int64_t input);
 }
@@ -165,7 +165,8 @@ namespace Invader::EditQt {
         }
 
         // Set up the scroll area and widgets
-        auto values = std::vector<Parser::ParserStructValue>(this->parser_data->get_values());
+        auto struct_values = this->parser_data->get_values();
+        auto values = std::vector<Parser::ParserStructValue>(struct_values.begin(), struct_values.end());
         this->scroll_widget = new QScrollArea();
         this->setCentralWidget(this->scroll_widget);
         this->main_widget = new TagEditorEditWidgetView(nullptr, values, this, true, extra_widget_panel);
@@ -305,8 +306,7 @@ namespace Invader::EditQt {
             
             // Save it!
             auto result = this->perform_save();
-            this->file = this->parent_window->all_tags.emplace_back(this->file);
-            this->parent_window->reload_tags(false);
+            this->parent_window->apply_tag_changes({ this->file }, {});
             
             // Done
             return result;
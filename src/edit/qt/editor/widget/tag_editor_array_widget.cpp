@@ -300,7 +300,8 @@ namespace Invader::EditQt {
         // Get it!
         auto index_unsigned = static_cast<std::size_t>(index);
         auto &s = this->get_struct_value()->get_object_in_array(index_unsigned);
-        this->tag_view_widget = new TagEditorEditWidgetView(this, s.get_values(), this->get_editor_window(), false);
+        auto values = s.get_values();
+        this->tag_view_widget = new TagEditorEditWidgetView(this, std::vector<Parser::ParserStructValue>(values.begin(), values.end()), this->get_editor_window(), false);
         this->vbox_layout->addWidget(this->tag_view_widget);
     }
 
@@ -374,7 +374,7 @@ namespace Invader::EditQt {
 
                     // Use a QStandardItemModel - it's a bit faster than adding directly, especially on Windows for whatever reason
                     auto *model = new QStandardItemModel(combobox);
-                    auto &allowed_classes = value->get_allowed_classes();
+                    auto allowed_classes = value->get_allowed_classes();
                     std::size_t count = allowed_classes.size();
                     if(count) {
                         for(std::size_t i = 0; i < count; i++) {
@@ -967,7 +967,8 @@ namespace Invader::EditQt {
     }
 
     void TagEditorEditWidget::find_dependency() {
-        TagTreeDialog dialog(nullptr, this->get_editor_window()->get_parent_window(), this->get_struct_value()->get_allowed_classes(), std::filesystem::path(this->get_editor_window()->get_file().tag_path).parent_path().string().c_str());
+        auto allowed_classes = this->get_struct_value()->get_allowed_classes();
+        TagTreeDialog dialog(nullptr, this->get_editor_window()->get_parent_window(), std::vector<HEK::TagFourCC>(allowed_classes.begin(), allowed_classes.end()), std::filesystem::path(this->get_editor_window()->get_file().tag_path).parent_path().string().c_str());
         dialog.exec();
         auto &tag = dialog.get_tag();
         if(tag.has_value()) {
@@ -17,11 +17,350 @@ namespace Invader::EditQt {
         this->setAnimated(false);
         this->refresh_view(parent_window);
         connect(parent_window, &TagTreeWindow::tags_reloaded, this, &TagTreeWidget::refresh_view);
+        connect(parent_window, &TagTreeWindow::tags_changed, this, &TagTreeWidget::apply_tag_changes);
+    }
+
+    bool TagTreeWidget::tag_is_filtered_out(const File::TagFile &tag) const {
+        // First, can we drop it simply because it's out of our current scope?
+        if(this->tag_arrays_to_show.has_value()) {
+            bool remove = true;
+            for(auto t : *this->tag_arrays_to_show) {
+                if(tag.tag_directory == t) {
+                    remove = false;
+                    break;
+                }
+            }
+            if(remove) {
+                return true;
+            }
+        }
+
+        // Next, can we filter it out based on tag class alone?
+        if(this->filter.has_value() && this->filter->size() > 0) {
+            bool remove = true;
+            for(auto f : *this->filter) {
+                if(tag.tag_fourcc == f) {
+                    remove = false;
+                    break;
+                }
+            }
+            if(remove) {
+                return true;
+            }
+        }
+
+        // Also, do we have this in our filters list?
+        if(this->expressions.has_value()) {
+            return this->expressions->empty() || !this->expression_matcher->matches(tag.tag_path);
+        }
+
+        return false;
+    }
+
+    static bool item_less_than(QTreeWidgetItem *item_i, QTreeWidgetItem *item_j) {
+        bool i_is_dir = !item_i->data(0, Qt::UserRole).isValid();
+        bool j_is_dir = !item_j->data(0, Qt::UserRole).isValid();
+
+        return !(j_is_dir && !i_is_dir) && ((i_is_dir && !j_is_dir) || (item_i->text(0).compare(item_j->text(0), Qt::CaseInsensitive) < 0));
+    }
+
+    void TagTreeWidget::add_tag_item(const File::TagFile &t, bool hide, bool sorted, const QIcon &dir_icon, const QIcon &file_icon) {
+        QTreeWidgetItem *dir_item = nullptr;
+
+        // Reference the tag by its virtual path so the window's tag array can change without invalidating the item
+        auto data = QVariant::fromValue(QString(t.tag_path.c_str()));
+
+        std::vector<std::string> separate_tag_path;
+        auto prep = File::preferred_path_to_halo_path(t.tag_path);
+        std::size_t last_separator = 0;
+        std::size_t length = prep.size();
+
+        for(std::size_t i = 0; i < length; i++) {
+            if(prep[i] == '\\') {
+                separate_tag_path.emplace_back(prep.c_str() + last_separator, (i - last_separator));
+                last_separator = ++i;
+            }
+        }
+        separate_tag_path.emplace_back(prep.c_str() + last_separator, (length - last_separator));
+
+        std::size_t element_count = separate_tag_path.size();
+        for(std::size_t e = 0; e < element_count; e++) {
+            auto &element = separate_tag_path[e];
+            bool found = false;
+            bool last = e + 1 == element_count;
+
+            // See if we have it
+            if(dir_item == nullptr) {
+                int count = this->topLevelItemCount();
+                for(int i = 0; i < count; i++) {
+                    auto *item = this->topLevelItem(i);
+                    if(item->text(0) == element.c_str()) {
+                        found = true;
+                        dir_item = item;
+                        break;
+                    }
+                }
+            }
+            else {
+                int count = dir_item->childCount();
+                for(int i = 0; i < count; i++) {
+                    auto *item = dir_item->child(i);
+                    if(item->text(0) == element.c_str()) {
+                        found = true;
+                        dir_item = item;
+                        break;
+                    }
+                }
+            }
+
+            // Bail early if we're hiding this
+            if(last && hide) {
+                break;
+            }
+
+            // If we don't have it, make it
+            if(!found) {
+                auto *new_dir_item = new QTreeWidgetItem(QStringList(element.c_str()));
+                this->setContentsMargins(0, 0, 0, 0);
+
+                // Tags have data; set it before we figure out where it goes
+                if(last) {
+                    new_dir_item->setData(0, Qt::UserRole, data);
+                }
+
+                if(dir_item == nullptr) {
+                    int index = this->topLevelItemCount();
+                    if(sorted) {
+                        for(int i = 0; i < index; i++) {
+                            if(item_less_than(new_dir_item, this->topLevelItem(i))) {
+                                index = i;
+                                break;
+                            }
+                        }
+                    }
+                    this->insertTopLevelItem(index, new_dir_item);
+                }
+                else {
+                    int index = dir_item->childCount();
+                    if(sorted) {
+                        for(int i = 0; i < index; i++) {
+                            if(item_less_than(new_dir_item, dir_item->child(i))) {
+                                index = i;
+                                break;
+                            }
+                        }
+                    }
+                    dir_item->insertChild(index, new_dir_item);
+                }
+                dir_item = new_dir_item;
+            }
+
+            // If it's the last one, all is well then
+            if(last) {
+                if(!found) {
+                    dir_item->setIcon(0, file_icon);
+                }
+                this->set_tag_item_details(dir_item, t);
+            }
+            else if(!found) {
+                dir_item->setIcon(0, dir_icon);
+            }
+        }
+    }
+
+    void TagTreeWidget::set_tag_item_details(QTreeWidgetItem *item, const File::TagFile &t) {
+        // Point the item at this tag (replacing whatever it pointed to before), remembering which tags directory it's from
+        item->setData(0, Qt::UserRole, QVariant::fromValue(QString(t.tag_path.c_str())));
+        item->setData(0, TAG_DIRECTORY_ROLE, QVariant::fromValue(static_cast<qulonglong>(t.tag_directory)));
+
+        // Make size text
+        char size[12];
+        std::uint64_t file_size;
+        try {
+            file_size = std::filesystem::file_size(t.full_path);
+        }
+        catch(std::exception &e) {
+            eprintf_error("Failed to get file size for %s: %s", t.full_path.string().c_str(), e.what());
+            file_size = 0;
+        }
+        if(file_size > 1024 * 1024) {
+            std::snprintf(size, sizeof(size), "%.02f MiB", file_size / 1024.0 / 1024.0);
+        }
+        else if(file_size > 1024) {
+            std::snprintf(size, sizeof(size), "%.02f KiB", file_size / 1024.0);
+        }
+        else if(file_size > 0) {
+            std::snprintf(size, sizeof(size), "%zu byte%s", file_size, file_size == 1 ? "" : "s");
+        }
+        else {
+            std::strcpy(size, "Unknown");
+        }
+
+        // Make hover text
+        char text[1024];
+        std::snprintf(text, sizeof(text),
+            "Virtual path: %s\n"
+            "File path: %s\n"
+            "File size: %s"
+        , t.tag_path.c_str(),  t.full_path.string().c_str(), size);
+        item->setToolTip(0, text);
+        item->setToolTip(1, text);
+        item->setText(1, size);
+    }
+
+    QTreeWidgetItem *TagTreeWidget::find_tag_item(const std::string &tag_path) const {
+        QTreeWidgetItem *item = nullptr;
+        auto prep = File::preferred_path_to_halo_path(tag_path);
+        std::size_t start = 0;
+        while(true) {
+            auto end = prep.find('\\', start);
+            auto element = prep.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+            QTreeWidgetItem *next = nullptr;
+            int count = item ? item->childCount() : this->topLevelItemCount();
+            for(int i = 0; i < count; i++) {
+                auto *child = item ? item->child(i) : this->topLevelItem(i);
+                if(child->text(0) == element.c_str()) {
+                    next = child;
+                    break;
+                }
+            }
+
+            item = next;
+            if(item == nullptr || end == std::string::npos) {
+                break;
+            }
+            start = end + 1;
+        }
+
+        if(item == nullptr || !item->data(0, Qt::UserRole).isValid()) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    std::map<std::string, const File::TagFile *> TagTreeWidget::surviving_tags(const std::vector<File::TagFile> &removed) const {
+        std::map<std::string, const File::TagFile *> highest;
+        for(auto &t : removed) {
+            highest.emplace(t.tag_path, nullptr);
+        }
+
+        // Removals come from the window after it updates its own tags, so those are current here. Go through them once,
+        // keeping whichever of each path is in the highest priority tags directory.
+        for(auto &t : this->last_window->get_all_tags()) {
+            auto found = highest.find(t.tag_path);
+            if(found != highest.end() && (found->second == nullptr || t.tag_directory < found->second->tag_directory)) {
+                found->second = &t;
+            }
+        }
+
+        return highest;
+    }
+
+    void TagTreeWidget::add_tags(const std::vector<File::TagFile> &tags) {
+        if(this->last_window == nullptr || this->last_window->fast_listing_mode()) {
+            return;
+        }
+
+        QIcon dir_icon = QFileIconProvider().icon(QFileIconProvider::Folder);
+        QIcon file_icon = QFileIconProvider().icon(QFileIconProvider::File);
+
+        // Tags may still be getting listed, so only use what's in this batch and what's already in the tree to find
+        // which copy of each path is in the highest priority tags directory
+        std::map<std::string, const File::TagFile *> highest;
+        for(auto &t : tags) {
+            auto &best = highest[t.tag_path];
+            if(best == nullptr || t.tag_directory < best->tag_directory) {
+                best = &t;
+            }
+        }
+
+        for(auto &[tag_path, t] : highest) {
+            if(this->tag_is_filtered_out(*t)) {
+                continue;
+            }
+
+            // Anything listed from a higher priority tags directory takes precedence (otherwise this replaces it)
+            auto *item = this->find_tag_item(tag_path);
+            if(item == nullptr) {
+                this->total_tags++;
+            }
+            else if(item->data(0, TAG_DIRECTORY_ROLE).toULongLong() < t->tag_directory) {
+                continue;
+            }
+            this->add_tag_item(*t, false, true, dir_icon, file_icon);
+        }
+    }
+
+    void TagTreeWidget::remove_tags(const std::vector<File::TagFile> &tags) {
+        if(this->last_window == nullptr || this->last_window->fast_listing_mode()) {
+            return;
+        }
+
+        QIcon dir_icon = QFileIconProvider().icon(QFileIconProvider::Folder);
+        QIcon file_icon = QFileIconProvider().icon(QFileIconProvider::File);
+        auto surviving = this->surviving_tags(tags);
+
+        for(auto &t : tags) {
+            auto *item = this->find_tag_item(t.tag_path);
+
+            // If the same virtual path is still in another tags directory, list that one instead
+            auto *survivor = surviving[t.tag_path];
+            if(survivor != nullptr && !this->tag_is_filtered_out(*survivor)) {
+                if(item != nullptr) {
+                    this->set_tag_item_details(item, *survivor);
+                }
+                else {
+                    this->add_tag_item(*survivor, false, true, dir_icon, file_icon);
+                    this->total_tags++;
+                }
+                continue;
+            }
+
+            if(item == nullptr) {
+                continue;
+            }
+
+            // Remove it along with any directories it leaves empty
+            while(item) {
+                auto *parent = item->parent();
+                delete item;
+                if(parent == nullptr || parent->childCount() > 0) {
+                    break;
+                }
+                item = parent;
+            }
+
+            if(this->total_tags > 0) {
+                this->total_tags--;
+            }
+        }
+    }
+
+    void TagTreeWidget::apply_tag_changes(TagTreeWindow *, const std::vector<File::TagFile> &added, const std::vector<File::TagFile> &removed) {
+        this->remove_tags(removed);
+        this->add_tags(added);
     }
 
     void TagTreeWidget::refresh_view(TagTreeWindow *window) {
+        // Remember what was expanded so the view doesn't collapse on refresh
+        std::vector<QStringList> expanded_items;
+        auto find_expanded_items = [&expanded_items](QTreeWidgetItem *item, QStringList path, auto &find_expanded_items) -> void {
+            path.append(item->text(0));
+            if(item->isExpanded()) {
+                expanded_items.emplace_back(path);
+            }
+            for(int i = 0; i < item->childCount(); i++) {
+                find_expanded_items(item->child(i), path, find_expanded_items);
+            }
+        };
+        for(int i = 0; i < this->topLevelItemCount(); i++) {
+            find_expanded_items(this->topLevelItem(i), QStringList(), find_expanded_items);
+        }
+
         this->clear();
         this->last_window = window;
+        this->total_tags = 0;
         
         QIcon dir_icon = QFileIconProvider().icon(QFileIconProvider::Folder);
         QIcon file_icon = QFileIconProvider().icon(QFileIconProvider::File);
@@ -35,41 +374,8 @@ namespace Invader::EditQt {
 
             // Next, go through each tag and filter out anything we don't need (i.e. lower-priority tags, non-matching extensions)
             for(std::size_t i = 0; i < all_tags_size; i++) {
-                bool remove = false;
                 auto &tag = all_tags[i];
-
-                // First, can we drop it simply because it's out of our current scope?
-                if(this->tag_arrays_to_show.has_value()) {
-                    remove = true;
-                    for(auto t : *this->tag_arrays_to_show) {
-                        if(tag.tag_directory == t) {
-                            remove = false;
-                            break;
-                        }
-                    }
-                }
-
-                // Next, can we filter it out based on tag class alone?
-                if(!remove && this->filter.has_value() && this->filter->size() > 0) {
-                    remove = true;
-                    for(auto f : *this->filter) {
-                        if(tag.tag_fourcc == f) {
-                            remove = false;
-                            break;
-                        }
-                    }
-                }
-                
-                // Also, do we have this in our filters list?
-                if(!remove && this->expressions.has_value()) {
-                    remove = true;
-                    for(auto &f : *this->expressions) {
-                        if(File::path_matches(tag.tag_path.c_str(), f.c_str())) {
-                            remove = false;
-                            break;
-                        }
-                    }
-                }
+                bool remove = this->tag_is_filtered_out(tag);
 
                 // Lastly, is this superceded by anything?
                 if(!remove && tag.tag_directory > 0) {
@@ -108,113 +414,7 @@ namespace Invader::EditQt {
                 }
 
                 auto &t = all_tags[i];
-                QTreeWidgetItem *dir_item = nullptr;
-
-                std::vector<std::string> separate_tag_path;
-                auto prep = File::preferred_path_to_halo_path(t.tag_path);
-                std::size_t last_separator = 0;
-                std::size_t length = prep.size();
-
-                for(std::size_t i = 0; i < length; i++) {
-                    if(prep[i] == '\\') {
-                        separate_tag_path.emplace_back(prep.c_str() + last_separator, (i - last_separator));
-                        last_separator = ++i;
-                    }
-                }
-                separate_tag_path.emplace_back(prep.c_str() + last_separator, (length - last_separator));
-
-                std::size_t element_count = separate_tag_path.size();
-                for(std::size_t e = 0; e < element_count; e++) {
-                    auto &element = separate_tag_path[e];
-                    bool found = false;
-
-                    // See if we have it
-                    if(dir_item == nullptr) {
-                        int count = this->topLevelItemCount();
-                        for(int i = 0; i < count; i++) {
-                            auto *item = this->topLevelItem(i);
-                            if(item->text(0) == element.c_str()) {
-                                found = true;
-                                dir_item = item;
-                                break;
-                            }
-                        }
-                    }
-                    else {
-                        int count = dir_item->childCount();
-                        for(int i = 0; i < count; i++) {
-                            auto *item = dir_item->child(i);
-                            if(item->text(0) == element.c_str()) {
-                                found = true;
-                                dir_item = item;
-                                break;
-                            }
-                        }
-                    }
-
-                    // Bail early if we're hiding this
-                    if(e + 1 == element_count && hide) {
-                        break;
-                    }
-
-                    // If we don't have it, make it
-                    if(!found) {
-                        auto *new_dir_item = new QTreeWidgetItem(QStringList(element.c_str()));
-                        this->setContentsMargins(0, 0, 0, 0);
-                        if(dir_item == nullptr) {
-                            this->addTopLevelItem(new_dir_item);
-                        }
-                        else {
-                            dir_item->addChild(new_dir_item);
-                        }
-                        dir_item = new_dir_item;
-                    }
-
-                    // If it's the last one, all is well then
-                    if(e + 1 == element_count) {
-                        dir_item->setData(0, Qt::UserRole, QVariant::fromValue(reinterpret_cast<std::uintptr_t>(&t)));
-                        if(!found) {
-                            dir_item->setIcon(0, file_icon);
-                        }
-                        
-                        // Make size text
-                        char size[12];
-                        std::uint64_t file_size;
-                        try {
-                            file_size = std::filesystem::file_size(t.full_path);
-                        }
-                        catch(std::exception &e) {
-                            eprintf_error("Failed to get file size for %s: %s", t.full_path.string().c_str(), e.what());
-                            file_size = 0;
-                        }
-                        if(file_size > 1024 * 1024) {
-                            std::snprintf(size, sizeof(size), "%.02f MiB", file_size / 1024.0 / 1024.0);
-                        }
-                        else if(file_size > 1024) {
-                            std::snprintf(size, sizeof(size), "%.02f KiB", file_size / 1024.0);
-                        }
-                        else if(file_size > 0) {
-                            std::snprintf(size, sizeof(size), "%zu byte%s", file_size, file_size == 1 ? "" : "s");
-                        }
-                        else {
-                            std::strcpy(size, "Unknown");
-                        }
-                        
-                        // Make hover text
-                        char text[1024];
-                        std::snprintf(text, sizeof(text),
-                            "Virtual path: %s\n"
-                            "File path: %s\n"
-                            "File size: %s"
-                        , t.tag_path.c_str(),  t.full_path.string().c_str(), size);
-                        dir_item->setToolTip(0, text);
-                        dir_item->setToolTip(1, text);
-                        dir_item->setText(1, size);
-                    }
-                    else if(!found) {
-                        dir_item->setIcon(0, dir_icon);
-                    }
-                }
+                this->add_tag_item(t, hide, false, dir_icon, file_icon);
             }
         }
         
@@ -224,10 +424,33 @@ namespace Invader::EditQt {
         }
 
         // Connect this in case we expand any items while in fast mode
-        connect(this, &TagTreeWidget::itemExpanded, this, &TagTreeWidget::load_directories);
+        connect(this, &TagTreeWidget::itemExpanded, this, &TagTreeWidget::load_directories, Qt::UniqueConnection);
         
         // Done!
         this->resort_elements();
+
+        // Expand anything that was expanded before
+        for(auto &path : expanded_items) {
+            QTreeWidgetItem *item = nullptr;
+            for(auto &element : path) {
+                QTreeWidgetItem *next = nullptr;
+                int count = item ? item->childCount() : this->topLevelItemCount();
+                for(int i = 0; i < count; i++) {
+                    auto *child = item ? item->child(i) : this->topLevelItem(i);
+                    if(child->text(0) == element) {
+                        next = child;
+                        break;
+                    }
+                }
+                item = next;
+                if(item == nullptr) {
+                    break;
+                }
+            }
+            if(item) {
+                item->setExpanded(true);
+            }
+        }
     }
     
     void TagTreeWidget::load_directories(QTreeWidgetItem *item) {
@@ -337,12 +560,7 @@ namespace Invader::EditQt {
     }
 
     void TagTreeWidget::resort_elements() {
-        auto less_than = [](QTreeWidgetItem *item_i, QTreeWidgetItem *item_j) {
-            bool i_is_dir = !item_i->data(0, Qt::UserRole).isValid();
-            bool j_is_dir = !item_j->data(0, Qt::UserRole).isValid();
-
-            return !(j_is_dir && !i_is_dir) && ((i_is_dir && !j_is_dir) || (item_i->text(0).compare(item_j->text(0), Qt::CaseInsensitive) < 0));
-        };
+        auto less_than = item_less_than;
 
         // First, sort the top level
         int top_level_count = this->topLevelItemCount();
@@ -434,6 +652,12 @@ namespace Invader::EditQt {
             
             if(!currently_showing_everything || currently_showing_everything != showing_everything_array(expression_filters)) {
                 this->expressions = expression_filters;
+                if(expression_filters.has_value()) {
+                    this->expression_matcher.emplace(*expression_filters, std::vector<std::string>());
+                }
+                else {
+                    this->expression_matcher.reset();
+                }
                 change_made = true;
             }
         }
@@ -449,14 +673,25 @@ namespace Invader::EditQt {
         
         if(selected_items.size()) {
             auto data = selected_items[0]->data(0, Qt::UserRole);
-            auto ptr = data.value<std::uintptr_t>();
-            if(ptr) {
-                return *reinterpret_cast<const File::TagFile *>(ptr);
-            }
             auto path = data.value<QString>();
             if(!path.isEmpty()) {
-                File::TagFile file;
                 auto path_str = path.toStdString();
+
+                // If we listed everything, we already know where it is, so use whichever one has the highest priority
+                if(!this->last_window->fast_listing_mode()) {
+                    const File::TagFile *found = nullptr;
+                    for(auto &t : this->last_window->get_all_tags()) {
+                        if(t.tag_path == path_str && (found == nullptr || t.tag_directory < found->tag_directory)) {
+                            found = &t;
+                        }
+                    }
+                    if(found) {
+                        return *found;
+                    }
+                    return std::nullopt;
+                }
+
+                File::TagFile file;
                 auto split = File::split_tag_class_extension(path_str).value();
                 file.tag_path = path_str;
                 file.tag_fourcc = split.fourcc;
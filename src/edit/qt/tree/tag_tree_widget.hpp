@@ -5,6 +5,7 @@
 
 #include <QTreeWidget>
 #include <filesystem>
+#include <map>
 #include <invader/file/file.hpp>
 
 #include <invader/hek/fourcc.hpp>
@@ -53,14 +54,37 @@ namespace Invader::EditQt {
          * Sort elements in the tree
          */
         void resort_elements();
+
+        /**
+         * Add tags to the view in sorted order without rebuilding it (used to show tags while they are still being listed)
+         * @param tags tags to add
+         */
+        void add_tags(const std::vector<File::TagFile> &tags);
+
+        /**
+         * Remove tags from the view without rebuilding it
+         * @param tags tags to remove (these must already be removed from the window's tags)
+         */
+        void remove_tags(const std::vector<File::TagFile> &tags);
     private:
+        /** Item data role holding which tags directory a tag item was listed from */
+        static constexpr int TAG_DIRECTORY_ROLE = Qt::UserRole + 1;
+
         std::size_t total_tags = 0;
         std::optional<std::vector<HEK::TagFourCC>> filter;
         std::optional<std::vector<std::size_t>> tag_arrays_to_show;
         std::optional<std::vector<std::string>> expressions;
-        TagTreeWindow *last_window;
+        std::optional<File::PathMatcher> expression_matcher;
+        TagTreeWindow *last_window = nullptr;
         bool show_directories;
         void refresh_view(TagTreeWindow *window);
+
+        bool tag_is_filtered_out(const File::TagFile &tag) const;
+        void add_tag_item(const File::TagFile &tag, bool hide, bool sorted, const QIcon &dir_icon, const QIcon &file_icon);
+        void set_tag_item_details(QTreeWidgetItem *item, const File::TagFile &tag);
+        QTreeWidgetItem *find_tag_item(const std::string &tag_path) const;
+        std::map<std::string, const File::TagFile *> surviving_tags(const std::vector<File::TagFile> &removed) const;
+        void apply_tag_changes(TagTreeWindow *window, const std::vector<File::TagFile> &added, const std::vector<File::TagFile> &removed);
         
         void load_directories(QTreeWidgetItem *item);
     };
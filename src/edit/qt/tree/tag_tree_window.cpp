@@ -15,6 +15,7 @@
 #include <QInputDialog>
 #include <SDL2/SDL.h>
 #include <QThread>
+#include <map>
 #include "tag_tree_window.hpp"
 #include "tag_tree_widget.hpp"
 #include "tag_tree_dialog.hpp"
@@ -125,6 +126,14 @@ namespace Invader::EditQt {
         this->setCentralWidget(central_widget);
         connect(this->tag_view, &TagTreeWidget::itemDoubleClicked, this, &TagTreeWindow::on_double_click);
 
+        // Watch the tags directories so changes made by us or anything else don't need everything to be listed again
+        this->tag_watcher = new QFileSystemWatcher(this);
+        connect(this->tag_watcher, &QFileSystemWatcher::directoryChanged, this, &TagTreeWindow::directory_changed);
+        this->tag_watcher_timer = new QTimer(this);
+        this->tag_watcher_timer->setSingleShot(true);
+        this->tag_watcher_timer->setInterval(250);
+        connect(this->tag_watcher_timer, &QTimer::timeout, this, &TagTreeWindow::process_changed_directories);
+
         // Next, set up the status bar
         QStatusBar *status_bar = new QStatusBar();
         this->tag_count_label = new QLabel();
@@ -170,10 +179,9 @@ namespace Invader::EditQt {
         this->tag_count_label->setText(tag_count_str);
     }
 
-    void TagTreeWindow::tag_count_changed(std::pair<std::mutex, std::size_t> *tag_count) {
-        tag_count->first.lock();
-        this->set_count_label(tag_count->second);
-        tag_count->first.unlock();
+    void TagTreeWindow::tags_found(const std::vector<File::TagFile> &tags, std::size_t total_count) {
+        this->set_count_label(total_count);
+        this->tag_view->add_tags(tags);
     }
 
     void TagTreeWindow::refresh_view() {
@@ -289,26 +297,34 @@ namespace Invader::EditQt {
     }
 
     void TagFetcherThread::run() {
-        // Function for loading it
-        std::size_t error_count;
-        auto load_it = [&error_count](std::vector<File::TagFile> *to, std::vector<std::filesystem::path> *all_paths, std::pair<std::mutex, std::size_t> *statuser) {
-            *to = Invader::File::load_virtual_tag_folder(*all_paths, false, statuser, &error_count);
+        // Send what we find in batches rather than one signal per directory so we don't flood the event loop
+        static constexpr auto BATCH_INTERVAL = std::chrono::milliseconds(100);
+
+        std::size_t error_count = 0;
+        std::vector<File::TagFile> batch;
+        std::size_t total_count = 0;
+        auto last_batch = std::chrono::steady_clock::now();
+
+        auto found = [this, &batch, &total_count, &last_batch](const std::vector<File::TagFile> &tags, std::size_t new_tags) {
+            batch.insert(batch.end(), tags.end() - new_tags, tags.end());
+            total_count = tags.size();
+
+            auto now = std::chrono::steady_clock::now();
+            if(now - last_batch >= BATCH_INTERVAL) {
+                last_batch = now;
+                emit tags_found(batch, total_count);
+                batch.clear();
+            }
         };
 
-        // Run this in parallel
-        QThread *t = QThread::create(load_it, &this->all_tags, &this->all_paths, &this->statuser);
-        t->start();
-        std::size_t last_tag_count = 0;
-        while(!t->isFinished()) {
-            this->statuser.first.lock();
-            std::size_t new_count = this->statuser.second;
-            this->statuser.first.unlock();
-            if(new_count > last_tag_count + 100) {
-                last_tag_count = new_count;
-                emit tag_count_changed(&this->statuser);
-            }
+        // Also get every directory so they can be watched for changes
+        this->all_tags = Invader::File::load_virtual_tag_folder(this->all_paths, false, nullptr, &error_count, found, &this->all_directories);
+
+        if(!batch.empty()) {
+            emit tags_found(batch, total_count);
         }
-        delete t;
+
+        emit directories_found(&this->all_directories);
 
         // Emit one last signal
         emit fetch_finished(&this->all_tags, static_cast<int>(error_count));
@@ -324,6 +340,7 @@ namespace Invader::EditQt {
         
         // If we have fast listing mode, we don't need to do much
         if(this->fast_listing) {
+            this->watch_directories(nullptr);
             this->tags_reloaded_finished(nullptr, 0);
             return;
         }
@@ -337,7 +354,8 @@ namespace Invader::EditQt {
         if(reiterate_directories) {
             // Now... let's do this
             this->fetcher_thread = new TagFetcherThread(this, this->paths);
-            connect(this->fetcher_thread, &TagFetcherThread::tag_count_changed, this, &TagTreeWindow::tag_count_changed);
+            connect(this->fetcher_thread, &TagFetcherThread::tags_found, this, &TagTreeWindow::tags_found);
+            connect(this->fetcher_thread, &TagFetcherThread::directories_found, this, &TagTreeWindow::watch_directories);
             connect(this->fetcher_thread, &TagFetcherThread::fetch_finished, this, &TagTreeWindow::tags_reloaded_finished);
             connect(this->fetcher_thread, &TagFetcherThread::finished, this->fetcher_thread, &TagFetcherThread::deleteLater);
             this->fetcher_thread->start();
@@ -385,6 +403,201 @@ namespace Invader::EditQt {
         emit tags_reloaded(this);
     }
 
+    void TagTreeWindow::apply_tag_changes(const std::vector<File::TagFile> &added, const std::vector<File::TagFile> &removed) {
+        // Remove first so something that was replaced isn't removed after being added
+        if(!removed.empty()) {
+            std::set<std::filesystem::path> removed_paths;
+            for(auto &r : removed) {
+                removed_paths.emplace(r.full_path);
+            }
+            std::erase_if(this->all_tags, [&removed_paths](const File::TagFile &tag) { return removed_paths.contains(tag.full_path); });
+        }
+
+        // Don't add anything twice (e.g. if we saved a tag and then got notified that it was created)
+        std::vector<File::TagFile> actually_added;
+        if(!added.empty()) {
+            std::set<std::filesystem::path> present;
+            for(auto &i : this->all_tags) {
+                present.emplace(i.full_path);
+            }
+            for(auto &a : added) {
+                if(present.emplace(a.full_path).second) {
+                    this->all_tags.emplace_back(a);
+                    actually_added.emplace_back(a);
+                }
+            }
+        }
+
+        if(actually_added.empty() && removed.empty()) {
+            return;
+        }
+
+        this->set_count_label(this->all_tags.size());
+        emit tags_changed(this, actually_added, removed);
+    }
+
+    void TagTreeWindow::watch_directories(const std::vector<std::filesystem::path> *directories) {
+        auto watched = this->tag_watcher->directories();
+        if(!watched.isEmpty()) {
+            this->tag_watcher->removePaths(watched);
+        }
+        this->changed_directories.clear();
+
+        if(directories && !directories->empty()) {
+            QStringList to_watch;
+            to_watch.reserve(static_cast<qsizetype>(directories->size()));
+            for(auto &d : *directories) {
+                to_watch.append(QString::fromStdString(d.string()));
+            }
+
+            // This uses inotify (or whatever the OS has), falling back to polling if that fails
+            this->tag_watcher->addPaths(to_watch);
+        }
+    }
+
+    void TagTreeWindow::directory_changed(const QString &path) {
+        // Wait for things to settle down since this often comes in bursts
+        this->changed_directories.emplace(path.toStdString());
+        this->tag_watcher_timer->start();
+    }
+
+    void TagTreeWindow::process_changed_directories() {
+        if(this->fast_listing) {
+            this->changed_directories.clear();
+            return;
+        }
+
+        // If we're listing everything right now, try again once that's done
+        if(this->tags_reloading_queued) {
+            this->tag_watcher_timer->start();
+            return;
+        }
+
+        auto changed_directories = std::move(this->changed_directories);
+        this->changed_directories.clear();
+
+        std::vector<File::TagFile> added;
+        std::vector<File::TagFile> removed;
+        QStringList new_directories;
+
+        auto watched_list = this->tag_watcher->directories();
+        std::set<std::filesystem::path> watched;
+        for(auto &w : watched_list) {
+            watched.emplace(w.toStdString());
+        }
+
+        auto is_within = [](const std::filesystem::path &path, const std::filesystem::path &directory) -> bool {
+            auto relative = path.lexically_relative(directory);
+            return !relative.empty() && *relative.begin() != "..";
+        };
+
+        auto make_tag_file = [this](const std::filesystem::path &file_path, std::size_t tag_directory) -> std::optional<File::TagFile> {
+            if(!file_path.has_extension()) {
+                return std::nullopt;
+            }
+            auto extension = file_path.extension().string();
+            auto tag_fourcc = HEK::tag_extension_to_fourcc(extension.c_str() + 1);
+            if(tag_fourcc == HEK::TagFourCC::TAG_FOURCC_NULL || tag_fourcc == HEK::TagFourCC::TAG_FOURCC_NONE) {
+                return std::nullopt;
+            }
+            auto tag_path = File::file_path_to_tag_path(file_path, this->paths[tag_directory]);
+            if(!tag_path.has_value()) {
+                return std::nullopt;
+            }
+
+            File::TagFile file;
+            file.full_path = file_path;
+            file.tag_fourcc = tag_fourcc;
+            file.tag_directory = tag_directory;
+            file.tag_path = *tag_path;
+            return file;
+        };
+
+        // Find what tags directory each changed directory is in
+        std::map<std::filesystem::path, std::size_t> changed_tag_directories;
+        std::set<std::filesystem::path> gone_directories;
+        for(auto &directory : changed_directories) {
+            for(auto &p : this->paths) {
+                if(directory == p || is_within(directory, p)) {
+                    changed_tag_directories.emplace(directory, &p - this->paths.data());
+                    std::error_code ec;
+                    if(!std::filesystem::is_directory(directory, ec)) {
+                        gone_directories.emplace(directory);
+                    }
+                    break;
+                }
+            }
+        }
+
+        // Go through our tags once. Anything directly in a changed directory (or anywhere in one that is gone) that doesn't
+        // exist anymore was removed.
+        std::map<std::filesystem::path, std::set<std::filesystem::path>> present;
+        if(!changed_tag_directories.empty()) {
+            for(auto &t : this->all_tags) {
+                auto parent = t.full_path.parent_path();
+                std::error_code ec;
+                if(changed_tag_directories.contains(parent) && !gone_directories.contains(parent)) {
+                    if(std::filesystem::exists(t.full_path, ec)) {
+                        present[parent].emplace(t.full_path);
+                    }
+                    else {
+                        removed.emplace_back(t);
+                    }
+                    continue;
+                }
+                if(gone_directories.empty()) {
+                    continue;
+                }
+                for(auto p = parent; !p.empty() && p != p.parent_path(); p = p.parent_path()) {
+                    if(gone_directories.contains(p)) {
+                        removed.emplace_back(t);
+                        break;
+                    }
+                }
+            }
+        }
+
+        for(auto &[directory, tag_directory] : changed_tag_directories) {
+            if(gone_directories.contains(directory)) {
+                continue;
+            }
+
+            std::error_code ec;
+            auto &present_here = present[directory];
+
+            // Anything new here was added, and anything in new directories was, too
+            for(auto &d : std::filesystem::directory_iterator(directory, ec)) {
+                if(d.is_directory(ec)) {
+                    if(watched.contains(d.path())) {
+                        continue;
+                    }
+                    watched.emplace(d.path());
+                    new_directories.append(QString::fromStdString(d.path().string()));
+                    for(auto i = std::filesystem::recursive_directory_iterator(d.path(), std::filesystem::directory_options::skip_permission_denied, ec); !ec && i != std::filesystem::recursive_directory_iterator(); i.increment(ec)) {
+                        if(i->is_directory(ec)) {
+                            watched.emplace(i->path());
+                            new_directories.append(QString::fromStdString(i->path().string()));
+                        }
+                        else if(auto file = make_tag_file(i->path(), tag_directory); file.has_value()) {
+                            added.emplace_back(std::move(*file));
+                        }
+                    }
+                }
+                else if(!present_here.contains(d.path())) {
+                    if(auto file = make_tag_file(d.path(), tag_directory); file.has_value()) {
+                        added.emplace_back(std::move(*file));
+                    }
+                }
+            }
+        }
+
+        if(!new_directories.isEmpty()) {
+            this->tag_watcher->addPaths(new_directories);
+        }
+
+        this->apply_tag_changes(added, removed);
+    }
+
     const std::vector<File::TagFile> &TagTreeWindow::get_all_tags() const noexcept {
         return this->all_tags;
     }
@@ -623,16 +836,8 @@ namespace Invader::EditQt {
                 // Remove from file system
                 std::filesystem::remove(tag->full_path);
                 
-                // Remove from array
-                for(auto &i : this->all_tags) {
-                    if(i.full_path == tag->full_path) {
-                        this->all_tags.erase(this->all_tags.begin() + (&i - this->all_tags.data()));
-                        break;
-                    }
-                }
-                
-                // Quickly refresh
-                this->reload_tags(false);
+                // Remove from the list
+                this->apply_tag_changes({}, { *tag });
                 return true;
             case QMessageBox::Cancel:
                 return false;
@@ -9,6 +9,9 @@
 #include <filesystem>
 #include <QObject>
 #include <QThread>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <set>
 #include <invader/file/file.hpp>
 
 #include "../editor/tag_editor_window.hpp"
@@ -26,15 +29,15 @@ namespace Invader::EditQt {
         TagFetcherThread(QObject *parent, const std::vector<std::filesystem::path> &all_paths);
 
     signals:
-        void tag_count_changed(std::pair<std::mutex, std::size_t> *new_count);
+        void tags_found(const std::vector<File::TagFile> &tags, std::size_t total_count);
+        void directories_found(const std::vector<std::filesystem::path> *directories);
         void fetch_finished(const std::vector<File::TagFile> *tags, int errors);
 
     private:
         void run() override;
         std::vector<std::filesystem::path> all_paths;
         std::vector<File::TagFile> all_tags;
-        std::pair<std::mutex, std::size_t> statuser;
-        std::size_t last_tag_count;
+        std::vector<std::filesystem::path> all_directories;
     };
 
     class TagTreeWindow : public QMainWindow {
@@ -136,6 +139,7 @@ namespace Invader::EditQt {
 
     signals:
         void tags_reloaded(TagTreeWindow *window);
+        void tags_changed(TagTreeWindow *window, const std::vector<File::TagFile> &added, const std::vector<File::TagFile> &removed);
 
     private:
         /** Reload the tags in the tag array */
@@ -183,12 +187,24 @@ namespace Invader::EditQt {
         /** We're done */
         void tags_reloaded_finished(const std::vector<File::TagFile> *result, int error_count);
 
-        /** We're done */
-        void tag_count_changed(std::pair<std::mutex, std::size_t> *count);
+        /** Some tags were found while we're still listing */
+        void tags_found(const std::vector<File::TagFile> &tags, std::size_t total_count);
         
         /** Set count label */
         void set_count_label(std::size_t count);
 
+        /** Add and remove tags without reloading everything */
+        void apply_tag_changes(const std::vector<File::TagFile> &added, const std::vector<File::TagFile> &removed);
+
+        /** Watch the given directories (and only these) for changes */
+        void watch_directories(const std::vector<std::filesystem::path> *directories);
+
+        /** A watched directory changed */
+        void directory_changed(const QString &path);
+
+        /** Update the tags from every directory that changed since the last update */
+        void process_changed_directories();
+
         #ifdef SHOW_NIGHTLY_LINK
         /** Nightly build? */
         void show_nightly_build();
@@ -232,6 +248,10 @@ namespace Invader::EditQt {
         std::size_t listing_errors = 0;
         
         bool fast_listing = false;
+
+        QFileSystemWatcher *tag_watcher;
+        QTimer *tag_watcher_timer;
+        std::set<std::filesystem::path> changed_directories;
         
         void set_filter(const QString &filter);
         void toggle_filter_visible();
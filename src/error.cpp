@@ -52,3 +52,83 @@ void set_up_color_term() noexcept {
 bool is_on_color_term() noexcept {
     return on_color_term;
 }
+
+namespace Invader {
+    void BufferedOutput::print(OutputType type, const char *fmt, ...) {
+        std::va_list args;
+        va_start(args, fmt);
+        this->vprint(type, fmt, args);
+        va_end(args);
+    }
+
+    void BufferedOutput::vprint(OutputType type, const char *fmt, std::va_list args) {
+        // Measure first so long messages are never truncated
+        std::va_list args_copy;
+        va_copy(args_copy, args);
+        int length = std::vsnprintf(nullptr, 0, fmt, args_copy);
+        va_end(args_copy);
+
+        std::string message;
+        if(length > 0) {
+            message.resize(static_cast<std::size_t>(length) + 1);
+            std::vsnprintf(message.data(), message.size(), fmt, args);
+            message.resize(static_cast<std::size_t>(length));
+        }
+        this->messages.emplace_back(type, std::move(message));
+    }
+
+    void BufferedOutput::print_to(BufferedOutput *output, OutputType type, const char *fmt, ...) {
+        BufferedOutput now;
+        auto &target = output ? *output : now;
+
+        std::va_list args;
+        va_start(args, fmt);
+        target.vprint(type, fmt, args);
+        va_end(args);
+
+        now.flush();
+    }
+
+    void BufferedOutput::flush() {
+        for(auto &[type, message] : this->messages) {
+            switch(type) {
+                case OutputType::OUTPUT_PLAIN:
+                    oprintf("%s", message.c_str());
+                    break;
+                case OutputType::OUTPUT_PLAIN_ERROR:
+                    eprintf("%s", message.c_str());
+                    break;
+                case OutputType::OUTPUT_SUCCESS:
+                    oprintf_success("%s", message.c_str());
+                    break;
+                case OutputType::OUTPUT_SUCCESS_WARN:
+                    oprintf_success_warn("%s", message.c_str());
+                    break;
+                case OutputType::OUTPUT_SUCCESS_LESSER_WARN:
+                    oprintf_success_lesser_warn("%s", message.c_str());
+                    break;
+                case OutputType::OUTPUT_FAIL:
+                    oprintf_fail("%s", message.c_str());
+                    break;
+                case OutputType::OUTPUT_WARN:
+                    eprintf_warn("%s", message.c_str());
+                    break;
+                case OutputType::OUTPUT_ERROR:
+                    eprintf_error("%s", message.c_str());
+                    break;
+            }
+        }
+        this->messages.clear();
+    }
+
+    std::string BufferedOutput::to_string() const {
+        std::string text;
+        for(auto &[type, message] : this->messages) {
+            text += message;
+            if(type != OutputType::OUTPUT_PLAIN && type != OutputType::OUTPUT_PLAIN_ERROR) {
+                text += '\n';
+            }
+        }
+        return text;
+    }
+}
@@ -266,13 +266,14 @@ namespace Invader {
         }
 
         else {
+            File::PathMatcher matcher(queries, queries_exclude);
             for(std::size_t t = 0; t < tag_count; t++) {
                 // Get the full path
                 const auto &tag = map->get_tag(t);
                 auto full_tag_path = tag.get_path() + "." + HEK::tag_fourcc_to_extension(tag.get_tag_fourcc());
 
                 // Match it
-                if(File::path_matches(full_tag_path.c_str(), queries, queries_exclude)) {
+                if(matcher.matches(full_tag_path)) {
                     all_tags_to_extract.emplace_back(t);
                 }
             }
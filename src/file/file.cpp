@@ -10,8 +10,11 @@
 
 #include <cstdio>
 #include <filesystem>
+#include <fstream>
 #include <cstring>
 #include <climits>
+#include <algorithm>
+#include <bit>
 
 namespace Invader::File {
     std::optional<std::vector<std::byte>> open_file(const std::filesystem::path &path) {
@@ -92,6 +95,63 @@ namespace Invader::File {
         std::fclose(f);
         return true;
     }
+
+    std::uint64_t hash_data(const void *data, std::size_t size) noexcept {
+        // 64-bit FNV-1a
+        std::uint64_t hash = 0xCBF29CE484222325;
+        const auto *bytes = reinterpret_cast<const std::uint8_t *>(data);
+        for(std::size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 0x100000001B3;
+        }
+        return hash;
+    }
+
+    std::optional<std::string> open_state_file(const std::filesystem::path &path, const std::string &header) {
+        // Not having one yet is fine
+        std::error_code ec;
+        if(!std::filesystem::is_regular_file(path, ec)) {
+            return std::nullopt;
+        }
+
+        auto data = open_file(path);
+        if(!data.has_value()) {
+            return std::nullopt;
+        }
+
+        std::string text(reinterpret_cast<const char *>(data->data()), data->size());
+        if(text.compare(0, header.size(), header) != 0) {
+            return std::nullopt;
+        }
+        return text.substr(header.size());
+    }
+
+    bool save_state_file(const std::filesystem::path &path, const std::string &header, const std::string &contents) {
+        // Write to a temporary file first so an interrupted write doesn't leave a truncated file behind
+        auto temp_path = path;
+        temp_path += ".tmp";
+
+        {
+            std::ofstream stream(temp_path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+            if(!stream.is_open()) {
+                return false;
+            }
+            stream << header << contents;
+            if(!stream.good()) {
+                stream.close();
+                std::error_code ec;
+                std::filesystem::remove(temp_path, ec);
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(temp_path, path, ec);
+        if(ec) {
+            std::filesystem::remove(temp_path, ec);
+            return false;
+        }
+        return true;
+    }
     
     std::optional<std::filesystem::path> tag_path_to_file_path(const std::string &tag_path, const std::vector<std::filesystem::path> &tags) {
         for(auto &i : tags) {
@@ -289,7 +349,7 @@ namespace Invader::File {
         }
     }
 
-    std::vector<TagFile> load_virtual_tag_folder(const std::vector<std::filesystem::path> &tags, bool filter_duplicates, std::pair<std::mutex, std::size_t> *status, std::size_t *errors) {
+    std::vector<TagFile> load_virtual_tag_folder(const std::vector<std::filesystem::path> &tags, bool filter_duplicates, std::pair<std::mutex, std::size_t> *status, std::size_t *errors, const std::function<void (const std::vector<TagFile> &tags, std::size_t new_tags)> &found, std::vector<std::filesystem::path> *directories) {
         std::vector<TagFile> all_tags;
         
         std::size_t new_errors = 0;
@@ -312,18 +372,22 @@ namespace Invader::File {
         
         // win32 implementation because Windows I/O is AWFUL
         #ifdef _WIN32
-        auto iterate_directories = [&all_tags, &status, &new_errors](const std::filesystem::path &dir, auto &iterate_directories, int depth, std::size_t priority, const std::vector<std::filesystem::path> &main_dir) -> void {
+        auto iterate_directories = [&all_tags, &status, &new_errors, &found, &directories](const std::filesystem::path &dir, auto &iterate_directories, int depth, std::size_t priority, const std::vector<std::filesystem::path> &main_dir) -> void {
             if(++depth == 256) {
                 return;
             }
             
             WIN32_FIND_DATA find_data;
             HANDLE file = FindFirstFileA((dir / "*").string().c_str(), &find_data);
-            bool found = file != nullptr;
+            bool has_next = file != nullptr;
+            if(has_next && directories) {
+                directories->emplace_back(dir);
+            }
             
-            std::size_t tags_found = 0;
+            // Tags in this directory are held until subdirectories are done so they end up together at the end of all_tags
+            std::vector<TagFile> directory_tags;
             
-            while(found) {
+            while(has_next) {
                 if(std::strcmp(find_data.cFileName, ".") != 0 && std::strcmp(find_data.cFileName, "..") != 0) {
                     auto file_path = dir / find_data.cFileName;
                     if(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
@@ -344,32 +408,43 @@ namespace Invader::File {
                         file.tag_fourcc = tag_fourcc;
                         file.tag_directory = priority;
                         file.tag_path = Invader::File::file_path_to_tag_path(file_path.string(), main_dir).value();
-                        all_tags.emplace_back(std::move(file));
-                        
-                        tags_found++;
+                        directory_tags.emplace_back(std::move(file));
                     }
                 }
                 
                 spaghetti_next_tag:
-                found = FindNextFileA(file, &find_data);
+                has_next = FindNextFileA(file, &find_data);
             }
             
             // Update the find count
+            std::size_t tags_found = directory_tags.size();
             if(tags_found) {
+                all_tags.insert(all_tags.end(), std::make_move_iterator(directory_tags.begin()), std::make_move_iterator(directory_tags.end()));
+
                 status->first.lock();
                 status->second += tags_found;
                 status->first.unlock();
+
+                if(found) {
+                    found(all_tags, tags_found);
+                }
             }
         };
         #else
-        auto iterate_directories = [&all_tags, &status, &new_errors](const std::filesystem::path &dir, auto &iterate_directories, int depth, std::size_t priority, const std::vector<std::filesystem::path> &main_dir) -> void {
+        auto iterate_directories = [&all_tags, &status, &new_errors, &found, &directories](const std::filesystem::path &dir, auto &iterate_directories, int depth, std::size_t priority, const std::vector<std::filesystem::path> &main_dir) -> void {
             if(++depth == 256) {
                 return;
             }
             
-            std::size_t tags_found = 0;
+            // Tags in this directory are held until subdirectories are done so they end up together at the end of all_tags
+            std::vector<TagFile> directory_tags;
 
-            for(auto &d : std::filesystem::directory_iterator(dir)) {
+            std::filesystem::directory_iterator directory_iterator(dir);
+            if(directories) {
+                directories->emplace_back(dir);
+            }
+
+            for(auto &d : directory_iterator) {
                 auto file_path = d.path();
                 
                 if(d.is_directory()) {
@@ -390,16 +465,22 @@ namespace Invader::File {
                     file.tag_fourcc = tag_fourcc;
                     file.tag_directory = priority;
                     file.tag_path = Invader::File::file_path_to_tag_path(file_path.string(), main_dir).value();
-                    all_tags.emplace_back(std::move(file));
-                    tags_found++;
+                    directory_tags.emplace_back(std::move(file));
                 }
             }
             
             // Update the find count
+            std::size_t tags_found = directory_tags.size();
             if(tags_found) {
+                all_tags.insert(all_tags.end(), std::make_move_iterator(directory_tags.begin()), std::make_move_iterator(directory_tags.end()));
+
                 status->first.lock();
                 status->second += tags_found;
                 status->first.unlock();
+
+                if(found) {
+                    found(all_tags, tags_found);
+                }
             }
         };
         #endif
@@ -504,56 +585,140 @@ namespace Invader::File {
     }
     
     bool path_matches(const char *path, const char *pattern) noexcept {
-        for(const char *p = pattern;; p++) {
-            // End of string
-            if(*p == *path && *p == 0) {
-                return true;
-            }
-            else if(
-                (*p == '?' || *p == *path) || 
-                ((*p == '/' || *p == '\\' || *p == INVADER_PREFERRED_PATH_SEPARATOR) && (*path == '\\' || *path == '/' || *path == INVADER_PREFERRED_PATH_SEPARATOR))
-            ) {
-                path++;
+        return PathMatcher({ pattern }, {}).matches(path);
+    }
+    
+    bool path_matches(const char *path, const std::vector<std::string> &include, const std::vector<std::string> &exclude) noexcept {
+        return PathMatcher(include, exclude).matches(path);
+    }
+    
+    PathMatcher::PathMatcher(const std::vector<std::string> &include, const std::vector<std::string> &exclude) : include_all(include.empty()) {
+        std::vector<std::size_t> pattern_starts;
+        pattern_starts.reserve(include.size() + exclude.size());
+        
+        for(auto &i : include) {
+            pattern_starts.push_back(this->states.size());
+            this->compile(i, STATE_ACCEPT_INCLUDE);
+        }
+        for(auto &e : exclude) {
+            pattern_starts.push_back(this->states.size());
+            this->compile(e, STATE_ACCEPT_EXCLUDE);
+        }
+        
+        // Every pattern begins active
+        this->start_states.resize((this->states.size() + 63) / 64);
+        for(auto s : pattern_starts) {
+            this->add_state(this->start_states.data(), s);
+        }
+    }
+    
+    void PathMatcher::compile(const std::string &pattern, StateType accept) {
+        bool last_was_star = false;
+        for(char c : pattern) {
+            if(c == '*') {
+                // Runs of * are the same as one *
+                if(!last_was_star) {
+                    this->states.push_back({ STATE_STAR, 0 });
+                }
+                last_was_star = true;
                 continue;
             }
-            else if(*p == '*') {
-                // Skip duplicates
-                while(*p == '*') {
-                    p++;
-                }
-                if(*p == 0) {
-                    return true;
-                }
-                for(const char *s = path; *s; s++) {
-                    if(path_matches(s, p)) {
-                        return true;
-                    }
-                }
-                return false;
+            
+            last_was_star = false;
+            if(c == '?') {
+                this->states.push_back({ STATE_ANY, 0 });
+            }
+            else if(c == '/' || c == '\\' || c == INVADER_PREFERRED_PATH_SEPARATOR) {
+                this->states.push_back({ STATE_SEPARATOR, 0 });
             }
             else {
-                return false;
+                this->states.push_back({ STATE_LITERAL, c });
             }
         }
-        return true;
+        this->states.push_back({ accept, 0 });
     }
     
-    bool path_matches(const char *path, const std::vector<std::string> &include, const std::vector<std::string> &exclude) noexcept {
-        // Check if excluded
-        for(auto &e : exclude) {
-            if(path_matches(path, e.c_str())) {
-                return false;
-            }
+    void PathMatcher::add_state(std::uint64_t *set, std::size_t state) const noexcept {
+        set[state / 64] |= static_cast<std::uint64_t>(1) << (state % 64);
+        
+        // * can match nothing, so whatever follows it is also active (runs of * were collapsed, so this never chains)
+        if(this->states[state].type == STATE_STAR) {
+            auto next = state + 1;
+            set[next / 64] |= static_cast<std::uint64_t>(1) << (next % 64);
         }
+    }
+    
+    bool PathMatcher::matches(const char *path) const noexcept {
+        auto word_count = this->start_states.size();
         
-        // Check if included
-        for(auto &i : include) {
-            if(path_matches(path, i.c_str())) {
-                return true;
+        // Two sets of active states; small pattern sets fit on the stack
+        static constexpr std::size_t STACK_WORDS = 32;
+        std::uint64_t stack_sets[STACK_WORDS * 2];
+        std::vector<std::uint64_t> heap_sets;
+        std::uint64_t *current = stack_sets;
+        if(word_count > STACK_WORDS) {
+            heap_sets.resize(word_count * 2);
+            current = heap_sets.data();
+        }
+        std::uint64_t *next = current + word_count;
+        std::copy(this->start_states.begin(), this->start_states.end(), current);
+        
+        for(const char *c = path; *c; c++) {
+            bool separator = *c == '/' || *c == '\\' || *c == INVADER_PREFERRED_PATH_SEPARATOR;
+            bool alive = false;
+            std::fill_n(next, word_count, 0);
+            
+            for(std::size_t w = 0; w < word_count; w++) {
+                for(auto bits = current[w]; bits; bits &= bits - 1) {
+                    auto s = w * 64 + static_cast<std::size_t>(std::countr_zero(bits));
+                    auto &state = this->states[s];
+                    switch(state.type) {
+                        case STATE_LITERAL:
+                            if(state.character != *c) {
+                                continue;
+                            }
+                            this->add_state(next, s + 1);
+                            break;
+                        case STATE_ANY:
+                            this->add_state(next, s + 1);
+                            break;
+                        case STATE_SEPARATOR:
+                            if(!separator) {
+                                continue;
+                            }
+                            this->add_state(next, s + 1);
+                            break;
+                        case STATE_STAR:
+                            this->add_state(next, s);
+                            break;
+                        default:
+                            continue;
+                    }
+                    alive = true;
+                }
+            }
+            
+            // Nothing can match anymore
+            if(!alive) {
+                return this->include_all;
             }
+            
+            std::swap(current, next);
         }
         
-        // If include is empty, we're good
-        return include.empty();
+        // Exclude patterns take priority over include patterns
+        bool included = this->include_all;
+        for(std::size_t w = 0; w < word_count; w++) {
+            for(auto bits = current[w]; bits; bits &= bits - 1) {
+                auto type = this->states[w * 64 + static_cast<std::size_t>(std::countr_zero(bits))].type;
+                if(type == STATE_ACCEPT_EXCLUDE) {
+                    return false;
+                }
+                else if(type == STATE_ACCEPT_INCLUDE) {
+                    included = true;
+                }
+            }
+        }
+        return included;
     }
 }
@@ -8,6 +8,11 @@
 #include <cstdint>
 #include <filesystem>
 #include <vector>
+#include <map>
+#include <optional>
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include <invader/tag/hek/definition.hpp>
 #include <invader/tag/hek/header.hpp>
 #include <invader/printf.hpp>
@@ -42,6 +47,82 @@ enum FontExtension {
 };
 static_assert(FONT_EXTENSION_COUNT == sizeof(FONT_EXTENSION_STR) / sizeof(*FONT_EXTENSION_STR));
 
+// Number of characters a thread takes at a time
+static constexpr int CHARACTERS_PER_BLOCK = 256;
+
+// Render characters until there are none left. Each thread needs its own face since FreeType faces can't be shared between threads.
+static bool render_characters(const char *font_path, int pixel_size, int characters_to_add, std::atomic<int> &next_character, std::atomic<bool> &failed, std::vector<std::optional<RenderedCharacter>> &rendered) {
+    FT_Library library;
+    FT_Face face;
+    if(FT_Init_FreeType(&library)) {
+        eprintf_error("Failed to initialize freetype.");
+        failed = true;
+        return false;
+    }
+    if(FT_New_Face(library, font_path, 0, &face)) {
+        eprintf_error("Failed to open %s.", font_path);
+        FT_Done_FreeType(library);
+        failed = true;
+        return false;
+    }
+
+    bool success = true;
+    if(FT_Set_Pixel_Sizes(face, pixel_size, pixel_size)) {
+        eprintf_error("Failed to set pixel size %i.", pixel_size);
+        success = false;
+    }
+
+    while(success && !failed) {
+        int start = next_character.fetch_add(CHARACTERS_PER_BLOCK, std::memory_order_relaxed);
+        if(start >= characters_to_add) {
+            break;
+        }
+        int end = start + CHARACTERS_PER_BLOCK > characters_to_add ? characters_to_add : start + CHARACTERS_PER_BLOCK;
+
+        for(int i = start; i < end; i++) {
+            auto index = FT_Get_Char_Index(face, i);
+            if(FT_Load_Glyph(face, index, FT_LOAD_DEFAULT)) {
+                eprintf_error("Failed to load glyph %i", i);
+                success = false;
+                break;
+            }
+
+            RenderedCharacter c;
+            c.character_index = static_cast<std::size_t>(i);
+            c.left = face->glyph->bitmap_left;
+            c.top = face->glyph->bitmap_top;
+            c.x = face->glyph->advance.x >> 6;
+            c.y = face->glyph->advance.y >> 6;
+            c.width = face->glyph->bitmap.width;
+            c.height = face->glyph->bitmap.rows;
+            c.hori_advance = face->glyph->metrics.horiAdvance / 64;
+
+            if(index != 0) {
+                if(FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL)) {
+                    eprintf_error("Failed to render glyph %i", i);
+                    success = false;
+                    break;
+                }
+
+                auto *buffer = reinterpret_cast<std::byte *>(face->glyph->bitmap.buffer);
+                c.data.insert(c.data.begin(), buffer, buffer + c.width * c.height);
+            }
+
+            if(index != 0 || i == 127) {
+                rendered[i] = std::move(c);
+            }
+        }
+    }
+
+    if(!success) {
+        failed = true;
+    }
+
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+    return success;
+}
+
 int main(int argc, char *argv[]) {
     set_up_color_term();
     
@@ -54,6 +135,8 @@ int main(int argc, char *argv[]) {
         int pixel_size = 14;
         bool use_filesystem_path = false;
         bool use_latin1 = false;
+        bool verbose = false;
+        std::size_t max_threads = std::thread::hardware_concurrency() < 1 ? 1 : std::thread::hardware_concurrency();
     } font_options;
 
     // Command line options
@@ -63,7 +146,9 @@ int main(int argc, char *argv[]) {
         CommandLineOption::from_preset(CommandLineOption::PRESET_COMMAND_LINE_OPTION_DATA),
         CommandLineOption::from_preset(CommandLineOption::PRESET_COMMAND_LINE_OPTION_TAGS),
         CommandLineOption("font-size", 's', 1, "Set the font size in pixels.", "<px>"),
-        CommandLineOption("8-bit", '8', 0, "Use the first 256 characters only.")
+        CommandLineOption("8-bit", '8', 0, "Use the first 256 characters only."),
+        CommandLineOption("threads", 'j', 1, "Set the number of threads to use for rendering characters. Default: CPU thread count"),
+        CommandLineOption("verbose", 'v', 0, "Show how long each step took.")
     };
 
     static constexpr char DESCRIPTION[] = "Create font tags from OTF/TTF files.";
@@ -96,6 +181,24 @@ int main(int argc, char *argv[]) {
                 }
                 break;
 
+            case 'j':
+                try {
+                    font_options.max_threads = std::stoul(args[0]);
+                }
+                catch(std::exception &) {
+                    eprintf_error("Invalid number of threads %s", args[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                if(font_options.max_threads < 1) {
+                    eprintf_error("Invalid number of threads %s", args[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                break;
+
+            case 'v':
+                font_options.verbose = true;
+                break;
+
             case 'i':
                 show_version_info();
                 std::exit(EXIT_SUCCESS);
@@ -155,66 +258,49 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
 
-    // Load the TTF
-    FT_Library library;
-    FT_Face face;
-    if(FT_Init_FreeType(&library)) {
-        eprintf_error("Failed to initialize freetype.");
-        return EXIT_FAILURE;
+    // Render the characters in a range
+    auto render_start = std::chrono::steady_clock::now();
+    int characters_to_add = font_options.use_latin1 ? 256 : 65536;
+    std::vector<std::optional<RenderedCharacter>> rendered(characters_to_add);
+    std::atomic<int> next_character = 1;
+    std::atomic<bool> failed = false;
+
+    std::size_t thread_count = (characters_to_add + CHARACTERS_PER_BLOCK - 1) / CHARACTERS_PER_BLOCK;
+    if(thread_count > font_options.max_threads) {
+        thread_count = font_options.max_threads;
     }
-    if(FT_New_Face(library, final_ttf_path.c_str(), 0, &face)) {
-        eprintf_error("Failed to open %s.", final_ttf_path.c_str());
-        return EXIT_FAILURE;
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+    for(std::size_t t = 0; t < thread_count; t++) {
+        threads.emplace_back(render_characters, final_ttf_path.c_str(), font_options.pixel_size, characters_to_add, std::ref(next_character), std::ref(failed), std::ref(rendered));
+    }
+    for(auto &t : threads) {
+        t.join();
     }
-    if(FT_Set_Pixel_Sizes(face, font_options.pixel_size, font_options.pixel_size)) {
-        eprintf_error("Failed to set pixel size %i.", font_options.pixel_size);
+    if(failed) {
         return EXIT_FAILURE;
     }
 
-    // Render the characters in a range
+    // Put them in order
     std::vector<RenderedCharacter> characters;
-    int characters_to_add = font_options.use_latin1 ? 256 : 65536;
-    for(int i = 1; i < characters_to_add; i++) {
-        auto index = FT_Get_Char_Index(face, i);
-        if(FT_Load_Glyph(face, index, FT_LOAD_DEFAULT)) {
-            eprintf_error("Failed to load glyph %i", i);
-            return EXIT_FAILURE;
-        }
-
-        RenderedCharacter c;
-        c.character_index = static_cast<std::size_t>(i);
-        c.left = face->glyph->bitmap_left;
-        c.top = face->glyph->bitmap_top;
-        c.x = face->glyph->advance.x >> 6;
-        c.y = face->glyph->advance.y >> 6;
-        c.width = face->glyph->bitmap.width;
-        c.height = face->glyph->bitmap.rows;
-        c.hori_advance = face->glyph->metrics.horiAdvance / 64;
-
-        if(index != 0) {
-            if(FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL)) {
-                eprintf_error("Failed to render glyph %i", i);
-                return EXIT_FAILURE;
-            }
-
-            auto *buffer = reinterpret_cast<std::byte *>(face->glyph->bitmap.buffer);
-            c.data.insert(c.data.begin(), buffer, buffer + c.width * c.height);
-        }
-
-        if(index != 0 || i == 127) {
-            characters.emplace_back(c);
+    for(auto &c : rendered) {
+        if(c.has_value()) {
+            characters.emplace_back(std::move(*c));
         }
     }
-
-    // Done
-    FT_Done_Face(face);
-    FT_Done_FreeType(library);
+    rendered.clear();
+    auto render_end = std::chrono::steady_clock::now();
 
     // Create
     Parser::Font font = {};
     std::vector<HEK::FontCharacter<HEK::BigEndian>> tag_characters;
     auto &pixels = font.pixels;
 
+    // Identical bitmaps (such as the same missing glyph box for many characters) only need to be stored once
+    std::map<std::vector<std::byte>, std::uint32_t> pixel_offsets;
+    std::size_t deduped_characters = 0;
+
     // Set up the character stuff
     int max_descending_height = 1;
     int max_ascending_height = 1;
@@ -267,11 +353,23 @@ int main(int argc, char *argv[]) {
             tag_character.bitmap_height = character.height;
             tag_character.bitmap_width = character.width;
             tag_character.character_width = character.x;
-            tag_character.pixels_offset = static_cast<std::uint32_t>(pixels.size());
             tag_character.hardware_character_index = -1;
             tag_character.bitmap_origin_x = -character.left;
             tag_character.bitmap_origin_y = character.top;
-            pixels.insert(pixels.end(), character.data.begin(), character.data.end());
+
+            if(character.data.empty()) {
+                tag_character.pixels_offset = static_cast<std::uint32_t>(pixels.size());
+            }
+            else {
+                auto [offset, inserted] = pixel_offsets.try_emplace(character.data, static_cast<std::uint32_t>(pixels.size()));
+                tag_character.pixels_offset = offset->second;
+                if(inserted) {
+                    pixels.insert(pixels.end(), character.data.begin(), character.data.end());
+                }
+                else {
+                    deduped_characters++;
+                }
+            }
 
             int descending_height = tag_character.bitmap_height - character.top;
             int ascending_height = tag_character.bitmap_height - descending_height;
@@ -289,6 +387,8 @@ int main(int argc, char *argv[]) {
     font.ascending_height = max_ascending_height;
     font.descending_height = max_descending_height;
 
+    auto build_end = std::chrono::steady_clock::now();
+
     // Write
     std::error_code ec;
     std::filesystem::create_directories(tag_path.parent_path(), ec);
@@ -296,4 +396,12 @@ int main(int argc, char *argv[]) {
         eprintf_error("Failed to save %s.", final_tag_path.c_str());
         return EXIT_FAILURE;
     }
+    auto save_end = std::chrono::steady_clock::now();
+
+    if(font_options.verbose) {
+        auto ms = [](auto start, auto end) { return static_cast<unsigned long>(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()); };
+        oprintf("Rendered %zu character%s with %zu thread%s in %lu ms\n", character_count, character_count == 1 ? "" : "s", thread_count, thread_count == 1 ? "" : "s", ms(render_start, render_end));
+        oprintf("Built font data (%zu byte%s of pixels, %zu duplicate bitmap%s) in %lu ms\n", pixels.size(), pixels.size() == 1 ? "" : "s", deduped_characters, deduped_characters == 1 ? "" : "s", ms(render_end, build_end));
+        oprintf("Saved %s in %lu ms\n", final_tag_path.c_str(), ms(build_end, save_end));
+    }
 }
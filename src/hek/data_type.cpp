@@ -258,6 +258,155 @@ namespace Invader::HEK {
         k = decompress_float<10>(v >> 22);
     }
 
+    // These give the same results as compress_float/decompress_float, but they don't branch, so loops using them can
+    // be vectorized by the compiler (signed integers are used for conversions as these have vector instructions)
+    template<unsigned int bits> static inline std::uint32_t compress_float_branchless(float f) noexcept {
+        constexpr const std::uint32_t SIGNED_BIT = 1 << (bits - 1);
+        constexpr const std::uint32_t MASK = SIGNED_BIT - 1;
+        f = std::max(std::min(f, 1.0F), -1.0F);
+        auto positive = static_cast<std::int32_t>(f * MASK + 0.5F);
+        auto negative = static_cast<std::int32_t>((1.0 + f) * MASK + 0.5) | static_cast<std::int32_t>(SIGNED_BIT);
+        auto select = -static_cast<std::int32_t>(f >= 0.0F);
+        return static_cast<std::uint32_t>((positive & select) | (negative & ~select));
+    }
+
+    template<unsigned int bits> static inline float decompress_float_branchless(std::uint32_t f) noexcept {
+        constexpr const std::uint32_t SIGNED_BIT = 1 << (bits - 1);
+        constexpr const std::uint32_t MASK = SIGNED_BIT - 1;
+        auto number = static_cast<double>(static_cast<std::int32_t>(f & MASK)) / MASK;
+        return static_cast<float>(number - static_cast<double>(static_cast<std::int32_t>((f & SIGNED_BIT) >> (bits - 1))));
+    }
+
+    void compress_vectors(const float *vectors, std::uint32_t *compressed, std::size_t count) noexcept {
+        for(std::size_t v = 0; v < count; v++) {
+            const float *vector = vectors + v * 3;
+            compressed[v] = compress_float_branchless<11>(vector[0]) | (compress_float_branchless<11>(vector[1]) << 11) | (compress_float_branchless<10>(vector[2]) << 22);
+        }
+    }
+
+    void decompress_vectors(const std::uint32_t *compressed, float *vectors, std::size_t count) noexcept {
+        for(std::size_t v = 0; v < count; v++) {
+            float *vector = vectors + v * 3;
+            vector[0] = decompress_float_branchless<11>(compressed[v]);
+            vector[1] = decompress_float_branchless<11>(compressed[v] >> 11);
+            vector[2] = decompress_float_branchless<10>(compressed[v] >> 22);
+        }
+    }
+
+    static void compress_floats_16(const float *floats, std::uint32_t *compressed, std::size_t count) noexcept {
+        for(std::size_t f = 0; f < count; f++) {
+            compressed[f] = compress_float_branchless<16>(floats[f]);
+        }
+    }
+
+    static void decompress_floats_16(const std::uint32_t *compressed, float *floats, std::size_t count) noexcept {
+        for(std::size_t f = 0; f < count; f++) {
+            floats[f] = decompress_float_branchless<16>(compressed[f]);
+        }
+    }
+
+    // Vertices are done in blocks so each component can be converted in one tight loop
+    static constexpr const std::size_t MODEL_VERTEX_BLOCK_SIZE = 256;
+
+    void compress_model_vertices(const ModelVertexUncompressed<NativeEndian> *vertices, ModelVertexCompressed<NativeEndian> *compressed, std::size_t count) noexcept {
+        float vectors[MODEL_VERTEX_BLOCK_SIZE * 3 * 3];
+        float floats[MODEL_VERTEX_BLOCK_SIZE * 3];
+        std::uint32_t compressed_vectors[MODEL_VERTEX_BLOCK_SIZE * 3];
+        std::uint32_t compressed_floats[MODEL_VERTEX_BLOCK_SIZE * 3];
+
+        for(std::size_t start = 0; start < count; start += MODEL_VERTEX_BLOCK_SIZE) {
+            std::size_t block_count = std::min(count - start, MODEL_VERTEX_BLOCK_SIZE);
+            const auto *input = vertices + start;
+            auto *output = compressed + start;
+
+            // Gather the normal, binormal, and tangent of each vertex, then the texture coordinates and weight
+            for(std::size_t v = 0; v < block_count; v++) {
+                auto &vertex = input[v];
+                float *vector = vectors + v * 9;
+                vector[0] = vertex.normal.i;
+                vector[1] = vertex.normal.j;
+                vector[2] = vertex.normal.k;
+                vector[3] = vertex.binormal.i;
+                vector[4] = vertex.binormal.j;
+                vector[5] = vertex.binormal.k;
+                vector[6] = vertex.tangent.i;
+                vector[7] = vertex.tangent.j;
+                vector[8] = vertex.tangent.k;
+
+                float *f = floats + v * 3;
+                f[0] = vertex.texture_coords.x;
+                f[1] = vertex.texture_coords.y;
+                f[2] = vertex.node0_weight;
+            }
+
+            compress_vectors(vectors, compressed_vectors, block_count * 3);
+            compress_floats_16(floats, compressed_floats, block_count * 3);
+
+            for(std::size_t v = 0; v < block_count; v++) {
+                auto &vertex = input[v];
+                auto &r = output[v];
+                r.position = vertex.position;
+                r.node0_index = vertex.node0_index > Invader::Parser::MaxCompressedModelNodeIndex::MAX_COMPRESSED_MODEL_NODE_INDEX ? -3 : vertex.node0_index * 3;
+                r.node1_index = vertex.node1_index > Invader::Parser::MaxCompressedModelNodeIndex::MAX_COMPRESSED_MODEL_NODE_INDEX ? -3 : vertex.node1_index * 3;
+                r.normal = compressed_vectors[v * 3];
+                r.binormal = compressed_vectors[v * 3 + 1];
+                r.tangent = compressed_vectors[v * 3 + 2];
+                r.texture_coordinate_u = static_cast<std::int16_t>(compressed_floats[v * 3]);
+                r.texture_coordinate_v = static_cast<std::int16_t>(compressed_floats[v * 3 + 1]);
+                r.node0_weight = static_cast<std::int16_t>(compressed_floats[v * 3 + 2]);
+            }
+        }
+    }
+
+    void decompress_model_vertices(const ModelVertexCompressed<NativeEndian> *compressed, ModelVertexUncompressed<NativeEndian> *vertices, std::size_t count) noexcept {
+        std::uint32_t compressed_vectors[MODEL_VERTEX_BLOCK_SIZE * 3];
+        std::uint32_t compressed_floats[MODEL_VERTEX_BLOCK_SIZE * 3];
+        float vectors[MODEL_VERTEX_BLOCK_SIZE * 3 * 3];
+        float floats[MODEL_VERTEX_BLOCK_SIZE * 3];
+
+        for(std::size_t start = 0; start < count; start += MODEL_VERTEX_BLOCK_SIZE) {
+            std::size_t block_count = std::min(count - start, MODEL_VERTEX_BLOCK_SIZE);
+            const auto *input = compressed + start;
+            auto *output = vertices + start;
+
+            for(std::size_t v = 0; v < block_count; v++) {
+                auto &vertex = input[v];
+                compressed_vectors[v * 3] = vertex.normal;
+                compressed_vectors[v * 3 + 1] = vertex.binormal;
+                compressed_vectors[v * 3 + 2] = vertex.tangent;
+                compressed_floats[v * 3] = static_cast<std::uint32_t>(vertex.texture_coordinate_u.read());
+                compressed_floats[v * 3 + 1] = static_cast<std::uint32_t>(vertex.texture_coordinate_v.read());
+                compressed_floats[v * 3 + 2] = vertex.node0_weight;
+            }
+
+            decompress_vectors(compressed_vectors, vectors, block_count * 3);
+            decompress_floats_16(compressed_floats, floats, block_count * 3);
+
+            for(std::size_t v = 0; v < block_count; v++) {
+                auto &vertex = input[v];
+                auto &r = output[v];
+                const float *vector = vectors + v * 9;
+                const float *f = floats + v * 3;
+                r.position = vertex.position;
+                r.node0_index = vertex.node0_index < 0 ? 65535 : vertex.node0_index / 3;
+                r.node1_index = vertex.node1_index < 0 ? 65535 : vertex.node1_index / 3;
+                r.normal.i = vector[0];
+                r.normal.j = vector[1];
+                r.normal.k = vector[2];
+                r.binormal.i = vector[3];
+                r.binormal.j = vector[4];
+                r.binormal.k = vector[5];
+                r.tangent.i = vector[6];
+                r.tangent.j = vector[7];
+                r.tangent.k = vector[8];
+                r.texture_coords.x = f[0];
+                r.texture_coords.y = f[1];
+                r.node0_weight = f[2];
+                r.node1_weight = 1.0F - r.node0_weight; // this is just derived from node0_weight
+            }
+        }
+    }
+
     ModelVertexCompressed<NativeEndian> compress_model_vertex(const ModelVertexUncompressed<NativeEndian> &vertex) noexcept {
         ModelVertexCompressed<NativeEndian> r;
         r.position = vertex.position;
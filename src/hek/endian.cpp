@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <invader/hek/endian.hpp>
+
+namespace Invader::HEK {
+    void EndianSwapMask::add(std::size_t width, std::size_t count) {
+        if(count == 0) {
+            return;
+        }
+        this->record_size += width * count;
+        if(!this->runs.empty() && this->runs.back().width == width) {
+            this->runs.back().count += count;
+        }
+        else {
+            this->runs.emplace_back(Run { width, count });
+        }
+    }
+
+    template <std::size_t width> static std::byte *swap_run(std::byte *data, std::size_t count) noexcept {
+        swap_endian_words<width>(data, count);
+        return data + width * count;
+    }
+
+    void EndianSwapMask::swap(std::byte *data, std::size_t record_count) const noexcept {
+        auto swap_run_any = [](std::byte *data, std::size_t width, std::size_t count) noexcept {
+            switch(width) {
+                case 2:
+                    return swap_run<2>(data, count);
+                case 4:
+                    return swap_run<4>(data, count);
+                case 8:
+                    return swap_run<8>(data, count);
+                default:
+                    return data + width * count;
+            }
+        };
+
+        // If every value is the same width, the whole array can be swapped at once
+        if(this->runs.size() == 1) {
+            swap_run_any(data, this->runs[0].width, this->runs[0].count * record_count);
+            return;
+        }
+
+        for(std::size_t r = 0; r < record_count; r++) {
+            for(auto &run : this->runs) {
+                data = swap_run_any(data, run.width, run.count);
+            }
+        }
+    }
+}
@@ -1,6 +1,13 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
 #include <optional>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <thread>
 #include <invader/map/map.hpp>
 #include <invader/file/file.hpp>
 #include "../command_line_option.hpp"
@@ -17,13 +24,15 @@
 
 struct DisplayValue {
     const char * const name;
-    void (* const calculate_value)(const Invader::Map &map);
+    void (* const calculate_value)(Invader::Info::MapQuery &query, Invader::BufferedOutput &output);
+    
+    // Whether this uses the CRC32 and/or the protection check, so they're only done (ahead of time) if needed
+    bool needs_crc32 = false;
+    bool needs_protection = false;
 };
 
 #define MAKE_DISPLAY_VALUE(name) {# name, Invader::Info::name }
-
-static std::byte header_cache[sizeof(Invader::HEK::NativeCacheFileHeader)];
-static std::size_t file_size = 0;
+#define MAKE_DISPLAY_VALUE_NEEDING(name, crc32, protection) {# name, Invader::Info::name, crc32, protection }
 
 // Calculating compression ratio:
 //
@@ -32,52 +41,55 @@ static std::size_t file_size = 0;
 //
 //        So, if a map is 15 MiB compressed and 20 MiB uncompressed, the compression ratio is 0.75.
 //
-static double calculate_compression_ratio(const Invader::Map &map) {
-    auto uncompressed_length = map.get_data_length() - sizeof(Invader::HEK::CacheFileHeader);
-    auto compressed_length = file_size - sizeof(Invader::HEK::CacheFileHeader);
+static double calculate_compression_ratio(const Invader::Info::MapQuery &query) {
+    auto uncompressed_length = query.get_map().get_data_length() - sizeof(Invader::HEK::CacheFileHeader);
+    auto compressed_length = query.get_file_size() - sizeof(Invader::HEK::CacheFileHeader);
     return static_cast<double>(compressed_length) / uncompressed_length;
 }
 
 namespace Invader::Info {
-    void compression_ratio(const Invader::Map &map) {
-        oprintf("%f\n", calculate_compression_ratio(map));
+    void compression_ratio(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%f\n", calculate_compression_ratio(query));
     }
     
-    void overview(const Invader::Map &map) {
-        #define PRINT_LINE(function, key, format, ...) function("%-19s" format, key, __VA_ARGS__)
+    void overview(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        auto *header_cache = query.get_file_header();
+        
+        #define PRINT_LINE(type, key, format, ...) output.print(BufferedOutput::type, "%-19s" format, key, __VA_ARGS__)
         
         // Basic metadata
-        PRINT_LINE(oprintf, "Scenario name:", "%s\n", map.get_scenario_name());
+        PRINT_LINE(OUTPUT_PLAIN, "Scenario name:", "%s\n", map.get_scenario_name());
         
         auto cache_version = map.get_cache_version();
         auto &game_engine_info = HEK::GameEngineInfo::get_game_engine_info(map.get_game_engine());
-        PRINT_LINE(oprintf, "Engine:", "%s\n", game_engine_info.name);
+        PRINT_LINE(OUTPUT_PLAIN, "Engine:", "%s\n", game_engine_info.name);
         
         if(cache_version == HEK::CacheFileEngine::CACHE_FILE_NATIVE) {
-            PRINT_LINE(oprintf, "Timestamp:", "%s\n", reinterpret_cast<Invader::HEK::NativeCacheFileHeader *>(header_cache)->timestamp.string);
+            PRINT_LINE(OUTPUT_PLAIN, "Timestamp:", "%s\n", reinterpret_cast<const Invader::HEK::NativeCacheFileHeader *>(header_cache)->timestamp.string);
         }
         
         auto build_string = map.get_build();
         
         if(std::strlen(build_string) != 0) {
-            PRINT_LINE(oprintf, "Build string:", "%s\n", build_string);
+            PRINT_LINE(OUTPUT_PLAIN, "Build string:", "%s\n", build_string);
         }
         
         auto map_type = map.get_type();
         
         if(map_type == map.get_header_type()) {
-            PRINT_LINE(oprintf_success, "Map type:", "%s (matches header)", type_name(map_type));
+            PRINT_LINE(OUTPUT_SUCCESS, "Map type:", "%s (matches header)", type_name(map_type));
         }
         else {
-            PRINT_LINE(oprintf_success_warn, "Map type:", "%s (mismatched)", type_name(map_type));
+            PRINT_LINE(OUTPUT_SUCCESS_WARN, "Map type:", "%s (mismatched)", type_name(map_type));
         }
         
         if(cache_version == HEK::CacheFileEngine::CACHE_FILE_MCC_CEA) {
-            if(reinterpret_cast<Invader::HEK::CacheFileHeaderCEA *>(header_cache)->flags & HEK::CacheFileHeaderCEAFlags::CACHE_FILE_HEADER_CEA_FLAGS_CLASSIC_ONLY) {
-                PRINT_LINE(oprintf_success, "Classic:", "%s", "Yes");
+            if(reinterpret_cast<const Invader::HEK::CacheFileHeaderCEA *>(header_cache)->flags & HEK::CacheFileHeaderCEAFlags::CACHE_FILE_HEADER_CEA_FLAGS_CLASSIC_ONLY) {
+                PRINT_LINE(OUTPUT_SUCCESS, "Classic:", "%s", "Yes");
             }
             else {
-                PRINT_LINE(oprintf_success_lesser_warn, "Classic:", "%s", "No");
+                PRINT_LINE(OUTPUT_SUCCESS_LESSER_WARN, "Classic:", "%s", "No");
             }
         }
         
@@ -87,71 +99,71 @@ namespace Invader::Info {
         auto stub_count = calculate_stub_count(map);
         
         if(stub_count == 0) {
-            PRINT_LINE(oprintf_success, "Tags:", "%zu / %zu (%.02f MiB)", tag_count, HEK::CacheFileLimits::CACHE_FILE_MAX_TAG_COUNT, tag_data_size);
+            PRINT_LINE(OUTPUT_SUCCESS, "Tags:", "%zu / %zu (%.02f MiB)", tag_count, HEK::CacheFileLimits::CACHE_FILE_MAX_TAG_COUNT, tag_data_size);
         }
         else {
-            PRINT_LINE(oprintf_success_lesser_warn, "Tags:", "%zu / %zu (%.02f MiB), %zu stubbed", tag_count, HEK::CacheFileLimits::CACHE_FILE_MAX_TAG_COUNT, tag_data_size, stub_count);
+            PRINT_LINE(OUTPUT_SUCCESS_LESSER_WARN, "Tags:", "%zu / %zu (%.02f MiB), %zu stubbed", tag_count, HEK::CacheFileLimits::CACHE_FILE_MAX_TAG_COUNT, tag_data_size, stub_count);
         }
         
-        auto crc = map.get_crc32();
+        auto crc = query.get_crc32();
         auto crc_matches = map.get_header_crc32() == crc;
         
         // TODODILE: Figure out how to check an Xbox map's integrity
         if(cache_version != HEK::CacheFileEngine::CACHE_FILE_XBOX) {
             // CRC32
             if(crc_matches) {
-                PRINT_LINE(oprintf_success, "CRC32:", "0x%08X (matches header)", crc);
+                PRINT_LINE(OUTPUT_SUCCESS, "CRC32:", "0x%08X (matches header)", crc);
             }
             else {
-                PRINT_LINE(oprintf_success_warn, "CRC32:", "0x%08X (mismatched)", crc);
+                PRINT_LINE(OUTPUT_SUCCESS_WARN, "CRC32:", "0x%08X (mismatched)", crc);
             }
             
             // Dirty?
-            if(map.is_clean()) {
-                PRINT_LINE(oprintf_success, "Integrity:", "%s", "Clean");
+            if(query.is_clean()) {
+                PRINT_LINE(OUTPUT_SUCCESS, "Integrity:", "%s", "Clean");
             }
             else {
-                PRINT_LINE(oprintf_success_warn, "Integrity:", "%s", "Dirty (map may be corrupted or modified)");
+                PRINT_LINE(OUTPUT_SUCCESS_WARN, "Integrity:", "%s", "Dirty (map may be corrupted or modified)");
             }
         }
         
         // Protected?
-        std::vector<std::string> protection_reasons;
-        if(!map.is_protected(protection_reasons)) {
-            PRINT_LINE(oprintf_success, "Protected:", "%s", "No (probably)");
+        auto &protection_reasons = query.get_protection_issues();
+        if(protection_reasons.empty()) {
+            PRINT_LINE(OUTPUT_SUCCESS, "Protected:", "%s", "No (probably)");
         }
         else {
-            PRINT_LINE(oprintf_success_warn, "Protected:", "%s (probably - %zu issue%s)", "Yes", protection_reasons.size(), protection_reasons.size() == 1 ? "" : "s");
+            PRINT_LINE(OUTPUT_SUCCESS_WARN, "Protected:", "%s (probably - %zu issue%s)", "Yes", protection_reasons.size(), protection_reasons.size() == 1 ? "" : "s");
         }
         
-        std::size_t external_bitmaps = find_external_tags_indices(map, Map::DataMapType::DATA_MAP_BITMAP, true, true).size();
-        std::size_t external_sounds = find_external_tags_indices(map, Map::DataMapType::DATA_MAP_SOUND, true, true).size();
-        std::size_t external_loc = find_external_tags_indices(map, Map::DataMapType::DATA_MAP_LOC, true, true).size();
+        std::size_t external_bitmaps = query.find_external_tags_indices(Map::DataMapType::DATA_MAP_BITMAP, true, true).size();
+        std::size_t external_sounds = query.find_external_tags_indices(Map::DataMapType::DATA_MAP_SOUND, true, true).size();
+        std::size_t external_loc = query.find_external_tags_indices(Map::DataMapType::DATA_MAP_LOC, true, true).size();
         std::size_t total_external = external_bitmaps + external_sounds + external_loc;
         
         if(cache_version != HEK::CacheFileEngine::CACHE_FILE_NATIVE && cache_version != HEK::CacheFileEngine::CACHE_FILE_XBOX) {
             if(total_external == 0) {
-                PRINT_LINE(oprintf_success, "External tags:", "%s", "None");
+                PRINT_LINE(OUTPUT_SUCCESS, "External tags:", "%s", "None");
             }
             else if(cache_version == HEK::CacheFileEngine::CACHE_FILE_CUSTOM_EDITION) {
-                PRINT_LINE(oprintf_success_lesser_warn, "External tags:", "%zu (%zu bitmap%s, %zu loc, %zu sound%s)", total_external, external_bitmaps, external_bitmaps == 1 ? "" : "s", external_loc, external_sounds, external_sounds == 1 ? "" : "s");
+                PRINT_LINE(OUTPUT_SUCCESS_LESSER_WARN, "External tags:", "%zu (%zu bitmap%s, %zu loc, %zu sound%s)", total_external, external_bitmaps, external_bitmaps == 1 ? "" : "s", external_loc, external_sounds, external_sounds == 1 ? "" : "s");
                 
                 // If we're custom edition we need to see if they're at least all indexed
-                std::size_t indexed_bitmaps = find_external_tags_indices(map, Map::DataMapType::DATA_MAP_BITMAP, true, false).size();
-                std::size_t indexed_sounds = find_external_tags_indices(map, Map::DataMapType::DATA_MAP_SOUND, true, false).size();
-                std::size_t indexed_loc = find_external_tags_indices(map, Map::DataMapType::DATA_MAP_LOC, true, false).size();
+                std::size_t indexed_bitmaps = query.find_external_tags_indices(Map::DataMapType::DATA_MAP_BITMAP, true, false).size();
+                std::size_t indexed_sounds = query.find_external_tags_indices(Map::DataMapType::DATA_MAP_SOUND, true, false).size();
+                std::size_t indexed_loc = query.find_external_tags_indices(Map::DataMapType::DATA_MAP_LOC, true, false).size();
                 std::size_t total_indexed = indexed_bitmaps + indexed_sounds + indexed_loc;
                 
                 // If not, that's bad
                 if(total_indexed != total_external) {
-                    PRINT_LINE(oprintf_success_warn, "Indexed tags:", "%zu (%zu bitmap%s, %zu loc, %zu sound%s)", total_indexed, indexed_bitmaps, indexed_bitmaps == 1 ? "" : "s", indexed_loc, indexed_sounds, indexed_sounds == 1 ? "" : "s");
+                    PRINT_LINE(OUTPUT_SUCCESS_WARN, "Indexed tags:", "%zu (%zu bitmap%s, %zu loc, %zu sound%s)", total_indexed, indexed_bitmaps, indexed_bitmaps == 1 ? "" : "s", indexed_loc, indexed_sounds, indexed_sounds == 1 ? "" : "s");
                 }
                 else {
-                    PRINT_LINE(oprintf_success, "Indexed tags:", "%zu (%zu bitmap%s, %zu loc, %zu sound%s)", total_indexed, indexed_bitmaps, indexed_bitmaps == 1 ? "" : "s", indexed_loc, indexed_sounds, indexed_sounds == 1 ? "" : "s");
+                    PRINT_LINE(OUTPUT_SUCCESS, "Indexed tags:", "%zu (%zu bitmap%s, %zu loc, %zu sound%s)", total_indexed, indexed_bitmaps, indexed_bitmaps == 1 ? "" : "s", indexed_loc, indexed_sounds, indexed_sounds == 1 ? "" : "s");
                 }
             }
             else {
-                PRINT_LINE(oprintf_success_warn, "External tags:", "%zu (%zu bitmap%s, %zu sound%s)", total_external, external_bitmaps, external_bitmaps == 1 ? "" : "s", external_sounds, external_sounds == 1 ? "" : "s");
+                PRINT_LINE(OUTPUT_SUCCESS_WARN, "External tags:", "%zu (%zu bitmap%s, %zu sound%s)", total_external, external_bitmaps, external_bitmaps == 1 ? "" : "s", external_sounds, external_sounds == 1 ? "" : "s");
             }
         }
         
@@ -160,19 +172,19 @@ namespace Invader::Info {
             case CHECK_TAG_ORDER_RESULT_UNKNOWN:
                 break;
             case CHECK_TAG_ORDER_RESULT_MATCHED:
-                PRINT_LINE(oprintf_success, "Stock tag order:", "%s", "Matched");
+                PRINT_LINE(OUTPUT_SUCCESS, "Stock tag order:", "%s", "Matched");
                 break;
             case CHECK_TAG_ORDER_RESULT_NETWORK_MATCHED:
-                PRINT_LINE(oprintf_success_lesser_warn, "Stock tag order:", "%s", "Network compatible (probably) but tags do not match");
+                PRINT_LINE(OUTPUT_SUCCESS_LESSER_WARN, "Stock tag order:", "%s", "Network compatible (probably) but tags do not match");
                 break;
             case CHECK_TAG_ORDER_RESULT_NETWORK_MATCHED_AS_HOST:
-                PRINT_LINE(oprintf_success_warn, "Stock tag order:", "%s", "Host only (may crash if joining a stock host as a client)");
+                PRINT_LINE(OUTPUT_SUCCESS_WARN, "Stock tag order:", "%s", "Host only (may crash if joining a stock host as a client)");
                 break;
             case CHECK_TAG_ORDER_RESULT_NETWORK_MATCHED_AS_CLIENT:
-                PRINT_LINE(oprintf_success_warn, "Stock tag order:", "%s", "Client only (may crash clients if joining with stock map)");
+                PRINT_LINE(OUTPUT_SUCCESS_WARN, "Stock tag order:", "%s", "Client only (may crash clients if joining with stock map)");
                 break;
             case CHECK_TAG_ORDER_RESULT_MISMATCHED_TAGS:
-                PRINT_LINE(oprintf_fail, "Stock tag order:", "%s", "Mismatched (game may crash)");
+                PRINT_LINE(OUTPUT_FAIL, "Stock tag order:", "%s", "Mismatched (game may crash)");
                 break;
         }
         
@@ -181,14 +193,14 @@ namespace Invader::Info {
             bool any;
             auto languages = find_languages_for_map(map, any);
             if(any) {
-                PRINT_LINE(oprintf_success, "Valid languages:", "%s", "Any (map will work on all original releases of the game)");
+                PRINT_LINE(OUTPUT_SUCCESS, "Valid languages:", "%s", "Any (map will work on all original releases of the game)");
             }
             else if(languages.size() == 0) {
                 if(!check_if_valid_indexed_tags_for_stock_custom_edition(map)) {
-                    PRINT_LINE(oprintf_success_warn, "Valid languages:", "%s", "None (map contains invalid indices for stock resource maps)");
+                    PRINT_LINE(OUTPUT_SUCCESS_WARN, "Valid languages:", "%s", "None (map contains invalid indices for stock resource maps)");
                 }
                 else {
-                    PRINT_LINE(oprintf_success_warn, "Valid languages:", "%s", "None (map was built against custom resource maps)");
+                    PRINT_LINE(OUTPUT_SUCCESS_WARN, "Valid languages:", "%s", "None (map was built against custom resource maps)");
                 }
             }
             else {
@@ -202,7 +214,7 @@ namespace Invader::Info {
                         list += i;
                     }
                 }
-                PRINT_LINE(oprintf_success_warn, "Valid languages:", "%s", list.c_str());
+                PRINT_LINE(OUTPUT_SUCCESS_WARN, "Valid languages:", "%s", list.c_str());
             }
         }
         
@@ -219,10 +231,10 @@ namespace Invader::Info {
                     break;
             }
             
-            PRINT_LINE(oprintf, "Compressed:", "Yes (%.02f %%) via %s\n", calculate_compression_ratio(map) * 100.0, compression_algorithm);
+            PRINT_LINE(OUTPUT_PLAIN, "Compressed:", "Yes (%.02f %%) via %s\n", calculate_compression_ratio(query) * 100.0, compression_algorithm);
         }
         else {
-            PRINT_LINE(oprintf, "Compressed:", "%s\n", "No");
+            PRINT_LINE(OUTPUT_PLAIN, "Compressed:", "%s\n", "No");
         }
         
         // Uncompressed size
@@ -237,18 +249,18 @@ namespace Invader::Info {
             std::snprintf(uncompressed_size, sizeof(uncompressed_size), "%.02f / %.02f MiB (%.02f %%)%s", num, den, 100.0 * num / den, size_mismatched ? " (mismatched)" : " (matches header)");
             
             if(num > den || size_mismatched) {
-                PRINT_LINE(oprintf_success_warn, "Uncompressed size:", "%s", uncompressed_size);
+                PRINT_LINE(OUTPUT_SUCCESS_WARN, "Uncompressed size:", "%s", uncompressed_size);
             }
             else {
-                PRINT_LINE(oprintf_success, "Uncompressed size:", "%s", uncompressed_size);
+                PRINT_LINE(OUTPUT_SUCCESS, "Uncompressed size:", "%s", uncompressed_size);
             }
         }
         else {
             if(size_mismatched) {
-                PRINT_LINE(oprintf_success_warn, "Uncompressed size:", "%.02f MiB (mismatched)", BYTES_TO_MiB(map.get_data_length()));
+                PRINT_LINE(OUTPUT_SUCCESS_WARN, "Uncompressed size:", "%.02f MiB (mismatched)", BYTES_TO_MiB(map.get_data_length()));
             }
             else {
-                PRINT_LINE(oprintf_success, "Uncompressed size:", "%.02f MiB (matches header)", BYTES_TO_MiB(map.get_data_length()));
+                PRINT_LINE(OUTPUT_SUCCESS, "Uncompressed size:", "%.02f MiB (matches header)", BYTES_TO_MiB(map.get_data_length()));
             }
         }
         
@@ -257,11 +269,11 @@ namespace Invader::Info {
 }
 
 static DisplayValue all_values[] = {
-    MAKE_DISPLAY_VALUE(overview),
+    MAKE_DISPLAY_VALUE_NEEDING(overview, true, true),
     MAKE_DISPLAY_VALUE(build),
     MAKE_DISPLAY_VALUE(compression_ratio),
-    MAKE_DISPLAY_VALUE(crc32),
-    MAKE_DISPLAY_VALUE(crc32_mismatched),
+    MAKE_DISPLAY_VALUE_NEEDING(crc32, true, false),
+    MAKE_DISPLAY_VALUE_NEEDING(crc32_mismatched, true, false),
     MAKE_DISPLAY_VALUE(engine),
     
     MAKE_DISPLAY_VALUE(external_bitmaps),
@@ -299,11 +311,11 @@ static DisplayValue all_values[] = {
     
     
     MAKE_DISPLAY_VALUE(is_compressed),
-    MAKE_DISPLAY_VALUE(is_dirty),
-    MAKE_DISPLAY_VALUE(is_protected),
+    MAKE_DISPLAY_VALUE_NEEDING(is_dirty, true, true),
+    MAKE_DISPLAY_VALUE_NEEDING(is_protected, false, true),
     MAKE_DISPLAY_VALUE(languages),
     MAKE_DISPLAY_VALUE(map_type),
-    MAKE_DISPLAY_VALUE(protection_issues),
+    MAKE_DISPLAY_VALUE_NEEDING(protection_issues, false, true),
     MAKE_DISPLAY_VALUE(scenario),
     MAKE_DISPLAY_VALUE(scenario_path),
     MAKE_DISPLAY_VALUE(stub_count),
@@ -314,6 +326,57 @@ static DisplayValue all_values[] = {
     MAKE_DISPLAY_VALUE(uses_external_pointers)
 };
 
+enum InfoFormat {
+    /** Text meant to be read by people (default) */
+    INFO_FORMAT_TEXT,
+    
+    /** One "map<TAB>type<TAB>value" line per line of each value */
+    INFO_FORMAT_TSV,
+    
+    /** A JSON array with an object for each map, with each value as an array of its lines */
+    INFO_FORMAT_JSON
+};
+
+static void append_json_string(std::string &json, const std::string &string) {
+    json += '"';
+    for(char c : string) {
+        switch(c) {
+            case '"':
+                json += "\\\"";
+                break;
+            case '\\':
+                json += "\\\\";
+                break;
+            default:
+                if(static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+                    json += escaped;
+                }
+                else {
+                    json += c;
+                }
+                break;
+        }
+    }
+    json += '"';
+}
+
+// Split a value into its lines (without the trailing newline)
+static std::vector<std::string> value_lines(const std::string &value) {
+    std::vector<std::string> lines;
+    std::size_t start = 0;
+    while(start < value.size()) {
+        auto end = value.find('\n', start);
+        if(end == std::string::npos) {
+            end = value.size();
+        }
+        lines.emplace_back(value, start, end - start);
+        start = end + 1;
+    }
+    return lines;
+}
+
 int main(int argc, const char **argv) {
     set_up_color_term();
     
@@ -321,7 +384,9 @@ int main(int argc, const char **argv) {
 
     // Options struct
     struct MapInfoOptions {
-        const DisplayValue *type = &all_values[0];
+        std::vector<const DisplayValue *> types;
+        InfoFormat format = InfoFormat::INFO_FORMAT_TEXT;
+        std::size_t max_threads = std::thread::hardware_concurrency() < 1 ? 1 : std::thread::hardware_concurrency();
     } map_info_options;
     
     // Form the options list
@@ -329,7 +394,7 @@ int main(int argc, const char **argv) {
     bool overview_added = false;
     for(auto &i : all_values) {
         if(!overview_added) {
-            options_list += "Set the type of data to show. Can be overview (default)";
+            options_list += "Set the type of data to show. This can be used multiple times to show multiple types from one load of the map. Can be overview (default)";
             overview_added = true;
         }
         else {
@@ -341,21 +406,23 @@ int main(int argc, const char **argv) {
     // Command line options
     const CommandLineOption options[] = {
         CommandLineOption("type", 'T', 1, options_list.c_str(), "<type>"),
+        CommandLineOption("format", 'F', 1, "Set the output format. Can be text (default), tsv (a map, type, and value line for each line of each value), or json (an array of map objects with each value as an array of lines).", "<format>"),
+        CommandLineOption("threads", 'j', 1, "Set the number of threads to use for loading maps when multiple maps are given. Default: CPU thread count"),
         CommandLineOption::from_preset(CommandLineOption::PRESET_COMMAND_LINE_OPTION_INFO)
     };
 
-    static constexpr char DESCRIPTION[] = "Display map metadata.";
-    static constexpr char USAGE[] = "[option] <map>";
+    static constexpr char DESCRIPTION[] = "Display map metadata. If a directory is given, all maps in it are used.";
+    static constexpr char USAGE[] = "[options] <map|directory> [map|directory ...]";
 
     // Do it!
-    auto remaining_arguments = Invader::CommandLineOption::parse_arguments<MapInfoOptions &>(argc, argv, options, USAGE, DESCRIPTION, 1, 1, map_info_options, [](char opt, const auto &args, auto &map_info_options) {
+    auto remaining_arguments = Invader::CommandLineOption::parse_arguments<MapInfoOptions &>(argc, argv, options, USAGE, DESCRIPTION, 1, SIZE_MAX, map_info_options, [](char opt, const auto &args, auto &map_info_options) {
         switch(opt) {
             case 'T': {
                 bool found = false;
                 
                 for(auto &i : all_values) {
                     if(std::strcmp(args[0], i.name) == 0) {
-                        map_info_options.type = &i;
+                        map_info_options.types.emplace_back(&i);
                         found = true;
                         break;
                     }
@@ -367,30 +434,244 @@ int main(int argc, const char **argv) {
                 }
                 break;
             }
+            case 'F':
+                if(std::strcmp(args[0], "text") == 0) {
+                    map_info_options.format = InfoFormat::INFO_FORMAT_TEXT;
+                }
+                else if(std::strcmp(args[0], "tsv") == 0) {
+                    map_info_options.format = InfoFormat::INFO_FORMAT_TSV;
+                }
+                else if(std::strcmp(args[0], "json") == 0) {
+                    map_info_options.format = InfoFormat::INFO_FORMAT_JSON;
+                }
+                else {
+                    eprintf_error("Unknown format %s", args[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                break;
+            case 'j':
+                try {
+                    map_info_options.max_threads = std::stoul(args[0]);
+                }
+                catch(std::exception &) {
+                    eprintf_error("Invalid number of threads %s", args[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                if(map_info_options.max_threads < 1) {
+                    eprintf_error("Invalid number of threads %s", args[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                break;
             case 'i':
                 Invader::show_version_info();
                 std::exit(EXIT_SUCCESS);
         }
     });
-
-    // Load it
-    std::unique_ptr<Map> map;
-    try {
-        auto file = File::open_file(remaining_arguments[0]).value();
-        file_size = file.size();
-        if(file_size >= sizeof(header_cache)) {
-            std::memcpy(header_cache, file.data(), sizeof(header_cache));
+    
+    if(map_info_options.types.empty()) {
+        map_info_options.types.emplace_back(&all_values[0]);
+    }
+    
+    // Find all of the maps
+    std::vector<std::filesystem::path> map_paths;
+    bool directory_given = false;
+    for(auto *argument : remaining_arguments) {
+        std::error_code ec;
+        if(std::filesystem::is_directory(argument, ec)) {
+            directory_given = true;
+            std::vector<std::filesystem::path> directory_maps;
+            for(auto &entry : std::filesystem::recursive_directory_iterator(argument, ec)) {
+                if(entry.is_regular_file(ec) && entry.path().extension() == ".map") {
+                    directory_maps.emplace_back(entry.path());
+                }
+            }
+            std::sort(directory_maps.begin(), directory_maps.end());
+            map_paths.insert(map_paths.end(), directory_maps.begin(), directory_maps.end());
+        }
+        else {
+            map_paths.emplace_back(argument);
         }
-        
-        map = std::make_unique<Map>(Map::map_with_move(std::move(file)));
     }
-    catch (std::exception &e) {
-        eprintf_error("Failed to parse %s: %s", remaining_arguments[0], e.what());
+    
+    auto map_count = map_paths.size();
+    if(map_count == 0) {
+        eprintf_error("No maps were found");
         return EXIT_FAILURE;
     }
     
+    bool show_map_names = map_count > 1 || directory_given;
+    bool show_type_names = map_info_options.types.size() > 1;
+    
+    // Only do the expensive checks if something shown needs them
+    bool needs_crc32 = false;
+    bool needs_protection = false;
+    for(auto *type : map_info_options.types) {
+        needs_crc32 = needs_crc32 || type->needs_crc32;
+        needs_protection = needs_protection || type->needs_protection;
+    }
+    
+    // Load it
+    auto load_map = [&needs_crc32, &needs_protection](const std::filesystem::path &path, std::unique_ptr<Info::MapQuery> &query, std::string &error) {
+        auto file = File::open_file(path);
+        if(!file.has_value()) {
+            error = "Failed to read " + path.string();
+            return;
+        }
+        
+        try {
+            query = std::make_unique<Info::MapQuery>(std::move(*file));
+            query->prepare(needs_crc32, needs_protection);
+        }
+        catch (std::exception &e) {
+            error = "Failed to parse " + path.string() + ": " + e.what();
+        }
+    };
+    
+    // Maps are loaded in parallel, but they're shown in order, so maps that are done loading are held until the maps
+    // before them are shown. Loading stops if too many maps are held so they don't all end up in memory at once.
+    std::vector<std::unique_ptr<Info::MapQuery>> queries(map_count);
+    std::vector<std::string> errors(map_count);
+    std::vector<bool> loaded(map_count);
+    std::size_t maps_shown = 0;
+    std::atomic<std::size_t> next_map = 0;
+    std::mutex map_mutex;
+    std::condition_variable map_condition;
+    
+    auto thread_count = std::min(map_info_options.max_threads, map_count);
+    auto max_held = thread_count * 2;
+    auto load_thread = [&]() {
+        while(true) {
+            auto m = next_map.fetch_add(1, std::memory_order_relaxed);
+            if(m >= map_count) {
+                return;
+            }
+            
+            {
+                std::unique_lock<std::mutex> lock(map_mutex);
+                map_condition.wait(lock, [&]() { return m < maps_shown + max_held; });
+            }
+            
+            load_map(map_paths[m], queries[m], errors[m]);
+            
+            {
+                std::scoped_lock<std::mutex> lock(map_mutex);
+                loaded[m] = true;
+            }
+            map_condition.notify_all();
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    if(map_count > 1) {
+        threads.reserve(thread_count);
+        for(std::size_t j = 0; j < thread_count; j++) {
+            threads.emplace_back(load_thread);
+        }
+    }
+    
     // Do it!
-    map_info_options.type->calculate_value(*map);
+    bool failed = false;
+    auto format = map_info_options.format;
+    if(format == InfoFormat::INFO_FORMAT_JSON) {
+        oprintf("[");
+    }
+    
+    for(std::size_t m = 0; m < map_count; m++) {
+        if(threads.empty()) {
+            load_map(map_paths[m], queries[m], errors[m]);
+        }
+        else {
+            std::unique_lock<std::mutex> lock(map_mutex);
+            map_condition.wait(lock, [&]() { return static_cast<bool>(loaded[m]); });
+        }
+        
+        // In text, each type is shown exactly as it would be on its own, with head-style "==> map <==" and "[type]"
+        // headers only when more than one map or type is shown. Scripts should use tsv or json instead of parsing this.
+        auto map_path = map_paths[m].string();
+        if(format == InfoFormat::INFO_FORMAT_TEXT && show_map_names) {
+            oprintf("%s==> %s <==\n", m == 0 ? "" : "\n", map_path.c_str());
+        }
+        
+        if(!queries[m]) {
+            eprintf_error("%s", errors[m].c_str());
+            failed = true;
+        }
+        
+        if(format == InfoFormat::INFO_FORMAT_TEXT) {
+            if(queries[m]) {
+                for(auto *type : map_info_options.types) {
+                    if(show_type_names) {
+                        oprintf("[%s]\n", type->name);
+                    }
+                    BufferedOutput output;
+                    type->calculate_value(*queries[m], output);
+                    output.flush();
+                }
+            }
+        }
+        
+        // In tsv, every line of every value is prefixed with the map and type so lines can be filtered on their own
+        else if(format == InfoFormat::INFO_FORMAT_TSV) {
+            if(queries[m]) {
+                for(auto *type : map_info_options.types) {
+                    BufferedOutput output;
+                    type->calculate_value(*queries[m], output);
+                    for(auto &line : value_lines(output.to_string())) {
+                        oprintf("%s\t%s\t%s\n", map_path.c_str(), type->name, line.c_str());
+                    }
+                }
+            }
+        }
+        
+        // In json, each map is an object with its path and either its values or the error that stopped it from loading
+        else {
+            std::string json = m == 0 ? "\n{\"map\":" : ",\n{\"map\":";
+            append_json_string(json, map_path);
+            if(queries[m]) {
+                json += ",\"values\":{";
+                bool first_type = true;
+                for(auto *type : map_info_options.types) {
+                    BufferedOutput output;
+                    type->calculate_value(*queries[m], output);
+                    json += first_type ? "" : ",";
+                    append_json_string(json, type->name);
+                    json += ":[";
+                    bool first_line = true;
+                    for(auto &line : value_lines(output.to_string())) {
+                        json += first_line ? "" : ",";
+                        append_json_string(json, line);
+                        first_line = false;
+                    }
+                    json += "]";
+                    first_type = false;
+                }
+                json += "}}";
+            }
+            else {
+                json += ",\"error\":";
+                append_json_string(json, errors[m]);
+                json += "}";
+            }
+            oprintf("%s", json.c_str());
+        }
+        oflush();
+        
+        // Free the map now that we're done with it
+        queries[m].reset();
+        {
+            std::scoped_lock<std::mutex> lock(map_mutex);
+            maps_shown = m + 1;
+        }
+        map_condition.notify_all();
+    }
+    
+    for(auto &t : threads) {
+        t.join();
+    }
+    
+    if(format == InfoFormat::INFO_FORMAT_JSON) {
+        oprintf("\n]\n");
+    }
     
-    return EXIT_SUCCESS;
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
+#include <cstring>
 #include <invader/map/map.hpp>
 #include <invader/printf.hpp>
 #include <invader/file/file.hpp>
@@ -10,10 +11,10 @@
 #include "info_def.hpp"
 
 namespace Invader::Info {
-    static void print_all_indices(const Invader::Map &map, const std::vector<std::size_t> &indices) {
+    static void print_all_indices(BufferedOutput &output, const Invader::Map &map, const std::vector<std::size_t> &indices) {
         for(auto i : indices) {
             auto &tag = map.get_tag(i);
-            oprintf("%s.%s\n", File::halo_path_to_preferred_path(tag.get_path()).c_str(), HEK::tag_fourcc_to_extension(tag.get_tag_fourcc()));
+            output.print(BufferedOutput::OUTPUT_PLAIN, "%s.%s\n", File::halo_path_to_preferred_path(tag.get_path()).c_str(), HEK::tag_fourcc_to_extension(tag.get_tag_fourcc()));
         }
     }
     
@@ -318,189 +319,252 @@ namespace Invader::Info {
         return languages;
     }
     
-    void build(const Invader::Map &map) {
-        oprintf("%s\n", map.get_build());
+    MapQuery::MapQuery(std::vector<std::byte> &&file) {
+        this->file_size = file.size();
+        if(this->file_size >= sizeof(this->file_header)) {
+            std::memcpy(this->file_header, file.data(), sizeof(this->file_header));
+        }
+        this->map = std::make_unique<Map>(Map::map_with_move(std::move(file)));
+    }
+    
+    std::uint32_t MapQuery::get_crc32() {
+        if(!this->crc32.has_value()) {
+            this->crc32 = this->map->get_crc32();
+        }
+        return *this->crc32;
+    }
+    
+    const std::vector<std::string> &MapQuery::get_protection_issues() {
+        if(!this->protection_issues.has_value()) {
+            this->map->is_protected(this->protection_issues.emplace());
+        }
+        return *this->protection_issues;
+    }
+    
+    const std::vector<std::size_t> &MapQuery::find_external_tags_indices(std::optional<Map::DataMapType> data_type, bool by_index, bool by_resource, bool inverted) {
+        auto key = std::make_tuple(data_type, by_index, by_resource, inverted);
+        auto found = this->external_tags_indices.find(key);
+        if(found == this->external_tags_indices.end()) {
+            found = this->external_tags_indices.emplace(key, Info::find_external_tags_indices(*this->map, data_type, by_index, by_resource, inverted)).first;
+        }
+        return found->second;
+    }
+    
+    void MapQuery::prepare(bool crc32, bool protection) {
+        if(crc32) {
+            this->get_crc32();
+        }
+        if(protection) {
+            this->get_protection_issues();
+        }
+    }
+    
+    void build(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%s\n", map.get_build());
     }
     
-    void crc32(const Invader::Map &map) {
-        oprintf("0x%08X\n", map.get_crc32());
+    void crc32(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "0x%08X\n", query.get_crc32());
     }
-    void crc32_mismatched(const Invader::Map &map) {
-        oprintf("%i\n", map.get_crc32() != map.get_header_crc32());
+    void crc32_mismatched(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%i\n", query.get_crc32() != map.get_header_crc32());
     }
     
-    void engine(const Invader::Map &map) {
-        oprintf("%s\n", HEK::GameEngineInfo::get_game_engine_info(map.get_game_engine()).name);
+    void engine(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%s\n", HEK::GameEngineInfo::get_game_engine_info(map.get_game_engine()).name);
     }
     
-    void external_bitmap_indices_count(const Invader::Map &map) {
-        oprintf("%zu\n", find_external_tags_indices(map, Map::DataMapType::DATA_MAP_BITMAP, true, false).size());
+    void external_bitmap_indices_count(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", query.find_external_tags_indices(Map::DataMapType::DATA_MAP_BITMAP, true, false).size());
     }
-    void external_bitmaps_count(const Invader::Map &map) {
-        oprintf("%zu\n", find_external_tags_indices(map, Map::DataMapType::DATA_MAP_BITMAP, true, true).size());
+    void external_bitmaps_count(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", query.find_external_tags_indices(Map::DataMapType::DATA_MAP_BITMAP, true, true).size());
     }
     
-    void external_bitmaps(const Invader::Map &map) {
-        print_all_indices(map, find_external_tags_indices(map, Map::DataMapType::DATA_MAP_BITMAP, true, true));
+    void external_bitmaps(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        print_all_indices(output, map, query.find_external_tags_indices(Map::DataMapType::DATA_MAP_BITMAP, true, true));
     }
-    void external_sounds(const Invader::Map &map) {
-        print_all_indices(map, find_external_tags_indices(map, Map::DataMapType::DATA_MAP_SOUND, true, true));
+    void external_sounds(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        print_all_indices(output, map, query.find_external_tags_indices(Map::DataMapType::DATA_MAP_SOUND, true, true));
     }
     
-    void internal_bitmaps(const Invader::Map &map) {
-        print_all_indices(map, find_external_tags_indices(map, Map::DataMapType::DATA_MAP_BITMAP, true, true, true));
+    void internal_bitmaps(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        print_all_indices(output, map, query.find_external_tags_indices(Map::DataMapType::DATA_MAP_BITMAP, true, true, true));
     }
-    void internal_sounds(const Invader::Map &map) {
-        print_all_indices(map, find_external_tags_indices(map, Map::DataMapType::DATA_MAP_SOUND, true, true, true));
+    void internal_sounds(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        print_all_indices(output, map, query.find_external_tags_indices(Map::DataMapType::DATA_MAP_SOUND, true, true, true));
     }
-    void internal_bitmaps_count(const Invader::Map &map) {
-        oprintf("%zu\n", find_external_tags_indices(map, Map::DataMapType::DATA_MAP_BITMAP, true, true, true).size());
+    void internal_bitmaps_count(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", query.find_external_tags_indices(Map::DataMapType::DATA_MAP_BITMAP, true, true, true).size());
     }
-    void internal_sounds_count(const Invader::Map &map) {
-        oprintf("%zu\n", find_external_tags_indices(map, Map::DataMapType::DATA_MAP_SOUND, true, true, true).size());
+    void internal_sounds_count(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", query.find_external_tags_indices(Map::DataMapType::DATA_MAP_SOUND, true, true, true).size());
     }
     
-    void external_tags(const Invader::Map &map) {
-        print_all_indices(map, find_external_tags_indices(map,std::nullopt, true, true));
+    void external_tags(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        print_all_indices(output, map, query.find_external_tags_indices(std::nullopt, true, true));
     }
     
-    void external_loc_indices_count(const Invader::Map &map) {
-        oprintf("%zu\n", find_external_tags_indices(map, Map::DataMapType::DATA_MAP_LOC, true, false).size());
+    void external_loc_indices_count(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", query.find_external_tags_indices(Map::DataMapType::DATA_MAP_LOC, true, false).size());
     }
     
-    void external_sound_indices_count(const Invader::Map &map) {
-        oprintf("%zu\n", find_external_tags_indices(map, Map::DataMapType::DATA_MAP_SOUND, true, false).size());
+    void external_sound_indices_count(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", query.find_external_tags_indices(Map::DataMapType::DATA_MAP_SOUND, true, false).size());
     }
     
-    void external_sounds_count(const Invader::Map &map) {
-        oprintf("%zu\n", find_external_tags_indices(map, Map::DataMapType::DATA_MAP_SOUND, true, true).size());
+    void external_sounds_count(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", query.find_external_tags_indices(Map::DataMapType::DATA_MAP_SOUND, true, true).size());
     }
     
-    void external_tags_count(const Invader::Map &map) {
-        oprintf("%zu\n", find_external_tags_indices(map, Map::DataMapType::DATA_MAP_BITMAP, true, true).size() + find_external_tags_indices(map, Map::DataMapType::DATA_MAP_LOC, true, true).size() + find_external_tags_indices(map, Map::DataMapType::DATA_MAP_SOUND, true, true).size());
+    void external_tags_count(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", query.find_external_tags_indices(Map::DataMapType::DATA_MAP_BITMAP, true, true).size() + query.find_external_tags_indices(Map::DataMapType::DATA_MAP_LOC, true, true).size() + query.find_external_tags_indices(Map::DataMapType::DATA_MAP_SOUND, true, true).size());
     }
-    void external_indices_count(const Invader::Map &map) {
-        oprintf("%zu\n", find_external_tags_indices(map, Map::DataMapType::DATA_MAP_BITMAP, true, true).size() + find_external_tags_indices(map, Map::DataMapType::DATA_MAP_LOC, true, false).size() + find_external_tags_indices(map, Map::DataMapType::DATA_MAP_SOUND, true, false).size());
+    void external_indices_count(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", query.find_external_tags_indices(Map::DataMapType::DATA_MAP_BITMAP, true, true).size() + query.find_external_tags_indices(Map::DataMapType::DATA_MAP_LOC, true, false).size() + query.find_external_tags_indices(Map::DataMapType::DATA_MAP_SOUND, true, false).size());
     }
     
-    void external_loc_indices(const Invader::Map &map) {
-        print_all_indices(map, find_external_tags_indices(map, Map::DataMapType::DATA_MAP_LOC, true, false));
+    void external_loc_indices(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        print_all_indices(output, map, query.find_external_tags_indices(Map::DataMapType::DATA_MAP_LOC, true, false));
     }
-    void external_pointers(const Invader::Map &map) {
-        print_all_indices(map, find_external_tags_indices(map, std::nullopt, false, true));
+    void external_pointers(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        print_all_indices(output, map, query.find_external_tags_indices(std::nullopt, false, true));
     }
-    void external_bitmap_indices(const Invader::Map &map) {
-        print_all_indices(map, find_external_tags_indices(map, Map::DataMapType::DATA_MAP_BITMAP, true, false));
+    void external_bitmap_indices(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        print_all_indices(output, map, query.find_external_tags_indices(Map::DataMapType::DATA_MAP_BITMAP, true, false));
     }
-    void external_sound_indices(const Invader::Map &map) {
-        print_all_indices(map, find_external_tags_indices(map, Map::DataMapType::DATA_MAP_SOUND, true, false));
+    void external_sound_indices(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        print_all_indices(output, map, query.find_external_tags_indices(Map::DataMapType::DATA_MAP_SOUND, true, false));
     }
-    void external_indices(const Invader::Map &map) {
-        print_all_indices(map, find_external_tags_indices(map, std::nullopt, true, false));
+    void external_indices(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        print_all_indices(output, map, query.find_external_tags_indices(std::nullopt, true, false));
     }
     
-    void external_bitmap_pointers(const Invader::Map &map) {
+    void external_bitmap_pointers(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
         std::printf("A\n");
-        print_all_indices(map, find_external_tags_indices(map, Map::DataMapType::DATA_MAP_BITMAP, false, true));
+        print_all_indices(output, map, query.find_external_tags_indices(Map::DataMapType::DATA_MAP_BITMAP, false, true));
     }
-    void external_bitmap_pointers_count(const Invader::Map &map) {
-        oprintf("%zu\n", find_external_tags_indices(map, Map::DataMapType::DATA_MAP_BITMAP, false, true).size());
+    void external_bitmap_pointers_count(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", query.find_external_tags_indices(Map::DataMapType::DATA_MAP_BITMAP, false, true).size());
     }
-    void external_sound_pointers(const Invader::Map &map) {
-        print_all_indices(map, find_external_tags_indices(map, Map::DataMapType::DATA_MAP_SOUND, false, true));
+    void external_sound_pointers(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        print_all_indices(output, map, query.find_external_tags_indices(Map::DataMapType::DATA_MAP_SOUND, false, true));
     }
-    void external_sound_pointers_count(const Invader::Map &map) {
-        oprintf("%zu\n", find_external_tags_indices(map, Map::DataMapType::DATA_MAP_SOUND, false, true).size());
+    void external_sound_pointers_count(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", query.find_external_tags_indices(Map::DataMapType::DATA_MAP_SOUND, false, true).size());
     }
     
-    void languages(const Invader::Map &map) {
+    void languages(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
         bool all;
         auto languages = find_languages_for_map(map, all);
         if(all) {
-            oprintf("all\n");
+            output.print(BufferedOutput::OUTPUT_PLAIN, "all\n");
         }
         else if(languages.size() == 0) {
-            oprintf("unknown\n");
+            output.print(BufferedOutput::OUTPUT_PLAIN, "unknown\n");
         }
         else for(auto &i : languages) {
-            oprintf("%s\n", i.c_str());
+            output.print(BufferedOutput::OUTPUT_PLAIN, "%s\n", i.c_str());
         }
     }
     
-    void map_type(const Invader::Map &map) {
-        oprintf("%s\n", type_name(map.get_type()));
+    void map_type(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%s\n", type_name(map.get_type()));
     }
     
-    void is_compressed(const Invader::Map &map) {
-        oprintf("%i\n", map.get_compression_algorithm());
+    void is_compressed(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%i\n", map.get_compression_algorithm());
     }
-    void is_dirty(const Invader::Map &map) {
-        oprintf("%i\n", !map.is_clean());
+    void is_dirty(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%i\n", !query.is_clean());
     }
-    void is_protected(const Invader::Map &map) {
-        oprintf("%i\n", map.is_protected());
+    void is_protected(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%i\n", query.is_protected());
     }
     
-    void protection_issues(const Invader::Map &map) {
-        std::vector<std::string> list;
-        map.is_protected(list);
-        for(auto &i : list) {
-            oprintf("%s\n", i.c_str());
+    void protection_issues(MapQuery &query, BufferedOutput &output) {
+        for(auto &i : query.get_protection_issues()) {
+            output.print(BufferedOutput::OUTPUT_PLAIN, "%s\n", i.c_str());
         }
     }
     
-    void scenario(const Invader::Map &map) {
-        oprintf("%s\n", map.get_scenario_name());
+    void scenario(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%s\n", map.get_scenario_name());
     }
     
-    void scenario_path(const Invader::Map &map) {
-        oprintf("%s\n", File::halo_path_to_preferred_path(map.get_tag(map.get_scenario_tag_id()).get_path()).c_str());
+    void scenario_path(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%s\n", File::halo_path_to_preferred_path(map.get_tag(map.get_scenario_tag_id()).get_path()).c_str());
     }
     
-    void tags_count(const Invader::Map &map) {
-        oprintf("%zu\n", map.get_tag_count());
+    void tags_count(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", map.get_tag_count());
     }
     
-    void stub_count(const Invader::Map &map) {
-        oprintf("%zu\n", calculate_stub_count(map));
+    void stub_count(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", calculate_stub_count(map));
     }
     
-    void tags(const Invader::Map &map) {
+    void tags(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
         auto tag_count = map.get_tag_count();
         for(std::size_t i = 0; i < tag_count; i++) {
             auto &tag = map.get_tag(i);
-            oprintf("%s.%s\n", File::halo_path_to_preferred_path(tag.get_path()).c_str(), HEK::tag_fourcc_to_extension(tag.get_tag_fourcc()));
+            output.print(BufferedOutput::OUTPUT_PLAIN, "%s.%s\n", File::halo_path_to_preferred_path(tag.get_path()).c_str(), HEK::tag_fourcc_to_extension(tag.get_tag_fourcc()));
         }
     }
     
-    void uncompressed_size(const Invader::Map &map) {
-        oprintf("%zu\n", map.get_data_length());
+    void uncompressed_size(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%zu\n", map.get_data_length());
     }
     
-    void tag_order_match(const Invader::Map &map) {
+    void tag_order_match(MapQuery &query, BufferedOutput &output) {
+        auto &map = query.get_map();
         switch(check_tag_order(map)) {
             case CHECK_TAG_ORDER_RESULT_UNKNOWN:
-                oprintf("unknown\n");
+                output.print(BufferedOutput::OUTPUT_PLAIN, "unknown\n");
                 break;
             case CHECK_TAG_ORDER_RESULT_MISMATCHED_TAGS:
-                oprintf("mismatched\n");
+                output.print(BufferedOutput::OUTPUT_PLAIN, "mismatched\n");
                 break;
             case CHECK_TAG_ORDER_RESULT_NETWORK_MATCHED_AS_CLIENT:
-                oprintf("client-only\n");
+                output.print(BufferedOutput::OUTPUT_PLAIN, "client-only\n");
                 break;
             case CHECK_TAG_ORDER_RESULT_NETWORK_MATCHED_AS_HOST:
-                oprintf("host-only\n");
+                output.print(BufferedOutput::OUTPUT_PLAIN, "host-only\n");
                 break;
             case CHECK_TAG_ORDER_RESULT_NETWORK_MATCHED:
-                oprintf("network-matched\n");
+                output.print(BufferedOutput::OUTPUT_PLAIN, "network-matched\n");
                 break;
             case CHECK_TAG_ORDER_RESULT_MATCHED:
-                oprintf("matched\n");
+                output.print(BufferedOutput::OUTPUT_PLAIN, "matched\n");
                 break;
         }
     }
     
-    void uses_external_pointers(const Invader::Map &map) {
-        oprintf("%i\n", !find_external_tags_indices(map, std::nullopt, false, true).empty());
+    void uses_external_pointers(MapQuery &query, BufferedOutput &output) {
+        output.print(BufferedOutput::OUTPUT_PLAIN, "%i\n", !query.find_external_tags_indices(std::nullopt, false, true).empty());
     }
 }
@@ -5,12 +5,100 @@
 
 #include <vector>
 #include <optional>
-
-namespace Invader {
-    class Map;
-}
+#include <memory>
+#include <map>
+#include <tuple>
+#include <invader/map/map.hpp>
+#include <invader/hek/map.hpp>
+#include <invader/printf.hpp>
 
 namespace Invader::Info {
+    /**
+     * Loaded map and the results of any expensive checks done on it so far, so several queries on the same map only
+     * need to load it and check it once
+     */
+    class MapQuery {
+    public:
+        /**
+         * Load the map
+         * @param file map file data
+         * @throws     if the map fails to be parsed
+         */
+        MapQuery(std::vector<std::byte> &&file);
+        
+        /**
+         * Get the map
+         * @return map
+         */
+        const Invader::Map &get_map() const noexcept {
+            return *this->map;
+        }
+        
+        /**
+         * Get the size of the map file (before decompression)
+         * @return file size
+         */
+        std::size_t get_file_size() const noexcept {
+            return this->file_size;
+        }
+        
+        /**
+         * Get the map file's header as it was on disk (before decompression)
+         * @return header
+         */
+        const std::byte *get_file_header() const noexcept {
+            return this->file_header;
+        }
+        
+        /**
+         * Get the map's CRC32, calculating it if it hasn't been calculated yet
+         * @return crc32
+         */
+        std::uint32_t get_crc32();
+        
+        /**
+         * Get the reasons the map is protected, checking it if it hasn't been checked yet
+         * @return reasons (empty if not protected)
+         */
+        const std::vector<std::string> &get_protection_issues();
+        
+        /**
+         * Get whether or not the map is protected
+         * @return true if protected
+         */
+        bool is_protected() {
+            return !this->get_protection_issues().empty();
+        }
+        
+        /**
+         * Get whether or not the map is clean
+         * @return true if clean
+         */
+        bool is_clean() {
+            return this->map->is_clean(this->get_crc32(), this->is_protected());
+        }
+        
+        /**
+         * Find external tags (see find_external_tags_indices), reusing the result if it was already found
+         */
+        const std::vector<std::size_t> &find_external_tags_indices(std::optional<Map::DataMapType> data_type, bool by_index, bool by_resource, bool inverted = false);
+        
+        /**
+         * Do expensive checks ahead of time (e.g. on another thread) so queries that need them are fast
+         * @param crc32      calculate the CRC32
+         * @param protection check for protection
+         */
+        void prepare(bool crc32, bool protection);
+        
+    private:
+        std::unique_ptr<Invader::Map> map;
+        std::size_t file_size = 0;
+        std::byte file_header[sizeof(HEK::NativeCacheFileHeader)] = {};
+        std::optional<std::uint32_t> crc32;
+        std::optional<std::vector<std::string>> protection_issues;
+        std::map<std::tuple<std::optional<Map::DataMapType>, bool, bool, bool>, std::vector<std::size_t>> external_tags_indices;
+    };
+    
     /**
      * Check if the indices are valid for stock Halo Custom Edition
      * @param map map to check
@@ -71,47 +159,47 @@ namespace Invader::Info {
      */
     CheckTagOrderResult check_tag_order(const Invader::Map &map);
     
-    void overview(const Invader::Map &);
-    void build(const Invader::Map &);
-    void crc32(const Invader::Map &);
-    void crc32_mismatched(const Invader::Map &);
-    void engine(const Invader::Map &);
-    void external_bitmap_indices(const Invader::Map &);
-    void external_bitmap_indices_count(const Invader::Map &);
-    void external_bitmap_pointers(const Invader::Map &);
-    void external_bitmap_pointers_count(const Invader::Map &);
-    void external_bitmaps(const Invader::Map &);
-    void external_bitmaps_count(const Invader::Map &);
-    void external_indices(const Invader::Map &);
-    void external_indices_count(const Invader::Map &);
-    void external_loc_indices(const Invader::Map &);
-    void external_loc_indices_count(const Invader::Map &);
-    void external_sound_indices(const Invader::Map &);
-    void external_sound_indices_count(const Invader::Map &);
-    void external_sound_pointers(const Invader::Map &);
-    void external_sound_pointers_count(const Invader::Map &);
-    void external_sounds(const Invader::Map &);
-    void external_sounds_count(const Invader::Map &);
-    void external_tags(const Invader::Map &);
-    void external_tags_count(const Invader::Map &);
-    void internal_bitmaps(const Invader::Map &);
-    void internal_bitmaps_count(const Invader::Map &);
-    void internal_sounds(const Invader::Map &);
-    void internal_sounds_count(const Invader::Map &);
-    void is_compressed(const Invader::Map &);
-    void is_dirty(const Invader::Map &);
-    void is_protected(const Invader::Map &);
-    void languages(const Invader::Map &);
-    void map_type(const Invader::Map &);
-    void protection_issues(const Invader::Map &);
-    void scenario(const Invader::Map &);
-    void scenario_path(const Invader::Map &);
-    void stub_count(const Invader::Map &);
-    void tags(const Invader::Map &);
-    void tags_count(const Invader::Map &);
-    void tag_order_match(const Invader::Map &);
-    void uncompressed_size(const Invader::Map &);
-    void uses_external_pointers(const Invader::Map &);
+    void overview(MapQuery &, BufferedOutput &);
+    void build(MapQuery &, BufferedOutput &);
+    void crc32(MapQuery &, BufferedOutput &);
+    void crc32_mismatched(MapQuery &, BufferedOutput &);
+    void engine(MapQuery &, BufferedOutput &);
+    void external_bitmap_indices(MapQuery &, BufferedOutput &);
+    void external_bitmap_indices_count(MapQuery &, BufferedOutput &);
+    void external_bitmap_pointers(MapQuery &, BufferedOutput &);
+    void external_bitmap_pointers_count(MapQuery &, BufferedOutput &);
+    void external_bitmaps(MapQuery &, BufferedOutput &);
+    void external_bitmaps_count(MapQuery &, BufferedOutput &);
+    void external_indices(MapQuery &, BufferedOutput &);
+    void external_indices_count(MapQuery &, BufferedOutput &);
+    void external_loc_indices(MapQuery &, BufferedOutput &);
+    void external_loc_indices_count(MapQuery &, BufferedOutput &);
+    void external_sound_indices(MapQuery &, BufferedOutput &);
+    void external_sound_indices_count(MapQuery &, BufferedOutput &);
+    void external_sound_pointers(MapQuery &, BufferedOutput &);
+    void external_sound_pointers_count(MapQuery &, BufferedOutput &);
+    void external_sounds(MapQuery &, BufferedOutput &);
+    void external_sounds_count(MapQuery &, BufferedOutput &);
+    void external_tags(MapQuery &, BufferedOutput &);
+    void external_tags_count(MapQuery &, BufferedOutput &);
+    void internal_bitmaps(MapQuery &, BufferedOutput &);
+    void internal_bitmaps_count(MapQuery &, BufferedOutput &);
+    void internal_sounds(MapQuery &, BufferedOutput &);
+    void internal_sounds_count(MapQuery &, BufferedOutput &);
+    void is_compressed(MapQuery &, BufferedOutput &);
+    void is_dirty(MapQuery &, BufferedOutput &);
+    void is_protected(MapQuery &, BufferedOutput &);
+    void languages(MapQuery &, BufferedOutput &);
+    void map_type(MapQuery &, BufferedOutput &);
+    void protection_issues(MapQuery &, BufferedOutput &);
+    void scenario(MapQuery &, BufferedOutput &);
+    void scenario_path(MapQuery &, BufferedOutput &);
+    void stub_count(MapQuery &, BufferedOutput &);
+    void tags(MapQuery &, BufferedOutput &);
+    void tags_count(MapQuery &, BufferedOutput &);
+    void tag_order_match(MapQuery &, BufferedOutput &);
+    void uncompressed_size(MapQuery &, BufferedOutput &);
+    void uses_external_pointers(MapQuery &, BufferedOutput &);
 }
 
 #endif
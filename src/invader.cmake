@@ -60,12 +60,16 @@ set(INVADER_SOURCE_FILES
     src/error.cpp
     src/hek/fourcc.cpp
     src/hek/data_type.cpp
+    src/hek/endian.cpp
     src/hek/map.cpp
     src/resource/resource_map.cpp
     src/dependency/found_tag_dependency.cpp
+    src/dependency/tag_dependency_closure.cpp
+    src/dependency/tag_dependency_index.cpp
     src/map/map.cpp
     src/map/tag.cpp
     src/file/file.cpp
+    src/build/build_profiler.cpp
     src/build/build_workload.cpp
     src/build/build_workload_dedupe.cpp
     src/bitmap/bcdec/bcdec.c
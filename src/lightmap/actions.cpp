@@ -1,4 +1,5 @@
 #include "actions.hpp"
+#include "mesh_format.hpp"
 
 #include <invader/file/file.hpp>
 #include <invader/build/build_workload.hpp>
@@ -6,11 +7,15 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <charconv>
+#include <deque>
+#include <string_view>
 #include <map>
 
 using namespace Invader;
 
-static constexpr const std::size_t MESH_FORMAT_VERSION = 1;
+static constexpr const std::size_t MESH_FORMAT_VERSION = Lightmap::MeshFormat::MESH_VERSION;
 
 struct ExportedVertex {
     float x, y, z;
@@ -77,14 +82,13 @@ struct ExportedObject {
     float roll;
 };
 
-static std::size_t add_shader_to_materials(const Tag &tag, std::vector<ExportedMaterial> &materials) {
+static std::size_t add_shader_to_materials(const Tag &tag, std::vector<ExportedMaterial> &materials, std::map<std::string, std::size_t> &material_indices) {
     auto fourcc = tag.get_tag_fourcc();
     auto full_path = tag.get_path() + "." + HEK::tag_fourcc_to_extension(fourcc);
     auto mat_count = materials.size();
-    for(std::size_t m = 0; m < mat_count; m++) {
-        if(materials[m].path == full_path) {
-            return m;
-        }
+    auto [existing, added] = material_indices.try_emplace(full_path, mat_count);
+    if(!added) {
+        return existing->second;
     }
     
     // Get the shader of fun
@@ -107,7 +111,7 @@ static std::size_t add_shader_to_materials(const Tag &tag, std::vector<ExportedM
     return mat_count;
 }
 
-static ExportedModel read_bsp(const Tag &tag, std::vector<ExportedMaterial> &materials_arr, std::vector<ExportedSky> &skies_arr) {
+static ExportedModel read_bsp(const Tag &tag, std::vector<ExportedMaterial> &materials_arr, std::map<std::string, std::size_t> &material_indices, std::vector<ExportedSky> &skies_arr) {
     ExportedModel exported_model;
     exported_model.path = tag.get_path() + "." + HEK::tag_fourcc_to_extension(tag.get_tag_fourcc());
     
@@ -133,7 +137,7 @@ static ExportedModel read_bsp(const Tag &tag, std::vector<ExportedMaterial> &mat
             std::size_t rendered_vertices_count = material.rendered_vertices_count;
             const Parser::ScenarioStructureBSPMaterialUncompressedRenderedVertex::struct_little *uncompressed_vertices = reinterpret_cast<const Parser::ScenarioStructureBSPMaterialUncompressedRenderedVertex::struct_little *>(tag.data(material.uncompressed_vertices.pointer, sizeof(*uncompressed_vertices) * rendered_vertices_count));
             
-            std::size_t material_index = add_shader_to_materials(map.get_tag(material.shader.tag_id.read().index), materials_arr);
+            std::size_t material_index = add_shader_to_materials(map.get_tag(material.shader.tag_id.read().index), materials_arr, material_indices);
             std::size_t offset = exported_model.vertices.size();
             for(std::size_t v = 0; v < rendered_vertices_count; v++) {
                 auto &vertex = exported_model.vertices.emplace_back();
@@ -220,7 +224,7 @@ static ExportedModel read_bsp(const Tag &tag, std::vector<ExportedMaterial> &mat
     return exported_model;
 }
 
-template<typename GeometryStruct, typename PartStruct, typename ModelStruct> static ExportedModel read_model(const Tag &tag, const ModelStruct &base_struct, std::vector<ExportedMaterial> &materials) {
+template<typename GeometryStruct, typename PartStruct, typename ModelStruct> static ExportedModel read_model(const Tag &tag, const ModelStruct &base_struct, std::vector<ExportedMaterial> &materials, std::map<std::string, std::size_t> &material_indices) {
     ExportedModel exported_model;
     exported_model.path = tag.get_path() + "." + HEK::tag_fourcc_to_extension(tag.get_tag_fourcc());
     
@@ -233,7 +237,7 @@ template<typename GeometryStruct, typename PartStruct, typename ModelStruct> sta
     
     std::map<std::size_t, std::size_t> material_map; // map local shader A to material B
     for(std::size_t s = 0; s < shader_count; s++) {
-        material_map[s] = add_shader_to_materials(tag.get_map().get_tag(shaders[s].shader.tag_id.read().index), materials);
+        material_map[s] = add_shader_to_materials(tag.get_map().get_tag(shaders[s].shader.tag_id.read().index), materials, material_indices);
     }
     
     // Hold geometry information
@@ -323,7 +327,217 @@ template<typename GeometryStruct, typename PartStruct, typename ModelStruct> sta
     return exported_model;
 }
 
-std::string Invader::Lightmap::export_lightmap_mesh(const char *scenario, const char *bsp_name, const std::vector<std::filesystem::path> &tags_directories) {
+static std::vector<std::byte> write_text_mesh(const std::vector<ExportedSky> &skies, const std::vector<ExportedMaterial> &materials, const std::vector<ExportedModel> &bsps, const std::vector<ExportedModel> &models, const std::vector<ExportedObject> &objects) {
+    std::string str;
+    
+#define ADD_LINE(...) (str += __VA_ARGS__) += '\n'
+    
+    auto float_to_str = [](const auto &f) -> std::string {
+        std::string fstr = std::to_string(f);
+        
+        while(fstr[fstr.size() - 1] == '0') {
+            fstr.resize(fstr.size() - 1);
+        }
+        if(fstr[fstr.size() - 1] == '.') {
+            fstr.resize(fstr.size() - 1);
+        }
+        
+        return fstr;
+    };
+    
+    // Put the version in it
+    ADD_LINE("version " + std::to_string(MESH_FORMAT_VERSION) + " unbaked");
+    
+    // Add skies
+    for(auto &s : skies) {
+        ADD_LINE(std::string("sky \"") + s.path + "\" " + float_to_str(s.outdoor_power) + " " + float_to_str(s.outdoor_red) + " " + float_to_str(s.outdoor_green) + " " + float_to_str(s.outdoor_blue) + " {");
+        for(auto &l : s.lights) {
+            ADD_LINE(std::string(" light ") + float_to_str(l.power) + " " + float_to_str(l.red) + " " + float_to_str(l.green) + " " + float_to_str(l.blue) + " " + float_to_str(l.yaw) + " " + float_to_str(l.pitch));
+        }
+        ADD_LINE("}");
+    }
+    
+    // Add materials
+    for(auto &mat : materials) {
+        ADD_LINE(std::string("material \"") + mat.path + "\" " + ExportedMaterialTypeStr[mat.type] + " " + float_to_str(mat.power) + " rgb " + float_to_str(mat.emission_red) + " " + float_to_str(mat.emission_green) + " " + float_to_str(mat.emission_blue)); // todo: add image sampling (base64 of pixel data maybe - `image <base64>` vs `rgb <red> <green> <blue>`)
+    }
+    
+    // Add models
+    auto write_model = [&str, &float_to_str](auto &m) {
+        ADD_LINE(std::string(m.lightmaps.size() ? "scenario_structure_bsp" : "model") + " \"" + m.path + "\" {");
+        for(auto &v : m.vertices) {
+            ADD_LINE(std::string(" vertex ") + float_to_str(v.x) + " " + float_to_str(v.y) + " " + float_to_str(v.z));
+        }
+        for(auto &t : m.triangles) {
+            ADD_LINE(std::string(" triangle ") + std::to_string(t.a) + " " + std::to_string(t.b) + " " + std::to_string(t.c) + " " + std::to_string(t.material));
+        }
+        for(auto &l : m.lightmaps) {
+            ADD_LINE(std::string(" lightmap ") + std::to_string(l.first_triangle_index) + " " + std::to_string(l.triangle_count));
+        }
+        ADD_LINE("}");
+    };
+    
+    for(auto &m : bsps) {
+        write_model(m);
+    }
+    
+    for(auto &m : models) {
+        write_model(m);
+    }
+    
+    // Add objects
+    for(auto &o : objects) {
+        ADD_LINE(std::string("object ") + std::to_string(o.model) + " " + float_to_str(o.x) + " " + float_to_str(o.y) + " " + float_to_str(o.z) + " " + float_to_str(o.yaw) + " " + float_to_str(o.pitch) + " " + float_to_str(o.roll));
+    }
+    
+#undef ADD_LINE
+    
+    auto *data = reinterpret_cast<const std::byte *>(str.data());
+    return std::vector<std::byte>(data, data + str.size());
+}
+
+static std::vector<std::byte> write_binary_mesh(const std::vector<ExportedSky> &skies, const std::vector<ExportedMaterial> &materials, const std::vector<ExportedModel> &bsps, const std::vector<ExportedModel> &models, const std::vector<ExportedObject> &objects) {
+    using namespace Lightmap::MeshFormat;
+    
+    std::vector<MeshSky> mesh_skies;
+    std::vector<MeshSkyLight> mesh_sky_lights;
+    std::vector<MeshMaterial> mesh_materials;
+    std::vector<MeshModel> mesh_models;
+    std::vector<MeshVertex> mesh_vertices;
+    std::vector<MeshTriangle> mesh_triangles;
+    std::vector<MeshLightmap> mesh_lightmaps;
+    std::vector<MeshObject> mesh_objects;
+    std::string strings;
+    
+    auto add_string = [&strings](const std::string &string) -> std::uint32_t {
+        auto offset = static_cast<std::uint32_t>(strings.size());
+        strings.append(string.c_str(), string.size() + 1);
+        return offset;
+    };
+    
+    // Add skies
+    for(auto &s : skies) {
+        auto &sky = mesh_skies.emplace_back();
+        sky.path = add_string(s.path);
+        sky.outdoor_power = s.outdoor_power;
+        sky.outdoor_red = s.outdoor_red;
+        sky.outdoor_green = s.outdoor_green;
+        sky.outdoor_blue = s.outdoor_blue;
+        sky.first_light = static_cast<std::uint32_t>(mesh_sky_lights.size());
+        sky.light_count = static_cast<std::uint32_t>(s.lights.size());
+        for(auto &l : s.lights) {
+            auto &light = mesh_sky_lights.emplace_back();
+            light.power = l.power;
+            light.red = l.red;
+            light.green = l.green;
+            light.blue = l.blue;
+            light.yaw = l.yaw;
+            light.pitch = l.pitch;
+        }
+    }
+    
+    // Add materials
+    for(auto &mat : materials) {
+        auto &material = mesh_materials.emplace_back();
+        material.path = add_string(mat.path);
+        material.type = mat.type == ExportedMaterialType::EXPORTED_MATERIAL_TYPE_OPAQUE ? MeshMaterialType::MESH_MATERIAL_TYPE_OPAQUE : MeshMaterialType::MESH_MATERIAL_TYPE_INVISIBLE;
+        material.power = mat.power;
+        material.emission_red = mat.emission_red;
+        material.emission_green = mat.emission_green;
+        material.emission_blue = mat.emission_blue;
+    }
+    
+    // Add models
+    auto write_model = [&](const ExportedModel &m) {
+        auto &model = mesh_models.emplace_back();
+        model.path = add_string(m.path);
+        model.flags = m.lightmaps.size() ? MeshModelFlags::MESH_MODEL_FLAGS_SCENARIO_STRUCTURE_BSP : static_cast<MeshModelFlags>(0);
+        model.first_vertex = static_cast<std::uint32_t>(mesh_vertices.size());
+        model.vertex_count = static_cast<std::uint32_t>(m.vertices.size());
+        model.first_triangle = static_cast<std::uint32_t>(mesh_triangles.size());
+        model.triangle_count = static_cast<std::uint32_t>(m.triangles.size());
+        model.first_lightmap = static_cast<std::uint32_t>(mesh_lightmaps.size());
+        model.lightmap_count = static_cast<std::uint32_t>(m.lightmaps.size());
+        
+        for(auto &v : m.vertices) {
+            auto &vertex = mesh_vertices.emplace_back();
+            vertex.x = v.x;
+            vertex.y = v.y;
+            vertex.z = v.z;
+        }
+        for(auto &t : m.triangles) {
+            auto &triangle = mesh_triangles.emplace_back();
+            triangle.a = static_cast<std::uint32_t>(t.a);
+            triangle.b = static_cast<std::uint32_t>(t.b);
+            triangle.c = static_cast<std::uint32_t>(t.c);
+            triangle.material = static_cast<std::uint32_t>(t.material);
+        }
+        for(auto &l : m.lightmaps) {
+            auto &lightmap = mesh_lightmaps.emplace_back();
+            lightmap.first_triangle = static_cast<std::uint32_t>(l.first_triangle_index);
+            lightmap.triangle_count = static_cast<std::uint32_t>(l.triangle_count);
+            lightmap.image_filename = NULL_STRING;
+        }
+    };
+    
+    for(auto &m : bsps) {
+        write_model(m);
+    }
+    
+    for(auto &m : models) {
+        write_model(m);
+    }
+    
+    // Add objects (unlike the text format, the model index includes the BSPs since they're in the same array)
+    for(auto &o : objects) {
+        auto &object = mesh_objects.emplace_back();
+        object.model = static_cast<std::uint32_t>(bsps.size() + o.model);
+        object.x = o.x;
+        object.y = o.y;
+        object.z = o.z;
+        object.yaw = o.yaw;
+        object.pitch = o.pitch;
+        object.roll = o.roll;
+    }
+    
+    // Lay it all out
+    std::vector<std::byte> output(sizeof(MeshHeader));
+    auto append_array = [&output](MeshArray &array, const auto &elements) {
+        array.offset = static_cast<std::uint32_t>(output.size());
+        array.count = static_cast<std::uint32_t>(elements.size());
+        const auto *data = reinterpret_cast<const std::byte *>(elements.data());
+        output.insert(output.end(), data, data + elements.size() * sizeof(elements[0]));
+    };
+    
+    MeshHeader header = {};
+    header.magic = MESH_MAGIC;
+    header.version = MESH_VERSION;
+    header.flags = static_cast<MeshFlags>(0);
+    append_array(header.skies, mesh_skies);
+    append_array(header.sky_lights, mesh_sky_lights);
+    append_array(header.materials, mesh_materials);
+    append_array(header.models, mesh_models);
+    append_array(header.vertices, mesh_vertices);
+    append_array(header.triangles, mesh_triangles);
+    append_array(header.lightmaps, mesh_lightmaps);
+    append_array(header.objects, mesh_objects);
+    header.uvs.offset = static_cast<std::uint32_t>(output.size());
+    
+    header.strings_offset = static_cast<std::uint32_t>(output.size());
+    header.strings_size = static_cast<std::uint32_t>(strings.size());
+    const auto *strings_data = reinterpret_cast<const std::byte *>(strings.data());
+    output.insert(output.end(), strings_data, strings_data + strings.size());
+    
+    if(output.size() > UINT32_MAX) {
+        eprintf_error("Mesh exceeds the maximum size of the binary format");
+        std::exit(EXIT_FAILURE);
+    }
+    
+    std::memcpy(output.data(), &header, sizeof(header));
+    return output;
+}
+
+std::vector<std::byte> Invader::Lightmap::export_lightmap_mesh(const char *scenario, const char *bsp_name, const std::vector<std::filesystem::path> &tags_directories, bool binary) {
     BuildWorkload::BuildParameters parameters;
     parameters.verbosity = BuildWorkload::BuildParameters::BuildVerbosity::BUILD_VERBOSITY_QUIET;
     parameters.tags_directories = tags_directories;
@@ -331,15 +545,13 @@ std::string Invader::Lightmap::export_lightmap_mesh(const char *scenario, const
     parameters.scenario = scenario;
     parameters.details.build_compress = false;
     
-    std::vector<std::string> lines;
     std::vector<ExportedMaterial> materials;
+    std::map<std::string, std::size_t> material_indices;
     std::vector<ExportedModel> models;
     std::vector<ExportedModel> bsps;
     std::vector<ExportedObject> objects;
     std::vector<ExportedSky> skies;
     
-#define ADD_LINE(...) lines.emplace_back(__VA_ARGS__)
-    
     try {
         auto map = Map::map_with_move(BuildWorkload::compile_map(parameters));
         auto &scenario_tag = map.get_tag(map.get_scenario_tag_id());
@@ -367,7 +579,7 @@ std::string Invader::Lightmap::export_lightmap_mesh(const char *scenario, const
             // Do it
             if(std::strcmp(bsp_tag_name, bsp_name) == 0) {
                 bsp_index = b;
-                bsps.emplace_back(read_bsp(bsp_tag, materials, skies)); // add the BSP
+                bsps.emplace_back(read_bsp(bsp_tag, materials, material_indices, skies)); // add the BSP
                 break;
             }
         }
@@ -421,10 +633,10 @@ std::string Invader::Lightmap::export_lightmap_mesh(const char *scenario, const
                         
                         switch(model_tag.get_tag_fourcc()) {
                             case HEK::TagFourCC::TAG_FOURCC_GBXMODEL:
-                                models.emplace_back(read_model<Parser::GBXModelGeometry::struct_little, Parser::GBXModelGeometryPart::struct_little>(model_tag, model_tag.get_base_struct<HEK::GBXModel>(), materials));
+                                models.emplace_back(read_model<Parser::GBXModelGeometry::struct_little, Parser::GBXModelGeometryPart::struct_little>(model_tag, model_tag.get_base_struct<HEK::GBXModel>(), materials, material_indices));
                                 break;
                             case HEK::TagFourCC::TAG_FOURCC_MODEL:
-                                models.emplace_back(read_model<Parser::ModelGeometry::struct_little, Parser::ModelGeometryPart::struct_little>(model_tag, model_tag.get_base_struct<HEK::Model>(), materials));
+                                models.emplace_back(read_model<Parser::ModelGeometry::struct_little, Parser::ModelGeometryPart::struct_little>(model_tag, model_tag.get_base_struct<HEK::Model>(), materials, material_indices));
                                 break;
                             default:
                                 std::fprintf(stderr, "Unknown model fourcc");
@@ -450,78 +662,18 @@ std::string Invader::Lightmap::export_lightmap_mesh(const char *scenario, const
         std::exit(EXIT_FAILURE);
     }
     
-    auto float_to_str = [](const auto &f) -> std::string {
-        std::string fstr = std::to_string(f);
-        
-        while(fstr[fstr.size() - 1] == '0') {
-            fstr.resize(fstr.size() - 1);
-        }
-        if(fstr[fstr.size() - 1] == '.') {
-            fstr.resize(fstr.size() - 1);
-        }
-        
-        return fstr;
-    };
-    
-    // Put the version in it
-    ADD_LINE("version 1 unbaked");
-    
     // Check skies
     if(skies.size() > 1) {
         eprintf_error("Only 1 sky per BSP is currently allowed maximum for this operation");
         std::exit(EXIT_FAILURE);
     }
     
-    // Add skies
-    for(auto &s : skies) {
-        ADD_LINE(std::string("sky \"") + s.path + "\" " + float_to_str(s.outdoor_power) + " " + float_to_str(s.outdoor_red) + " " + float_to_str(s.outdoor_green) + " " + float_to_str(s.outdoor_blue) + " {");
-        for(auto &l : s.lights) {
-            ADD_LINE(std::string(" light ") + float_to_str(l.power) + " " + float_to_str(l.red) + " " + float_to_str(l.green) + " " + float_to_str(l.blue) + " " + float_to_str(l.yaw) + " " + float_to_str(l.pitch));
-        }
-        ADD_LINE("}");
+    if(binary) {
+        return write_binary_mesh(skies, materials, bsps, models, objects);
     }
-    
-    // Add materials
-    for(auto &mat : materials) {
-        ADD_LINE(std::string("material \"") + mat.path + "\" " + ExportedMaterialTypeStr[mat.type] + " " + float_to_str(mat.power) + " rgb " + float_to_str(mat.emission_red) + " " + float_to_str(mat.emission_green) + " " + float_to_str(mat.emission_blue)); // todo: add image sampling (base64 of pixel data maybe - `image <base64>` vs `rgb <red> <green> <blue>`)
+    else {
+        return write_text_mesh(skies, materials, bsps, models, objects);
     }
-    
-    // Add models
-    auto write_model = [&lines, &float_to_str](auto &m) {
-        ADD_LINE(std::string(m.lightmaps.size() ? "scenario_structure_bsp" : "model") + " \"" + m.path + "\" {");
-        for(auto &v : m.vertices) {
-            ADD_LINE(std::string(" vertex ") + float_to_str(v.x) + " " + float_to_str(v.y) + " " + float_to_str(v.z));
-        }
-        for(auto &t : m.triangles) {
-            ADD_LINE(std::string(" triangle ") + std::to_string(t.a) + " " + std::to_string(t.b) + " " + std::to_string(t.c) + " " + std::to_string(t.material));
-        }
-        for(auto &l : m.lightmaps) {
-            ADD_LINE(std::string(" lightmap ") + std::to_string(l.first_triangle_index) + " " + std::to_string(l.triangle_count));
-        }
-        ADD_LINE("}");
-    };
-    
-    for(auto &m : bsps) {
-        write_model(m);
-    }
-    
-    for(auto &m : models) {
-        write_model(m);
-    }
-    
-    // Add objects
-    for(auto &o : objects) {
-        ADD_LINE(std::string("object ") + std::to_string(o.model) + " " + float_to_str(o.x) + " " + float_to_str(o.y) + " " + float_to_str(o.z) + " " + float_to_str(o.yaw) + " " + float_to_str(o.pitch) + " " + float_to_str(o.roll));
-    }
-    
-#undef ADD_LINE
-
-    // Concatenate into a string
-    std::string str;
-    for(auto &l : lines) {
-        str += std::move(l) + "\n";
-    }
-    return str;
 }
 
 struct ImportedBSPVertex {
@@ -544,14 +696,33 @@ struct ImportedBSP {
     std::vector<ImportedBSPLightmap> lightmaps;
 };
     
-void Invader::Lightmap::import_lightmap_mesh(const std::string &mesh_data, const std::filesystem::path &mesh_path, const char *scenario, const char *bsp_name, const std::vector<std::filesystem::path> &tags_directories) {
-    auto size = mesh_data.size();
-    auto *data = mesh_data.data();
+struct ImportedMesh {
+    std::optional<std::size_t> format_length, format_bpp;
+    std::vector<ImportedBSP> bsps;
+};
+
+template <typename T> static T token_to_number(const std::optional<std::string_view> &token) {
+    if(!token.has_value()) {
+        throw std::exception();
+    }
+    
+    T value;
+    auto *token_end = token->data() + token->size();
+    auto result = std::from_chars(token->data(), token_end, value);
+    if(result.ec != std::errc() || result.ptr != token_end) {
+        throw std::exception();
+    }
+    return value;
+}
+
+static ImportedMesh parse_text_mesh(const char *data, std::size_t size, const std::filesystem::path &mesh_path) {
     auto *data_end = data + size;
     
     const char *token_start = nullptr;
-    std::vector<std::string> tokens;
+    std::vector<std::string_view> tokens;
+    std::deque<std::string> unquoted_tokens; // tokens with quotes removed (a deque so views of these stay valid)
     bool in_quote = false;
+    bool has_quote = false;
     
     // Split whitespace
     for(const char *a = data; a < data_end; a++) {
@@ -561,17 +732,22 @@ void Invader::Lightmap::import_lightmap_mesh(const std::string &mesh_data, const
                 continue;
             }
             else {
-                auto &str = tokens.emplace_back(token_start, a);
-                
                 // Remove quotes from string
-                for(std::size_t t = 0; t < str.size(); t++) {
-                    if(str[t] == '"') {
-                        str.erase(str.begin() + t);
-                        t--;
+                if(has_quote) {
+                    auto &str = unquoted_tokens.emplace_back();
+                    for(const char *c = token_start; c < a; c++) {
+                        if(*c != '"') {
+                            str += *c;
+                        }
                     }
+                    tokens.emplace_back(str);
+                }
+                else {
+                    tokens.emplace_back(token_start, a - token_start);
                 }
                 
                 token_start = nullptr;
+                has_quote = false;
                 continue;
             }
         }
@@ -582,6 +758,7 @@ void Invader::Lightmap::import_lightmap_mesh(const std::string &mesh_data, const
         
         if(*a == '"') {
             in_quote = !in_quote;
+            has_quote = true;
         }
     }
     
@@ -602,7 +779,7 @@ void Invader::Lightmap::import_lightmap_mesh(const std::string &mesh_data, const
     }
     
     std::size_t next_token = 0;
-    auto extract_next_token = [&next_token, &tokens]() -> std::optional<std::string> {
+    auto extract_next_token = [&next_token, &tokens]() -> std::optional<std::string_view> {
         if(next_token == tokens.size()) {
             return std::nullopt;
         }
@@ -626,21 +803,23 @@ void Invader::Lightmap::import_lightmap_mesh(const std::string &mesh_data, const
     }
     
     // Hold the format here
-    std::optional<std::size_t> format_length, format_bpp;
-    std::vector<ImportedBSP> bsps;
+    ImportedMesh mesh;
+    auto &format_length = mesh.format_length;
+    auto &format_bpp = mesh.format_bpp;
+    auto &bsps = mesh.bsps;
     
     while(true) {
         auto command_maybe = extract_next_token();
         if(!command_maybe.has_value()) {
             break; // done
         }
-        auto &command = *command_maybe;
+        auto command = std::string(*command_maybe);
         
         // Format
         if(command == "format") {
             try {
-                format_length = std::stoul(extract_next_token().value());
-                format_bpp = std::stoul(extract_next_token().value());
+                format_length = token_to_number<std::size_t>(extract_next_token());
+                format_bpp = token_to_number<std::size_t>(extract_next_token());
             }
             catch(...) {
                 eprintf_error("Invalid format specified.");
@@ -671,7 +850,9 @@ void Invader::Lightmap::import_lightmap_mesh(const std::string &mesh_data, const
                     }
                     else if(subcommand == "vertex") {
                         try {
-                            bsp.vertices.emplace_back() = { std::stof(extract_next_token().value()), std::stof(extract_next_token().value()) };
+                            auto u = token_to_number<float>(extract_next_token());
+                            auto v = token_to_number<float>(extract_next_token());
+                            bsp.vertices.emplace_back() = { u, v };
                         }
                         catch(...) {
                             eprintf_error("Invalid vertex specified.");
@@ -680,7 +861,10 @@ void Invader::Lightmap::import_lightmap_mesh(const std::string &mesh_data, const
                     }
                     else if(subcommand == "triangle") {
                         try {
-                            bsp.triangles.emplace_back() = { std::stoul(extract_next_token().value()), std::stoul(extract_next_token().value()), std::stoul(extract_next_token().value()) };
+                            auto a = token_to_number<std::size_t>(extract_next_token());
+                            auto b = token_to_number<std::size_t>(extract_next_token());
+                            auto c = token_to_number<std::size_t>(extract_next_token());
+                            bsp.triangles.emplace_back() = { a, b, c };
                         }
                         catch(...) {
                             eprintf_error("Invalid triangle specified.");
@@ -689,7 +873,9 @@ void Invader::Lightmap::import_lightmap_mesh(const std::string &mesh_data, const
                     }
                     else if(subcommand == "lightmap") {
                         try {
-                            bsp.lightmaps.emplace_back() = { std::stoul(extract_next_token().value()), std::stoul(extract_next_token().value()), extract_next_token().value() };
+                            auto first_triangle = token_to_number<std::size_t>(extract_next_token());
+                            auto triangle_count = token_to_number<std::size_t>(extract_next_token());
+                            bsp.lightmaps.emplace_back() = { first_triangle, triangle_count, std::string(extract_next_token().value()) };
                         }
                         catch(...) {
                             eprintf_error("Invalid lightmap specified.");
@@ -697,7 +883,7 @@ void Invader::Lightmap::import_lightmap_mesh(const std::string &mesh_data, const
                         }
                     }
                     else {
-                        eprintf_error("Unknown %s command %s", command.c_str(), subcommand.c_str());
+                        eprintf_error("Unknown %s command %s", command.c_str(), std::string(subcommand).c_str());
                         std::exit(EXIT_FAILURE);
                     }
                 }
@@ -713,6 +899,118 @@ void Invader::Lightmap::import_lightmap_mesh(const std::string &mesh_data, const
         }
     }
     
+    return mesh;
+}
+
+template <typename T> static const T *get_mesh_array(const std::byte *data, std::size_t size, const Lightmap::MeshFormat::MeshArray &array, const std::filesystem::path &mesh_path) {
+    std::size_t offset = array.offset;
+    std::size_t count = array.count;
+    if(offset > size || count > (size - offset) / sizeof(T)) {
+        eprintf_error("Failed to parse %s: Array is out of bounds", mesh_path.string().c_str());
+        std::exit(EXIT_FAILURE);
+    }
+    return reinterpret_cast<const T *>(data + offset);
+}
+
+static ImportedMesh parse_binary_mesh(const std::byte *data, std::size_t size, const std::filesystem::path &mesh_path) {
+    using namespace Lightmap::MeshFormat;
+    
+    auto &header = *reinterpret_cast<const MeshHeader *>(data);
+    if(header.version != MESH_VERSION) {
+        eprintf_error("Input mesh does not have a supported version");
+        std::exit(EXIT_FAILURE);
+    }
+    if(!(header.flags & MeshFlags::MESH_FLAGS_BAKED)) {
+        eprintf_error("Input mesh is not baked");
+        std::exit(EXIT_FAILURE);
+    }
+    
+    // Bounds check everything before reading it
+    auto *models = get_mesh_array<MeshModel>(data, size, header.models, mesh_path);
+    auto *uvs = get_mesh_array<MeshUV>(data, size, header.uvs, mesh_path);
+    auto *triangles = get_mesh_array<MeshTriangle>(data, size, header.triangles, mesh_path);
+    auto *lightmaps = get_mesh_array<MeshLightmap>(data, size, header.lightmaps, mesh_path);
+    
+    std::size_t strings_offset = header.strings_offset;
+    std::size_t strings_size = header.strings_size;
+    if(strings_offset > size || strings_size > size - strings_offset) {
+        eprintf_error("Failed to parse %s: String table is out of bounds", mesh_path.string().c_str());
+        std::exit(EXIT_FAILURE);
+    }
+    auto *strings = reinterpret_cast<const char *>(data + strings_offset);
+    auto get_string = [&strings, &strings_size, &mesh_path](std::uint32_t offset) -> std::string {
+        if(offset >= strings_size || std::memchr(strings + offset, 0, strings_size - offset) == nullptr) {
+            eprintf_error("Failed to parse %s: String is out of bounds", mesh_path.string().c_str());
+            std::exit(EXIT_FAILURE);
+        }
+        return strings + offset;
+    };
+    
+    auto check_range = [&mesh_path](std::uint32_t first, std::uint32_t count, std::uint32_t total) {
+        if(first > total || count > total - first) {
+            eprintf_error("Failed to parse %s: Model is out of bounds", mesh_path.string().c_str());
+            std::exit(EXIT_FAILURE);
+        }
+    };
+    
+    ImportedMesh mesh;
+    if(header.format_length != 0 && header.format_bpp != 0) {
+        mesh.format_length = header.format_length;
+        mesh.format_bpp = header.format_bpp;
+    }
+    
+    std::size_t model_count = header.models.count;
+    for(std::size_t m = 0; m < model_count; m++) {
+        auto &model = models[m];
+        if(!(model.flags & MeshModelFlags::MESH_MODEL_FLAGS_SCENARIO_STRUCTURE_BSP)) {
+            continue;
+        }
+        
+        std::uint32_t first_vertex = model.first_vertex, vertex_count = model.vertex_count;
+        std::uint32_t first_triangle = model.first_triangle, triangle_count = model.triangle_count;
+        std::uint32_t first_lightmap = model.first_lightmap, lightmap_count = model.lightmap_count;
+        check_range(first_vertex, vertex_count, header.uvs.count);
+        check_range(first_triangle, triangle_count, header.triangles.count);
+        check_range(first_lightmap, lightmap_count, header.lightmaps.count);
+        
+        auto &bsp = mesh.bsps.emplace_back();
+        bsp.path = get_string(model.path);
+        
+        bsp.vertices.reserve(vertex_count);
+        for(std::size_t v = first_vertex; v < first_vertex + vertex_count; v++) {
+            bsp.vertices.emplace_back() = { uvs[v].u, uvs[v].v };
+        }
+        
+        bsp.triangles.reserve(triangle_count);
+        for(std::size_t t = first_triangle; t < first_triangle + triangle_count; t++) {
+            bsp.triangles.emplace_back() = { triangles[t].a, triangles[t].b, triangles[t].c };
+        }
+        
+        bsp.lightmaps.reserve(lightmap_count);
+        for(std::size_t l = first_lightmap; l < first_lightmap + lightmap_count; l++) {
+            auto &lightmap = lightmaps[l];
+            bsp.lightmaps.emplace_back() = { lightmap.first_triangle, lightmap.triangle_count, lightmap.image_filename == NULL_STRING ? std::string() : get_string(lightmap.image_filename) };
+        }
+    }
+    
+    return mesh;
+}
+
+void Invader::Lightmap::import_lightmap_mesh(const std::vector<std::byte> &mesh_data, const std::filesystem::path &mesh_path, const char *scenario, const char *bsp_name, const std::vector<std::filesystem::path> &tags_directories) {
+    // Binary meshes start with the magic; anything else is treated as text
+    ImportedMesh mesh;
+    auto *header = reinterpret_cast<const Lightmap::MeshFormat::MeshHeader *>(mesh_data.data());
+    if(mesh_data.size() >= sizeof(*header) && header->magic == Lightmap::MeshFormat::MESH_MAGIC) {
+        mesh = parse_binary_mesh(mesh_data.data(), mesh_data.size(), mesh_path);
+    }
+    else {
+        mesh = parse_text_mesh(reinterpret_cast<const char *>(mesh_data.data()), mesh_data.size(), mesh_path);
+    }
+    
+    auto &format_length = mesh.format_length;
+    auto &format_bpp = mesh.format_bpp;
+    auto &bsps = mesh.bsps;
+    
     // Check the format
     if(!format_length.has_value() || !format_bpp.has_value()) {
         eprintf_error("Input mesh does not specify a format.");
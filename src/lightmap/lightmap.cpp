@@ -30,6 +30,7 @@ int main(int argc, const char **argv) {
         std::filesystem::path data = "data";
         
         std::optional<LightmapMode> mode;
+        bool binary = false;
     } shadowmouse_options;
     
     const CommandLineOption options[] {
@@ -38,7 +39,8 @@ int main(int argc, const char **argv) {
         CommandLineOption::from_preset(CommandLineOption::PRESET_COMMAND_LINE_OPTION_DATA),
         CommandLineOption::from_preset(CommandLineOption::PRESET_COMMAND_LINE_OPTION_TAGS_MULTIPLE),
         CommandLineOption("export-mesh", 'E', 0, "Export a lightmap mesh to be imported and baked using an external program."),
-        CommandLineOption("import-mesh", 'I', 0, "Import a lightmap mesh that was baked.")
+        CommandLineOption("import-mesh", 'I', 0, "Import a lightmap mesh that was baked."),
+        CommandLineOption("binary", 'B', 0, "Export the mesh in the binary format rather than as text. Meshes can be imported in either format.")
     };
 
     static constexpr char DESCRIPTION[] = "Generate meshes to bake lightmaps using Blender's Cycles renderer.";
@@ -58,6 +60,9 @@ int main(int argc, const char **argv) {
             case 'E':
                 shadowmouse_options.mode = LightmapMode::LIGHTMAP_EXPORT;
                 break;
+            case 'B':
+                shadowmouse_options.binary = true;
+                break;
             case 'P':
                 shadowmouse_options.filesystem_path = true;
                 break;
@@ -101,10 +106,8 @@ int main(int argc, const char **argv) {
     
     switch(*shadowmouse_options.mode) {
         case LightmapMode::LIGHTMAP_EXPORT: {
-            auto output = export_lightmap_mesh(scenario_tag.c_str(), bsp_name.c_str(), shadowmouse_options.tags);
-            auto *data = reinterpret_cast<const std::byte *>(output.c_str());
-            auto *data_end = data + output.size();
-            if(!File::save_file(mesh_file, std::vector<std::byte>(data, data_end))) {
+            auto output = export_lightmap_mesh(scenario_tag.c_str(), bsp_name.c_str(), shadowmouse_options.tags, shadowmouse_options.binary);
+            if(!File::save_file(mesh_file, output)) {
                 eprintf_error("Failed to save %s", mesh_file.string().c_str());
                 return EXIT_FAILURE;
             }
@@ -112,8 +115,7 @@ int main(int argc, const char **argv) {
             break;
         }
         case LightmapMode::LIGHTMAP_IMPORT: {
-            auto input_bytes = Invader::File::open_file(mesh_file).value();
-            auto input = std::string(reinterpret_cast<const char *>(input_bytes.data()), input_bytes.size());
+            auto input = Invader::File::open_file(mesh_file).value();
             import_lightmap_mesh(input, mesh_file, scenario_tag.c_str(), bsp_name.c_str(), shadowmouse_options.tags);
             break;
         }
@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef INVADER__LIGHTMAP__MESH_FORMAT_HPP
+#define INVADER__LIGHTMAP__MESH_FORMAT_HPP
+
+#include <invader/hek/data_type.hpp>
+
+/*
+ * Binary lightmap mesh format
+ *
+ * Everything is little endian. The file starts with a MeshHeader, and every array is referenced by an offset from the
+ * start of the file and an element count. The elements of each array have a fixed size, so the file can be read in
+ * place without parsing it.
+ *
+ * Strings are stored as offsets into the string table, which is a list of null-terminated strings. NULL_STRING is used
+ * for no string.
+ *
+ * Unbaked meshes (exported) have skies, sky lights, materials, models, vertices, triangles, lightmaps, and objects.
+ * Baked meshes (imported) have models (BSPs), UVs, triangles, and lightmaps. A model's vertex range refers to vertices
+ * if unbaked and UVs if baked.
+ */
+namespace Invader::Lightmap::MeshFormat {
+    using namespace HEK;
+
+    /** "lmsh" */
+    static constexpr const std::uint32_t MESH_MAGIC = 0x6873686C;
+
+    /** Version of the format (this is the same as the text format's version) */
+    static constexpr const std::uint32_t MESH_VERSION = 1;
+
+    /** No string */
+    static constexpr const std::uint32_t NULL_STRING = 0xFFFFFFFF;
+
+    enum MeshFlags : std::uint32_t {
+        MESH_FLAGS_BAKED = 1 << 0
+    };
+
+    enum MeshModelFlags : std::uint32_t {
+        MESH_MODEL_FLAGS_SCENARIO_STRUCTURE_BSP = 1 << 0
+    };
+
+    enum MeshMaterialType : std::uint32_t {
+        MESH_MATERIAL_TYPE_OPAQUE,
+        MESH_MATERIAL_TYPE_INVISIBLE
+    };
+
+    struct MeshArray {
+        /**
+         * Offset of the first element from the start of the file
+         */
+        LittleEndian<std::uint32_t> offset;
+
+        /**
+         * Number of elements
+         */
+        LittleEndian<std::uint32_t> count;
+    };
+    static_assert(sizeof(MeshArray) == 0x8);
+
+    struct MeshHeader {
+        /**
+         * Must be MESH_MAGIC
+         */
+        LittleEndian<std::uint32_t> magic;
+
+        /**
+         * Must be MESH_VERSION
+         */
+        LittleEndian<std::uint32_t> version;
+
+        /**
+         * Flags
+         */
+        LittleEndian<MeshFlags> flags;
+
+        /**
+         * Lightmap length (baked only)
+         */
+        LittleEndian<std::uint32_t> format_length;
+
+        /**
+         * Lightmap bits per pixel (baked only)
+         */
+        LittleEndian<std::uint32_t> format_bpp;
+
+        /**
+         * String table size in bytes
+         */
+        LittleEndian<std::uint32_t> strings_size;
+
+        /**
+         * String table offset
+         */
+        LittleEndian<std::uint32_t> strings_offset;
+
+        /**
+         * Unused
+         */
+        LittleEndian<std::uint32_t> reserved;
+
+        MeshArray skies;
+        MeshArray sky_lights;
+        MeshArray materials;
+        MeshArray models;
+        MeshArray vertices;
+        MeshArray uvs;
+        MeshArray triangles;
+        MeshArray lightmaps;
+        MeshArray objects;
+    };
+    static_assert(sizeof(MeshHeader) == 0x68);
+
+    struct MeshSky {
+        LittleEndian<std::uint32_t> path;
+        LittleEndian<float> outdoor_power;
+        LittleEndian<float> outdoor_red;
+        LittleEndian<float> outdoor_green;
+        LittleEndian<float> outdoor_blue;
+        LittleEndian<std::uint32_t> first_light;
+        LittleEndian<std::uint32_t> light_count;
+    };
+    static_assert(sizeof(MeshSky) == 0x1C);
+
+    struct MeshSkyLight {
+        LittleEndian<float> power;
+        LittleEndian<float> red;
+        LittleEndian<float> green;
+        LittleEndian<float> blue;
+        LittleEndian<float> yaw;
+        LittleEndian<float> pitch;
+    };
+    static_assert(sizeof(MeshSkyLight) == 0x18);
+
+    struct MeshMaterial {
+        LittleEndian<std::uint32_t> path;
+        LittleEndian<MeshMaterialType> type;
+        LittleEndian<float> power;
+        LittleEndian<float> emission_red;
+        LittleEndian<float> emission_green;
+        LittleEndian<float> emission_blue;
+    };
+    static_assert(sizeof(MeshMaterial) == 0x18);
+
+    struct MeshModel {
+        LittleEndian<std::uint32_t> path;
+        LittleEndian<MeshModelFlags> flags;
+
+        /** Vertex indices in triangles are relative to the first vertex */
+        LittleEndian<std::uint32_t> first_vertex;
+        LittleEndian<std::uint32_t> vertex_count;
+        LittleEndian<std::uint32_t> first_triangle;
+        LittleEndian<std::uint32_t> triangle_count;
+
+        /** Triangle indices in lightmaps are relative to the first triangle */
+        LittleEndian<std::uint32_t> first_lightmap;
+        LittleEndian<std::uint32_t> lightmap_count;
+    };
+    static_assert(sizeof(MeshModel) == 0x20);
+
+    struct MeshVertex {
+        LittleEndian<float> x;
+        LittleEndian<float> y;
+        LittleEndian<float> z;
+    };
+    static_assert(sizeof(MeshVertex) == 0xC);
+
+    struct MeshUV {
+        LittleEndian<float> u;
+        LittleEndian<float> v;
+    };
+    static_assert(sizeof(MeshUV) == 0x8);
+
+    struct MeshTriangle {
+        LittleEndian<std::uint32_t> a;
+        LittleEndian<std::uint32_t> b;
+        LittleEndian<std::uint32_t> c;
+
+        /** Index of the material (unbaked only) */
+        LittleEndian<std::uint32_t> material;
+    };
+    static_assert(sizeof(MeshTriangle) == 0x10);
+
+    struct MeshLightmap {
+        LittleEndian<std::uint32_t> first_triangle;
+        LittleEndian<std::uint32_t> triangle_count;
+
+        /** Image file (baked only) */
+        LittleEndian<std::uint32_t> image_filename;
+    };
+    static_assert(sizeof(MeshLightmap) == 0xC);
+
+    struct MeshObject {
+        LittleEndian<std::uint32_t> model;
+        LittleEndian<float> x;
+        LittleEndian<float> y;
+        LittleEndian<float> z;
+        LittleEndian<float> yaw;
+        LittleEndian<float> pitch;
+        LittleEndian<float> roll;
+    };
+    static_assert(sizeof(MeshObject) == 0x1C);
+}
+
+#endif
@@ -644,7 +644,11 @@ namespace Invader {
     }
     
     bool Map::is_clean() const noexcept {
-        if(this->get_crc32() != this->get_header_crc32() || this->is_protected() || this->data.size() != this->get_header_decompressed_file_size() || this->get_type() != this->get_header_type()) {
+        return this->is_clean(this->get_crc32(), this->is_protected());
+    }
+    
+    bool Map::is_clean(std::uint32_t crc32, bool is_protected) const noexcept {
+        if(crc32 != this->get_header_crc32() || is_protected || this->data.size() != this->get_header_decompressed_file_size() || this->get_type() != this->get_header_type()) {
             return false;
         }
         else if(this->get_cache_version() != HEK::CacheFileEngine::CACHE_FILE_NATIVE) {
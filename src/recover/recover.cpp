@@ -1,7 +1,13 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <chrono>
 #include "../command_line_option.hpp"
 #include <invader/file/file.hpp>
+#include <invader/map/map.hpp>
 #include <invader/tag/parser/parser.hpp>
 #include <invader/version.hpp>
 #include <invader/tag/hek/header.hpp>
@@ -18,6 +24,8 @@ int main(int argc, const char **argv) {
         std::filesystem::path data = "data";
         bool overwrite = false;
         std::vector<std::string> batch, batch_exclude;
+        std::optional<std::filesystem::path> map;
+        std::size_t max_threads = std::thread::hardware_concurrency() < 1 ? 1 : std::thread::hardware_concurrency();
     } recover_options;
 
     const CommandLineOption options[] = {
@@ -27,10 +35,12 @@ int main(int argc, const char **argv) {
         CommandLineOption::from_preset(CommandLineOption::PRESET_COMMAND_LINE_OPTION_BATCH),
         CommandLineOption::from_preset(CommandLineOption::PRESET_COMMAND_LINE_OPTION_BATCH_EXCLUDE),
         CommandLineOption("overwrite", 'O', 0, "Overwrite data if it already exists"),
+        CommandLineOption("map", 'M', 1, "Only recover tags that are in the given map. This can be used without --batch to recover every tag in the map.", "<map>"),
+        CommandLineOption("threads", 'j', 1, "Set the number of threads to use for recovering tags when batching. Default: CPU thread count"),
     };
 
     static constexpr char DESCRIPTION[] = "Recover source data from tags.";
-    static constexpr char USAGE[] = "[options] <-b <expr> | <tag.group>>";
+    static constexpr char USAGE[] = "[options] <-b <expr> | -M <map> | <tag.group>>";
 
     auto remaining_arguments = Invader::CommandLineOption::parse_arguments<RecoverOptions &>(argc, argv, options, USAGE, DESCRIPTION, 0, 1, recover_options, [](char opt, const auto &args, RecoverOptions &recover_options) {
         switch(opt) {
@@ -52,6 +62,22 @@ int main(int argc, const char **argv) {
             case 'e':
                 recover_options.batch_exclude.emplace_back(args[0]);
                 break;
+            case 'M':
+                recover_options.map = args[0];
+                break;
+            case 'j':
+                try {
+                    recover_options.max_threads = std::stoul(args[0]);
+                }
+                catch(std::exception &) {
+                    eprintf_error("Invalid number of threads %s", args[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                if(recover_options.max_threads < 1) {
+                    eprintf_error("Invalid number of threads %s", args[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                break;
         }
     });
     
@@ -60,7 +86,7 @@ int main(int argc, const char **argv) {
         return EXIT_FAILURE;
     }
     
-    auto uses_batching = !(recover_options.batch.empty() && recover_options.batch_exclude.empty());
+    auto uses_batching = !(recover_options.batch.empty() && recover_options.batch_exclude.empty()) || recover_options.map.has_value();
     if(uses_batching != remaining_arguments.empty()) {
         eprintf_error("Expected a tag path OR batching (not both)");
         return EXIT_FAILURE;
@@ -68,43 +94,136 @@ int main(int argc, const char **argv) {
     
     bool result = false;
     
-    auto do_on_tag = [&recover_options, &result](const auto &tag) -> bool {
+    auto do_on_tag = [&recover_options](const auto &tag, Recover::RecoverConflicts *conflicts, BufferedOutput &log) -> bool {
         // read it
         auto file_path = File::tag_path_to_file_path(tag, recover_options.tags);
         auto file = File::open_file(file_path);
         if(!file.has_value()) {
-            eprintf_error("Failed to read %s", file_path.string().c_str());
+            log.print(BufferedOutput::OUTPUT_ERROR, "Failed to read %s", file_path.string().c_str());
             return false;
         }
         
         // Load it
         auto tag_data = Parser::ParserStruct::parse_hek_tag_file(file->data(), file->size());
-        auto r = Recover::recover(*tag_data, std::filesystem::path(tag).replace_extension().string(), recover_options.data, reinterpret_cast<const HEK::TagFileHeader *>(file->data())->tag_fourcc, recover_options.overwrite);
-        result = r || result;
-        return r;
+        return Recover::recover(*tag_data, std::filesystem::path(tag).replace_extension().string(), recover_options.data, reinterpret_cast<const HEK::TagFileHeader *>(file->data())->tag_fourcc, recover_options.overwrite, conflicts, &log);
     };
     
     // Let's do this
     if(uses_batching) {
+        // If a map was given, only use tags that are in it
+        std::optional<std::set<File::TagFilePath>> map_tags;
+        if(recover_options.map.has_value()) {
+            auto map_data = File::open_file(*recover_options.map);
+            if(!map_data.has_value()) {
+                eprintf_error("Failed to read %s", recover_options.map->string().c_str());
+                return EXIT_FAILURE;
+            }
+            try {
+                auto map = Map::map_with_move(std::move(*map_data));
+                auto &tags = map_tags.emplace();
+                auto tag_count = map.get_tag_count();
+                for(std::size_t i = 0; i < tag_count; i++) {
+                    auto &tag = map.get_tag(i);
+                    tags.emplace(File::halo_path_to_preferred_path(tag.get_path()), tag.get_tag_fourcc());
+                }
+            }
+            catch(std::exception &e) {
+                eprintf_error("Failed to parse %s: %s", recover_options.map->string().c_str(), e.what());
+                return EXIT_FAILURE;
+            }
+        }
+
         auto virtual_tags = File::load_virtual_tag_folder({recover_options.tags});
-        std::size_t total = 0;
-        std::size_t recovered = 0;
+        std::vector<File::TagFile> tags_to_recover;
+        File::PathMatcher matcher(recover_options.batch, recover_options.batch_exclude);
         for(auto &t : virtual_tags) {
-            if(File::path_matches(t.tag_path.c_str(), recover_options.batch, recover_options.batch_exclude)) {
-                total++;
-                if(!do_on_tag(t.tag_path)) {
-                    eprintf("Skipped %s\n", t.tag_path.c_str());
+            if(map_tags.has_value() && !map_tags->contains(File::TagFilePath(std::filesystem::path(t.tag_path).replace_extension().string(), t.tag_fourcc))) {
+                continue;
+            }
+            if((recover_options.batch.empty() && recover_options.batch_exclude.empty()) || matcher.matches(t.tag_path)) {
+                tags_to_recover.emplace_back(std::move(t));
+            }
+        }
+
+        // Recover everything in parallel. Bitmaps' color plates are decompressed and written as TIFFs on whichever thread got them.
+        std::size_t total = tags_to_recover.size();
+        // Each tag gets its own slot, so these can be written without locking
+        std::vector<std::uint8_t> recovered_tags(total, 0);
+        std::vector<BufferedOutput> logs(total);
+        std::atomic<std::size_t> next_tag = 0;
+        Recover::RecoverConflicts conflicts;
+        auto start = std::chrono::steady_clock::now();
+
+        // Print each tag's messages in order as soon as every tag before it is done
+        std::mutex print_mutex;
+        std::vector<std::uint8_t> finished(total, 0);
+        std::size_t next_to_print = 0;
+
+        auto recover_thread = [&tags_to_recover, &recovered_tags, &logs, &next_tag, &conflicts, &do_on_tag, &total, &print_mutex, &finished, &next_to_print]() {
+            while(true) {
+                auto t = next_tag.fetch_add(1, std::memory_order_relaxed);
+                if(t >= total) {
+                    break;
+                }
+
+                auto &tag_path = tags_to_recover[t].tag_path;
+                auto &log = logs[t];
+                bool r = false;
+                try {
+                    r = do_on_tag(tag_path, &conflicts, log);
+                }
+                catch(std::exception &e) {
+                    log.print(BufferedOutput::OUTPUT_ERROR, "Failed to recover %s: %s", tag_path.c_str(), e.what());
+                }
+
+                if(r) {
+                    log.print(BufferedOutput::OUTPUT_SUCCESS, "Recovered %s", tag_path.c_str());
+                    recovered_tags[t] = 1;
                 }
                 else {
-                    oprintf_success("Recovered %s", t.tag_path.c_str());
-                    recovered++;
+                    log.print(BufferedOutput::OUTPUT_PLAIN_ERROR, "Skipped %s\n", tag_path.c_str());
+                }
+
+                std::scoped_lock<std::mutex> lock(print_mutex);
+                finished[t] = 1;
+                while(next_to_print < total && finished[next_to_print]) {
+                    logs[next_to_print++].flush();
                 }
             }
+        };
+
+        std::vector<std::thread> threads;
+        auto thread_count = std::min(recover_options.max_threads, total);
+        threads.reserve(thread_count);
+        for(std::size_t j = 0; j < thread_count; j++) {
+            threads.emplace_back(recover_thread);
+        }
+        for(auto &t : threads) {
+            t.join();
+        }
+
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto recovered = static_cast<std::size_t>(std::count(recovered_tags.begin(), recovered_tags.end(), 1));
+        result = recovered > 0;
+
+        // Report everything that wasn't written at once
+        if(!conflicts.conflicts.empty()) {
+            std::sort(conflicts.conflicts.begin(), conflicts.conflicts.end());
+            eprintf_warn("%zu data file%s already existed or %s recovered from more than one tag, so %s not written:", conflicts.conflicts.size(), conflicts.conflicts.size() == 1 ? "" : "s", conflicts.conflicts.size() == 1 ? "was" : "were", conflicts.conflicts.size() == 1 ? "it was" : "they were");
+            for(auto &c : conflicts.conflicts) {
+                eprintf_warn("    %s", c.string().c_str());
+            }
+            if(!recover_options.overwrite) {
+                eprintf_warn("Use --overwrite to overwrite existing data files.");
+            }
         }
-        oprintf("Recovered %zu of %zu tag%s\n", recovered, total, total == 1 ? "" : "s");
+
+        oprintf("Recovered %zu of %zu tag%s in %.03f seconds\n", recovered, total, total == 1 ? "" : "s", seconds);
     }
     else {
-        do_on_tag(File::halo_path_to_preferred_path(remaining_arguments[0]));
+        BufferedOutput log;
+        result = do_on_tag(File::halo_path_to_preferred_path(remaining_arguments[0]), nullptr, log);
+        log.flush();
         if(result) {
             oprintf_success("Recovered %s", remaining_arguments[0]);
         }
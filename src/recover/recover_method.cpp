@@ -16,19 +16,39 @@ namespace Invader::Recover {
         std::filesystem::create_directories(path.parent_path());
     }
 
-    static bool create_directories_save_and_quit(const std::filesystem::path &path, const std::vector<std::byte> &data) {
+    static bool create_directories_save_and_quit(const std::filesystem::path &path, const std::vector<std::byte> &data, BufferedOutput &log) {
         create_directories_for_path(path);
 
         // Save it
         if(!File::save_file(path, data)) {
-            eprintf_error("Failed to write to %s", path.string().c_str());
+            log.print(BufferedOutput::OUTPUT_ERROR, "Failed to write to %s", path.string().c_str());
             return false;
         }
         
         return true;
     }
 
-    static std::optional<bool> recover_tag_collection(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, bool overwrite) {
+    static bool can_write_data_file(const std::filesystem::path &path, bool overwrite, RecoverConflicts *conflicts) {
+        if(conflicts == nullptr) {
+            if(std::filesystem::exists(path) && !overwrite) {
+                oprintf_success_warn("%s already exists", path.string().c_str());
+                return false;
+            }
+            return true;
+        }
+
+        // Don't write over anything another tag already recovered in this batch, even when overwriting
+        auto normal_path = path.lexically_normal();
+        std::scoped_lock<std::mutex> lock(conflicts->mutex);
+        if(conflicts->written.contains(normal_path) || (std::filesystem::exists(normal_path) && !overwrite)) {
+            conflicts->conflicts.emplace_back(std::move(normal_path));
+            return false;
+        }
+        conflicts->written.emplace(std::move(normal_path));
+        return true;
+    }
+
+    static std::optional<bool> recover_tag_collection(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, bool overwrite, RecoverConflicts *conflicts, BufferedOutput &log) {
         auto *tag_collection = dynamic_cast<const Parser::TagCollection *>(&tag);
         if(!tag_collection) {
             return std::nullopt;
@@ -43,16 +63,15 @@ namespace Invader::Recover {
         // Create directories
         auto file_path = data / (path + ".txt");
 
-        if(std::filesystem::exists(file_path) && !overwrite) {
-            oprintf_success_warn("%s already exists", file_path.string().c_str());
+        if(!can_write_data_file(file_path, overwrite, conflicts)) {
             return false;
         }
 
         auto *output_data = output.data();
-        return create_directories_save_and_quit(file_path, std::vector<std::byte>(reinterpret_cast<const std::byte *>(output_data), reinterpret_cast<const std::byte *>(output_data + output.size())));
+        return create_directories_save_and_quit(file_path, std::vector<std::byte>(reinterpret_cast<const std::byte *>(output_data), reinterpret_cast<const std::byte *>(output_data + output.size())), log);
     }
 
-    static std::optional<bool> recover_bitmap(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, bool overwrite) {
+    static std::optional<bool> recover_bitmap(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, bool overwrite, RecoverConflicts *conflicts, BufferedOutput &log) {
         auto *bitmap = dynamic_cast<const Parser::Bitmap *>(&tag);
         auto file_path = data / (path + ".tif");
 
@@ -66,8 +85,7 @@ namespace Invader::Recover {
         }
 
         // Does it already exist?
-        if(std::filesystem::exists(file_path) && !overwrite) {
-            oprintf_success_warn("%s already exists", file_path.string().c_str());
+        if(!can_write_data_file(file_path, overwrite, conflicts)) {
             return false;
         }
 
@@ -76,7 +94,7 @@ namespace Invader::Recover {
         
         // Do we have color plate data?
         if(!decompressed_stuff.has_value()) {
-            eprintf_warn("No color plate data to recover from - tag likely extracted");
+            log.print(BufferedOutput::OUTPUT_WARN, "No color plate data to recover from - tag likely extracted");
             return false;
         }
 
@@ -86,7 +104,7 @@ namespace Invader::Recover {
 
         auto *tiff = TIFFOpen(file_path_str.c_str(), "w");
         if(!tiff) {
-            eprintf_error("Failed to open %s for writing", file_path_str.c_str());
+            log.print(BufferedOutput::OUTPUT_ERROR, "Failed to open %s for writing", file_path_str.c_str());
             return false;
         }
 
@@ -117,7 +135,7 @@ namespace Invader::Recover {
 
         TIFFClose(tiff);
 
-        oprintf("Recovered data file %s\n", file_path_str.c_str());
+        log.print(BufferedOutput::OUTPUT_PLAIN, "Recovered data file %s\n", file_path_str.c_str());
 
         return true;
     }
@@ -130,7 +148,7 @@ namespace Invader::Recover {
         "superlow"
     };
 
-    template<typename T> static std::optional<bool> make_jms(const T &model, const std::string &permutation, std::size_t lod, const std::filesystem::path &models_path, bool local_nodes, bool overwrite) {
+    template<typename T> static std::optional<bool> make_jms(const T &model, const std::string &permutation, std::size_t lod, const std::filesystem::path &models_path, bool local_nodes, bool overwrite, RecoverConflicts *conflicts, BufferedOutput &log) {
         JMS jms;
 
         // Set the checksum value
@@ -186,7 +204,7 @@ namespace Invader::Recover {
 
                     // Is it valid?
                     if(geometry_index >= model.geometries.size()) {
-                        eprintf_error("Geometry index for permutation #%zu of region #%zu is out of bounds (%zu >= %zu)", &p - r.permutations.data(), &r - model.regions.data(), geometry_index, model.geometries.size());
+                        log.print(BufferedOutput::OUTPUT_ERROR, "Geometry index for permutation #%zu of region #%zu is out of bounds (%zu >= %zu)", &p - r.permutations.data(), &r - model.regions.data(), geometry_index, model.geometries.size());
                         throw Invader::InvalidTagDataException();
                     }
 
@@ -219,7 +237,7 @@ namespace Invader::Recover {
                     for(auto &p : geometry.parts) {
                         // Is the shader valid?
                         if(p.shader_index >= model.shaders.size()) {
-                            eprintf_error("Invalid shader index!");
+                            log.print(BufferedOutput::OUTPUT_ERROR, "Invalid shader index!");
                             throw Invader::InvalidTagDataException();
                         }
 
@@ -244,7 +262,7 @@ namespace Invader::Recover {
 
                         // Uncompressed vertices are missing
                         if(p.uncompressed_vertices.size() == 0) {
-                            eprintf_error("Missing uncompressed vertices - tag likely extracted improperly (haw haw!)");
+                            log.print(BufferedOutput::OUTPUT_ERROR, "Missing uncompressed vertices - tag likely extracted improperly (haw haw!)");
                             throw Invader::InvalidTagDataException();
                         }
 
@@ -260,13 +278,13 @@ namespace Invader::Recover {
                             if(local_nodes) {
                                 auto *memes = reinterpret_cast<const Parser::GBXModelGeometryPart *>(&p);
                                 if(memes->local_node_count > sizeof(memes->local_node_indices) / sizeof(*memes->local_node_indices)) {
-                                    eprintf_error("Local nodes overflow");
+                                    log.print(BufferedOutput::OUTPUT_ERROR, "Local nodes overflow");
                                     throw Invader::InvalidTagDataException();
                                 }
 
                                 if(v.node0_index != NULL_INDEX) {
                                     if(v.node0_index >= memes->local_node_count) {
-                                        eprintf_error("Local nodes index out of bounds");
+                                        log.print(BufferedOutput::OUTPUT_ERROR, "Local nodes index out of bounds");
                                         throw Invader::InvalidTagDataException();
                                     }
                                     vertex.node0 = v.node0_index;
@@ -277,7 +295,7 @@ namespace Invader::Recover {
 
                                 if(v.node1_index != NULL_INDEX) {
                                     if(v.node1_index >= memes->local_node_count) {
-                                        eprintf_error("Local nodes index out of bounds");
+                                        log.print(BufferedOutput::OUTPUT_ERROR, "Local nodes index out of bounds");
                                         throw Invader::InvalidTagDataException();
                                     }
                                     vertex.node1 = v.node1_index;
@@ -310,7 +328,7 @@ namespace Invader::Recover {
 
                         // Error if that went wrong
                         if(indices.size() < 3) {
-                            eprintf_error("Geometry has no geometry");
+                            log.print(BufferedOutput::OUTPUT_ERROR, "Geometry has no geometry");
                             throw Invader::InvalidTagDataException();
                         }
 
@@ -356,22 +374,21 @@ namespace Invader::Recover {
         auto string_data = jms.string();
         auto *jms_data = string_data.data();
         
-        if(std::filesystem::exists(filename) && !overwrite) {
-            oprintf_success_warn("%s already exists", filename.string().c_str());
+        if(!can_write_data_file(filename, overwrite, conflicts)) {
             return std::nullopt;
         }
         
         if(File::save_file(filename, std::vector<std::byte>(reinterpret_cast<std::byte *>(jms_data), reinterpret_cast<std::byte *>(jms_data + string_data.size())))) {
-            oprintf("Recovered data file %s\n", filename.string().c_str());
+            log.print(BufferedOutput::OUTPUT_PLAIN, "Recovered data file %s\n", filename.string().c_str());
             return true;
         }
         else {
-            eprintf_error("Failed to write to %s", filename.string().c_str());
+            log.print(BufferedOutput::OUTPUT_ERROR, "Failed to write to %s", filename.string().c_str());
             return false;
         }
     }
 
-    template<typename T> static std::optional<bool> recover_jms(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, bool overwrite) {
+    template<typename T> static std::optional<bool> recover_jms(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, bool overwrite, RecoverConflicts *conflicts, BufferedOutput &log) {
         auto *model = dynamic_cast<const T *>(&tag);
         if(!model) {
             return std::nullopt;
@@ -381,8 +398,8 @@ namespace Invader::Recover {
         auto path_path = std::filesystem::path(path);
         auto parent_path_path = path_path.parent_path();
         if(parent_path_path.filename() != path_path.filename()) {
-            eprintf_error("Cannot recover due to parent filename not matching tag filename");
-            eprintf_error("Parent filename is %s, but the tag's filename is %s", parent_path_path.filename().string().c_str(), path_path.filename().string().c_str());
+            log.print(BufferedOutput::OUTPUT_ERROR, "Cannot recover due to parent filename not matching tag filename");
+            log.print(BufferedOutput::OUTPUT_ERROR, "Parent filename is %s, but the tag's filename is %s", parent_path_path.filename().string().c_str(), path_path.filename().string().c_str());
             return false;
         }
 
@@ -394,7 +411,7 @@ namespace Invader::Recover {
         std::filesystem::create_directories(model_directory, ec);
 
         if(model->markers.size() > 0) {
-            eprintf_error("Markers are present in base struct - tag likely extracted improperly (haw haw!)");
+            log.print(BufferedOutput::OUTPUT_ERROR, "Markers are present in base struct - tag likely extracted improperly (haw haw!)");
             throw Invader::InvalidTagDataException();
         }
 
@@ -421,7 +438,7 @@ namespace Invader::Recover {
         bool recovered_anything = false;
         for(auto &p : permutations) {
             for(std::size_t i = 0; i < sizeof(ALL_LODS) / sizeof(*ALL_LODS); i++) {
-                auto jms_operation = make_jms(*model, p, i, model_directory, local_nodes, overwrite);
+                auto jms_operation = make_jms(*model, p, i, model_directory, local_nodes, overwrite, conflicts, log);
                 if(jms_operation.has_value() && *jms_operation == false) {
                     return false;
                 }
@@ -434,7 +451,7 @@ namespace Invader::Recover {
         return recovered_anything;
     }
 
-    static std::optional<bool> recover_string_list(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, bool overwrite) {
+    static std::optional<bool> recover_string_list(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, bool overwrite, RecoverConflicts *conflicts, BufferedOutput &log) {
         auto *unicode_string_list = dynamic_cast<const Parser::UnicodeStringList *>(&tag);
         auto *string_list = dynamic_cast<const Parser::StringList *>(&tag);
         if(string_list == nullptr && unicode_string_list == nullptr) {
@@ -443,8 +460,7 @@ namespace Invader::Recover {
 
         auto data_path = data / (path + ".txt");
 
-        if(std::filesystem::exists(data_path) && !overwrite) {
-            oprintf_success_warn("%s already exists", data_path.string().c_str());
+        if(!can_write_data_file(data_path, overwrite, conflicts)) {
             return false;
         }
 
@@ -452,7 +468,7 @@ namespace Invader::Recover {
             std::string result;
 
             if(Parser::check_for_broken_strings(*string_list)) {
-                eprintf_error("String list has broken strings - tag is corrupt or edited improperly");
+                log.print(BufferedOutput::OUTPUT_ERROR, "String list has broken strings - tag is corrupt or edited improperly");
                 return false;
             }
 
@@ -463,7 +479,7 @@ namespace Invader::Recover {
 
             // Save
             auto *final_result = reinterpret_cast<const std::byte *>(result.data());
-            create_directories_save_and_quit(data_path, std::vector<std::byte>(final_result, final_result + result.size()));
+            create_directories_save_and_quit(data_path, std::vector<std::byte>(final_result, final_result + result.size()), log);
         }
         else if(unicode_string_list) {
             // Start with the BOM
@@ -471,7 +487,7 @@ namespace Invader::Recover {
 
             // Oh... also, is this broken?
             if(Parser::check_for_broken_strings(*unicode_string_list)) {
-                eprintf_error("String list has broken strings - tag is corrupt or edited improperly");
+                log.print(BufferedOutput::OUTPUT_ERROR, "String list has broken strings - tag is corrupt or edited improperly");
                 return false;
             }
 
@@ -485,7 +501,7 @@ namespace Invader::Recover {
             auto *result_data = result.data();
             auto *final_result = reinterpret_cast<const std::byte *>(result_data);
             auto *final_result_end = reinterpret_cast<const std::byte *>(result_data + result.size());
-            create_directories_save_and_quit(data_path, std::vector<std::byte>(final_result, final_result_end));
+            create_directories_save_and_quit(data_path, std::vector<std::byte>(final_result, final_result_end), log);
         }
         else {
             std::terminate();
@@ -494,14 +510,14 @@ namespace Invader::Recover {
         return true;
     }
 
-    static std::optional<bool> recover_scripts(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, bool overwrite) {
+    static std::optional<bool> recover_scripts(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, bool overwrite, RecoverConflicts *conflicts, BufferedOutput &log) {
         auto *scenario = dynamic_cast<const Parser::Scenario *>(&tag);
         if(!scenario) {
             return std::nullopt;
         }
 
         if(scenario->source_files.size() == 0) {
-            eprintf_warn("Scenario does not have any script source data to recover");
+            log.print(BufferedOutput::OUTPUT_WARN, "Scenario does not have any script source data to recover");
             return false;
         }
 
@@ -525,10 +541,7 @@ namespace Invader::Recover {
                 hsc_path = scripts_directory / (script_name + ".hsc");
             }
             
-            bool exists = std::filesystem::exists(hsc_path);
-            
-            if(exists && !overwrite) {
-                oprintf_success_warn("%s already exists", hsc_path.string().c_str());
+            if(!can_write_data_file(hsc_path, overwrite, conflicts)) {
                 continue;
             }
             
@@ -539,11 +552,11 @@ namespace Invader::Recover {
             }
             
             if(File::save_file(hsc_path, source)) {
-                oprintf("Recovered data file %s\n", hsc_path.string().c_str());
+                log.print(BufferedOutput::OUTPUT_PLAIN, "Recovered data file %s\n", hsc_path.string().c_str());
                 recovered_anything = true;
             }
             else {
-                eprintf_error("Failed to write to %s", hsc_path.string().c_str());
+                log.print(BufferedOutput::OUTPUT_ERROR, "Failed to write to %s", hsc_path.string().c_str());
                 return false;
             }
         }
@@ -551,25 +564,24 @@ namespace Invader::Recover {
         return recovered_anything;
     }
 
-    std::optional<bool> recover_model(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, bool overwrite) {
-        auto a = recover_jms<Parser::Model>(tag, path, data, overwrite);
+    std::optional<bool> recover_model(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, bool overwrite, RecoverConflicts *conflicts, BufferedOutput &log) {
+        auto a = recover_jms<Parser::Model>(tag, path, data, overwrite, conflicts, log);
         if(a.has_value()) {
             return a;
         }
         else {
-            return recover_jms<Parser::GBXModel>(tag, path, data, overwrite);
+            return recover_jms<Parser::GBXModel>(tag, path, data, overwrite, conflicts, log);
         }
     }
 
-    std::optional<bool> recover_hud_message_text(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, bool overwrite) {
+    std::optional<bool> recover_hud_message_text(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, bool overwrite, RecoverConflicts *conflicts, BufferedOutput &log) {
         auto *hmt = dynamic_cast<const Parser::HUDMessageText *>(&tag);
         if(hmt == nullptr) {
             return std::nullopt;
         }
         
         auto file_path = data / std::filesystem::path(path + ".hmt");
-        if(!overwrite && std::filesystem::exists(file_path)) {
-            oprintf_success_warn("%s already exists", file_path.string().c_str());
+        if(!can_write_data_file(file_path, overwrite, conflicts)) {
             return false;
         }
         
@@ -587,13 +599,13 @@ namespace Invader::Recover {
             }
             else if(element.type == 1) {
                 if(element.data >= static_cast<std::int8_t>(sizeof(ALL_MESSAGE_TYPES) / sizeof(*ALL_MESSAGE_TYPES))) {
-                    eprintf_error("Element #%zu has an incorrect button type", e);
+                    log.print(BufferedOutput::OUTPUT_ERROR, "Element #%zu has an incorrect button type", e);
                     return false;
                 }
                 continue;
             }
             else {
-                eprintf_error("Element #%zu has an unknown type", e);
+                log.print(BufferedOutput::OUTPUT_ERROR, "Element #%zu has an unknown type", e);
                 return false;
             }
         }
@@ -613,7 +625,7 @@ namespace Invader::Recover {
             auto count = static_cast<std::size_t>(message.panel_count);
             auto end_index = first_index + count;
             if(end_index > element_count) {
-                eprintf_error("Message #%zu (%s) has an out-of-bounds range", m, message.name.string);
+                log.print(BufferedOutput::OUTPUT_ERROR, "Message #%zu (%s) has an out-of-bounds range", m, message.name.string);
                 return false;
             }
             
@@ -631,7 +643,7 @@ namespace Invader::Recover {
                     }
                     
                     if(end > string_data_size) {
-                        eprintf_error("Message #%zu (%s) has an out-of-bounds string range", m, message.name.string);
+                        log.print(BufferedOutput::OUTPUT_ERROR, "Message #%zu (%s) has an out-of-bounds string range", m, message.name.string);
                         return false;
                     }
                     
@@ -667,7 +679,7 @@ namespace Invader::Recover {
         std::filesystem::create_directories(file_path.parent_path(), ec);
         
         if(File::save_file(file_path, std::vector<std::byte>(reinterpret_cast<std::byte *>(output_file.data()), reinterpret_cast<std::byte *>(output_file.data() + output_file.size())))) {
-            oprintf("Recovered data file %s\n", file_path.string().c_str());
+            log.print(BufferedOutput::OUTPUT_PLAIN, "Recovered data file %s\n", file_path.string().c_str());
             return true;
         }
         else {
@@ -675,8 +687,12 @@ namespace Invader::Recover {
         }
     }
 
-    bool recover(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, HEK::TagFourCC tag_fourcc, bool overwrite) {
-        #define ATTEMPT_RECOVER(fn) if(!a.has_value()) { a = fn(tag, path, data, overwrite); }
+    bool recover(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, HEK::TagFourCC tag_fourcc, bool overwrite, RecoverConflicts *conflicts, BufferedOutput *output) {
+        // Print at the end unless the caller is holding this tag's messages
+        BufferedOutput own_output;
+        auto &log = output ? *output : own_output;
+
+        #define ATTEMPT_RECOVER(fn) if(!a.has_value()) { a = fn(tag, path, data, overwrite, conflicts, log); }
         std::optional<bool> a;
         ATTEMPT_RECOVER(recover_bitmap)
         ATTEMPT_RECOVER(recover_tag_collection)
@@ -685,9 +701,11 @@ namespace Invader::Recover {
         ATTEMPT_RECOVER(recover_scripts)
         ATTEMPT_RECOVER(recover_hud_message_text)
         if(!a.has_value()) {
-            eprintf_warn("Data cannot be recovered from %s tags", HEK::tag_fourcc_to_extension(tag_fourcc));
+            log.print(BufferedOutput::OUTPUT_WARN, "Data cannot be recovered from %s tags", HEK::tag_fourcc_to_extension(tag_fourcc));
             a = false;
         }
+
+        own_output.flush();
         return a.value();
     }
 }
@@ -4,14 +4,33 @@
 #define INVADER__RECOVER__RECOVER_HPP
 
 #include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <invader/hek/fourcc.hpp>
+#include <invader/printf.hpp>
 
 namespace Invader::Parser {
     struct ParserStruct;
 }
 
 namespace Invader::Recover {
+    /**
+     * Data files written when recovering multiple tags at once
+     */
+    struct RecoverConflicts {
+        std::mutex mutex;
+
+        /** Data files recovered so far */
+        std::set<std::filesystem::path> written;
+
+        /** Data files that were not written because they already existed or another tag already recovered them */
+        std::vector<std::filesystem::path> conflicts;
+    };
+
     /**
      * Recover tag data
      * @param tag        tag to recover
@@ -19,10 +38,12 @@ namespace Invader::Recover {
      * @param data       data directory to recover to
      * @param tag_fourcc tag class fourcc
      * @param overwrite  overwrite data
+     * @param conflicts  if set, record data files that were not written here instead of printing them
+     * @param output     if set, hold messages here instead of printing them
      * 
      * @return           true if successful, false if not
      */
-    bool recover(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, HEK::TagFourCC tag_fourcc, bool overwrite);
+    bool recover(const Parser::ParserStruct &tag, const std::string &path, const std::filesystem::path &data, HEK::TagFourCC tag_fourcc, bool overwrite, RecoverConflicts *conflicts = nullptr, BufferedOutput *output = nullptr);
 }
 
 #endif
@@ -2,6 +2,8 @@
 
 #include <vector>
 #include <string>
+#include <set>
+#include <tuple>
 #include <filesystem>
 #include <invader/printf.hpp>
 #include <invader/version.hpp>
@@ -10,11 +12,12 @@
 #include "../command_line_option.hpp"
 #include <invader/tag/parser/parser.hpp>
 #include <invader/file/file.hpp>
+#include <invader/dependency/tag_dependency_index.hpp>
 
 using namespace Invader;
 using namespace Invader::File;
 
-std::size_t refactor_tags(const std::filesystem::path &file_path, const std::vector<std::pair<TagFilePath, TagFilePath>> &replacements, bool check_only, bool dry_run) {
+std::size_t refactor_tags(const std::filesystem::path &file_path, const std::vector<std::pair<TagFilePath, TagFilePath>> &replacements, std::vector<std::byte> &file_data) {
     // Open the tag
     auto tag = open_file(file_path);
     if(!tag.has_value()) {
@@ -23,7 +26,6 @@ std::size_t refactor_tags(const std::filesystem::path &file_path, const std::vec
     }
 
     // Get the header
-    std::vector<std::byte> file_data;
     std::size_t count = 0;
 
     try {
@@ -35,22 +37,21 @@ std::size_t refactor_tags(const std::filesystem::path &file_path, const std::vec
         if(count) {
             file_data = tag_data->generate_hek_tag_data(header->tag_fourcc);
         }
-        else {
-            return count;
-        }
     }
     catch(std::exception &e) {
         eprintf_error("Error: Failed to refactor in %s", file_path.string().c_str());
         std::exit(EXIT_FAILURE);
     }
 
-    if(!check_only) {
-        if(!dry_run && !save_file(file_path, file_data)) {
-            eprintf_error("Error: Failed to write to %s. This tag will need to be manually edited.", file_path.string().c_str());
-            return 0;
-        }
-        oprintf_success("Replaced %zu reference%s in %s", count, count == 1 ? "" : "s", file_path.string().c_str());
+    return count;
+}
+
+std::size_t save_refactored_tag(const std::filesystem::path &file_path, std::size_t count, const std::vector<std::byte> &file_data, bool dry_run) {
+    if(!dry_run && !save_file(file_path, file_data)) {
+        eprintf_error("Error: Failed to write to %s. This tag will need to be manually edited.", file_path.string().c_str());
+        return 0;
     }
+    oprintf_success("Replaced %zu reference%s in %s", count, count == 1 ? "" : "s", file_path.string().c_str());
 
     return count;
 }
@@ -76,6 +77,7 @@ int main(int argc, char * const *argv) {
         CommandLineOption("tag", 'T', 2, "Refactor an individual tag. This can be specified multiple times but cannot be used with --recursive.", "<f> <t>"),
         CommandLineOption("groups", 'g', 2, "Refactor all tags of a given group to another group. All tags in the destination group must exist. This can be specified multiple times but cannot be used with --recursive or -M move.", "<f> <t>"),
         CommandLineOption("single-tag", 's', 1, "Make changes to a single tag, only, rather than the whole tags directory.", "<path>"),
+        CommandLineOption("index", 'x', 0, "Keep an index of what each tag references in each tags directory (.invader-tag-index) so only tags that changed since the last time need to be read."),
         CommandLineOption("replace-string", 'R', 2, "Replaces all instances in a path of <a> with <b>. This can be used multiple times for multiple replacements. If --groups or --recursive are used, this applies to the output of those. Otherwise, it applies to all tags.", "<a> <b>")
     };
 
@@ -88,6 +90,7 @@ int main(int argc, char * const *argv) {
         std::optional<RefactorMode> mode;
         const char *single_tag = nullptr;
         bool unsafe = false;
+        bool use_index = false;
 
         std::vector<std::pair<std::string, std::string>> string_replacements;
         std::vector<std::pair<TagFilePath, TagFilePath>> replacements;
@@ -117,6 +120,9 @@ int main(int argc, char * const *argv) {
             case 'U':
                 refactor_options.unsafe = true;
                 break;
+            case 'x':
+                refactor_options.use_index = true;
+                break;
             case 'M':
                 if(std::strcmp(arguments[0], "move") == 0) {
                     refactor_options.mode = RefactorMode::REFACTOR_MODE_MOVE;
@@ -468,21 +474,53 @@ int main(int argc, char * const *argv) {
         }
     };
     
+    // Index what every tag references so only tags that reference something we're replacing need to be parsed
+    std::optional<TagDependencyIndex> dependency_index;
+    if(!refactor_options.single_tag) {
+        dependency_index = refactor_options.use_index ? TagDependencyIndex::index_tags_directories(all_tags, refactor_options.tags) : TagDependencyIndex::index_virtual_tag_folder(all_tags);
+        if(dependency_index->get_error_count() > 0) {
+            eprintf_error("Error: Failed to read %zu tag%s", dependency_index->get_error_count(), dependency_index->get_error_count() == 1 ? "" : "s");
+            return EXIT_FAILURE;
+        }
+    }
+
     // Before we do our thing, perform the move if we need to copy
     if(*refactor_options.mode == RefactorMode::REFACTOR_MODE_COPY) {
         perform_move();
         
         // Refresh our directory to account for copies
         all_tags = load_virtual_tag_folder(refactor_options.tags);
+
+        // Add the copies to the index
+        if(dependency_index.has_value()) {
+            for(auto &tag : all_tags) {
+                if(!dependency_index->get_file_path(*File::split_tag_class_extension(File::preferred_path_to_halo_path(tag.tag_path)))) {
+                    dependency_index->update_tag(tag);
+                }
+            }
+        }
+    }
+
+    std::set<TagFilePath> referencing_tags;
+    if(dependency_index.has_value()) {
+        for(auto &i : replacements) {
+            auto &referrers = dependency_index->get_referrers(i.first);
+            referencing_tags.insert(referrers.begin(), referrers.end());
+        }
     }
 
     // Go through all the tags and see what needs edited
     std::size_t total_tags = 0;
     std::size_t total_replaced = 0;
-    std::vector<TagFile *> tags_to_do;
+    std::vector<std::tuple<TagFile *, std::size_t, std::vector<std::byte>>> tags_to_do;
 
     for(auto &tag : *tag_to_modify) {
         bool skip = false;
+
+        // If we have an index, skip anything that doesn't reference what we're replacing
+        if(dependency_index.has_value() && !referencing_tags.contains(*File::split_tag_class_extension(File::preferred_path_to_halo_path(tag.tag_path)))) {
+            continue;
+        }
         
         // If copying and we aren't performing a dry run, don't modify the original tags
         if(*refactor_options.mode == RefactorMode::REFACTOR_MODE_COPY) {
@@ -519,14 +557,18 @@ int main(int argc, char * const *argv) {
                 break;
         }
         
-        if(!skip && refactor_tags(tag.full_path.string().c_str(), replacements, true, refactor_options.dry_run)) {
-            tags_to_do.emplace_back(&tag);
+        if(!skip) {
+            std::vector<std::byte> file_data;
+            auto count = refactor_tags(tag.full_path, replacements, file_data);
+            if(count) {
+                tags_to_do.emplace_back(&tag, count, std::move(file_data));
+            }
         }
     }
 
     // Now actually do it
-    for(auto *tag : tags_to_do) {
-        std::size_t count = refactor_tags(tag->full_path.string().c_str(), replacements, false, refactor_options.dry_run);
+    for(auto &[tag, count_to_replace, file_data] : tags_to_do) {
+        std::size_t count = save_refactored_tag(tag->full_path, count_to_replace, file_data, refactor_options.dry_run);
         if(count) {
             total_replaced += count;
             total_tags++;
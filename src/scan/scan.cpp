@@ -3,6 +3,9 @@
 #include <vector>
 #include <string>
 #include <filesystem>
+#include <thread>
+#include <atomic>
+#include <map>
 #include <invader/printf.hpp>
 #include <invader/version.hpp>
 #include <invader/tag/hek/header.hpp>
@@ -14,51 +17,184 @@
 
 int main(int argc, char * const *argv) {
     set_up_color_term();
-    
+
     using namespace Invader;
-    
+
     const CommandLineOption options[] {
-        CommandLineOption::from_preset(CommandLineOption::PRESET_COMMAND_LINE_OPTION_INFO)
+        CommandLineOption::from_preset(CommandLineOption::PRESET_COMMAND_LINE_OPTION_INFO),
+        CommandLineOption("threads", 'j', 1, "Set the number of threads to use for scanning tags. Default: CPU thread count"),
+        CommandLineOption("summary", 's', 0, "Only show how many times each struct had non-zero data at each offset across all maps rather than each tag.")
     };
 
     static constexpr char DESCRIPTION[] = "Scans for unknown hidden data in tags";
-    static constexpr char USAGE[] = "[options] <map>";
+    static constexpr char USAGE[] = "[options] <map> [map ...]";
 
     struct ScanOptions {
+        std::size_t max_threads = std::thread::hardware_concurrency() < 1 ? 1 : std::thread::hardware_concurrency();
+        bool summary = false;
     } scan_options;
 
-    auto remaining_arguments = CommandLineOption::parse_arguments<ScanOptions &>(argc, argv, options, USAGE, DESCRIPTION, 1, 1, scan_options, [](char opt, const std::vector<const char *> &, ScanOptions &) {
+    auto remaining_arguments = CommandLineOption::parse_arguments<ScanOptions &>(argc, argv, options, USAGE, DESCRIPTION, 1, SIZE_MAX, scan_options, [](char opt, const std::vector<const char *> &arguments, ScanOptions &scan_options) {
         switch(opt) {
             case 'i':
                 show_version_info();
                 std::exit(EXIT_SUCCESS);
+            case 'j':
+                try {
+                    scan_options.max_threads = std::stoul(arguments[0]);
+                }
+                catch(std::exception &) {
+                    eprintf_error("Invalid number of threads %s", arguments[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                if(scan_options.max_threads < 1) {
+                    eprintf_error("Invalid number of threads %s", arguments[0]);
+                    std::exit(EXIT_FAILURE);
+                }
+                break;
+            case 's':
+                scan_options.summary = true;
+                break;
         }
     });
-    
-    auto map_data = File::open_file(remaining_arguments[0]).value();
-    auto map = Map::map_with_copy(map_data.data(), map_data.size());
-    auto tag_count = map.get_tag_count();
-    
-    for(std::size_t t = 0; t < tag_count; t++) {
-        auto &tag = map.get_tag(t);
-        if(!tag.data_is_available()) {
-            continue;
+
+    // Each tag's results are kept so output stays in order regardless of which thread finished first
+    struct ScannedTag {
+        std::vector<Parser::PaddingScanResult> results;
+        std::optional<std::string> error;
+    };
+
+    // Number of times a struct had a non-zero byte at an offset and how many tags it was found in
+    struct SummaryEntry {
+        std::size_t count = 0;
+        std::size_t tag_count = 0;
+    };
+    std::map<std::pair<std::string, std::size_t>, SummaryEntry> summary;
+    std::size_t total_tags = 0;
+    std::size_t total_tags_with_results = 0;
+    std::size_t total_results = 0;
+    bool failed = false;
+
+    for(auto *map_path : remaining_arguments) {
+        auto map_data = File::open_file(map_path);
+        if(!map_data.has_value()) {
+            eprintf_error("Failed to read %s", map_path);
+            return EXIT_FAILURE;
         }
-        
-        #define DO_TAG_CLASS(c, v) case HEK::v: {\
-            Parser::c::scan_padding(tag);\
-            break;\
+
+        std::unique_ptr<Map> map_ptr;
+        try {
+            map_ptr = std::make_unique<Map>(Map::map_with_move(std::move(*map_data)));
         }
-        
-        auto tci = tag.get_tag_fourcc();
-        if(tci == HEK::TagFourCC::TAG_FOURCC_SCENARIO_STRUCTURE_BSP && map.get_cache_version() != HEK::CacheFileEngine::CACHE_FILE_NATIVE) {
-            Parser::ScenarioStructureBSP::scan_padding(tag, tag.get_base_struct<HEK::ScenarioStructureBSPCompiledHeader>().pointer);
-            continue;
+        catch(std::exception &e) {
+            eprintf_error("Failed to parse %s: %s", map_path, e.what());
+            return EXIT_FAILURE;
         }
-        
-        switch(tci) {
-            DO_BASED_ON_TAG_CLASS
-            default: break;
+
+        const auto &map = *map_ptr;
+        auto tag_count = map.get_tag_count();
+        std::vector<ScannedTag> scanned(tag_count);
+        std::atomic<std::size_t> next_tag = 0;
+
+        auto scan_thread = [&map, &scanned, &next_tag, &tag_count]() {
+            while(true) {
+                auto t = next_tag.fetch_add(1, std::memory_order_relaxed);
+                if(t >= tag_count) {
+                    return;
+                }
+
+                auto &tag = map.get_tag(t);
+                if(!tag.data_is_available()) {
+                    continue;
+                }
+
+                auto &results = scanned[t].results;
+                try {
+                    #define DO_TAG_CLASS(c, v) case HEK::v: {\
+                        Parser::c::scan_padding(tag, results);\
+                        break;\
+                    }
+
+                    auto tci = tag.get_tag_fourcc();
+                    if(tci == HEK::TagFourCC::TAG_FOURCC_SCENARIO_STRUCTURE_BSP && map.get_cache_version() != HEK::CacheFileEngine::CACHE_FILE_NATIVE) {
+                        Parser::ScenarioStructureBSP::scan_padding(tag, results, tag.get_base_struct<HEK::ScenarioStructureBSPCompiledHeader>().pointer);
+                        continue;
+                    }
+
+                    switch(tci) {
+                        DO_BASED_ON_TAG_CLASS
+                        default: break;
+                    }
+
+                    #undef DO_TAG_CLASS
+                }
+                catch(std::exception &e) {
+                    scanned[t].error = e.what();
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        auto thread_count = std::min(scan_options.max_threads, tag_count);
+        threads.reserve(thread_count);
+        for(std::size_t j = 0; j < thread_count; j++) {
+            threads.emplace_back(scan_thread);
+        }
+        for(auto &t : threads) {
+            t.join();
+        }
+
+        // Report results
+        if(!scan_options.summary && remaining_arguments.size() > 1) {
+            oprintf("%s:\n", map_path);
+        }
+
+        for(std::size_t t = 0; t < tag_count; t++) {
+            auto &tag = map.get_tag(t);
+            auto &s = scanned[t];
+            auto *extension = HEK::tag_fourcc_to_extension(tag.get_tag_fourcc());
+
+            if(s.error.has_value()) {
+                eprintf_error("Failed to scan %s.%s: %s", tag.get_path().c_str(), extension, s.error->c_str());
+                failed = true;
+            }
+
+            total_tags++;
+            if(s.results.empty()) {
+                continue;
+            }
+            total_tags_with_results++;
+            total_results += s.results.size();
+
+            if(!scan_options.summary) {
+                for(auto &r : s.results) {
+                    oprintf("%s.%s: %s @ 0x%04zX - %02X\n", tag.get_path().c_str(), extension, r.struct_name, r.offset, r.value);
+                }
+                continue;
+            }
+
+            // Count each struct and offset once per tag for the tag count
+            std::map<std::pair<std::string, std::size_t>, bool> found_in_tag;
+            for(auto &r : s.results) {
+                auto key = std::pair<std::string, std::size_t>(r.struct_name, r.offset);
+                auto &entry = summary[key];
+                entry.count++;
+                auto &found = found_in_tag[key];
+                if(!found) {
+                    entry.tag_count++;
+                    found = true;
+                }
+            }
         }
     }
+
+    if(scan_options.summary) {
+        for(auto &i : summary) {
+            auto &entry = i.second;
+            oprintf("%s @ 0x%04zX - %zu time%s in %zu tag%s\n", i.first.first.c_str(), i.first.second, entry.count, entry.count == 1 ? "" : "s", entry.tag_count, entry.tag_count == 1 ? "" : "s");
+        }
+        oprintf("Found %zu non-zero byte%s in %zu of %zu tag%s\n", total_results, total_results == 1 ? "" : "s", total_tags_with_results, total_tags, total_tags == 1 ? "" : "s");
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -118,8 +118,9 @@ int main(int argc, char * const *argv) {
         return strip_tag(File::tag_path_to_file_path(*single_tag, strip_options.tags).string().c_str(), File::halo_path_to_preferred_path(single_tag->join())) ? EXIT_SUCCESS : EXIT_FAILURE;
     }
     
+    File::PathMatcher matcher(strip_options.search, strip_options.search_exclude);
     for(auto &i : File::load_virtual_tag_folder( { strip_options.tags } )) {
-        if(File::path_matches(i.tag_path.c_str(), strip_options.search, strip_options.search_exclude)) {
+        if(matcher.matches(i.tag_path)) {
             total++;
             success += strip_tag(i.full_path.c_str(), i.tag_path) ? 1 : 0;
         }
@@ -4,8 +4,8 @@ from copy import deepcopy
 from compile import make_cache_format_data
 from generate_hek_tag_data import make_cpp_save_hek_data
 from read_cache_file_data import make_parse_cache_file_data
-from read_hek_data import make_parse_hek_tag_data
-from read_hek_file import make_parse_hek_tag_file
+from read_hek_data import make_parse_hek_tag_data, make_scan_hek_tag_dependencies, get_dependency_scan_info
+from read_hek_file import make_parse_hek_tag_file, make_scan_hek_tag_file_dependencies
 from cache_deformat_data import make_cache_deformat
 from refactor_reference import make_refactor_reference
 from parser_struct import make_parser_struct
@@ -51,9 +51,12 @@ def make_parser(all_enums, all_bitfields, all_structs_arranged, all_structs, hpp
     cpp_cache_format_data.write("#include <invader/build/build_workload.hpp>\n")
     cpp_read_cache_file_data.write("#include <invader/file/file.hpp>\n")
     cpp_read_hek_data.write("#include <invader/file/file.hpp>\n")
+    cpp_read_hek_data.write("#include <cstring>\n")
     cpp_save_hek_data.write("extern \"C\" std::uint32_t crc32(std::uint32_t crc, const void *buf, std::size_t size) noexcept;\n")
     write_for_all_cpps("namespace Invader::Parser {\n")
 
+    dependency_scan_info = get_dependency_scan_info(all_structs)
+
     for struct in all_structs_arranged:
         struct_name = struct["name"]
         post_cache_deformat = "post_cache_deformat" in struct and struct["post_cache_deformat"]
@@ -187,6 +190,8 @@ def make_parser(all_enums, all_bitfields, all_structs_arranged, all_structs, hpp
         make_parse_cache_file_data(post_cache_parse, all_bitfields, all_used_structs, struct_name, hpp, cpp_read_cache_file_data)
         make_parse_hek_tag_data(postprocess_hek_data, all_bitfields, struct_name, all_used_structs, hpp, cpp_read_hek_data)
         make_parse_hek_tag_file(struct_name, hpp, cpp_read_hek_file)
+        make_scan_hek_tag_dependencies(dependency_scan_info, struct_name, all_used_structs, hpp, cpp_read_hek_data)
+        make_scan_hek_tag_file_dependencies(struct_name, hpp, cpp_read_hek_file)
         make_refactor_reference(all_used_structs, struct_name, hpp, cpp_refactor_reference)
         make_parser_struct(cpp_struct_value, all_enums, all_bitfields, all_used_structs, all_used_groups, hpp, struct_name, read_only, title)
         make_check_invalid_ranges(all_used_structs, struct_name, hpp, cpp_check_invalid_ranges)
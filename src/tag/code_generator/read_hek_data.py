@@ -53,7 +53,9 @@ def make_parse_hek_tag_data(postprocess_hek_data, all_bitfields, struct_name, al
                 cpp_read_hek_data.write("                throw InvalidTagDataException();\n")
                 cpp_read_hek_data.write("            }\n")
                 if not unread:
-                    cpp_read_hek_data.write("            r.{}.path = Invader::File::remove_duplicate_slashes(std::string(reinterpret_cast<const char *>(data)));\n".format(name))
+                    cpp_read_hek_data.write("            r.{}.path.assign(h_{}_char, h_{}_expected_length);\n".format(name, name, name))
+                    cpp_read_hek_data.write("            Invader::File::remove_duplicate_slashes_chars(r.{}.path.data());\n".format(name))
+                    cpp_read_hek_data.write("            r.{}.path.resize(std::strlen(r.{}.path.c_str()));\n".format(name, name))
                 cpp_read_hek_data.write("            data_size -= h_{}_expected_length + 1;\n".format(name))
                 cpp_read_hek_data.write("            data_read += h_{}_expected_length + 1;\n".format(name))
                 cpp_read_hek_data.write("            data += h_{}_expected_length + 1;\n".format(name))
@@ -175,3 +177,146 @@ def make_parse_hek_tag_data(postprocess_hek_data, all_bitfields, struct_name, al
         cpp_read_hek_data.write("        }\n")
     cpp_read_hek_data.write("        return r;\n")
     cpp_read_hek_data.write("    }\n")
+
+def get_dependency_scan_info(all_structs):
+    structs_by_name = {}
+    for s in all_structs:
+        structs_by_name[s["name"]] = s
+
+    def get_fields(struct):
+        fields = []
+        if "inherits" in struct:
+            fields = get_fields(structs_by_name[struct["inherits"]])
+        for f in struct["fields"]:
+            if f["type"] != "pad":
+                fields.append(f)
+        return fields
+
+    # Structs with data after them can't be skipped over without reading them
+    variable_size = set()
+    for s in all_structs:
+        for f in get_fields(s):
+            if f["type"] == "TagDependency" or f["type"] == "TagReflexive" or f["type"] == "TagDataOffset":
+                variable_size.add(s["name"])
+                break
+
+    # Structs that have dependencies (or have reflexives with dependencies) shown as values
+    has_dependencies = set()
+    changed = True
+    while changed:
+        changed = False
+        for s in all_structs:
+            if s["name"] in has_dependencies:
+                continue
+            for f in get_fields(s):
+                if not is_dependency_scan_value_listed(f):
+                    continue
+                if f["type"] == "TagDependency" or (f["type"] == "TagReflexive" and f["struct"] in has_dependencies):
+                    has_dependencies.add(s["name"])
+                    changed = True
+                    break
+
+    return (variable_size, has_dependencies)
+
+# Match what is listed by get_values() so scanning finds the same dependencies
+def is_dependency_scan_value_listed(struct):
+    if "hidden" in struct and struct["hidden"]:
+        return False
+    if ("cache_only" in struct and struct["cache_only"]) or ("endian" in struct and struct["endian"] == "little") or ("unused" in struct and struct["unused"]):
+        return False
+    return True
+
+# Match what compile.py skips so cache file scans don't follow references the build never loads
+def is_dependency_scan_value_compiled(struct):
+    return not (("non_cached" in struct and struct["non_cached"]) or ("compile_ignore" in struct and struct["compile_ignore"]))
+
+def make_scan_hek_tag_dependencies(dependency_scan_info, struct_name, all_used_structs, hpp, cpp_read_hek_data):
+    (variable_size, has_dependencies) = dependency_scan_info
+
+    hpp.write("\n        /**\n")
+    hpp.write("         * Find the dependencies in the HEK tag data without parsing it.\n")
+    hpp.write("         * @param data        Data to read from for structs, tag references, and reflexives; if data_this is nullptr, this must point to the struct\n")
+    hpp.write("         * @param data_size   Size of the buffer\n")
+    hpp.write("         * @param data_read   This will be set to the amount of data read. If data_this is null, then the initial struct will also be added\n")
+    hpp.write("         * @param callback    Function to call for each dependency found; if this is null, the data is only checked\n")
+    hpp.write("         * @param data_this   Pointer to the struct; if this is null, then data will be used instead\n")
+    hpp.write("         * @param cache_only  Only find dependencies that are compiled into cache files\n")
+    hpp.write("         */\n")
+    hpp.write("        static void scan_hek_tag_data_dependencies(const std::byte *data, std::size_t data_size, std::size_t &data_read, const DependencyCallback *callback, const std::byte *data_this = nullptr, bool cache_only = false);\n")
+    cpp_read_hek_data.write("    void {}::scan_hek_tag_data_dependencies(const std::byte *data, std::size_t data_size, std::size_t &data_read, [[maybe_unused]] const DependencyCallback *callback, const std::byte *data_this, [[maybe_unused]] bool cache_only) {{\n".format(struct_name))
+    cpp_read_hek_data.write("        data_read = 0;\n")
+    cpp_read_hek_data.write("        if(data_this == nullptr) {\n")
+    cpp_read_hek_data.write("            if(sizeof(struct_big) > data_size) {\n")
+    cpp_read_hek_data.write("                eprintf_error(\"Failed to read {} base struct: %zu bytes needed > %zu bytes available\", sizeof(struct_big), data_size);\n".format(struct_name))
+    cpp_read_hek_data.write("                throw OutOfBoundsException();\n")
+    cpp_read_hek_data.write("            }\n")
+    cpp_read_hek_data.write("            data_this = data;\n")
+    cpp_read_hek_data.write("            data_size -= sizeof(struct_big);\n")
+    cpp_read_hek_data.write("            data_read += sizeof(struct_big);\n")
+    cpp_read_hek_data.write("            data += sizeof(struct_big);\n")
+    cpp_read_hek_data.write("        }\n")
+    if struct_name in variable_size:
+        cpp_read_hek_data.write("        [[maybe_unused]] const auto &h = *reinterpret_cast<const HEK::{}<HEK::BigEndian> *>(data_this);\n".format(struct_name))
+        for struct in all_used_structs:
+            name = struct["member_name"]
+            listed = is_dependency_scan_value_listed(struct)
+            compiled = is_dependency_scan_value_compiled(struct)
+            if struct["type"] == "TagDependency":
+                cpp_read_hek_data.write("        std::size_t h_{}_expected_length = h.{}.path_size;\n".format(name,name))
+                cpp_read_hek_data.write("        if(h_{}_expected_length > 0) {{\n".format(name))
+                cpp_read_hek_data.write("            if(h_{}_expected_length + 1 > data_size) {{\n".format(name))
+                cpp_read_hek_data.write("                eprintf_error(\"Failed to read dependency {}::{}: %zu bytes needed > %zu bytes available\", h_{}_expected_length, data_size);\n".format(struct_name, name, name))
+                cpp_read_hek_data.write("                throw OutOfBoundsException();\n")
+                cpp_read_hek_data.write("            }\n")
+                cpp_read_hek_data.write("            if(std::memchr(data, 0, h_{}_expected_length) != nullptr) {{\n".format(name))
+                cpp_read_hek_data.write("                eprintf_error(\"Failed to read dependency {}::{}: size is smaller than expected\");\n".format(struct_name, name))
+                cpp_read_hek_data.write("                throw InvalidTagDataException();\n")
+                cpp_read_hek_data.write("            }\n")
+                cpp_read_hek_data.write("            if(static_cast<char>(data[h_{}_expected_length]) != 0) {{\n".format(name))
+                cpp_read_hek_data.write("                eprintf_error(\"Failed to read dependency {}::{}: missing null terminator\");\n".format(struct_name, name))
+                cpp_read_hek_data.write("                throw InvalidTagDataException();\n")
+                cpp_read_hek_data.write("            }\n")
+                if listed:
+                    cpp_read_hek_data.write("            if(callback{}) {{\n".format("" if compiled else " && !cache_only"))
+                    cpp_read_hek_data.write("                (*callback)(h.{}.tag_fourcc, std::string_view(reinterpret_cast<const char *>(data), h_{}_expected_length));\n".format(name, name))
+                    cpp_read_hek_data.write("            }\n")
+                cpp_read_hek_data.write("            data_size -= h_{}_expected_length + 1;\n".format(name))
+                cpp_read_hek_data.write("            data_read += h_{}_expected_length + 1;\n".format(name))
+                cpp_read_hek_data.write("            data += h_{}_expected_length + 1;\n".format(name))
+                cpp_read_hek_data.write("        }\n")
+            elif struct["type"] == "TagReflexive":
+                cpp_read_hek_data.write("        std::size_t h_{}_count = h.{}.count;\n".format(name,name))
+                cpp_read_hek_data.write("        if(h_{}_count > 0) {{\n".format(name))
+                cpp_read_hek_data.write("            const auto *array = reinterpret_cast<const HEK::{}<HEK::BigEndian> *>(data);\n".format(struct["struct"]))
+                cpp_read_hek_data.write("            std::size_t total_size = sizeof(*array) * h_{}_count;\n".format(name))
+                cpp_read_hek_data.write("            if(total_size > data_size) {\n")
+                cpp_read_hek_data.write("                eprintf_error(\"Failed to read reflexive {}::{}: %zu bytes needed > %zu bytes available\", total_size, data_size);\n".format(struct_name, name))
+                cpp_read_hek_data.write("                throw OutOfBoundsException();\n")
+                cpp_read_hek_data.write("            }\n")
+                cpp_read_hek_data.write("            data_size -= total_size;\n")
+                cpp_read_hek_data.write("            data_read += total_size;\n")
+                cpp_read_hek_data.write("            data += total_size;\n")
+
+                # If there's nothing after each element, we're done; otherwise, go through them (only reporting dependencies if there are any to report)
+                if struct["struct"] in variable_size:
+                    child_callback = "callback" if listed and struct["struct"] in has_dependencies else "nullptr"
+                    if child_callback != "nullptr" and not compiled:
+                        child_callback = "cache_only ? nullptr : callback"
+                    cpp_read_hek_data.write("            for(std::size_t ref = 0; ref < h_{}_count; ref++) {{\n".format(name))
+                    cpp_read_hek_data.write("                std::size_t ref_data_read = 0;\n")
+                    cpp_read_hek_data.write("                {}::scan_hek_tag_data_dependencies(data, data_size, ref_data_read, {}, reinterpret_cast<const std::byte *>(array + ref), cache_only);\n".format(struct["struct"], child_callback))
+                    cpp_read_hek_data.write("                data += ref_data_read;\n")
+                    cpp_read_hek_data.write("                data_read += ref_data_read;\n")
+                    cpp_read_hek_data.write("                data_size -= ref_data_read;\n")
+                    cpp_read_hek_data.write("            }\n")
+                cpp_read_hek_data.write("        }\n")
+            elif struct["type"] == "TagDataOffset":
+                cpp_read_hek_data.write("        std::size_t h_{}_size = h.{}.size;\n".format(name, name))
+                cpp_read_hek_data.write("        if(h_{}_size > data_size) {{\n".format(name))
+                cpp_read_hek_data.write("            eprintf_error(\"Failed to read tag data block {}::{}: %zu bytes needed > %zu bytes available\", h_{}_size, data_size);\n".format(struct_name, name, name))
+                cpp_read_hek_data.write("            throw OutOfBoundsException();\n")
+                cpp_read_hek_data.write("        }\n")
+                cpp_read_hek_data.write("        data_size -= h_{}_size;\n".format(name))
+                cpp_read_hek_data.write("        data_read += h_{}_size;\n".format(name))
+                cpp_read_hek_data.write("        data += h_{}_size;\n".format(name))
+    cpp_read_hek_data.write("    }\n")
@@ -20,3 +20,23 @@ def make_parse_hek_tag_file(struct_name, hpp, cpp_read_hek_data):
     cpp_read_hek_data.write("        }\n")
     cpp_read_hek_data.write("        return r;\n")
     cpp_read_hek_data.write("    }\n")
+
+def make_scan_hek_tag_file_dependencies(struct_name, hpp, cpp_read_hek_data):
+    hpp.write("\n        /**\n")
+    hpp.write("         * Find the dependencies in the HEK tag file without parsing it.\n")
+    hpp.write("         * @param data       Tag file data to read from\n")
+    hpp.write("         * @param data_size  Size of the tag file\n")
+    hpp.write("         * @param callback   Function to call for each dependency found\n")
+    hpp.write("         * @param cache_only Only find dependencies that are compiled into cache files\n")
+    hpp.write("         */\n")
+    hpp.write("        static void scan_hek_tag_file_dependencies(const std::byte *data, std::size_t data_size, const DependencyCallback &callback, bool cache_only = false);\n")
+    cpp_read_hek_data.write("    void {}::scan_hek_tag_file_dependencies(const std::byte *data, std::size_t data_size, const DependencyCallback &callback, bool cache_only) {{\n".format(struct_name))
+    cpp_read_hek_data.write("        HEK::TagFileHeader::validate_header(reinterpret_cast<const HEK::TagFileHeader *>(data), data_size);\n")
+    cpp_read_hek_data.write("        std::size_t data_read = 0;\n")
+    cpp_read_hek_data.write("        std::size_t expected_data_read = data_size - sizeof(HEK::TagFileHeader);\n")
+    cpp_read_hek_data.write("        scan_hek_tag_data_dependencies(data + sizeof(HEK::TagFileHeader), expected_data_read, data_read, &callback, nullptr, cache_only);\n")
+    cpp_read_hek_data.write("        if(data_read != expected_data_read) {\n")
+    cpp_read_hek_data.write("            eprintf_error(\"invalid tag file; tag data was left over\");\n")
+    cpp_read_hek_data.write("            throw InvalidTagDataException();\n")
+    cpp_read_hek_data.write("        }\n")
+    cpp_read_hek_data.write("    }\n")
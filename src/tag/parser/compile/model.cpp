@@ -210,20 +210,37 @@ namespace Invader::Parser {
                 return true;
             }
 
-            part.uncompressed_vertices.reserve(part.compressed_vertices.size());
-            for(auto &v : part.compressed_vertices) {
-                auto before_data = v.generate_hek_tag_data();
-                auto after_data = HEK::decompress_model_vertex(*reinterpret_cast<ModelVertexCompressed::struct_big *>(before_data.data()));
+            // Decompress everything in one go
+            auto vertex_count = part.compressed_vertices.size();
+            std::vector<HEK::ModelVertexCompressed<HEK::NativeEndian>> before_data(vertex_count);
+            std::vector<HEK::ModelVertexUncompressed<HEK::NativeEndian>> after_data(vertex_count);
+            for(std::size_t i = 0; i < vertex_count; i++) {
+                auto &v = part.compressed_vertices[i];
+                auto &before_data_write = before_data[i];
+                before_data_write.position = v.position;
+                before_data_write.normal = v.normal;
+                before_data_write.binormal = v.binormal;
+                before_data_write.tangent = v.tangent;
+                before_data_write.texture_coordinate_u = v.texture_coordinate_u;
+                before_data_write.texture_coordinate_v = v.texture_coordinate_v;
+                before_data_write.node0_index = v.node0_index;
+                before_data_write.node1_index = v.node1_index;
+                before_data_write.node0_weight = v.node0_weight;
+            }
+            HEK::decompress_model_vertices(before_data.data(), after_data.data(), vertex_count);
+
+            part.uncompressed_vertices.reserve(vertex_count);
+            for(auto &a : after_data) {
                 auto &after_data_write = part.uncompressed_vertices.emplace_back();
-                after_data_write.binormal = after_data.binormal;
-                after_data_write.normal = after_data.normal;
-                after_data_write.position = after_data.position;
-                after_data_write.tangent = after_data.tangent;
-                after_data_write.node0_index = after_data.node0_index;
-                after_data_write.node0_weight = after_data.node0_weight;
-                after_data_write.node1_index = after_data.node1_index;
-                after_data_write.node1_weight = after_data.node1_weight;
-                after_data_write.texture_coords = after_data.texture_coords;
+                after_data_write.binormal = a.binormal;
+                after_data_write.normal = a.normal;
+                after_data_write.position = a.position;
+                after_data_write.tangent = a.tangent;
+                after_data_write.node0_index = a.node0_index;
+                after_data_write.node0_weight = a.node0_weight;
+                after_data_write.node1_index = a.node1_index;
+                after_data_write.node1_weight = a.node1_weight;
+                after_data_write.texture_coords = a.texture_coords;
             }
         }
         else if(part.compressed_vertices.size() == 0 && part.uncompressed_vertices.size() > 0) {
@@ -260,26 +277,39 @@ namespace Invader::Parser {
                 return true;
             }
 
-            part.compressed_vertices.reserve(part.uncompressed_vertices.size());
+            // Resolve local nodes before throwing them into the compressor
+            auto vertex_count = part.uncompressed_vertices.size();
+            std::vector<HEK::ModelVertexUncompressed<HEK::NativeEndian>> before_data(vertex_count);
+            std::vector<HEK::ModelVertexCompressed<HEK::NativeEndian>> after_data(vertex_count);
+            for(std::size_t i = 0; i < vertex_count; i++) {
+                auto &v = part.uncompressed_vertices[i];
+                auto &before_data_write = before_data[i];
+                before_data_write.position = v.position;
+                before_data_write.normal = v.normal;
+                before_data_write.binormal = v.binormal;
+                before_data_write.tangent = v.tangent;
+                before_data_write.texture_coords = v.texture_coords;
+                before_data_write.node0_index = resolve_local_node(v.node0_index);
+                before_data_write.node1_index = resolve_local_node(v.node1_index);
+                before_data_write.node0_weight = v.node0_weight;
+                before_data_write.node1_weight = v.node1_weight;
+            }
 
-            for(auto &v : part.uncompressed_vertices) {
-                // Resolve local nodes before throwing them into the compressor
-                auto before_data_copy = *reinterpret_cast<ModelVertexUncompressed::struct_big *>(v.generate_hek_tag_data().data());
-                before_data_copy.node0_index = resolve_local_node(before_data_copy.node0_index);
-                before_data_copy.node1_index = resolve_local_node(before_data_copy.node1_index);
+            // Done
+            HEK::compress_model_vertices(before_data.data(), after_data.data(), vertex_count);
 
-                // Done
-                auto after_data = HEK::compress_model_vertex(before_data_copy);
+            part.compressed_vertices.reserve(vertex_count);
+            for(auto &a : after_data) {
                 auto &after_data_write = part.compressed_vertices.emplace_back();
-                after_data_write.binormal = after_data.binormal;
-                after_data_write.normal = after_data.normal;
-                after_data_write.position = after_data.position;
-                after_data_write.tangent = after_data.tangent;
-                after_data_write.node0_index = after_data.node0_index;
-                after_data_write.node0_weight = after_data.node0_weight;
-                after_data_write.node1_index = after_data.node1_index;
-                after_data_write.texture_coordinate_u = after_data.texture_coordinate_u;
-                after_data_write.texture_coordinate_v = after_data.texture_coordinate_v;
+                after_data_write.binormal = a.binormal;
+                after_data_write.normal = a.normal;
+                after_data_write.position = a.position;
+                after_data_write.tangent = a.tangent;
+                after_data_write.node0_index = a.node0_index;
+                after_data_write.node0_weight = a.node0_weight;
+                after_data_write.node1_index = a.node1_index;
+                after_data_write.texture_coordinate_u = a.texture_coordinate_u;
+                after_data_write.texture_coordinate_v = a.texture_coordinate_v;
             }
         }
         else if(part.compressed_vertices.size() != part.uncompressed_vertices.size()) {
@@ -770,7 +800,7 @@ namespace Invader::Parser {
         pre_compile_model(*this, workload, tag_index);
     }
 
-    template<class P, class PartVertex, class CacheVertex> static void pre_compile_model_geometry_part(P &what, BuildWorkload &workload, std::size_t tag_index, std::size_t struct_index, std::size_t struct_offset, const std::vector<PartVertex> &part_vertices, std::vector<CacheVertex> &workload_vertices) {
+    template<class P, class PartVertex, class CacheVertex> static void pre_compile_model_geometry_part(P &what, BuildWorkload &workload, std::size_t tag_index, std::size_t struct_index, std::size_t struct_offset, const std::vector<PartVertex> &part_vertices, std::vector<CacheVertex> &workload_vertices, std::unordered_map<std::size_t, std::vector<std::size_t>> &workload_vertices_lookup) {
         auto uncompressed_vertices = sizeof(CacheVertex) == sizeof(Parser::ModelVertexUncompressed::struct_little);
 
         std::vector<HEK::Index> triangle_indices;
@@ -818,17 +848,27 @@ namespace Invader::Parser {
             }
         }
 
-        // See if we can find a copy of this
+        // See if we can find a copy of this; only positions starting with the same three indices need to be checked, and
+        // these are in ascending order, so the first match is the same one a linear search would find
         std::size_t this_indices_count = triangle_indices_size;
         std::size_t indices_count = workload.model_indices.size();
         bool found = false;
 
-        if(indices_count >= this_indices_count) {
+        auto indices_key = [](const auto *indices) -> std::uint64_t {
+            return static_cast<std::uint64_t>(indices[0]) | (static_cast<std::uint64_t>(indices[1]) << 16) | (static_cast<std::uint64_t>(indices[2]) << 32);
+        };
+
+        auto indices_candidates = workload.model_indices_lookup.find(indices_key(triangle_indices.data()));
+        if(indices_candidates != workload.model_indices_lookup.end()) {
             auto &first = triangle_indices[0];
             auto &last = triangle_indices[triangle_indices_size - 1];
             std::size_t check_size = this_indices_count - 1;
 
-            for(std::size_t i = 0; i <= indices_count - this_indices_count; i++) {
+            for(std::size_t i : indices_candidates->second) {
+                if(i + this_indices_count > indices_count) {
+                    break;
+                }
+
                 auto *model_data = workload.model_indices.data() + i;
 
                 // Check the last index, first, since it's most likely to be different
@@ -848,6 +888,12 @@ namespace Invader::Parser {
         if(!found) {
             what.triangle_offset = indices_count * sizeof(workload.model_indices[0]);
             workload.model_indices.insert(workload.model_indices.end(), triangle_indices.begin(), triangle_indices.end());
+
+            // Index every new position (including ones that start before the indices we just added)
+            std::size_t new_indices_count = workload.model_indices.size();
+            for(std::size_t i = indices_count < 2 ? 0 : indices_count - 2; i + 3 <= new_indices_count; i++) {
+                workload.model_indices_lookup[indices_key(workload.model_indices.data() + i)].emplace_back(i);
+            }
         }
         what.triangle_offset_2 = what.triangle_offset;
 
@@ -888,25 +934,44 @@ namespace Invader::Parser {
         // Part thingy
         workload.model_parts.emplace_back(BuildWorkload::BuildWorkloadModelPart { struct_index, struct_offset });
 
-        // Let's see if we can also dedupe this
+        // Let's see if we can also dedupe this (same deal as the indices, but looking up by the first vertex)
         std::size_t this_vertices_count = vertices_of_fun.size();
         std::size_t vertices_count = workload_vertices.size();
         found = false;
 
-        if(vertices_count >= this_vertices_count) {
-            for(std::size_t i = 0; i <= vertices_count - this_vertices_count; i++) {
-                // If vertices match, set the vertices offset to this instead
-                if(std::memcmp(workload_vertices.data() + i, vertices_of_fun.data(), sizeof(CacheVertex) * this_vertices_count) == 0) {
-                    found = true;
-                    what.vertex_offset = i * sizeof(workload_vertices[0]);
-                    break;
+        auto vertex_key = [](const CacheVertex &vertex) -> std::size_t {
+            return std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char *>(&vertex), sizeof(vertex)));
+        };
+
+        if(this_vertices_count > 0) {
+            auto vertices_candidates = workload_vertices_lookup.find(vertex_key(vertices_of_fun[0]));
+            if(vertices_candidates != workload_vertices_lookup.end()) {
+                for(std::size_t i : vertices_candidates->second) {
+                    if(i + this_vertices_count > vertices_count) {
+                        break;
+                    }
+
+                    // If vertices match, set the vertices offset to this instead
+                    if(std::memcmp(workload_vertices.data() + i, vertices_of_fun.data(), sizeof(CacheVertex) * this_vertices_count) == 0) {
+                        found = true;
+                        what.vertex_offset = i * sizeof(workload_vertices[0]);
+                        break;
+                    }
                 }
             }
         }
+        else {
+            // Nothing to compare, so it matches right at the start
+            found = true;
+            what.vertex_offset = 0;
+        }
 
         if(!found) {
             what.vertex_offset = vertices_count * sizeof(CacheVertex);
             workload_vertices.insert(workload_vertices.end(), vertices_of_fun.begin(), vertices_of_fun.end());
+            for(std::size_t i = vertices_count; i < workload_vertices.size(); i++) {
+                workload_vertices_lookup[vertex_key(workload_vertices[i])].emplace_back(i);
+            }
         }
 
         // Don't forget to set these memes
@@ -915,15 +980,15 @@ namespace Invader::Parser {
     }
 
     void GBXModelGeometryPart::pre_compile(BuildWorkload &workload, std::size_t tag_index, std::size_t struct_index, std::size_t offset) {
-        pre_compile_model_geometry_part(*this, workload, tag_index, struct_index, offset, this->uncompressed_vertices, workload.uncompressed_model_vertices);
+        pre_compile_model_geometry_part(*this, workload, tag_index, struct_index, offset, this->uncompressed_vertices, workload.uncompressed_model_vertices, workload.uncompressed_model_vertices_lookup);
     }
 
     void ModelGeometryPart::pre_compile(BuildWorkload &workload, std::size_t tag_index, std::size_t struct_index, std::size_t offset) {
         if(workload.get_build_parameters()->details.build_cache_file_engine == HEK::CacheFileEngine::CACHE_FILE_XBOX) {
-            pre_compile_model_geometry_part(*this, workload, tag_index, struct_index, offset, this->compressed_vertices, workload.compressed_model_vertices);
+            pre_compile_model_geometry_part(*this, workload, tag_index, struct_index, offset, this->compressed_vertices, workload.compressed_model_vertices, workload.compressed_model_vertices_lookup);
         }
         else {
-            pre_compile_model_geometry_part(*this, workload, tag_index, struct_index, offset, this->uncompressed_vertices, workload.uncompressed_model_vertices);
+            pre_compile_model_geometry_part(*this, workload, tag_index, struct_index, offset, this->uncompressed_vertices, workload.uncompressed_model_vertices, workload.uncompressed_model_vertices_lookup);
         }
     }
 
@@ -19,6 +19,23 @@ namespace Invader::Parser {
         return total_size;
     }
 
+    HEK::EndianSwapMask animation_frame_endian_swap_mask(ModelAnimationsAnimation &animation, bool default_data) {
+        // Rotations are quaternions of int16s; transforms and scales are floats
+        HEK::EndianSwapMask mask;
+        for(std::size_t i = 0; i < animation.node_count; i++) {
+            if(read_bit_from_bitfield(i, animation.node_rotation_flag_data) != default_data) {
+                mask.add(sizeof(std::int16_t), sizeof(ModelAnimationsRotation::struct_big) / sizeof(std::int16_t));
+            }
+            if(read_bit_from_bitfield(i, animation.node_transform_flag_data) != default_data) {
+                mask.add(sizeof(float), sizeof(ModelAnimationsTransform::struct_big) / sizeof(float));
+            }
+            if(read_bit_from_bitfield(i, animation.node_scale_flag_data) != default_data) {
+                mask.add(sizeof(float), sizeof(ModelAnimationscale::struct_big) / sizeof(float));
+            }
+        }
+        return mask;
+    }
+
     void ModelAnimations::pre_compile(BuildWorkload &workload, std::size_t tag_index, std::size_t, std::size_t) {
         std::size_t animation_count = this->animations.size();
         std::size_t sound_count = this->sound_references.size();
@@ -155,40 +172,8 @@ namespace Invader::Parser {
             throw InvalidTagDataException();
         }
 
-        // Do frame info stuff
-        if(frame_info_size > 0) {
-            const auto *frame_info_big = this->frame_info.data();
-            std::vector<std::byte> frame_info_little_v(frame_info_size);
-            std::byte *frame_info_little = frame_info_little_v.data();
-
-            // Update frame_info data, updating everything to little endian endian
-            switch(frame_type) {
-                case HEK::AnimationFrameInfoType::ANIMATION_FRAME_INFO_TYPE_NONE:
-                    break;
-                case HEK::AnimationFrameInfoType::ANIMATION_FRAME_INFO_TYPE_DX_DY: {
-                    const auto *big = reinterpret_cast<const ModelAnimationsFrameInfoDxDy::struct_big *>(frame_info_big);
-                    auto *little = reinterpret_cast<ModelAnimationsFrameInfoDxDy::struct_little *>(frame_info_little);
-                    std::copy(big, big + frame_count, little);
-                    break;
-                }
-                case HEK::AnimationFrameInfoType::ANIMATION_FRAME_INFO_TYPE_DX_DY_DYAW: {
-                    const auto *big = reinterpret_cast<const ModelAnimationsFrameInfoDxDyDyaw::struct_big *>(frame_info_big);
-                    auto *little = reinterpret_cast<ModelAnimationsFrameInfoDxDyDyaw::struct_little *>(frame_info_little);
-                    std::copy(big, big + frame_count, little);
-                    break;
-                }
-                case HEK::AnimationFrameInfoType::ANIMATION_FRAME_INFO_TYPE_DX_DY_DZ_DYAW: {
-                    const auto *big = reinterpret_cast<const ModelAnimationsFrameInfoDxDyDzDyaw::struct_big *>(frame_info_big);
-                    auto *little = reinterpret_cast<ModelAnimationsFrameInfoDxDyDzDyaw::struct_little *>(frame_info_little);
-                    std::copy(big, big + frame_count, little);
-                    break;
-                }
-                case HEK::AnimationFrameInfoType::ANIMATION_FRAME_INFO_TYPE_ENUM_COUNT:
-                    std::terminate();
-            }
-
-            this->frame_info = frame_info_little_v;
-        }
+        // Update frame_info data to little endian (every frame info type is made only of floats, so it can be swapped in place)
+        HEK::swap_endian_words<sizeof(float)>(this->frame_info.data(), frame_info_size / sizeof(float));
 
         auto node_count = static_cast<std::size_t>(this->node_count);
         std::size_t frame_data_size = this->frame_data.size();
@@ -215,33 +200,7 @@ namespace Invader::Parser {
 
         // Let's do default_data. Basically just add what isn't in frame_data, and only for one frame
         if(default_data_size != 0 && !compressed) {
-            const auto *default_data_big = this->default_data.data();
-            std::vector<std::byte> default_data(default_data_size);
-            auto *default_data_little = default_data.data();
-            for(std::size_t node = 0; node < node_count; node++) {
-                if(!read_bit_from_bitfield(node, this->node_rotation_flag_data)) {
-                    const auto &rotation_big = *reinterpret_cast<const ModelAnimationsRotation::struct_big *>(default_data_big);
-                    auto &rotation_little = *reinterpret_cast<ModelAnimationsRotation::struct_little *>(default_data_little);
-                    rotation_little = rotation_big;
-                    default_data_big += sizeof(rotation_big);
-                    default_data_little += sizeof(rotation_big);
-                }
-                if(!read_bit_from_bitfield(node, this->node_transform_flag_data)) {
-                    const auto &transform_big = *reinterpret_cast<const ModelAnimationsTransform::struct_big *>(default_data_big);
-                    auto &transform_little = *reinterpret_cast<ModelAnimationsTransform::struct_little *>(default_data_little);
-                    transform_little = transform_big;
-                    default_data_big += sizeof(transform_big);
-                    default_data_little += sizeof(transform_big);
-                }
-                if(!read_bit_from_bitfield(node, this->node_scale_flag_data)) {
-                    const auto &scale_big = *reinterpret_cast<const ModelAnimationscale::struct_big *>(default_data_big);
-                    auto &scale_little = *reinterpret_cast<ModelAnimationscale::struct_little *>(default_data_little);
-                    scale_little = scale_big;
-                    default_data_big += sizeof(scale_big);
-                    default_data_little += sizeof(scale_big);
-                }
-            }
-            this->default_data = default_data;
+            animation_frame_endian_swap_mask(*this, true).swap(this->default_data.data(), 1);
         }
         else {
             this->default_data.clear();
@@ -255,38 +214,14 @@ namespace Invader::Parser {
             }
             this->frame_data = std::vector<std::byte>(this->frame_data.begin() + compressed_data_offset, this->frame_data.end());
         }
-        else {
-            const auto *frame_data_big = this->frame_data.data();
-            if(frame_data_size > 0) {
-                std::vector<std::byte> frame_data(frame_data_size, std::byte());
-                auto *frame_data_little = frame_data.data();
-                for(std::size_t frame = 0; frame < frame_count; frame++) {
-                    for(std::size_t node = 0; node < node_count; node++) {
-                        if(read_bit_from_bitfield(node, this->node_rotation_flag_data)) {
-                            const auto &rotation_big = *reinterpret_cast<const ModelAnimationsRotation::struct_big *>(frame_data_big);
-                            auto &rotation_little = *reinterpret_cast<ModelAnimationsRotation::struct_little *>(frame_data_little);
-                            rotation_little = rotation_big;
-                            frame_data_big += sizeof(rotation_big);
-                            frame_data_little += sizeof(rotation_big);
-                        }
-                        if(read_bit_from_bitfield(node, this->node_transform_flag_data)) {
-                            const auto &transform_big = *reinterpret_cast<const ModelAnimationsTransform::struct_big *>(frame_data_big);
-                            auto &transform_little = *reinterpret_cast<ModelAnimationsTransform::struct_little *>(frame_data_little);
-                            transform_little = transform_big;
-                            frame_data_big += sizeof(transform_big);
-                            frame_data_little += sizeof(transform_big);
-                        }
-                        if(read_bit_from_bitfield(node, this->node_scale_flag_data)) {
-                            const auto &scale_big = *reinterpret_cast<const ModelAnimationscale::struct_big *>(frame_data_big);
-                            auto &scale_little = *reinterpret_cast<ModelAnimationscale::struct_little *>(frame_data_little);
-                            scale_little = scale_big;
-                            frame_data_big += sizeof(scale_big);
-                            frame_data_little += sizeof(scale_big);
-                        }
-                    }
-                }
-                this->frame_data = frame_data;
+        else if(frame_data_size > 0) {
+            std::size_t total_uncompressed_frame_size = total_frame_size * frame_count;
+            if(frame_data_size < total_uncompressed_frame_size) {
+                REPORT_ERROR_PRINTF(workload, ERROR_TYPE_FATAL_ERROR, tag_index, "Animation #%zu has an invalid frame data size (%zu < %zu)", animation_index, frame_data_size, total_uncompressed_frame_size);
+                throw InvalidTagDataException();
             }
+            animation_frame_endian_swap_mask(*this, false).swap(this->frame_data.data(), frame_count);
+            std::fill(this->frame_data.begin() + total_uncompressed_frame_size, this->frame_data.end(), std::byte());
         }
     }
 }
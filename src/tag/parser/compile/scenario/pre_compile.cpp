@@ -903,7 +903,9 @@ namespace Invader::Parser {
         try {
             std::vector<std::string> warnings;
 
+            auto scripts_step = workload.profiler.step("Compiling scripts");
             compile_scripts(scenario, HEK::GameEngineInfo::get_game_engine_info(build_parameters.details.build_game_engine), warnings, build_parameters.tags_directories);
+            scripts_step.end();
             for(auto &w : warnings) {
                 REPORT_ERROR_PRINTF(workload, ERROR_TYPE_WARNING, tag_index, "Script compilation warning: %s", w.c_str());
             }
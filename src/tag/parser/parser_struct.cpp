@@ -8,156 +8,11 @@
 #include "../../crc/crc32.h"
 
 namespace Invader::Parser {
-    ParserStructValue::ParserStructValue(
-        const char *       name,
-        const char *       member_name,
-        const char *       comment,
-        Dependency *       dependency,
-        const TagFourCC *allowed_classes,
-        std::size_t        count,
-        bool               read_only
-    ) : name(name),
-        member_name(member_name),
-        comment(comment),
-        type(ValueType::VALUE_TYPE_DEPENDENCY),
-        address(dependency),
-        allowed_classes(allowed_classes, allowed_classes + count),
-        read_only(read_only) {}
-
-    
-    ParserStructValue::ParserStructValue(
-        const char *name,
-        const char *comment
-    ) : name(name), comment(comment), type(ValueType::VALUE_TYPE_GROUP_START) {}
-            
-    ParserStructValue::ParserStructValue(
-        const char *          name,
-        const char *          member_name,
-        const char *          comment,
-        void *                object,
-        ValueType             type,
-        const char *          unit,
-        std::size_t           count,
-        bool                  bounds,
-        bool                  volatile_value,
-        bool                  read_only,
-        std::optional<Number> minimum,
-        std::optional<Number> maximum
-    ) : name(name),
-        member_name(member_name),
-        comment(comment),
-        type(type),
-        address(object),
-        count(count),
-        bounds(bounds),
-        unit(unit),
-        minimum(minimum),
-        maximum(maximum),
-        volatile_value(volatile_value),
-        read_only(read_only) {}
-
-    ParserStructValue::ParserStructValue(
-        const char *                        name,
-        const char *                        member_name,
-        const char *                        comment,
-        void *                              array,
-        get_object_in_array_fn_type         get_object_in_array_fn,
-        get_array_size_fn_type              get_array_size_fn,
-        delete_objects_in_array_fn_type     delete_objects_in_array_fn,
-        insert_objects_in_array_fn_type     insert_objects_in_array_fn,
-        duplicate_objects_in_array_fn_type  duplicate_objects_in_array_fn,
-        swap_objects_in_array_fn_type       swap_objects_in_array_fn,
-        std::size_t                         minimum_array_size,
-        std::size_t                         maximum_array_size,
-        bool                                read_only
-    ) : name(name),
-        member_name(member_name),
-        comment(comment),
-        type(ValueType::VALUE_TYPE_REFLEXIVE),
-        address(array),
-        get_object_in_array_fn(get_object_in_array_fn),
-        get_array_size_fn(get_array_size_fn),
-        delete_objects_in_array_fn(delete_objects_in_array_fn),
-        insert_objects_in_array_fn(insert_objects_in_array_fn),
-        duplicate_objects_in_array_fn(duplicate_objects_in_array_fn),
-        swap_objects_in_array_fn(swap_objects_in_array_fn),
-        min_array_size(minimum_array_size),
-        max_array_size(maximum_array_size),
-        read_only(read_only) {}
-
-    ParserStructValue::ParserStructValue(
-        const char *    name,
-        const char *    member_name,
-        const char *    comment,
-        HEK::TagString *string,
-        bool            read_only
-    ) : name(name),
-        member_name(member_name),
-        comment(comment),
-        type(ValueType::VALUE_TYPE_TAGSTRING),
-        address(string),
-        read_only(read_only) {}
-
-    ParserStructValue::ParserStructValue(
-        const char *            name,
-        const char *            member_name,
-        const char *            comment,
-        std::vector<std::byte> *offset,
-        bool                    read_only
-    ) : name(name),
-        member_name(member_name),
-        comment(comment),
-        type(ValueType::VALUE_TYPE_TAGDATAOFFSET),
-        address(offset),
-        read_only(read_only) {}
-
-    ParserStructValue::ParserStructValue(
-        const char *       name,
-        const char *       member_name,
-        const char *       comment,
-        void *             value,
-        list_enum_fn_type  list_enum_fn,
-        list_enum_fn_type  list_enum_pretty_fn,
-        read_enum_fn_type  read_enum_fn,
-        write_enum_fn_type write_enum_fn,
-        bool               read_only
-    ) : name(name),
-        member_name(member_name),
-        comment(comment),
-        type(ValueType::VALUE_TYPE_ENUM),
-        address(value),
-        list_enum_fn(list_enum_fn),
-        list_enum_pretty_fn(list_enum_pretty_fn),
-        read_enum_fn(read_enum_fn),
-        write_enum_fn(write_enum_fn),
-        read_only(read_only) {}
-
-   ParserStructValue::ParserStructValue(
-       const char *           name,
-       const char *           member_name,
-       const char *           comment,
-       void *                 value,
-       list_enum_fn_type      list_enum_fn,
-       list_enum_fn_type      list_enum_pretty_fn,
-       read_bitfield_fn_type  read_bitfield_fn,
-       write_bitfield_fn_type write_bitfield_fn,
-       bool                   read_only
-   ) : name(name),
-       member_name(member_name),
-       comment(comment),
-       type(ValueType::VALUE_TYPE_BITMASK),
-       address(value),
-       list_enum_fn(list_enum_fn),
-       list_enum_pretty_fn(list_enum_pretty_fn),
-       read_bitfield_fn(read_bitfield_fn),
-       write_bitfield_fn(write_bitfield_fn),
-       read_only(read_only) {}
-
     ParserStructValue::NumberFormat ParserStructValue::get_number_format() const noexcept {
-        if(this->type < ValueType::VALUE_TYPE_FLOAT) {
+        if(this->descriptor->type < ValueType::VALUE_TYPE_FLOAT) {
             return NumberFormat::NUMBER_FORMAT_INT;
         }
-        else if(type < ValueType::VALUE_TYPE_REFLEXIVE) {
+        else if(this->descriptor->type < ValueType::VALUE_TYPE_REFLEXIVE) {
             return NumberFormat::NUMBER_FORMAT_FLOAT;
         }
         else {
@@ -166,7 +21,7 @@ namespace Invader::Parser {
     }
 
     std::size_t ParserStructValue::get_value_count() const noexcept {
-        switch(this->type) {
+        switch(this->descriptor->type) {
             case VALUE_TYPE_INT8:
             case VALUE_TYPE_UINT8:
             case VALUE_TYPE_INT16:
@@ -176,49 +31,49 @@ namespace Invader::Parser {
             case VALUE_TYPE_UINT32:
             case VALUE_TYPE_ENUM:
             case VALUE_TYPE_BITMASK:
-                return 1 * this->count;
+                return 1 * this->descriptor->count;
             case VALUE_TYPE_POINT2DINT:
-                return 2 * this->count;
+                return 2 * this->descriptor->count;
             case VALUE_TYPE_RECTANGLE2D:
             case VALUE_TYPE_COLORARGBINT:
-                return 4 * this->count;
+                return 4 * this->descriptor->count;
 
             case VALUE_TYPE_MATRIX:
-                return 9 * this->count;
+                return 9 * this->descriptor->count;
 
             case VALUE_TYPE_FLOAT:
             case VALUE_TYPE_ANGLE:
             case VALUE_TYPE_FRACTION:
-                return 1 * this->count;
+                return 1 * this->descriptor->count;
 
             case VALUE_TYPE_COLORARGB:
-                return 4 * this->count;
+                return 4 * this->descriptor->count;
 
             case VALUE_TYPE_COLORRGB:
-                return 3 * this->count;
+                return 3 * this->descriptor->count;
 
             case VALUE_TYPE_EULER2D:
             case VALUE_TYPE_VECTOR2D:
-                return 2 * this->count;
+                return 2 * this->descriptor->count;
 
             case VALUE_TYPE_EULER3D:
             case VALUE_TYPE_VECTOR3D:
-                return 3 * this->count;
+                return 3 * this->descriptor->count;
 
             case VALUE_TYPE_PLANE2D:
-                return 3 * this->count;
+                return 3 * this->descriptor->count;
 
             case VALUE_TYPE_PLANE3D:
-                return 4 * this->count;
+                return 4 * this->descriptor->count;
 
             case VALUE_TYPE_POINT2D:
-                return 2 * this->count;
+                return 2 * this->descriptor->count;
 
             case VALUE_TYPE_POINT3D:
-                return 3 * this->count;
+                return 3 * this->descriptor->count;
 
             case VALUE_TYPE_QUATERNION:
-                return 4 * this->count;
+                return 4 * this->descriptor->count;
 
             case VALUE_TYPE_REFLEXIVE:
             case VALUE_TYPE_DEPENDENCY:
@@ -240,8 +95,8 @@ namespace Invader::Parser {
 
     void ParserStructValue::get_values(Number *values) const noexcept {
         const auto *addr = reinterpret_cast<const std::byte *>(this->address);
-        for(std::size_t i = 0; i < this->count; i++) {
-            switch(this->type) {
+        for(std::size_t i = 0; i < this->descriptor->count; i++) {
+            switch(this->descriptor->type) {
                 case VALUE_TYPE_INT8:
                     *values = static_cast<std::int64_t>(*reinterpret_cast<const std::int8_t *>(addr));
                     addr += sizeof(std::int8_t);
@@ -459,8 +314,8 @@ namespace Invader::Parser {
 
     void ParserStructValue::set_values(const Number *values) noexcept {
         auto *addr = reinterpret_cast<std::byte *>(this->address);
-        for(std::size_t i = 0; i < this->count; i++) {
-            switch(this->type) {
+        for(std::size_t i = 0; i < this->descriptor->count; i++) {
+            switch(this->descriptor->type) {
                 case VALUE_TYPE_INT8:
                     *reinterpret_cast<std::int8_t *>(addr) = std::get<std::int64_t>(*values);
                     addr += sizeof(std::int8_t);
@@ -704,6 +559,29 @@ namespace Invader::Parser {
         #undef DO_TAG_CLASS
     }
 
+    void ParserStruct::scan_hek_tag_dependencies(const std::byte *data, std::size_t data_size, const DependencyCallback &callback, bool cache_only) {
+        const auto *header = reinterpret_cast<const HEK::TagFileHeader *>(data);
+        HEK::TagFileHeader::validate_header(header, data_size);
+
+        #define DO_TAG_CLASS(class_struct, fourcc) case TagFourCC::fourcc: { \
+            return Invader::Parser::class_struct::scan_hek_tag_file_dependencies(data, data_size, callback, cache_only); \
+        }
+
+        switch(header->tag_fourcc) {
+            DO_BASED_ON_TAG_CLASS
+
+            case Invader::HEK::TagFourCC::TAG_FOURCC_NONE:
+            case Invader::HEK::TagFourCC::TAG_FOURCC_NULL:
+            case Invader::HEK::TagFourCC::TAG_FOURCC_SPHEROID:
+                break;
+        }
+
+        eprintf_error("Unknown tag class %s", tag_fourcc_to_extension(header->tag_fourcc));
+        throw InvalidTagDataException();
+
+        #undef DO_TAG_CLASS
+    }
+
     std::unique_ptr<ParserStruct> ParserStruct::generate_base_struct(TagFourCC tag_class) {
         #define DO_TAG_CLASS(class_struct, fourcc) case TagFourCC::fourcc: { \
             return std::unique_ptr<ParserStruct>(new class_struct()); \
@@ -762,13 +640,13 @@ namespace Invader::Parser {
     }
     
     bool ParserStruct::check_for_invalid_references(bool null_references) {
-        auto &values = this->get_values();
+        auto values = this->get_values();
         bool result = false;
-        for(auto &i : values) {
+        for(auto i : values) {
             switch(i.get_type()) {
                 case ParserStructValue::ValueType::VALUE_TYPE_DEPENDENCY: {
                     auto &dep = i.get_dependency();
-                    auto &allowed_classes = i.get_allowed_classes(); // get allowed classes
+                    auto allowed_classes = i.get_allowed_classes(); // get allowed classes
                     if(allowed_classes.size() >= 1 && !dep.path.empty()) { // do we even have any?
                         bool valid = false;
                         for(auto &c : allowed_classes) {
@@ -846,8 +724,8 @@ namespace Invader::Parser {
         auto &this_value = *this;
         
         // Make sure these are the same
-        auto &v_this = this->get_values();
-        auto &v_other = what->get_values();
+        auto v_this = this->get_values();
+        auto v_other = what->get_values();
         
         auto vt_size = v_this.size();
         auto vo_size = v_other.size();
@@ -871,8 +749,8 @@ namespace Invader::Parser {
         };
         
         for(std::size_t v = 0; v < vt_size && should_continue; v++) {
-            auto &vt = v_this[v];
-            auto &vo = v_other[v];
+            auto vt = v_this[v];
+            auto vo = v_other[v];
             
             auto vt_type = vt.get_type();
             auto vo_type = vo.get_type();
@@ -1353,9 +1231,9 @@ namespace Invader::Parser {
     }
     
     bool ParserStruct::check_for_broken_enums(bool reset_enums) {
-        auto &values = this->get_values();
+        auto values = this->get_values();
         bool result = false;
-        for(auto &i : values) {
+        for(auto i : values) {
             switch(i.get_type()) {
                 case ParserStructValue::ValueType::VALUE_TYPE_ENUM: {
                     try {
@@ -1399,18 +1277,4 @@ namespace Invader::Parser {
         }
         return result;
     }
-    
-    std::vector<ParserStructValue> &ParserStruct::get_values() {
-        if(!this->values.has_value()) {
-            this->values = this->get_values_internal();
-        }
-        return *this->values;
-    }
-    
-    ParserStruct::ParserStruct(const ParserStruct &copy) noexcept : cache_formatted(copy.cache_formatted) {}
-    ParserStruct::ParserStruct(ParserStruct &&move) noexcept : cache_formatted(move.cache_formatted) {}
-    ParserStruct &ParserStruct::operator=(const ParserStruct &copy) noexcept {
-        this->cache_formatted = copy.cache_formatted;
-        return *this;
-    }
 }
@@ -55,18 +55,9 @@ namespace Invader::Parser {
         this->duration /= TICK_RATE;
     }
 
-    template <typename A, typename B> static void swap_endian_array(A *to, const B *from, std::size_t count) {
-        for(std::size_t i = 0; i < count; i++) {
-            to[i] = from[i];
-        }
-    }
-
     void Invader::Parser::ModelAnimationsAnimation::post_cache_deformat() {
         // Get whether or not it's compressed
         bool compressed = this->flags & HEK::ModelAnimationsAnimationFlagsFlag::MODEL_ANIMATIONS_ANIMATION_FLAGS_FLAG_COMPRESSED_DATA;
-        std::vector<std::byte> frame_data = this->frame_data;
-        std::vector<std::byte> frame_info = this->frame_info;
-        std::vector<std::byte> default_data = this->default_data;
 
         // Frame info
         std::size_t required_frame_info_size;
@@ -87,38 +78,12 @@ namespace Invader::Parser {
                 eprintf_error("unknown frame info type");
                 throw InvalidTagDataException();
         }
-        if(required_frame_info_size * this->frame_count != frame_info.size()) {
+        if(required_frame_info_size * this->frame_count != this->frame_info.size()) {
             throw OutOfBoundsException();
         }
 
-        // Convert endianness
-        if(frame_info.size() > 0) {
-            switch(this->frame_info_type) {
-                case HEK::AnimationFrameInfoType::ANIMATION_FRAME_INFO_TYPE_DX_DY:
-                    swap_endian_array(
-                        reinterpret_cast<ModelAnimationsFrameInfoDxDy::struct_big *>(this->frame_info.data()),
-                        reinterpret_cast<ModelAnimationsFrameInfoDxDy::struct_little *>(frame_info.data()),
-                        this->frame_count
-                    );
-                    break;
-                case HEK::AnimationFrameInfoType::ANIMATION_FRAME_INFO_TYPE_DX_DY_DYAW:
-                    swap_endian_array(
-                        reinterpret_cast<ModelAnimationsFrameInfoDxDyDyaw::struct_big *>(this->frame_info.data()),
-                        reinterpret_cast<ModelAnimationsFrameInfoDxDyDyaw::struct_little *>(frame_info.data()),
-                        this->frame_count
-                    );
-                    break;
-                case HEK::AnimationFrameInfoType::ANIMATION_FRAME_INFO_TYPE_DX_DY_DZ_DYAW:
-                    swap_endian_array(
-                        reinterpret_cast<ModelAnimationsFrameInfoDxDyDzDyaw::struct_big *>(this->frame_info.data()),
-                        reinterpret_cast<ModelAnimationsFrameInfoDxDyDzDyaw::struct_little *>(frame_info.data()),
-                        this->frame_count
-                    );
-                    break;
-                default:
-                    break;
-            }
-        }
+        // Convert endianness (every frame info type is made only of floats)
+        HEK::swap_endian_words<sizeof(float)>(this->frame_info.data(), this->frame_info.size() / sizeof(float));
 
         // Now do nodes
         if(this->node_count > 64) {
@@ -136,41 +101,13 @@ namespace Invader::Parser {
         // Do default data
         std::size_t expected_default_data_size = (max_frame_size - frame_data_size_expected);
         if(!compressed) {
-            std::size_t default_data_size = default_data.size();
+            std::size_t default_data_size = this->default_data.size();
             if(default_data_size > 0) {
-                if(default_data.size() != expected_default_data_size) {
+                if(default_data_size != expected_default_data_size) {
                     eprintf_error("Default data size is invalid (%zu > 0 && %zu != %zu)", default_data_size, static_cast<std::size_t>(default_data_size), expected_default_data_size);
                     throw InvalidTagDataException();
                 }
-
-                if(expected_default_data_size > 0) {
-                    auto *default_data_big = this->default_data.data();
-                    auto *default_data_little = default_data.data();
-
-                    for(std::size_t node = 0; node < this->node_count; node++) {
-                        if(!read_bit_from_bitfield(node, this->node_rotation_flag_data)) {
-                            auto &rotation_big = *reinterpret_cast<ModelAnimationsRotation::struct_big *>(default_data_big);
-                            const auto &rotation_little = *reinterpret_cast<const ModelAnimationsRotation::struct_little *>(default_data_little);
-                            rotation_big = rotation_little;
-                            default_data_big += sizeof(rotation_big);
-                            default_data_little += sizeof(rotation_big);
-                        }
-                        if(!read_bit_from_bitfield(node, this->node_transform_flag_data)) {
-                            auto &transform_big = *reinterpret_cast<ModelAnimationsTransform::struct_big *>(default_data_big);
-                            const auto &transform_little = *reinterpret_cast<const ModelAnimationsTransform::struct_little *>(default_data_little);
-                            transform_big = transform_little;
-                            default_data_big += sizeof(transform_big);
-                            default_data_little += sizeof(transform_big);
-                        }
-                        if(!read_bit_from_bitfield(node, this->node_scale_flag_data)) {
-                            auto &scale_big = *reinterpret_cast<ModelAnimationscale::struct_big *>(default_data_big);
-                            const auto &scale_little = *reinterpret_cast<const ModelAnimationscale::struct_little *>(default_data_little);
-                            scale_big = scale_little;
-                            default_data_big += sizeof(scale_big);
-                            default_data_little += sizeof(scale_big);
-                        }
-                    }
-                }
+                animation_frame_endian_swap_mask(*this, true).swap(this->default_data.data(), 1);
             }
         }
         // Zero out default data if there is none
@@ -182,7 +119,7 @@ namespace Invader::Parser {
         auto total_uncompressed_frame_size = frame_data_size_expected * this->frame_count;
 
         if(compressed) {
-            if(this->offset_to_compressed_data > frame_data.size()) {
+            if(this->offset_to_compressed_data > this->frame_data.size()) {
                 eprintf_error("Offset to compressed data offset is invalid (%zu > %zu)", static_cast<std::size_t>(this->offset_to_compressed_data), this->frame_data.size());
                 throw InvalidTagDataException();
             }
@@ -197,33 +134,7 @@ namespace Invader::Parser {
             }
 
             if(frame_data_size_expected) {
-                auto *frame_data_big = this->frame_data.data();
-                auto *frame_data_little = frame_data.data();
-                for(std::size_t frame = 0; frame < frame_count; frame++) {
-                    for(std::size_t node = 0; node < this->node_count; node++) {
-                        if(read_bit_from_bitfield(node, this->node_rotation_flag_data)) {
-                            auto &rotation_big = *reinterpret_cast<ModelAnimationsRotation::struct_little *>(frame_data_big);
-                            const auto &rotation_little = *reinterpret_cast<const ModelAnimationsRotation::struct_big *>(frame_data_little);
-                            rotation_big = rotation_little;
-                            frame_data_big += sizeof(rotation_big);
-                            frame_data_little += sizeof(rotation_big);
-                        }
-                        if(read_bit_from_bitfield(node, this->node_transform_flag_data)) {
-                            auto &transform_big = *reinterpret_cast<ModelAnimationsTransform::struct_little *>(frame_data_big);
-                            const auto &transform_little = *reinterpret_cast<const ModelAnimationsTransform::struct_big *>(frame_data_little);
-                            transform_big = transform_little;
-                            frame_data_big += sizeof(transform_big);
-                            frame_data_little += sizeof(transform_big);
-                        }
-                        if(read_bit_from_bitfield(node, this->node_scale_flag_data)) {
-                            auto &scale_big = *reinterpret_cast<ModelAnimationscale::struct_little *>(frame_data_big);
-                            const auto &scale_little = *reinterpret_cast<const ModelAnimationscale::struct_big *>(frame_data_little);
-                            scale_big = scale_little;
-                            frame_data_big += sizeof(scale_big);
-                            frame_data_little += sizeof(scale_big);
-                        }
-                    }
-                }
+                animation_frame_endian_swap_mask(*this, false).swap(this->frame_data.data(), this->frame_count);
             }
         }
     }
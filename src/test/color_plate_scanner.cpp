@@ -0,0 +1,235 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <invader/bitmap/color_plate_scanner.hpp>
+#include <invader/printf.hpp>
+
+using namespace Invader;
+
+static constexpr Pixel BLUE = { 0xFF, 0x00, 0x00, 0xFF };
+static constexpr Pixel MAGENTA = { 0xFF, 0x00, 0xFF, 0xFF };
+static constexpr Pixel CYAN = { 0xFF, 0xFF, 0x00, 0xFF };
+
+// A generated color plate. Plates are bigger than one band (64 rows or columns) so scanning them is split between
+// threads, and bitmaps are put on either side of band edges.
+struct ColorPlate {
+    std::uint32_t width;
+    std::uint32_t height;
+    std::vector<Pixel> pixels;
+
+    ColorPlate(std::uint32_t width, std::uint32_t height, const Pixel &divider, const Pixel &spacing) : width(width), height(height), pixels(static_cast<std::size_t>(width) * height, BLUE) {
+        this->pixels[1] = divider;
+        this->pixels[2] = spacing;
+    }
+
+    void fill(std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, const Pixel &color) {
+        for(std::uint32_t py = y; py < y + h; py++) {
+            for(std::uint32_t px = x; px < x + w; px++) {
+                this->pixels[static_cast<std::size_t>(py) * this->width + px] = color;
+            }
+        }
+    }
+
+    // Draw a bitmap of random colors that can never be mistaken for blue, magenta, or cyan (red is never 0x00 or 0xFF)
+    void bitmap(std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::mt19937 &random) {
+        for(std::uint32_t py = y; py < y + h; py++) {
+            for(std::uint32_t px = x; px < x + w; px++) {
+                auto value = random();
+                this->pixels[static_cast<std::size_t>(py) * this->width + px] = Pixel {
+                    static_cast<std::uint8_t>(value),
+                    static_cast<std::uint8_t>(value >> 8),
+                    static_cast<std::uint8_t>(0x10 + (value >> 16) % 0xE0),
+                    static_cast<std::uint8_t>(value >> 24)
+                };
+            }
+        }
+    }
+
+    // Draw a bitmap surrounded by cyan spacing (which moves its registration point)
+    void spaced_bitmap(std::uint32_t x, std::uint32_t y, std::uint32_t w, std::uint32_t h, std::uint32_t left, std::uint32_t top, std::uint32_t right, std::uint32_t bottom, std::mt19937 &random) {
+        this->fill(x - left, y - top, w + left + right, h + top + bottom, CYAN);
+        this->bitmap(x, y, w, h, random);
+    }
+
+    void divider(std::uint32_t y) {
+        this->fill(0, y, this->width, 1, MAGENTA);
+    }
+};
+
+struct ScanCase {
+    const char *name;
+    ColorPlate plate;
+    BitmapType type;
+    bool reg_point_hack;
+    bool allow_non_power_of_two;
+    bool expect_failure;
+    std::size_t expected_bitmaps;
+};
+
+struct ScanResult {
+    bool failed = false;
+    std::string messages;
+    GeneratedBitmapData data;
+};
+
+static ScanResult scan(const ScanCase &scan_case, std::size_t max_threads) {
+    ScanResult result;
+    BufferedOutput output;
+    try {
+        result.data = ColorPlateScanner::scan_color_plate(scan_case.plate.pixels.data(), scan_case.plate.width, scan_case.plate.height, scan_case.type, BitmapUsage::BITMAP_USAGE_DEFAULT, scan_case.reg_point_hack, scan_case.allow_non_power_of_two, max_threads, &output);
+    }
+    catch(std::exception &) {
+        result.failed = true;
+    }
+    result.messages = output.to_string();
+    return result;
+}
+
+// Return the first difference between the two results, or an empty string if there is none
+static std::string compare_results(const ScanResult &a, const ScanResult &b) {
+    if(a.failed != b.failed) {
+        return "failed " + std::to_string(a.failed) + " != " + std::to_string(b.failed);
+    }
+    if(a.messages != b.messages) {
+        return "messages \"" + a.messages + "\" != \"" + b.messages + "\"";
+    }
+    if(a.failed) {
+        return {};
+    }
+
+    if(a.data.sequences.size() != b.data.sequences.size()) {
+        return "sequence count " + std::to_string(a.data.sequences.size()) + " != " + std::to_string(b.data.sequences.size());
+    }
+    for(std::size_t s = 0; s < a.data.sequences.size(); s++) {
+        auto &sa = a.data.sequences[s];
+        auto &sb = b.data.sequences[s];
+        if(sa.y_start != sb.y_start || sa.y_end != sb.y_end || sa.first_bitmap != sb.first_bitmap || sa.bitmap_count != sb.bitmap_count || sa.sprites.size() != sb.sprites.size()) {
+            return "sequence #" + std::to_string(s) + " differs";
+        }
+    }
+
+    if(a.data.bitmaps.size() != b.data.bitmaps.size()) {
+        return "bitmap count " + std::to_string(a.data.bitmaps.size()) + " != " + std::to_string(b.data.bitmaps.size());
+    }
+    for(std::size_t i = 0; i < a.data.bitmaps.size(); i++) {
+        auto &ba = a.data.bitmaps[i];
+        auto &bb = b.data.bitmaps[i];
+        if(ba.width != bb.width || ba.height != bb.height || ba.color_plate_x != bb.color_plate_x || ba.color_plate_y != bb.color_plate_y) {
+            return "bitmap #" + std::to_string(i) + " bounds differ";
+        }
+        if(ba.registration_point_x != bb.registration_point_x || ba.registration_point_y != bb.registration_point_y) {
+            return "bitmap #" + std::to_string(i) + " registration point differs";
+        }
+        if(ba.pixels != bb.pixels) {
+            return "bitmap #" + std::to_string(i) + " pixels differ";
+        }
+    }
+
+    return {};
+}
+
+static std::vector<ScanCase> generate_cases() {
+    std::mt19937 random(0x1A7E);
+    std::vector<ScanCase> cases;
+
+    // Three sequences separated by magenta dividers, with bitmaps on both sides of the band edges
+    {
+        ColorPlate plate(300, 260, MAGENTA, BLUE);
+        plate.divider(1);
+        plate.bitmap(10, 10, 16, 16, random);
+        plate.bitmap(56, 20, 32, 8, random);
+        plate.bitmap(120, 4, 64, 64, random);
+        plate.divider(90);
+        plate.bitmap(60, 100, 8, 32, random);
+        plate.bitmap(200, 95, 64, 128, random);
+        plate.divider(230);
+        plate.bitmap(250, 240, 16, 16, random);
+        cases.push_back({"dividers", plate, BitmapType::BITMAP_TYPE_2D_TEXTURES, false, false, false, 6});
+    }
+
+    // The same, but with one divider broken past the first band of columns
+    {
+        ColorPlate plate(300, 260, MAGENTA, BLUE);
+        plate.bitmap(10, 10, 16, 16, random);
+        plate.divider(90);
+        plate.bitmap(200, 95, 64, 128, random);
+        plate.divider(230);
+        plate.fill(150, 230, 1, 1, BLUE);
+        cases.push_back({"broken divider", plate, BitmapType::BITMAP_TYPE_2D_TEXTURES, false, false, true, 0});
+    }
+
+    // No divider color, so sequences are separated by rows that are entirely blue
+    {
+        ColorPlate plate(200, 300, BLUE, BLUE);
+        plate.bitmap(70, 5, 16, 16, random);
+        plate.bitmap(130, 10, 32, 32, random);
+        plate.bitmap(5, 120, 128, 64, random);
+        plate.bitmap(20, 250, 4, 4, random);
+        cases.push_back({"blue sequences", plate, BitmapType::BITMAP_TYPE_2D_TEXTURES, false, false, false, 4});
+    }
+
+    // Sprites with cyan spacing on each side, which moves their registration points
+    {
+        ColorPlate plate(320, 200, MAGENTA, CYAN);
+        plate.spaced_bitmap(8, 12, 20, 11, 3, 2, 9, 1, random);
+        plate.spaced_bitmap(60, 30, 9, 40, 0, 7, 4, 0, random);
+        plate.spaced_bitmap(130, 70, 50, 50, 10, 10, 10, 10, random);
+        plate.divider(140);
+        plate.spaced_bitmap(250, 150, 31, 17, 5, 0, 2, 30, random);
+        cases.push_back({"cyan spacing", plate, BitmapType::BITMAP_TYPE_SPRITES, false, false, false, 4});
+        cases.push_back({"reg_point_hack", plate, BitmapType::BITMAP_TYPE_SPRITES, true, false, false, 4});
+    }
+
+    // Bitmaps that aren't a power of two, which only 2D textures can have if allowed
+    {
+        ColorPlate plate(260, 180, MAGENTA, BLUE);
+        plate.bitmap(3, 3, 13, 7, random);
+        plate.bitmap(62, 40, 5, 100, random);
+        plate.bitmap(140, 10, 100, 33, random);
+        cases.push_back({"non-power-of-two", plate, BitmapType::BITMAP_TYPE_2D_TEXTURES, false, true, false, 3});
+        cases.push_back({"non-power-of-two not allowed", plate, BitmapType::BITMAP_TYPE_2D_TEXTURES, false, false, true, 0});
+        cases.push_back({"non-power-of-two interface", plate, BitmapType::BITMAP_TYPE_INTERFACE_BITMAPS, false, false, false, 3});
+    }
+
+    // No color plate key, so the whole image is one bitmap
+    {
+        ColorPlate plate(150, 90, BLUE, BLUE);
+        plate.bitmap(0, 0, 150, 90, random);
+        cases.push_back({"no key", plate, BitmapType::BITMAP_TYPE_INTERFACE_BITMAPS, false, false, false, 1});
+    }
+
+    return cases;
+}
+
+// Scanning a color plate on multiple threads must give the same bitmaps, sequences, and errors as scanning it on one
+int main() {
+    bool failed = false;
+
+    for(auto &scan_case : generate_cases()) {
+        auto expected = scan(scan_case, 1);
+        if(expected.failed != scan_case.expect_failure) {
+            eprintf_error("%s: expected the scan to %s", scan_case.name, scan_case.expect_failure ? "fail" : "succeed");
+            failed = true;
+            continue;
+        }
+        if(!expected.failed && expected.data.bitmaps.size() != scan_case.expected_bitmaps) {
+            eprintf_error("%s: expected %zu bitmaps, but found %zu", scan_case.name, scan_case.expected_bitmaps, expected.data.bitmaps.size());
+            failed = true;
+            continue;
+        }
+
+        for(std::size_t max_threads : { 2, 3, 8 }) {
+            auto difference = compare_results(expected, scan(scan_case, max_threads));
+            if(!difference.empty()) {
+                eprintf_error("%s: %zu threads: %s", scan_case.name, max_threads, difference.c_str());
+                failed = true;
+            }
+        }
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <cstdlib>
+#include <vector>
+
+#include <invader/tag/parser/parser.hpp>
+#include <invader/printf.hpp>
+
+using namespace Invader;
+
+// A meter's source and stencil bitmaps are only used to make the meter; the build never loads them, so a cache file
+// scan must not ask for them even if they are missing
+int main() {
+    Parser::Meter meter = {};
+    meter.source_bitmap.path = "missing\\source";
+    meter.source_bitmap.tag_fourcc = TagFourCC::TAG_FOURCC_BITMAP;
+    meter.stencil_bitmaps.path = "missing\\stencil";
+    meter.stencil_bitmaps.tag_fourcc = TagFourCC::TAG_FOURCC_BITMAP;
+    auto data = meter.generate_hek_tag_data(TagFourCC::TAG_FOURCC_METER);
+
+    std::vector<std::string> all, cache_only;
+    Parser::ParserStruct::scan_hek_tag_dependencies(data.data(), data.size(), [&all](TagFourCC, std::string_view path) {
+        all.emplace_back(path);
+    });
+    Parser::ParserStruct::scan_hek_tag_dependencies(data.data(), data.size(), [&cache_only](TagFourCC, std::string_view path) {
+        cache_only.emplace_back(path);
+    }, true);
+
+    if(all.size() != 2) {
+        eprintf_error("Expected 2 meter dependencies, but found %zu", all.size());
+        return EXIT_FAILURE;
+    }
+    if(!cache_only.empty()) {
+        eprintf_error("Expected no cached meter dependencies, but found %s", cache_only[0].c_str());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
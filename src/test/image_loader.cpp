@@ -0,0 +1,454 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <cstdlib>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include <tiffio.h>
+#include <zlib.h>
+
+#include <invader/printf.hpp>
+#include "../bitmap/image_loader.hpp"
+#include "../bitmap/stb/stb_image.h"
+
+using namespace Invader;
+
+struct TestPNG {
+    const char *name;
+    std::uint8_t color;
+    std::uint8_t depth;
+    std::uint32_t width;
+    std::uint32_t height;
+
+    // Filter to use for each row (-1 to use a different filter for each row)
+    int filter;
+
+    // Write a tRNS chunk (gray and RGB images get the first pixel's color; palettes get an alpha for some entries)
+    bool transparency;
+
+    // Only set the header's interlace flag, which load_png_by_row must leave to stb_image
+    bool interlaced = false;
+};
+
+static void append_uint32(std::vector<std::uint8_t> &data, std::uint32_t value) {
+    data.push_back(static_cast<std::uint8_t>(value >> 24));
+    data.push_back(static_cast<std::uint8_t>(value >> 16));
+    data.push_back(static_cast<std::uint8_t>(value >> 8));
+    data.push_back(static_cast<std::uint8_t>(value));
+}
+
+static void append_chunk(std::vector<std::uint8_t> &png, const char *type, const std::vector<std::uint8_t> &data) {
+    append_uint32(png, static_cast<std::uint32_t>(data.size()));
+    auto type_offset = png.size();
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), data.begin(), data.end());
+    append_uint32(png, static_cast<std::uint32_t>(crc32(0, png.data() + type_offset, static_cast<uInt>(png.size() - type_offset))));
+}
+
+static bool save(const std::filesystem::path &path, const std::vector<std::uint8_t> &data) {
+    std::FILE *file = std::fopen(path.string().c_str(), "wb");
+    if(!file) {
+        return false;
+    }
+    bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    return std::fclose(file) == 0 && written;
+}
+
+// Make a PNG of random samples with the given color type, bit depth, filters, and transparency
+static std::vector<std::uint8_t> make_png(const TestPNG &test, std::mt19937 &random) {
+    std::size_t channels = test.color == 2 ? 3 : (test.color == 4 ? 2 : (test.color == 6 ? 4 : 1));
+    std::size_t row_size = (static_cast<std::size_t>(test.width) * channels * test.depth + 7) / 8;
+    std::size_t filter_bytes = std::max<std::size_t>(1, channels * test.depth / 8);
+    std::size_t palette_count = test.color == 3 ? std::min<std::size_t>(1 << test.depth, 200) : 0;
+
+    // Make the rows (palette indices must be in the palette)
+    std::vector<std::vector<std::uint8_t>> rows(test.height, std::vector<std::uint8_t>(row_size));
+    for(auto &row : rows) {
+        if(test.color == 3) {
+            for(std::size_t x = 0; x < test.width; x++) {
+                auto index = random() % palette_count;
+                std::size_t bit = x * test.depth;
+                row[bit / 8] |= static_cast<std::uint8_t>(index << (8 - test.depth - bit % 8));
+            }
+        }
+        else {
+            for(auto &byte : row) {
+                byte = static_cast<std::uint8_t>(random());
+            }
+
+            // Clear any bits past the last sample
+            auto used_bits = (static_cast<std::size_t>(test.width) * channels * test.depth) % 8;
+            if(used_bits != 0) {
+                row[row_size - 1] &= static_cast<std::uint8_t>(0xFF << (8 - used_bits));
+            }
+        }
+    }
+
+    // Repeat the first row's first pixel here and there so the tRNS color is actually used
+    std::size_t first_pixel_bytes = (channels * test.depth + 7) / 8;
+    if(test.depth >= 8) {
+        for(std::size_t y = 0; y < test.height; y++) {
+            for(std::size_t x = y % 3; x < test.width; x += 5) {
+                std::copy(rows[0].begin(), rows[0].begin() + first_pixel_bytes, rows[y].begin() + x * first_pixel_bytes);
+            }
+        }
+    }
+
+    // Filter each row
+    std::vector<std::uint8_t> filtered;
+    std::vector<std::uint8_t> zero_row(row_size);
+    for(std::size_t y = 0; y < test.height; y++) {
+        auto &row = rows[y];
+        auto &prior = y == 0 ? zero_row : rows[y - 1];
+        auto filter = test.filter < 0 ? static_cast<int>(y % 5) : test.filter;
+        filtered.push_back(static_cast<std::uint8_t>(filter));
+        for(std::size_t i = 0; i < row_size; i++) {
+            int a = i >= filter_bytes ? row[i - filter_bytes] : 0;
+            int b = prior[i];
+            int c = i >= filter_bytes ? prior[i - filter_bytes] : 0;
+            int predictor = 0;
+            switch(filter) {
+                case 1:
+                    predictor = a;
+                    break;
+                case 2:
+                    predictor = b;
+                    break;
+                case 3:
+                    predictor = (a + b) / 2;
+                    break;
+                case 4: {
+                    int p = a + b - c;
+                    int pa = std::abs(p - a);
+                    int pb = std::abs(p - b);
+                    int pc = std::abs(p - c);
+                    predictor = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+                    break;
+                }
+            }
+            filtered.push_back(static_cast<std::uint8_t>(row[i] - predictor));
+        }
+    }
+
+    std::vector<std::uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    std::vector<std::uint8_t> ihdr;
+    append_uint32(ihdr, test.width);
+    append_uint32(ihdr, test.height);
+    ihdr.push_back(test.depth);
+    ihdr.push_back(test.color);
+    ihdr.push_back(0);
+    ihdr.push_back(0);
+    ihdr.push_back(test.interlaced ? 1 : 0);
+    append_chunk(png, "IHDR", ihdr);
+
+    // Ancillary chunks that aren't understood are skipped
+    append_chunk(png, "tEXt", { 'T', 'e', 's', 't', 0, 'x' });
+
+    if(test.color == 3) {
+        std::vector<std::uint8_t> plte(palette_count * 3);
+        for(auto &byte : plte) {
+            byte = static_cast<std::uint8_t>(random());
+        }
+        append_chunk(png, "PLTE", plte);
+    }
+
+    if(test.transparency) {
+        std::vector<std::uint8_t> trns;
+        if(test.color == 3) {
+            for(std::size_t i = 0; i < palette_count / 2; i++) {
+                trns.push_back(static_cast<std::uint8_t>(random()));
+            }
+        }
+        else {
+            for(std::size_t c = 0; c < channels; c++) {
+                std::uint16_t value;
+                if(test.depth == 16) {
+                    value = static_cast<std::uint16_t>((rows[0][c * 2] << 8) | rows[0][c * 2 + 1]);
+                }
+                else if(test.depth == 8) {
+                    value = rows[0][c];
+                }
+                else {
+                    value = static_cast<std::uint16_t>(rows[0][0] >> (8 - test.depth));
+                }
+                trns.push_back(static_cast<std::uint8_t>(value >> 8));
+                trns.push_back(static_cast<std::uint8_t>(value));
+            }
+        }
+        append_chunk(png, "tRNS", trns);
+    }
+
+    // Split the image data between several IDAT chunks so rows span chunks
+    std::vector<std::uint8_t> compressed(compressBound(static_cast<uLong>(filtered.size())));
+    uLongf compressed_size = static_cast<uLongf>(compressed.size());
+    compress2(compressed.data(), &compressed_size, filtered.data(), static_cast<uLong>(filtered.size()), Z_BEST_SPEED);
+    compressed.resize(compressed_size);
+    static constexpr std::size_t IDAT_SIZE = 97;
+    for(std::size_t offset = 0; offset < compressed.size(); offset += IDAT_SIZE) {
+        auto end = std::min(offset + IDAT_SIZE, compressed.size());
+        append_chunk(png, "IDAT", std::vector<std::uint8_t>(compressed.begin() + offset, compressed.begin() + end));
+    }
+
+    append_chunk(png, "IEND", {});
+    return png;
+}
+
+struct TestTIFF {
+    const char *name;
+    std::uint16_t samples;
+    std::uint16_t depth;
+    std::uint16_t extra_samples;
+    std::uint16_t compression;
+    std::uint16_t orientation;
+
+    // Rows per strip, or 0 if tiled
+    std::uint32_t rows_per_strip;
+};
+
+static constexpr std::uint32_t TIFF_WIDTH = 173;
+static constexpr std::uint32_t TIFF_HEIGHT = 141;
+
+// Make a TIFF of random pixels, returning the pixels it should load as (if they are known exactly)
+static bool make_tiff(const TestTIFF &test, const std::filesystem::path &path, std::mt19937 &random, std::vector<Pixel> &expected) {
+    TIFF *tiff = TIFFOpen(path.string().c_str(), "w");
+    if(!tiff) {
+        return false;
+    }
+
+    TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, TIFF_WIDTH);
+    TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, TIFF_HEIGHT);
+    TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, test.samples);
+    TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, test.depth);
+    TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, test.samples >= 3 ? PHOTOMETRIC_RGB : PHOTOMETRIC_MINISBLACK);
+    TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(tiff, TIFFTAG_COMPRESSION, test.compression);
+    TIFFSetField(tiff, TIFFTAG_ORIENTATION, test.orientation);
+    if(test.samples == 2 || test.samples == 4) {
+        TIFFSetField(tiff, TIFFTAG_EXTRASAMPLES, 1, &test.extra_samples);
+    }
+
+    std::size_t pixel_size = test.samples * test.depth / 8;
+    std::vector<std::uint8_t> data(static_cast<std::size_t>(TIFF_WIDTH) * TIFF_HEIGHT * pixel_size);
+    for(auto &byte : data) {
+        byte = static_cast<std::uint8_t>(random());
+    }
+
+    bool written = true;
+    if(test.rows_per_strip == 0) {
+        static constexpr std::uint32_t TILE_SIZE = 32;
+        TIFFSetField(tiff, TIFFTAG_TILEWIDTH, TILE_SIZE);
+        TIFFSetField(tiff, TIFFTAG_TILELENGTH, TILE_SIZE);
+        std::vector<std::uint8_t> tile(TILE_SIZE * TILE_SIZE * pixel_size);
+        for(std::uint32_t top = 0; top < TIFF_HEIGHT; top += TILE_SIZE) {
+            for(std::uint32_t left = 0; left < TIFF_WIDTH; left += TILE_SIZE) {
+                std::fill(tile.begin(), tile.end(), 0);
+                for(std::uint32_t y = top; y < std::min(top + TILE_SIZE, TIFF_HEIGHT); y++) {
+                    auto columns = std::min(TILE_SIZE, TIFF_WIDTH - left);
+                    const auto *input = data.data() + (static_cast<std::size_t>(y) * TIFF_WIDTH + left) * pixel_size;
+                    std::copy(input, input + columns * pixel_size, tile.data() + static_cast<std::size_t>(y - top) * TILE_SIZE * pixel_size);
+                }
+                written = written && TIFFWriteTile(tiff, tile.data(), left, top, 0, 0) >= 0;
+            }
+        }
+    }
+    else {
+        TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, test.rows_per_strip);
+        for(std::uint32_t y = 0; y < TIFF_HEIGHT; y++) {
+            written = written && TIFFWriteScanline(tiff, data.data() + static_cast<std::size_t>(y) * TIFF_WIDTH * pixel_size, y, 0) >= 0;
+        }
+    }
+    TIFFClose(tiff);
+
+    // 8-bit RGB(A) stored top-down loads exactly as it was written (alpha is never multiplied in)
+    expected.clear();
+    if(test.depth == 8 && test.samples >= 3 && test.orientation == ORIENTATION_TOPLEFT) {
+        expected.resize(static_cast<std::size_t>(TIFF_WIDTH) * TIFF_HEIGHT);
+        for(std::size_t i = 0; i < expected.size(); i++) {
+            const auto *input = data.data() + i * pixel_size;
+            expected[i] = Pixel { input[2], input[1], input[0], test.samples == 4 ? input[3] : static_cast<std::uint8_t>(0xFF) };
+        }
+    }
+
+    return written;
+}
+
+// Return the index of the first pixel that differs, or the size if none differ
+static std::size_t first_difference(const std::vector<Pixel> &a, const std::vector<Pixel> &b) {
+    std::size_t i = 0;
+    while(i < a.size() && i < b.size() && a[i] == b[i]) {
+        i++;
+    }
+    return i;
+}
+
+static bool test_png(const TestPNG &test, const std::filesystem::path &directory, std::mt19937 &random) {
+    auto path = directory / (std::string(test.name) + ".png");
+    if(!save(path, make_png(test, random))) {
+        eprintf_error("%s: Failed to write %s", test.name, path.string().c_str());
+        return false;
+    }
+
+    std::uint32_t width = 0, height = 0;
+    auto pixels = load_png_by_row(path.string().c_str(), width, height);
+    if(test.interlaced) {
+        if(pixels.has_value()) {
+            eprintf_error("%s: Interlaced images should be left to stb_image", test.name);
+            return false;
+        }
+        return true;
+    }
+    if(!pixels.has_value()) {
+        eprintf_error("%s: load_png_by_row failed", test.name);
+        return false;
+    }
+
+    int x = 0, y = 0, channels = 0;
+    auto *stb_pixels = stbi_load(path.string().c_str(), &x, &y, &channels, 4);
+    if(!stb_pixels) {
+        eprintf_error("%s: stbi_load failed: %s", test.name, stbi_failure_reason());
+        return false;
+    }
+    std::vector<Pixel> expected(static_cast<std::size_t>(x) * y);
+    for(std::size_t i = 0; i < expected.size(); i++) {
+        const auto *rgba = stb_pixels + i * 4;
+        expected[i] = Pixel { rgba[2], rgba[1], rgba[0], rgba[3] };
+    }
+    stbi_image_free(stb_pixels);
+
+    if(width != static_cast<std::uint32_t>(x) || height != static_cast<std::uint32_t>(y)) {
+        eprintf_error("%s: Expected %ix%i but got %ux%u", test.name, x, y, width, height);
+        return false;
+    }
+    auto difference = first_difference(*pixels, expected);
+    if(difference != expected.size()) {
+        eprintf_error("%s: Pixel (%zu,%zu) does not match stb_image", test.name, difference % width, difference / width);
+        return false;
+    }
+
+    return true;
+}
+
+static bool test_tiff(const TestTIFF &test, const std::filesystem::path &directory, std::mt19937 &random) {
+    auto path = directory / (std::string(test.name) + ".tif");
+    std::vector<Pixel> expected;
+    if(!make_tiff(test, path, random, expected)) {
+        eprintf_error("%s: Failed to write %s", test.name, path.string().c_str());
+        return false;
+    }
+
+    std::vector<Pixel> single_threaded;
+    for(std::size_t max_threads : { 1, 2, 4, 7 }) {
+        std::uint32_t width = 0, height = 0;
+        std::size_t size = 0;
+        BufferedOutput output;
+        std::vector<Pixel> pixels;
+        try {
+            pixels = load_tiff(path.string().c_str(), width, height, size, max_threads, &output);
+        }
+        catch(std::exception &) {
+            output.flush();
+            eprintf_error("%s: load_tiff failed with %zu thread(s)", test.name, max_threads);
+            return false;
+        }
+
+        if(width != TIFF_WIDTH || height != TIFF_HEIGHT || size != pixels.size() * sizeof(Pixel)) {
+            eprintf_error("%s: Expected %ux%u but got %ux%u with %zu thread(s)", test.name, TIFF_WIDTH, TIFF_HEIGHT, width, height, max_threads);
+            return false;
+        }
+
+        if(max_threads == 1) {
+            single_threaded = std::move(pixels);
+            auto difference = first_difference(single_threaded, expected);
+            if(!expected.empty() && difference != expected.size()) {
+                eprintf_error("%s: Pixel (%zu,%zu) does not match what was written", test.name, difference % width, difference / width);
+                return false;
+            }
+        }
+        else {
+            auto difference = first_difference(pixels, single_threaded);
+            if(difference != single_threaded.size()) {
+                eprintf_error("%s: Pixel (%zu,%zu) differs between 1 and %zu thread(s)", test.name, difference % width, difference / width, max_threads);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// PNGs decoded a row at a time must match stb_image, and TIFFs read a strip or tile at a time must match no matter how
+// many threads read them
+int main() {
+    static const TestPNG pngs[] = {
+        { "gray-1", 0, 1, 37, 19, -1, false },
+        { "gray-2", 0, 2, 37, 19, -1, false },
+        { "gray-4", 0, 4, 37, 19, -1, false },
+        { "gray-8", 0, 8, 37, 19, -1, false },
+        { "gray-16", 0, 16, 37, 19, -1, false },
+        { "gray-1-trns", 0, 1, 37, 19, -1, true },
+        { "gray-4-trns", 0, 4, 37, 19, -1, true },
+        { "gray-8-trns", 0, 8, 37, 19, -1, true },
+        { "gray-16-trns", 0, 16, 37, 19, -1, true },
+        { "rgb-8", 2, 8, 41, 23, -1, false },
+        { "rgb-16", 2, 16, 41, 23, -1, false },
+        { "rgb-8-trns", 2, 8, 41, 23, -1, true },
+        { "rgb-16-trns", 2, 16, 41, 23, -1, true },
+        { "palette-1", 3, 1, 29, 17, -1, false },
+        { "palette-2", 3, 2, 29, 17, -1, false },
+        { "palette-4", 3, 4, 29, 17, -1, false },
+        { "palette-8", 3, 8, 29, 17, -1, false },
+        { "palette-2-trns", 3, 2, 29, 17, -1, true },
+        { "palette-8-trns", 3, 8, 29, 17, -1, true },
+        { "gray-alpha-8", 4, 8, 33, 21, -1, false },
+        { "gray-alpha-16", 4, 16, 33, 21, -1, false },
+        { "rgba-8", 6, 8, 64, 64, -1, false },
+        { "rgba-16", 6, 16, 33, 21, -1, false },
+        { "rgba-8-none", 6, 8, 31, 9, 0, false },
+        { "rgba-8-sub", 6, 8, 31, 9, 1, false },
+        { "rgba-8-up", 6, 8, 31, 9, 2, false },
+        { "rgba-8-average", 6, 8, 31, 9, 3, false },
+        { "rgba-8-paeth", 6, 8, 31, 9, 4, false },
+        { "gray-1-paeth", 0, 1, 31, 9, 4, false },
+        { "one-pixel", 6, 8, 1, 1, -1, false },
+        { "one-column", 0, 2, 1, 40, -1, false },
+        { "interlaced", 6, 8, 16, 16, 0, false, true }
+    };
+
+    static const TestTIFF tiffs[] = {
+        { "rgba-strips", 4, 8, EXTRASAMPLE_UNASSALPHA, COMPRESSION_NONE, ORIENTATION_TOPLEFT, 16 },
+        { "rgba-one-row-strips", 4, 8, EXTRASAMPLE_UNASSALPHA, COMPRESSION_NONE, ORIENTATION_TOPLEFT, 1 },
+        { "rgba-one-strip", 4, 8, EXTRASAMPLE_UNASSALPHA, COMPRESSION_NONE, ORIENTATION_TOPLEFT, TIFF_HEIGHT },
+        { "rgba-associated", 4, 8, EXTRASAMPLE_ASSOCALPHA, COMPRESSION_NONE, ORIENTATION_TOPLEFT, 10 },
+        { "rgba-lzw", 4, 8, EXTRASAMPLE_UNASSALPHA, COMPRESSION_LZW, ORIENTATION_TOPLEFT, 7 },
+        { "rgba-deflate-tiles", 4, 8, EXTRASAMPLE_UNASSALPHA, COMPRESSION_ADOBE_DEFLATE, ORIENTATION_TOPLEFT, 0 },
+        { "rgba-tiles", 4, 8, EXTRASAMPLE_UNASSALPHA, COMPRESSION_NONE, ORIENTATION_TOPLEFT, 0 },
+        { "rgba-16", 4, 16, EXTRASAMPLE_UNASSALPHA, COMPRESSION_NONE, ORIENTATION_TOPLEFT, 16 },
+        { "rgb-strips", 3, 8, 0, COMPRESSION_NONE, ORIENTATION_TOPLEFT, 9 },
+        { "gray-strips", 1, 8, 0, COMPRESSION_NONE, ORIENTATION_TOPLEFT, 16 },
+        { "gray-alpha-tiles", 2, 8, EXTRASAMPLE_UNASSALPHA, COMPRESSION_NONE, ORIENTATION_TOPLEFT, 0 },
+        { "rgba-bottom-up", 4, 8, EXTRASAMPLE_UNASSALPHA, COMPRESSION_NONE, ORIENTATION_BOTLEFT, 16 }
+    };
+
+    auto directory = std::filesystem::temp_directory_path() / "invader-test-image-loader";
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+    if(!std::filesystem::create_directories(directory, ec)) {
+        eprintf_error("Failed to create %s", directory.string().c_str());
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937 random(0x1A7E);
+    bool failed = false;
+    for(auto &png : pngs) {
+        failed = !test_png(png, directory, random) || failed;
+    }
+    for(auto &tiff : tiffs) {
+        failed = !test_tiff(tiff, directory, random) || failed;
+    }
+
+    std::filesystem::remove_all(directory, ec);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
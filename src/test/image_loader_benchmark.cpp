@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <invader/printf.hpp>
+#include "../bitmap/image_loader.hpp"
+#include "../command_line_option.hpp"
+
+using namespace Invader;
+
+// Reset the peak resident set size so each image's peak can be measured on its own (only Linux can do this)
+static bool reset_peak_rss() {
+    #ifdef __linux__
+    std::FILE *clear_refs = std::fopen("/proc/self/clear_refs", "w");
+    if(!clear_refs) {
+        return false;
+    }
+    bool reset = std::fputs("5", clear_refs) >= 0;
+    return std::fclose(clear_refs) == 0 && reset;
+    #else
+    return false;
+    #endif
+}
+
+// Get the peak resident set size in bytes
+static std::size_t peak_rss() {
+    #if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+    #else
+    #ifdef __linux__
+    // VmHWM is reset by reset_peak_rss() while ru_maxrss is not
+    std::FILE *status = std::fopen("/proc/self/status", "r");
+    if(status) {
+        char line[256];
+        std::size_t kib = 0;
+        while(std::fgets(line, sizeof(line), status)) {
+            if(std::sscanf(line, "VmHWM: %zu kB", &kib) == 1) {
+                break;
+            }
+        }
+        std::fclose(status);
+        if(kib) {
+            return kib * 1024;
+        }
+    }
+    #endif
+
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    #ifdef __APPLE__
+    return static_cast<std::size_t>(usage.ru_maxrss);
+    #else
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+    #endif
+    #endif
+}
+
+#define BYTES_TO_MIB(bytes) ((bytes) / 1024.0 / 1024.0)
+
+int main(int argc, const char **argv) {
+    struct BenchmarkOptions {
+        std::size_t iterations = 5;
+        std::size_t max_threads = std::thread::hardware_concurrency() < 1 ? 1 : std::thread::hardware_concurrency();
+    } benchmark_options;
+
+    const CommandLineOption options[] = {
+        CommandLineOption("iterations", 'n', 1, "Set the number of times to load each image. Default: 5", "<count>"),
+        CommandLineOption("threads", 'j', 1, "Set the number of threads to load TIFFs with. Default: CPU thread count", "<count>")
+    };
+
+    static constexpr char DESCRIPTION[] = "Measure how fast images load as color plates and how much memory loading them takes. The peak resident set size is only measured per image on Linux; elsewhere it is the peak of the whole run so far, so benchmark one image per run.";
+    static constexpr char USAGE[] = "[options] <image> [image ...]";
+
+    auto remaining_arguments = CommandLineOption::parse_arguments<BenchmarkOptions &>(argc, argv, options, USAGE, DESCRIPTION, 1, SIZE_MAX, benchmark_options, [](char opt, const auto &args, auto &benchmark_options) {
+        std::size_t value = 0;
+        try {
+            value = std::stoul(args[0]);
+        }
+        catch(std::exception &) {}
+        if(value < 1) {
+            eprintf_error("Invalid count %s", args[0]);
+            std::exit(EXIT_FAILURE);
+        }
+
+        switch(opt) {
+            case 'n':
+                benchmark_options.iterations = value;
+                break;
+            case 'j':
+                benchmark_options.max_threads = value;
+                break;
+        }
+    });
+
+    bool failed = false;
+    for(auto *path : remaining_arguments) {
+        auto extension = std::filesystem::path(path).extension().string();
+        for(auto &c : extension) {
+            c = static_cast<char>(std::tolower(c));
+        }
+        bool tiff = extension == ".tif" || extension == ".tiff";
+
+        std::error_code ec;
+        auto file_size = std::filesystem::file_size(path, ec);
+        if(ec) {
+            eprintf_error("Failed to read %s", path);
+            failed = true;
+            continue;
+        }
+
+        bool per_image = reset_peak_rss();
+        std::uint32_t width = 0, height = 0;
+        std::size_t image_size = 0;
+        double fastest = 0.0;
+        try {
+            for(std::size_t i = 0; i < benchmark_options.iterations; i++) {
+                auto start = std::chrono::steady_clock::now();
+                auto pixels = tiff ? load_tiff(path, width, height, image_size, benchmark_options.max_threads) : load_image(path, width, height, image_size);
+                auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                if(i == 0 || seconds < fastest) {
+                    fastest = seconds;
+                }
+            }
+        }
+        catch(std::exception &) {
+            failed = true;
+            continue;
+        }
+
+        oprintf("%s: %ux%u, %.03f MiB file\n", path, width, height, BYTES_TO_MIB(static_cast<double>(file_size)));
+        oprintf("    Fastest load:  %.03f ms of %zu\n", fastest * 1000.0, benchmark_options.iterations);
+        oprintf("    Throughput:    %.02f MiB/s read, %.02f MiB/s decoded\n", BYTES_TO_MIB(file_size / fastest), BYTES_TO_MIB(image_size / fastest));
+        oprintf("    Peak RSS:      %.02f MiB%s\n", BYTES_TO_MIB(static_cast<double>(peak_rss())), per_image ? "" : " (whole run)");
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+# SPDX-License-Identifier: GPL-3.0-only
+
+if(NOT DEFINED ${INVADER_TESTS})
+    set(INVADER_TESTS true CACHE BOOL "Build Invader's tests (run with ctest)")
+endif()
+
+if(${INVADER_TESTS})
+    enable_testing()
+
+    add_executable(invader-test-dependency-scan
+        src/test/dependency_scan.cpp
+    )
+    target_link_libraries(invader-test-dependency-scan invader)
+    add_test(NAME dependency-scan COMMAND invader-test-dependency-scan)
+
+    add_executable(invader-test-color-plate-scanner
+        src/test/color_plate_scanner.cpp
+    )
+    target_link_libraries(invader-test-color-plate-scanner invader)
+    add_test(NAME color-plate-scanner COMMAND invader-test-color-plate-scanner)
+
+    # The image loader is part of invader-bitmap, so it can only be tested if invader-bitmap can be built
+    if(${INVADER_BITMAP})
+        add_executable(invader-test-image-loader
+            src/test/image_loader.cpp
+            src/bitmap/image_loader.cpp
+            src/bitmap/stb/stb_impl.c
+        )
+        target_include_directories(invader-test-image-loader
+            PUBLIC ${TIFF_INCLUDE_DIRS}
+        )
+        target_link_libraries(invader-test-image-loader ${TIFF_LIBRARIES} invader)
+        add_test(NAME image-loader COMMAND invader-test-image-loader)
+
+        # Not a test; run it on color plates to see how fast they load and how much memory that takes
+        add_executable(invader-benchmark-image-loader
+            src/test/image_loader_benchmark.cpp
+            src/bitmap/image_loader.cpp
+            src/bitmap/stb/stb_impl.c
+        )
+        target_include_directories(invader-benchmark-image-loader
+            PUBLIC ${TIFF_INCLUDE_DIRS}
+        )
+        target_link_libraries(invader-benchmark-image-loader ${TIFF_LIBRARIES} invader)
+        if(WIN32)
+            target_link_libraries(invader-benchmark-image-loader psapi)
+        endif()
+    endif()
+endif()